@@ -0,0 +1,212 @@
+/**
+ * @file algorithm_bench.cpp
+ * @brief Host benchmark of the adaptation algorithms of SelectableLMSFilter.
+ *
+ * For each filter length and each algorithm the benchmark identifies a synthetic feedback path
+ * excited by white noise, then by coloured noise with most of its power in the low frequencies, as
+ * music has, and reports the cost per sample, the time needed to reach 10 dB of echo return loss
+ * enhancement (ERLE) and the ERLE reached at the end of the run. The algorithms with a fixed
+ * adaptation rate run with a rate suited to each of them; the others set their own. The last
+ * table switches from NLMS to each algorithm halfway through a run and reports the ERLE just
+ * before and just after the switch, which the weights handed over should keep.
+ *
+ * Build and run with the host Makefile:
+ *   make -C host algorithm_bench && host/build/algorithm_bench
+ */
+#include "SelectableLMSFilter.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+constexpr double SAMPLE_RATE{44117.64706}; ///< Sample rate of the Teensy audio library.
+constexpr std::size_t BLOCK_SAMPLES{128}; ///< Samples per processed block.
+constexpr std::size_t ERLE_WINDOW{4096}; ///< Window over which the ERLE is measured.
+constexpr double TARGET_ERLE_DB{10.0}; ///< ERLE at which the filter is considered converged.
+constexpr std::size_t RUN_SAMPLES{static_cast<std::size_t>(SAMPLE_RATE * 10.0)}; ///< Length of a simulated run.
+constexpr float NOISE_LEVEL{0.3f}; ///< RMS level of the excitation.
+constexpr float COLOUR_POLE{0.95f}; ///< Pole of the first-order filter colouring the noise.
+
+/**
+ * @brief Generates a synthetic feedback path: exponentially decaying Gaussian taps.
+ *
+ * @param length The number of taps.
+ * @param rng The random number generator.
+ * @return The impulse response.
+ */
+static std::vector<float> makePath(const std::size_t length, std::mt19937& rng) {
+    std::normal_distribution<float> tap{0.0f, 1.0f};
+    std::vector<float> path(length);
+    double energy{0.0};
+    for (std::size_t i = 0; i < length; ++i) {
+        path[i] = tap(rng) * std::exp(-4.0f * static_cast<float>(i) / static_cast<float>(length));
+        energy += static_cast<double>(path[i]) * path[i];
+    }
+    const auto scale = static_cast<float>(0.25 / std::sqrt(energy));
+    for (float& value : path) value *= scale;
+    return path;
+}
+
+/**
+ * @brief Gets the adaptation rate an algorithm runs with in the benchmark.
+ *
+ * LMS is given a tenth of its stability bound, NLMS, APA and IPNLMS half of theirs. VSS, Kalman
+ * and DynamicNoise keep the highest rate of their step control, and RLS ignores it.
+ *
+ * @param algorithm The algorithm.
+ * @param taps The number of taps of the filter.
+ * @return The adaptation rate.
+ */
+static float benchMu(const LMSAlgorithm algorithm, const std::size_t taps) {
+    switch (algorithm) {
+        case LMSAlgorithm::LMS:
+            return 0.2f / (static_cast<float>(taps) * NOISE_LEVEL * NOISE_LEVEL);
+        case LMSAlgorithm::NLMS:
+        case LMSAlgorithm::APA:
+        case LMSAlgorithm::IPNLMS:
+            return 0.5f;
+        case LMSAlgorithm::VSS:
+        case LMSAlgorithm::Kalman:
+        case LMSAlgorithm::DynamicNoise:
+            return 0.01f;
+        default:
+            return 0.0001f;
+    }
+}
+
+/**
+ * @brief Result of identifying a path with one algorithm.
+ */
+struct RunResult {
+    double nsPerSample{0.0}; ///< Cost of the adaptive filter per sample.
+    double convergenceMs{-1.0}; ///< Time to reach the target ERLE, or -1 if never reached.
+    double finalErle{0.0}; ///< ERLE over the last window of the run, in dB.
+    double erleBeforeSwitch{0.0}; ///< ERLE over the last window before the switch, in dB.
+    double erleAfterSwitch{0.0}; ///< ERLE over the first window after the switch, in dB.
+};
+
+/**
+ * @brief Identifies a feedback path with a SelectableLMSFilter.
+ *
+ * @param filter The adaptive filter, running its first algorithm.
+ * @param path The impulse response to identify.
+ * @param coloured True to excite the path with coloured noise instead of white noise.
+ * @param next The algorithm selected halfway through the run, or the first one for no switch.
+ * @return The cost, convergence time and ERLE.
+ */
+static RunResult identify(SelectableLMSFilter<float>& filter, const std::vector<float>& path, const bool coloured,
+                          const LMSAlgorithm next) {
+    std::mt19937 rng{7};
+    const float gain = coloured ? NOISE_LEVEL * std::sqrt(1.0f - COLOUR_POLE * COLOUR_POLE) : NOISE_LEVEL;
+    std::normal_distribution<float> noise{0.0f, gain};
+    float colour{0.0f};
+
+    std::vector<float> history(path.size(), 0.0f);
+    std::size_t historyIndex{0};
+    float reference[BLOCK_SAMPLES], desired[BLOCK_SAMPLES], error[BLOCK_SAMPLES];
+
+    RunResult result;
+    double desiredEnergy{0.0}, errorEnergy{0.0}, elapsedNs{0.0};
+    std::size_t windowFill{0};
+    constexpr std::size_t switchOffset{RUN_SAMPLES / 2 / ERLE_WINDOW * ERLE_WINDOW};
+
+    for (std::size_t offset = 0; offset < RUN_SAMPLES; offset += BLOCK_SAMPLES) {
+        if (offset == switchOffset) {
+            result.erleBeforeSwitch = result.finalErle;
+            filter.select(next);
+            filter.setMu(benchMu(next, path.size()));
+        }
+
+        for (std::size_t i = 0; i < BLOCK_SAMPLES; ++i) {
+            colour = (coloured ? COLOUR_POLE * colour : 0.0f) + noise(rng);
+            reference[i] = colour;
+            history[historyIndex] = reference[i];
+            float echo{0.0f};
+            for (std::size_t k = 0; k < path.size(); ++k) {
+                echo += path[k] * history[(historyIndex + path.size() - k) % path.size()];
+            }
+            historyIndex = (historyIndex + 1) % path.size();
+            desired[i] = echo;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        filter.processBlock(reference, desired, error, BLOCK_SAMPLES);
+        elapsedNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        for (std::size_t i = 0; i < BLOCK_SAMPLES; ++i) {
+            desiredEnergy += static_cast<double>(desired[i]) * desired[i];
+            errorEnergy += static_cast<double>(error[i]) * error[i];
+        }
+        windowFill += BLOCK_SAMPLES;
+
+        if (windowFill >= ERLE_WINDOW) {
+            result.finalErle = 10.0 * std::log10(desiredEnergy / (errorEnergy + 1e-20));
+            if (result.convergenceMs < 0.0 && result.finalErle >= TARGET_ERLE_DB) {
+                result.convergenceMs = 1000.0 * static_cast<double>(offset + BLOCK_SAMPLES) / SAMPLE_RATE;
+            }
+            if (offset + BLOCK_SAMPLES == switchOffset + ERLE_WINDOW) result.erleAfterSwitch = result.finalErle;
+            desiredEnergy = errorEnergy = 0.0;
+            windowFill = 0;
+        }
+    }
+
+    result.nsPerSample = elapsedNs / static_cast<double>(RUN_SAMPLES);
+    return result;
+}
+
+/**
+ * @brief Formats a convergence time for the result table.
+ *
+ * @param buffer The output buffer.
+ * @param size The size of the output buffer.
+ * @param ms The convergence time, or -1 if never reached.
+ * @return The formatted string.
+ */
+static const char* formatConvergence(char* buffer, const std::size_t size, const double ms) {
+    if (ms < 0.0) {
+        std::snprintf(buffer, size, "> %.0f", 1000.0 * static_cast<double>(RUN_SAMPLES) / SAMPLE_RATE);
+    } else {
+        std::snprintf(buffer, size, "%.0f", ms);
+    }
+    return buffer;
+}
+
+int main() {
+    for (const std::size_t taps : {64, 256}) {
+        for (const bool coloured : {false, true}) {
+            std::mt19937 rng{2024};
+            const std::vector<float> path = makePath(taps, rng);
+            std::printf("\n%zu taps, %s noise\n", taps, coloured ? "coloured" : "white");
+            std::printf("%10s %10s %12s %10s\n", "algorithm", "ns/smp", "10dB ms", "ERLE");
+            for (std::size_t i = 0; i < LMS_ALGORITHM_COUNT; ++i) {
+                const auto algorithm = static_cast<LMSAlgorithm>(i);
+                SelectableLMSFilter<float> filter{taps};
+                filter.select(algorithm);
+                filter.setMu(benchMu(algorithm, taps));
+                const RunResult result = identify(filter, path, coloured, algorithm);
+
+                char text[32];
+                std::printf("%10s %10.1f %12s %10.1f\n", lmsAlgorithmName(algorithm), result.nsPerSample,
+                            formatConvergence(text, sizeof(text), result.convergenceMs), result.finalErle);
+            }
+        }
+    }
+
+    std::mt19937 rng{2024};
+    const std::vector<float> path = makePath(64, rng);
+    std::printf("\n64 taps, coloured noise, switching from NLMS halfway\n");
+    std::printf("%10s %12s %12s %10s\n", "to", "ERLE before", "ERLE after", "ERLE end");
+    for (std::size_t i = 0; i < LMS_ALGORITHM_COUNT; ++i) {
+        const auto algorithm = static_cast<LMSAlgorithm>(i);
+        SelectableLMSFilter<float> filter{path.size()};
+        filter.select(LMSAlgorithm::NLMS);
+        filter.setMu(benchMu(LMSAlgorithm::NLMS, path.size()));
+        const RunResult result = identify(filter, path, true, algorithm);
+        std::printf("%10s %12.1f %12.1f %10.1f\n", lmsAlgorithmName(algorithm), result.erleBeforeSwitch,
+                    result.erleAfterSwitch, result.finalErle);
+    }
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+/**
+ * @file fdaf_bench.cpp
+ * @brief Host benchmark comparing PartitionedFDAFFilter with LMSFilter at equal filter lengths.
+ *
+ * For each length the benchmark identifies a synthetic feedback path excited by white noise
+ * and reports the cost per sample, the time needed to reach 10 dB of echo return loss
+ * enhancement (ERLE) and the ERLE reached at the end of the run. The time-domain filter is an
+ * NLMS with a fixed step, at the normalized adaptation rate of the FDAF.
+ *
+ * Build and run with the host Makefile:
+ *   make -C host fdaf_bench && host/build/fdaf_bench
+ */
+#include "LMSFilter.h"
+#include "PartitionedFDAFFilter.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+constexpr double SAMPLE_RATE{44117.64706}; ///< Sample rate of the Teensy audio library.
+constexpr std::size_t BLOCK_SAMPLES{128}; ///< Samples per processed block.
+constexpr std::size_t ERLE_WINDOW{1024}; ///< Window over which the ERLE is measured.
+constexpr double TARGET_ERLE_DB{10.0}; ///< ERLE at which the filter is considered converged.
+constexpr float STEP{0.5f}; ///< Normalized adaptation rate of both filters.
+constexpr std::size_t RUN_SAMPLES{static_cast<std::size_t>(SAMPLE_RATE * 5.0)}; ///< Length of a simulated run.
+
+/**
+ * @brief Generates a synthetic feedback path: exponentially decaying Gaussian taps.
+ *
+ * @param length The number of taps.
+ * @param rng The random number generator.
+ * @return The impulse response.
+ */
+static std::vector<float> makePath(const std::size_t length, std::mt19937& rng) {
+    std::normal_distribution<float> tap{0.0f, 1.0f};
+    std::vector<float> path(length);
+    double energy{0.0};
+    for (std::size_t i = 0; i < length; ++i) {
+        path[i] = tap(rng) * std::exp(-4.0f * static_cast<float>(i) / static_cast<float>(length));
+        energy += static_cast<double>(path[i]) * path[i];
+    }
+    const auto scale = static_cast<float>(0.5 / std::sqrt(energy));
+    for (float& value : path) value *= scale;
+    return path;
+}
+
+/**
+ * @brief Result of identifying a path with one adaptive filter.
+ */
+struct RunResult {
+    double nsPerSample{0.0}; ///< Cost of the adaptive filter per sample.
+    double convergenceMs{-1.0}; ///< Time to reach the target ERLE, or -1 if never reached.
+    double finalErle{0.0}; ///< ERLE over the last window of the run, in dB.
+};
+
+/**
+ * @brief Identifies a feedback path with an adaptive filter.
+ *
+ * @tparam Filter The adaptive filter type.
+ * @param filter The adaptive filter.
+ * @param path The impulse response to identify.
+ * @return The cost, convergence time and final ERLE.
+ */
+template<typename Filter>
+static RunResult identify(Filter& filter, const std::vector<float>& path) {
+    std::mt19937 rng{7};
+    std::normal_distribution<float> noise{0.0f, 0.3f};
+
+    std::vector<float> history(path.size(), 0.0f);
+    std::size_t historyIndex{0};
+    float reference[BLOCK_SAMPLES], desired[BLOCK_SAMPLES], error[BLOCK_SAMPLES];
+
+    RunResult result;
+    double desiredEnergy{0.0}, errorEnergy{0.0}, elapsedNs{0.0};
+    std::size_t windowFill{0};
+
+    for (std::size_t offset = 0; offset < RUN_SAMPLES; offset += BLOCK_SAMPLES) {
+        for (std::size_t i = 0; i < BLOCK_SAMPLES; ++i) {
+            reference[i] = noise(rng);
+            history[historyIndex] = reference[i];
+            float echo{0.0f};
+            for (std::size_t k = 0; k < path.size(); ++k) {
+                echo += path[k] * history[(historyIndex + path.size() - k) % path.size()];
+            }
+            historyIndex = (historyIndex + 1) % path.size();
+            desired[i] = echo;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        filter.processBlock(reference, desired, error, BLOCK_SAMPLES);
+        elapsedNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        for (std::size_t i = 0; i < BLOCK_SAMPLES; ++i) {
+            desiredEnergy += static_cast<double>(desired[i]) * desired[i];
+            errorEnergy += static_cast<double>(error[i]) * error[i];
+        }
+        windowFill += BLOCK_SAMPLES;
+
+        if (windowFill >= ERLE_WINDOW) {
+            result.finalErle = 10.0 * std::log10(desiredEnergy / (errorEnergy + 1e-20));
+            if (result.convergenceMs < 0.0 && result.finalErle >= TARGET_ERLE_DB) {
+                result.convergenceMs = 1000.0 * static_cast<double>(offset + BLOCK_SAMPLES) / SAMPLE_RATE;
+            }
+            desiredEnergy = errorEnergy = 0.0;
+            windowFill = 0;
+        }
+    }
+
+    result.nsPerSample = elapsedNs / static_cast<double>(RUN_SAMPLES);
+    return result;
+}
+
+/**
+ * @brief Formats a convergence time for the result table.
+ *
+ * @param buffer The output buffer.
+ * @param size The size of the output buffer.
+ * @param ms The convergence time, or -1 if never reached.
+ * @return The formatted string.
+ */
+static const char* formatConvergence(char* buffer, const std::size_t size, const double ms) {
+    if (ms < 0.0) {
+        std::snprintf(buffer, size, "> %.0f", 1000.0 * static_cast<double>(RUN_SAMPLES) / SAMPLE_RATE);
+    } else {
+        std::snprintf(buffer, size, "%.0f", ms);
+    }
+    return buffer;
+}
+
+int main() {
+    std::mt19937 rng{2024};
+
+    std::printf("%6s %12s %12s %14s %14s %10s %10s\n", "taps", "NLMS ns/smp", "FDAF ns/smp",
+                "NLMS 10dB ms", "FDAF 10dB ms", "NLMS ERLE", "FDAF ERLE");
+    for (std::size_t taps = 64; taps <= 4096; taps *= 2) {
+        const std::vector<float> path = makePath(taps, rng);
+
+        LMSFilter<float, 1, NLMSUpdate, FixedStep> lms{taps, STEP};
+        const RunResult lmsResult = identify(lms, path);
+
+        PartitionedFDAFFilter<float> fdaf{taps, STEP, std::min(taps, BLOCK_SAMPLES)};
+        const RunResult fdafResult = identify(fdaf, path);
+
+        char lmsText[32], fdafText[32];
+        std::printf("%6zu %12.1f %12.1f %14s %14s %10.1f %10.1f\n", taps, lmsResult.nsPerSample, fdafResult.nsPerSample,
+                    formatConvergence(lmsText, sizeof(lmsText), lmsResult.convergenceMs),
+                    formatConvergence(fdafText, sizeof(fdafText), fdafResult.convergenceMs),
+                    lmsResult.finalErle, fdafResult.finalErle);
+    }
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file frequency_bench.cpp
+ * @brief Host benchmark comparing the dominant-frequency estimators used by NotchLMSFilter.
+ *
+ * Each estimator is fed synthetic howl tones from 100 Hz to 8 kHz in white noise, in blocks of
+ * AUDIO_BLOCK_SAMPLES samples with one estimate per block, as NotchLMSFilter does. The benchmark
+ * reports the cost of one block (feeding and estimating) and the mean and worst absolute
+ * frequency error over the tones.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++17 -O2 -Isrc -Ihost/include host/bench/frequency_bench.cpp src/FFT.cpp \
+ *       src/AutocorrelationEstimator.cpp src/SpectralPeakEstimator.cpp src/SlidingDFTEstimator.cpp \
+ *       -o frequency_bench && ./frequency_bench
+ */
+#include "AutocorrelationEstimator.h"
+#include "SlidingDFTEstimator.h"
+#include "SpectralPeakEstimator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+constexpr std::size_t BLOCK_SAMPLES{AUDIO_BLOCK_SAMPLES}; ///< Samples per processed block.
+constexpr std::size_t BLOCK_COUNT{64}; ///< Number of blocks per tone.
+constexpr std::size_t SETTLE_BLOCKS{4}; ///< Blocks fed before the error is measured.
+constexpr float MIN_FREQUENCY{100.0f}; ///< Lowest frequency searched by the estimators.
+constexpr float MAX_FREQUENCY{8000.0f}; ///< Highest frequency searched by the estimators.
+
+/**
+ * @brief Reads a timestamp in CPU cycles, or in nanoseconds where no cycle counter is available.
+ *
+ * @return The current timestamp.
+ */
+static std::uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/**
+ * @brief Generates a howl tone in white noise.
+ *
+ * @param frequency The frequency of the tone, in Hz.
+ * @param n The number of samples.
+ * @param rng The random number generator.
+ * @return The generated signal.
+ */
+static std::vector<float> makeTone(const double frequency, const std::size_t n, std::mt19937& rng) {
+    std::normal_distribution<float> noise{0.0f, 0.05f};
+    std::uniform_real_distribution<double> phase{0.0, 2.0 * M_PI};
+    const double phi = phase(rng);
+    std::vector<float> signal(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        const double t = static_cast<double>(i) / AUDIO_SAMPLE_RATE_EXACT;
+        signal[i] = static_cast<float>(0.5 * std::sin(2.0 * M_PI * frequency * t + phi)) + noise(rng);
+    }
+    return signal;
+}
+
+/**
+ * @brief Result of running one estimator over all the tones.
+ */
+struct EstimatorResult {
+    double cyclesPerBlock{0.0}; ///< Mean cost of feeding and estimating one block.
+    double meanError{0.0}; ///< Mean absolute frequency error, in Hz.
+    double worstError{0.0}; ///< Worst absolute frequency error, in Hz.
+};
+
+/**
+ * @brief Runs an estimator over howl tones spread from MIN_FREQUENCY to MAX_FREQUENCY.
+ *
+ * @param estimator The estimator under test.
+ * @return The cost and the frequency error of the estimator.
+ */
+static EstimatorResult runEstimator(FrequencyEstimator<float>& estimator) {
+    std::mt19937 rng{42};
+    EstimatorResult result;
+    std::uint64_t cycles{0};
+    std::size_t blocks{0}, estimates{0};
+
+    for (double frequency = MIN_FREQUENCY; frequency <= MAX_FREQUENCY; frequency *= 1.05) {
+        const std::vector<float> signal = makeTone(frequency, BLOCK_SAMPLES * BLOCK_COUNT, rng);
+        estimator.reset();
+
+        for (std::size_t block = 0; block < BLOCK_COUNT; ++block) {
+            const std::uint64_t start = readCycles();
+            estimator.process(signal.data() + block * BLOCK_SAMPLES, BLOCK_SAMPLES);
+            const float estimate = estimator.estimate(MIN_FREQUENCY, MAX_FREQUENCY);
+            cycles += readCycles() - start;
+            ++blocks;
+
+            if (block < SETTLE_BLOCKS) continue;
+            const double error = std::abs(static_cast<double>(estimate) - frequency);
+            result.meanError += error;
+            result.worstError = std::max(result.worstError, error);
+            ++estimates;
+        }
+    }
+
+    result.cyclesPerBlock = static_cast<double>(cycles) / static_cast<double>(blocks);
+    result.meanError /= static_cast<double>(estimates);
+    return result;
+}
+
+/**
+ * @brief Prints one row of the result table.
+ *
+ * @param name The name of the estimator.
+ * @param result The run of the estimator.
+ */
+static void printRow(const char* name, const EstimatorResult& result) {
+    std::printf("%16s %16.0f %16.2f %16.2f\n", name, result.cyclesPerBlock, result.meanError, result.worstError);
+}
+
+int main() {
+    AutocorrelationEstimator<float> autocorrelation;
+    SpectralPeakEstimator<float> spectralPeak;
+    SlidingDFTEstimator<float> slidingDFT;
+
+    std::printf("%16s %16s %16s %16s\n", "estimator", "cycles/block", "mean err (Hz)", "worst err (Hz)");
+    printRow("autocorrelation", runEstimator(autocorrelation));
+    printRow("spectral peak", runEstimator(spectralPeak));
+    printRow("sliding DFT", runEstimator(slidingDFT));
+
+    return 0;
+}
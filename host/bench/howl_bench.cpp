@@ -0,0 +1,216 @@
+/**
+ * @file howl_bench.cpp
+ * @brief Host benchmark of HowlDetector on synthetic magnitude spectra.
+ *
+ * The spectra are those AudioAnalyzeFFT1024 would compute with its Hann window: each tone is
+ * the window kernel centred on its fractional bin, added with a random phase to complex white
+ * noise. Each scenario runs many trials of FRAMES spectra and reports how often a howl was
+ * reported, after how many spectra, how far from the true frequency, and the number of howls
+ * reported at wrong frequencies. A howl alone or over a voice should be found within a few
+ * spectra; a voice, a short tone and noise should report nothing. The cost of analyze() per
+ * spectrum is reported last.
+ *
+ * Build and run with the host Makefile:
+ *   make -C host howl_bench && host/build/howl_bench
+ */
+#include "HowlDetector.h"
+
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+constexpr std::size_t BINS{512}; ///< Number of bins of AudioAnalyzeFFT1024.
+constexpr float BIN_WIDTH{AUDIO_SAMPLE_RATE_EXACT / 1024.0f}; ///< Frequency spacing of the bins, in Hz.
+constexpr std::size_t FRAMES{48}; ///< Spectra per trial.
+constexpr std::size_t TRIALS{200}; ///< Trials per scenario.
+constexpr float NOISE_LEVEL{1e-4f}; ///< RMS magnitude of the noise in each bin.
+
+/**
+ * @brief A tone of a synthetic spectrum.
+ */
+struct Tone {
+    float frequency; ///< Frequency, in Hz.
+    float amplitude; ///< Peak amplitude.
+};
+
+/**
+ * @brief Gets the magnitude of the Hann window kernel at a distance from its centre.
+ *
+ * @param d The distance, in bins.
+ * @return The magnitude of a unit tone in a bin at distance d, 0.5 at the centre.
+ */
+static float hannKernel(const float d) {
+    const auto sinc = [](const double x) { return std::abs(x) < 1e-9 ? 1.0 : std::sin(M_PI * x) / (M_PI * x); };
+    return static_cast<float>(0.5 * sinc(d) + 0.25 * sinc(d - 1.0) + 0.25 * sinc(d + 1.0));
+}
+
+/**
+ * @brief Builds the magnitude spectrum of tones in white noise.
+ *
+ * @param tones The tones.
+ * @param rng The random number generator.
+ * @param magnitude The BINS magnitudes to fill.
+ */
+static void makeSpectrum(const std::vector<Tone>& tones, std::mt19937& rng, float* magnitude) {
+    std::normal_distribution<float> noise{0.0f, NOISE_LEVEL / std::sqrt(2.0f)};
+    std::uniform_real_distribution<float> phase{0.0f, 2.0f * static_cast<float>(M_PI)};
+
+    std::complex<float> bins[BINS];
+    for (std::complex<float>& bin : bins) {
+        bin = {noise(rng), noise(rng)};
+    }
+    for (const Tone& tone : tones) {
+        const float centre = tone.frequency / BIN_WIDTH;
+        const std::complex<float> rotation = std::polar(tone.amplitude, phase(rng));
+        for (std::size_t k = 0; k < BINS; ++k) {
+            bins[k] += rotation * hannKernel(static_cast<float>(k) - centre);
+        }
+    }
+    for (std::size_t k = 0; k < BINS; ++k) {
+        magnitude[k] = std::abs(bins[k]);
+    }
+}
+
+/**
+ * @brief Builds the harmonics of a voiced sound, falling by 6 dB per octave.
+ *
+ * @param fundamental The fundamental frequency, in Hz.
+ * @param amplitude The amplitude of the fundamental.
+ * @param tones The tones to append the harmonics to.
+ */
+static void addVoice(const float fundamental, const float amplitude, std::vector<Tone>& tones) {
+    for (int harmonic = 1; fundamental * static_cast<float>(harmonic) < 5000.0f; ++harmonic) {
+        tones.push_back({fundamental * static_cast<float>(harmonic), amplitude / static_cast<float>(harmonic)});
+    }
+}
+
+/**
+ * @brief Kind of signal of a scenario.
+ */
+enum class Scenario { Howl, HowlOverVoice, Voice, ShortTone, Noise };
+
+/**
+ * @brief Result of running one scenario.
+ */
+struct ScenarioResult {
+    std::size_t detected{0}; ///< Trials where the howl was reported.
+    double latency{0.0}; ///< Mean number of spectra before the howl was reported.
+    double error{0.0}; ///< Mean absolute error of the reported frequency, in Hz.
+    std::size_t falseHowls{0}; ///< Spectra with a howl reported away from the true one.
+};
+
+/**
+ * @brief Runs the trials of a scenario.
+ *
+ * A howl grows by 1 dB per spectrum from 30 dB below its final amplitude. A voice has a
+ * fundamental between 100 and 300 Hz with a 1 % vibrato. The short tone lasts 3 spectra.
+ *
+ * @param scenario The scenario.
+ * @return The detection statistics.
+ */
+static ScenarioResult runScenario(const Scenario scenario) {
+    std::mt19937 rng{7};
+    std::uniform_real_distribution<float> howlFrequency{300.0f, 7000.0f};
+    std::uniform_real_distribution<float> voiceFrequency{100.0f, 300.0f};
+    HowlDetector<float> detector{BINS, BIN_WIDTH};
+    float magnitude[BINS];
+    ScenarioResult result;
+
+    for (std::size_t trial = 0; trial < TRIALS; ++trial) {
+        detector.reset();
+        const float howl = howlFrequency(rng);
+        const float voice = voiceFrequency(rng);
+        const bool hasHowl = scenario == Scenario::Howl || scenario == Scenario::HowlOverVoice;
+        bool found = false;
+
+        for (std::size_t frame = 0; frame < FRAMES; ++frame) {
+            std::vector<Tone> tones;
+            if (hasHowl) {
+                tones.push_back({howl, 0.1f * std::pow(10.0f, -std::max(0.0f, 30.0f - static_cast<float>(frame)) / 20.0f)});
+            }
+            if (scenario == Scenario::HowlOverVoice || scenario == Scenario::Voice) {
+                addVoice(voice * (1.0f + 0.01f * std::sin(0.7f * static_cast<float>(frame))), 0.05f, tones);
+            }
+            if (scenario == Scenario::ShortTone && frame >= 10 && frame < 13) {
+                tones.push_back({howl, 0.1f});
+            }
+            makeSpectrum(tones, rng, magnitude);
+            detector.analyze(magnitude);
+
+            float howls[HowlDetector<float>::MAX_CANDIDATES];
+            const std::size_t count = detector.getHowls(howls, HowlDetector<float>::MAX_CANDIDATES);
+            bool falseHowl = false;
+            for (std::size_t i = 0; i < count; ++i) {
+                const float error = std::abs(howls[i] - howl);
+                if (hasHowl && error <= BIN_WIDTH) {
+                    if (!found) {
+                        found = true;
+                        ++result.detected;
+                        result.latency += static_cast<double>(frame + 1);
+                        result.error += error;
+                    }
+                } else {
+                    falseHowl = true;
+                }
+            }
+            if (falseHowl) ++result.falseHowls;
+        }
+    }
+
+    if (result.detected > 0) {
+        result.latency /= static_cast<double>(result.detected);
+        result.error /= static_cast<double>(result.detected);
+    }
+    return result;
+}
+
+/**
+ * @brief Measures the cost of HowlDetector::analyze in nanoseconds per spectrum.
+ *
+ * @return The cost in nanoseconds per spectrum.
+ */
+static double benchAnalyze() {
+    std::mt19937 rng{11};
+    std::vector<Tone> tones{{1234.0f, 0.1f}};
+    addVoice(180.0f, 0.05f, tones);
+    float magnitude[BINS];
+    makeSpectrum(tones, rng, magnitude);
+
+    HowlDetector<float> detector{BINS, BIN_WIDTH};
+    constexpr std::size_t runs{20000};
+    volatile float sink{0.0f};
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < runs; ++i) {
+        detector.analyze(magnitude);
+        float howls[HowlDetector<float>::MAX_CANDIDATES];
+        sink = sink + static_cast<float>(detector.getHowls(howls, HowlDetector<float>::MAX_CANDIDATES));
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / static_cast<double>(runs);
+}
+
+/**
+ * @brief Prints one row of the result table.
+ *
+ * @param name The name of the scenario.
+ * @param result The run of the scenario.
+ */
+static void printRow(const char* name, const ScenarioResult& result) {
+    std::printf("%16s %12.1f %14.1f %14.2f %14.2f\n", name, 100.0 * static_cast<double>(result.detected) / TRIALS,
+                result.latency, result.error, static_cast<double>(result.falseHowls) / TRIALS);
+}
+
+int main() {
+    std::printf("%zu trials of %zu spectra, %.2f Hz per bin\n", TRIALS, FRAMES, static_cast<double>(BIN_WIDTH));
+    std::printf("%16s %12s %14s %14s %14s\n", "scenario", "found (%)", "latency (fr)", "error (Hz)", "false/trial");
+    printRow("howl", runScenario(Scenario::Howl));
+    printRow("howl over voice", runScenario(Scenario::HowlOverVoice));
+    printRow("voice", runScenario(Scenario::Voice));
+    printRow("short tone", runScenario(Scenario::ShortTone));
+    printRow("noise", runScenario(Scenario::Noise));
+    std::printf("\nanalyze + getHowls: %.0f ns per spectrum\n", benchAnalyze());
+    return 0;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file lms_bench.cpp
+ * @brief Host microbenchmark for LMSFilter::tick and LMSFilter::processBlock.
+ *
+ * Build and run with the host Makefile:
+ *   make -C host lms_bench && host/build/lms_bench
+ */
+#include "LMSFilter.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+constexpr std::size_t BLOCK_SAMPLES{128}; ///< Matches AUDIO_BLOCK_SAMPLES on the Teensy.
+constexpr std::size_t TOTAL_SAMPLES{1 << 18}; ///< Samples processed per measurement.
+
+/**
+ * @brief Generates a deterministic test signal: a tone plus white noise.
+ *
+ * @param n The number of samples.
+ * @return The generated signal.
+ */
+static std::vector<float> makeSignal(const std::size_t n) {
+    std::mt19937 rng{1234};
+    std::normal_distribution<float> noise{0.0f, 0.05f};
+    std::vector<float> signal(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        signal[i] = 0.5f * std::sin(0.07f * static_cast<float>(i)) + noise(rng);
+    }
+    return signal;
+}
+
+/**
+ * @brief Measures the cost of LMSFilter::tick in nanoseconds per sample.
+ *
+ * @param order The order of the filter.
+ * @param signal The input signal.
+ * @return The cost in nanoseconds per sample.
+ */
+static double benchTick(const std::size_t order, const std::vector<float>& signal) {
+    LMSFilter<float> filter{order};
+    volatile float sink{0.0f};
+
+    const auto start = std::chrono::steady_clock::now();
+    for (const float sample : signal) {
+        sink = sink + filter.tick(sample);
+    }
+    const auto stop = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(stop - start).count() / static_cast<double>(signal.size());
+}
+
+/**
+ * @brief Measures the cost of LMSFilter::processBlock in nanoseconds per sample.
+ *
+ * @param order The order of the filter.
+ * @param signal The input signal.
+ * @return The cost in nanoseconds per sample.
+ */
+static double benchBlock(const std::size_t order, const std::vector<float>& signal) {
+    LMSFilter<float> filter{order};
+    std::vector<float> output(BLOCK_SAMPLES);
+    volatile float sink{0.0f};
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t offset = 0; offset + BLOCK_SAMPLES <= signal.size(); offset += BLOCK_SAMPLES) {
+        filter.processBlock(signal.data() + offset, output.data(), BLOCK_SAMPLES);
+        sink = sink + output[0];
+    }
+    const auto stop = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(stop - start).count() / static_cast<double>(signal.size());
+}
+
+int main() {
+    const std::vector<float> signal = makeSignal(TOTAL_SAMPLES);
+
+    std::printf("%8s %14s %14s\n", "order", "tick ns/smp", "block ns/smp");
+    for (std::size_t order = 32; order <= 1024; order *= 2) {
+        const double tickCost = benchTick(order, signal);
+        const double blockCost = benchBlock(order, signal);
+        std::printf("%8zu %14.2f %14.2f\n", order, tickCost, blockCost);
+    }
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file multichannel_bench.cpp
+ * @brief Host microbenchmark of the multichannel LMSFilter and AdaptiveFeedbackCanceller.
+ *
+ * Runs 1, 2 and 4 channels through one filter and reports the cost per sample of each channel,
+ * which falls as the channels share the loops over the taps. The LMS filter is timed alone for
+ * several orders, then the whole canceller through update(), as the firmware runs it.
+ *
+ * Build and run with the host Makefile:
+ *   make -C host multichannel_bench && host/build/multichannel_bench
+ */
+#include "AdaptiveFeedbackCanceller.h"
+#include "LMSFilter.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+constexpr std::size_t BLOCK_SAMPLES{128}; ///< Matches AUDIO_BLOCK_SAMPLES on the Teensy.
+constexpr std::size_t TOTAL_SAMPLES{1 << 17}; ///< Samples of each channel processed per measurement.
+constexpr std::size_t MAX_CHANNELS{4}; ///< Largest number of channels measured.
+
+/**
+ * @brief Generates a deterministic test signal per channel: a tone plus white noise.
+ *
+ * @param n The number of samples of each channel.
+ * @return The signal of each channel.
+ */
+static std::vector<std::vector<float>> makeSignals(const std::size_t n) {
+    std::mt19937 rng{1234};
+    std::normal_distribution<float> noise{0.0f, 0.05f};
+    std::vector<std::vector<float>> signals(MAX_CHANNELS, std::vector<float>(n));
+    for (std::size_t channel = 0; channel < MAX_CHANNELS; ++channel) {
+        const float frequency = 0.07f + 0.01f * static_cast<float>(channel);
+        for (std::size_t i = 0; i < n; ++i) {
+            signals[channel][i] = 0.5f * std::sin(frequency * static_cast<float>(i)) + noise(rng);
+        }
+    }
+    return signals;
+}
+
+/**
+ * @brief Measures the cost of LMSFilter::processBlock in nanoseconds per sample of each channel.
+ *
+ * @tparam Channels The number of channels of the filter.
+ * @param order The order of the filter.
+ * @param signals The input signal of each channel.
+ * @return The cost in nanoseconds per sample of each channel.
+ */
+template<std::size_t Channels>
+static double benchLMS(const std::size_t order, const std::vector<std::vector<float>>& signals) {
+    LMSFilter<float, Channels> filter{order};
+    std::vector<float> output(Channels * BLOCK_SAMPLES);
+    const float* in[Channels];
+    float* out[Channels];
+    volatile float sink{0.0f};
+
+    const std::size_t n = signals[0].size();
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t offset = 0; offset + BLOCK_SAMPLES <= n; offset += BLOCK_SAMPLES) {
+        for (std::size_t channel = 0; channel < Channels; ++channel) {
+            in[channel] = signals[channel].data() + offset;
+            out[channel] = output.data() + channel * BLOCK_SAMPLES;
+        }
+        filter.processBlock(in, out, BLOCK_SAMPLES);
+        sink = sink + output[0];
+    }
+    const auto stop = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(stop - start).count() / static_cast<double>(n * Channels);
+}
+
+/**
+ * @brief Measures the cost of AdaptiveFeedbackCanceller::update in nanoseconds per sample of each channel.
+ *
+ * @tparam Channels The number of channels of the canceller.
+ * @param signals The input signal of each channel.
+ * @return The cost in nanoseconds per sample of each channel.
+ */
+template<std::size_t Channels>
+static double benchCanceller(const std::vector<std::vector<float>>& signals) {
+    auto canceller = std::make_unique<AdaptiveFeedbackCanceller<Channels>>();
+    std::chrono::steady_clock::duration elapsed{};
+
+    const std::size_t n = signals[0].size();
+    for (std::size_t offset = 0; offset + AUDIO_BLOCK_SAMPLES <= n; offset += AUDIO_BLOCK_SAMPLES) {
+        for (std::size_t channel = 0; channel < Channels; ++channel) {
+            audio_block_t* block = AudioStream::allocate();
+            for (std::size_t i = 0; i < AUDIO_BLOCK_SAMPLES; ++i) {
+                block->data[i] = static_cast<std::int16_t>(signals[channel][offset + i] * 16384.0f);
+            }
+            canceller->setInputBlock(block, channel);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        canceller->update();
+        elapsed += std::chrono::steady_clock::now() - start;
+
+        for (std::size_t channel = 0; channel < Channels; ++channel) {
+            AudioStream::release(canceller->takeOutputBlock(channel));
+        }
+    }
+
+    return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(n * Channels);
+}
+
+int main() {
+    const std::vector<std::vector<float>> signals = makeSignals(TOTAL_SAMPLES);
+
+    std::printf("LMSFilter<float, N>::processBlock, ns per sample per channel\n");
+    std::printf("%8s %10s %10s %10s\n", "order", "N=1", "N=2", "N=4");
+    for (std::size_t order = 32; order <= 512; order *= 2) {
+        const double one = benchLMS<1>(order, signals);
+        const double two = benchLMS<2>(order, signals);
+        const double four = benchLMS<4>(order, signals);
+        std::printf("%8zu %10.2f %10.2f %10.2f\n", order, one, two, four);
+    }
+
+#if !defined(AFC_FDAF) && !defined(AFC_SUBBAND)
+    std::printf("\nAdaptiveFeedbackCanceller<N>::update, ns per sample per channel\n");
+    std::printf("%8s %10s %10s %10s\n", "order", "N=1", "N=2", "N=4");
+    std::printf("%8zu %10.2f %10.2f %10.2f\n", afcFilterOrder, benchCanceller<1>(signals), benchCanceller<2>(signals),
+                benchCanceller<4>(signals));
+#endif
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file notch_bench.cpp
+ * @brief Host benchmark for NotchBank::processBlock as the number of notches grows.
+ *
+ * For 1 to NotchBank::MAX_NOTCHES allocated notches the benchmark reports the cost per sample
+ * of the pipelined bank and of the same number of NotchFilter objects ticked one after the other.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++17 -O2 -Isrc -Ihost/include host/bench/notch_bench.cpp src/NotchBank.cpp \
+ *       src/NotchFilter.cpp src/TrigTable.cpp -o notch_bench && ./notch_bench
+ */
+#include "NotchBank.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+constexpr std::size_t BLOCK_SAMPLES{AUDIO_BLOCK_SAMPLES}; ///< Samples per processed block.
+constexpr std::size_t TOTAL_SAMPLES{1 << 18}; ///< Samples processed per measurement.
+
+/**
+ * @brief Generates a deterministic test signal: a tone plus white noise.
+ *
+ * @param n The number of samples.
+ * @return The generated signal.
+ */
+static std::vector<float> makeSignal(const std::size_t n) {
+    std::mt19937 rng{1234};
+    std::normal_distribution<float> noise{0.0f, 0.05f};
+    std::vector<float> signal(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        signal[i] = 0.5f * std::sin(0.07f * static_cast<float>(i)) + noise(rng);
+    }
+    return signal;
+}
+
+/**
+ * @brief Gives notch i a frequency spread over the audio band.
+ *
+ * @param i The index of the notch.
+ * @return The center frequency of the notch.
+ */
+static float notchFrequency(const std::size_t i) {
+    return 200.0f * std::pow(1.25f, static_cast<float>(i));
+}
+
+/**
+ * @brief Measures the cost of NotchBank::processBlock in nanoseconds per sample.
+ *
+ * @param notches The number of allocated notches.
+ * @param signal The input signal.
+ * @return The cost in nanoseconds per sample.
+ */
+static double benchBank(const std::size_t notches, const std::vector<float>& signal) {
+    NotchBank<float> bank{notches};
+    for (std::size_t i = 0; i < notches; ++i) {
+        bank.setNotch(i, notchFrequency(i), NotchBank<float>::bandwidthFor(notchFrequency(i)));
+    }
+    std::vector<float> output(signal.size());
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t offset = 0; offset < signal.size(); offset += BLOCK_SAMPLES) {
+        bank.processBlock(signal.data() + offset, output.data() + offset, BLOCK_SAMPLES);
+    }
+    const auto stop = std::chrono::steady_clock::now();
+
+    volatile float sink = output.back();
+    (void)sink;
+    return std::chrono::duration<double, std::nano>(stop - start).count() / static_cast<double>(signal.size());
+}
+
+/**
+ * @brief Measures the cost of cascaded NotchFilter::tick calls in nanoseconds per sample.
+ *
+ * @param notches The number of cascaded notches.
+ * @param signal The input signal.
+ * @return The cost in nanoseconds per sample.
+ */
+static double benchCascade(const std::size_t notches, const std::vector<float>& signal) {
+    std::vector<NotchFilter<float>> filters;
+    for (std::size_t i = 0; i < notches; ++i) {
+        filters.emplace_back(notchFrequency(i), NotchBank<float>::bandwidthFor(notchFrequency(i)));
+    }
+    std::vector<float> output(signal.size());
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < signal.size(); ++i) {
+        float sample = signal[i];
+        for (NotchFilter<float>& filter : filters) {
+            sample = filter.tick(sample);
+        }
+        output[i] = sample;
+    }
+    const auto stop = std::chrono::steady_clock::now();
+
+    volatile float sink = output.back();
+    (void)sink;
+    return std::chrono::duration<double, std::nano>(stop - start).count() / static_cast<double>(signal.size());
+}
+
+int main() {
+    const std::vector<float> signal = makeSignal(TOTAL_SAMPLES);
+
+    std::printf("%8s %16s %16s\n", "notches", "cascade ns/smp", "bank ns/smp");
+    for (std::size_t notches = 1; notches <= NotchBank<float>::MAX_NOTCHES; ++notches) {
+        std::printf("%8zu %16.2f %16.2f\n", notches, benchCascade(notches, signal), benchBank(notches, signal));
+    }
+
+    return 0;
+}
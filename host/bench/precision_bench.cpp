@@ -0,0 +1,142 @@
+/**
+ * @file precision_bench.cpp
+ * @brief Host harness comparing the float, Q15 and Q31 builds of NotchLMSFilter to the double reference.
+ *
+ * For each sample type the harness reports the output SNR against the double
+ * reference and the cost of one AUDIO_BLOCK_SAMPLES block.
+ *
+ * Build and run with the host Makefile:
+ *   make -C host precision_bench && host/build/precision_bench
+ */
+#include "NotchLMSFilter.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+constexpr std::size_t BLOCK_SAMPLES{AUDIO_BLOCK_SAMPLES}; ///< Samples per processed block.
+constexpr std::size_t BLOCK_COUNT{2048}; ///< Number of blocks processed per variant.
+
+/**
+ * @brief Reads a timestamp in CPU cycles, or in nanoseconds where no cycle counter is available.
+ *
+ * @return The current timestamp.
+ */
+static std::uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/**
+ * @brief Generates the 16-bit test input: a howling tone, a second tone and white noise.
+ *
+ * @param n The number of samples.
+ * @return The generated signal.
+ */
+static std::vector<std::int16_t> makeInput(const std::size_t n) {
+    std::mt19937 rng{42};
+    std::normal_distribution<double> noise{0.0, 0.05};
+    std::vector<std::int16_t> input(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        const double t = static_cast<double>(i) / AUDIO_SAMPLE_RATE_EXACT;
+        const double x = 0.3 * std::sin(2.0 * M_PI * 2750.0 * t) + 0.2 * std::sin(2.0 * M_PI * 440.0 * t) + noise(rng);
+        input[i] = static_cast<std::int16_t>(std::lround(std::max(-1.0, std::min(1.0, x)) * 32767.0));
+    }
+    return input;
+}
+
+/**
+ * @brief Result of running one variant of the chain.
+ */
+struct VariantResult {
+    std::vector<double> output; ///< Output signal, converted to real values.
+    double cyclesPerBlock{0.0}; ///< Mean cost of one block.
+};
+
+/**
+ * @brief Runs the NotchLMSFilter chain built for the sample type T over the input.
+ *
+ * @tparam T The sample type.
+ * @param input The 16-bit input signal.
+ * @return The output signal and the mean cost per block.
+ */
+template<typename T>
+static VariantResult runVariant(const std::vector<std::int16_t>& input) {
+    using Traits = SampleTraits<T>;
+
+    NotchLMSFilter<T> filter{64, 2750, 100};
+    VariantResult result;
+    result.output.resize(input.size());
+
+    T block[BLOCK_SAMPLES];
+    std::uint64_t cycles{0};
+
+    for (std::size_t offset = 0; offset + BLOCK_SAMPLES <= input.size(); offset += BLOCK_SAMPLES) {
+        for (std::size_t i = 0; i < BLOCK_SAMPLES; ++i) {
+            block[i] = Traits::fromInt16(input[offset + i]);
+        }
+
+        const std::uint64_t start = readCycles();
+        filter.processBlock(block, block, BLOCK_SAMPLES);
+        cycles += readCycles() - start;
+
+        for (std::size_t i = 0; i < BLOCK_SAMPLES; ++i) {
+            result.output[offset + i] = static_cast<double>(Traits::toReal(block[i]));
+        }
+    }
+
+    result.cyclesPerBlock = static_cast<double>(cycles) / static_cast<double>(input.size() / BLOCK_SAMPLES);
+    return result;
+}
+
+/**
+ * @brief Computes the SNR of a signal against a reference, in dB.
+ *
+ * @param reference The reference signal.
+ * @param signal The signal under test.
+ * @return The SNR in dB.
+ */
+static double computeSnr(const std::vector<double>& reference, const std::vector<double>& signal) {
+    double signalPower{0.0}, noisePower{0.0};
+    for (std::size_t i = 0; i < reference.size(); ++i) {
+        signalPower += reference[i] * reference[i];
+        noisePower += (reference[i] - signal[i]) * (reference[i] - signal[i]);
+    }
+    if (noisePower == 0.0) return INFINITY;
+    return 10.0 * std::log10(signalPower / noisePower);
+}
+
+/**
+ * @brief Prints one row of the result table.
+ *
+ * @param name The name of the variant.
+ * @param reference The double reference run.
+ * @param result The run of the variant.
+ */
+static void printRow(const char* name, const VariantResult& reference, const VariantResult& result) {
+    std::printf("%8s %12.1f %16.0f\n", name, computeSnr(reference.output, result.output), result.cyclesPerBlock);
+}
+
+int main() {
+    const std::vector<std::int16_t> input = makeInput(BLOCK_SAMPLES * BLOCK_COUNT);
+
+    const VariantResult reference = runVariant<double>(input);
+
+    std::printf("%8s %12s %16s\n", "type", "SNR (dB)", "cycles/block");
+    printRow("double", reference, reference);
+    printRow("float", reference, runVariant<float>(input));
+    printRow("q31", reference, runVariant<q31_t>(input));
+    printRow("q15", reference, runVariant<q15_t>(input));
+
+    return 0;
+}
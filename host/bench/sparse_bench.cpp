@@ -0,0 +1,213 @@
+/**
+ * @file sparse_bench.cpp
+ * @brief Host benchmark of the proportionate NLMS algorithm and the bulk delay on sparse feedback paths.
+ *
+ * Each synthetic path is a bulk delay of half the filter length followed by a direct echo and a
+ * few reflections in the next ACTIVE_TAPS taps, plus measurement noise 40 dB below the echo. For
+ * each length the benchmark identifies the path, excited by white noise, then by coloured noise,
+ * with NLMS and IPNLMS over the whole length, then with NLMS and IPNLMS of ACTIVE_TAPS taps
+ * placed after the bulk delay found by a BulkDelayEstimator. It reports the cost per sample,
+ * estimator included, the time needed to reach 30 dB of echo return loss enhancement (ERLE) and
+ * the ERLE reached at the end of the run.
+ *
+ * Build and run with the host Makefile:
+ *   make -C host sparse_bench && host/build/sparse_bench
+ */
+#include "BulkDelayEstimator.h"
+#include "LMSFilter.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+constexpr double SAMPLE_RATE{44117.64706}; ///< Sample rate of the Teensy audio library.
+constexpr std::size_t BLOCK_SAMPLES{128}; ///< Samples per processed block.
+constexpr std::size_t ERLE_WINDOW{1024}; ///< Window over which the ERLE is measured.
+constexpr double TARGET_ERLE_DB{30.0}; ///< ERLE at which the filter is considered converged.
+constexpr std::size_t RUN_SAMPLES{static_cast<std::size_t>(SAMPLE_RATE * 5.0)}; ///< Length of a simulated run.
+constexpr std::size_t ACTIVE_TAPS{128}; ///< Length of the active region of the paths.
+constexpr std::size_t REFLECTIONS{6}; ///< Number of reflections after the direct echo.
+constexpr std::size_t DELAY_MARGIN{8}; ///< Taps kept ahead of the estimated bulk delay.
+constexpr float NOISE_LEVEL{0.3f}; ///< RMS level of the excitation.
+constexpr float MEASUREMENT_NOISE_DB{-40.0f}; ///< Level of the measurement noise relative to the echo.
+constexpr float COLOUR_POLE{0.95f}; ///< Pole of the first-order filter colouring the noise.
+constexpr float STEP{0.5f}; ///< Adaptation rate of every filter.
+
+/**
+ * @brief Generates a sparse feedback path: a bulk delay, a direct echo and decaying reflections.
+ *
+ * @param length The number of taps.
+ * @param delay The bulk delay, in samples.
+ * @param rng The random number generator.
+ * @return The impulse response.
+ */
+static std::vector<float> makeSparsePath(const std::size_t length, const std::size_t delay, std::mt19937& rng) {
+    std::uniform_int_distribution<std::size_t> position{1, ACTIVE_TAPS - 1};
+    std::uniform_real_distribution<float> amplitude{0.2f, 0.6f};
+    std::bernoulli_distribution sign;
+
+    std::vector<float> path(length, 0.0f);
+    path[delay] = 0.25f;
+    for (std::size_t i = 0; i < REFLECTIONS; ++i) {
+        const std::size_t offset = position(rng);
+        const float decay = std::exp(-3.0f * static_cast<float>(offset) / static_cast<float>(ACTIVE_TAPS));
+        path[delay + offset] += (sign(rng) ? 0.25f : -0.25f) * amplitude(rng) * decay;
+    }
+    return path;
+}
+
+/**
+ * @brief Result of identifying a path with one adaptive filter.
+ */
+struct RunResult {
+    double nsPerSample{0.0}; ///< Cost of the adaptive filter and the estimator per sample.
+    double convergenceMs{-1.0}; ///< Time to reach the target ERLE, or -1 if never reached.
+    double finalErle{0.0}; ///< ERLE over the last window of the run, in dB.
+    std::size_t delay{0}; ///< Bulk delay of the filter at the end of the run.
+};
+
+/**
+ * @brief Identifies a feedback path with an adaptive filter.
+ *
+ * @tparam Filter The adaptive filter type.
+ * @param filter The adaptive filter.
+ * @param path The impulse response to identify.
+ * @param coloured True to excite the path with coloured noise instead of white noise.
+ * @param estimator The estimator setting the bulk delay of the filter, or nullptr.
+ * @return The cost, convergence time and ERLE.
+ */
+template<typename Filter>
+static RunResult identify(Filter& filter, const std::vector<float>& path, const bool coloured, BulkDelayEstimator<float>* estimator) {
+    std::mt19937 rng{7};
+    const float gain = coloured ? NOISE_LEVEL * std::sqrt(1.0f - COLOUR_POLE * COLOUR_POLE) : NOISE_LEVEL;
+    std::normal_distribution<float> noise{0.0f, gain};
+    double pathEnergy{0.0};
+    for (const float tap : path) pathEnergy += static_cast<double>(tap) * tap;
+    const auto measurementLevel = static_cast<float>(NOISE_LEVEL * std::sqrt(pathEnergy) * std::pow(10.0, MEASUREMENT_NOISE_DB / 20.0));
+    std::normal_distribution<float> measurement{0.0f, measurementLevel};
+    float colour{0.0f};
+
+    std::vector<float> history(path.size(), 0.0f);
+    std::size_t historyIndex{0};
+    float reference[BLOCK_SAMPLES], desired[BLOCK_SAMPLES], echo[BLOCK_SAMPLES], error[BLOCK_SAMPLES];
+
+    RunResult result;
+    double echoEnergy{0.0}, residualEnergy{0.0}, elapsedNs{0.0};
+    std::size_t windowFill{0};
+
+    for (std::size_t offset = 0; offset < RUN_SAMPLES; offset += BLOCK_SAMPLES) {
+        for (std::size_t i = 0; i < BLOCK_SAMPLES; ++i) {
+            colour = (coloured ? COLOUR_POLE * colour : 0.0f) + noise(rng);
+            reference[i] = colour;
+            history[historyIndex] = reference[i];
+            float sum{0.0f};
+            for (std::size_t k = 0; k < path.size(); ++k) {
+                sum += path[k] * history[(historyIndex + path.size() - k) % path.size()];
+            }
+            historyIndex = (historyIndex + 1) % path.size();
+            echo[i] = sum;
+            desired[i] = sum + measurement(rng);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        if (estimator) {
+            estimator->process(reference, desired, BLOCK_SAMPLES);
+            std::size_t delay;
+            if (estimator->estimate(delay)) filter.setBulkDelay(delay > DELAY_MARGIN ? delay - DELAY_MARGIN : 0);
+        }
+        filter.processBlock(reference, desired, error, BLOCK_SAMPLES);
+        elapsedNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        for (std::size_t i = 0; i < BLOCK_SAMPLES; ++i) {
+            const float residual = error[i] - (desired[i] - echo[i]);
+            echoEnergy += static_cast<double>(echo[i]) * echo[i];
+            residualEnergy += static_cast<double>(residual) * residual;
+        }
+        windowFill += BLOCK_SAMPLES;
+
+        if (windowFill >= ERLE_WINDOW) {
+            result.finalErle = 10.0 * std::log10(echoEnergy / (residualEnergy + 1e-20));
+            if (result.convergenceMs < 0.0 && result.finalErle >= TARGET_ERLE_DB) {
+                result.convergenceMs = 1000.0 * static_cast<double>(offset + BLOCK_SAMPLES) / SAMPLE_RATE;
+            }
+            echoEnergy = residualEnergy = 0.0;
+            windowFill = 0;
+        }
+    }
+
+    result.nsPerSample = elapsedNs / static_cast<double>(RUN_SAMPLES);
+    result.delay = filter.getBulkDelay();
+    return result;
+}
+
+/**
+ * @brief Formats a convergence time for the result table.
+ *
+ * @param buffer The output buffer.
+ * @param size The size of the output buffer.
+ * @param ms The convergence time, or -1 if never reached.
+ * @return The formatted string.
+ */
+static const char* formatConvergence(char* buffer, const std::size_t size, const double ms) {
+    if (ms < 0.0) {
+        std::snprintf(buffer, size, "> %.0f", 1000.0 * static_cast<double>(RUN_SAMPLES) / SAMPLE_RATE);
+    } else {
+        std::snprintf(buffer, size, "%.0f", ms);
+    }
+    return buffer;
+}
+
+/**
+ * @brief Prints a row of the result table.
+ *
+ * @param name The name of the filter.
+ * @param taps The number of taps of the filter.
+ * @param result The result of the run.
+ */
+static void printRow(const char* name, const std::size_t taps, const RunResult& result) {
+    char text[32];
+    std::printf("%-16s %6zu %6zu %10.1f %12s %10.1f\n", name, taps, result.delay, result.nsPerSample,
+                formatConvergence(text, sizeof(text), result.convergenceMs), result.finalErle);
+}
+
+int main() {
+    using NLMS = LMSFilter<float, 1, NLMSUpdate, FixedStep>;
+    using IPNLMS = LMSFilter<float, 1, ProportionateUpdate, FixedStep>;
+
+    for (const std::size_t length : {256, 512, 1024}) {
+        for (const bool coloured : {false, true}) {
+            std::mt19937 rng{2024};
+            const std::vector<float> path = makeSparsePath(length, length / 2, rng);
+            std::printf("\n%zu taps, bulk delay %zu, %s noise\n", length, length / 2, coloured ? "coloured" : "white");
+            std::printf("%-16s %6s %6s %10s %12s %10s\n", "filter", "taps", "delay", "ns/smp", "30dB ms", "ERLE");
+
+            {
+                NLMS filter{length, STEP};
+                printRow("NLMS", length, identify(filter, path, coloured, nullptr));
+            }
+            {
+                IPNLMS filter{length, STEP};
+                printRow("IPNLMS", length, identify(filter, path, coloured, nullptr));
+            }
+            {
+                IPNLMS filter{length, STEP};
+                filter.getUpdate().setProportionality(0.9f);
+                printRow("IPNLMS a=0.9", length, identify(filter, path, coloured, nullptr));
+            }
+            {
+                NLMS filter{ACTIVE_TAPS, STEP, length};
+                BulkDelayEstimator<float> estimator{length};
+                printRow("NLMS + delay", ACTIVE_TAPS, identify(filter, path, coloured, &estimator));
+            }
+            {
+                IPNLMS filter{ACTIVE_TAPS, STEP, length};
+                BulkDelayEstimator<float> estimator{length};
+                printRow("IPNLMS + delay", ACTIVE_TAPS, identify(filter, path, coloured, &estimator));
+            }
+        }
+    }
+
+    return 0;
+}
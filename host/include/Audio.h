@@ -0,0 +1,165 @@
+#ifndef HOST_AUDIO_H
+#define HOST_AUDIO_H
+
+/**
+ * @file Audio.h
+ * @brief Host stand-in for the parts of the Teensy Audio library used by the DSP classes.
+ *
+ * AudioStream keeps the interface the firmware objects use (receiveReadOnly, allocate, transmit
+ * and release) on top of heap-allocated blocks. There is no audio graph: a host harness hands
+ * a block to an object with setInputBlock(), calls update() and collects the transmitted block
+ * with takeOutputBlock().
+ *
+ * As in the library, the block size and the sample rate can be set when building, for example
+ * with -DAUDIO_BLOCK_SAMPLES=16 for the small-block configuration.
+ */
+
+#include <algorithm>
+#include <cstdint>
+
+#ifndef AUDIO_SAMPLE_RATE_EXACT
+#define AUDIO_SAMPLE_RATE_EXACT 44117.64706f ///< Sample rate of the Teensy audio library, overridable as in the library.
+#endif
+#ifndef AUDIO_BLOCK_SAMPLES
+#define AUDIO_BLOCK_SAMPLES 128 ///< Number of samples in an audio block, overridable as in the library.
+#endif
+
+/**
+ * @brief A block of audio samples, reference counted as in the Teensy Audio library.
+ */
+struct audio_block_t {
+    std::uint8_t ref_count; ///< Number of owners of the block.
+    std::uint8_t reserved1; ///< Unused.
+    std::uint16_t memory_pool_index; ///< Unused on the host.
+    std::int16_t data[AUDIO_BLOCK_SAMPLES]; ///< The samples.
+};
+
+/**
+ * @brief The AudioStream class is the base of the objects of an audio graph.
+ */
+class AudioStream {
+public:
+    static constexpr unsigned int MAX_OUTPUTS = 8; ///< Number of output channels a host object can transmit on.
+
+    /**
+     * @brief Constructs an AudioStream object.
+     *
+     * @param ninput The number of inputs.
+     * @param iqueue The input queue, one block per input.
+     */
+    AudioStream(const unsigned char ninput, audio_block_t** iqueue) : inputQueue(iqueue), numInputs(ninput) {
+        for (unsigned char i = 0; i < numInputs; ++i) inputQueue[i] = nullptr;
+    }
+
+    /**
+     * @brief Destroys the AudioStream object and releases the blocks it still holds.
+     */
+    virtual ~AudioStream() {
+        for (unsigned char i = 0; i < numInputs; ++i) release(inputQueue[i]);
+        for (audio_block_t*& block : outputs) release(block);
+    }
+
+    AudioStream(const AudioStream&) = delete;
+    AudioStream& operator=(const AudioStream&) = delete;
+
+    /**
+     * @brief Processes the pending input blocks.
+     */
+    virtual void update() = 0;
+
+    /**
+     * @brief Allocates a block.
+     *
+     * @return The block, owned once.
+     */
+    static audio_block_t* allocate() {
+        auto* block = new audio_block_t{};
+        block->ref_count = 1;
+        return block;
+    }
+
+    /**
+     * @brief Gives up one ownership of a block, freeing it with the last one.
+     *
+     * @param block The block, or nullptr.
+     */
+    static void release(audio_block_t* block) {
+        if (block && --block->ref_count == 0) delete block;
+    }
+
+    /**
+     * @brief Queues a block on an input, for the next update(). Host only.
+     *
+     * @param block The block; the stream takes over its ownership.
+     * @param index The input.
+     */
+    void setInputBlock(audio_block_t* block, const unsigned int index = 0) {
+        release(inputQueue[index]);
+        inputQueue[index] = block;
+    }
+
+    /**
+     * @brief Takes the block transmitted on an output by the last update(). Host only.
+     *
+     * @param index The output.
+     * @return The block, owned by the caller, or nullptr if none was transmitted.
+     */
+    audio_block_t* takeOutputBlock(const unsigned int index = 0) {
+        audio_block_t* block = outputs[index];
+        outputs[index] = nullptr;
+        return block;
+    }
+
+protected:
+    /**
+     * @brief Takes the pending block of an input.
+     *
+     * @param index The input.
+     * @return The block, owned by the caller, or nullptr if none is pending.
+     */
+    audio_block_t* receiveReadOnly(const unsigned int index = 0) {
+        if (index >= numInputs) return nullptr;
+        audio_block_t* block = inputQueue[index];
+        inputQueue[index] = nullptr;
+        return block;
+    }
+
+    /**
+     * @brief Takes the pending block of an input, to be modified in place.
+     *
+     * A block shared with another owner is copied first, as in the Teensy Audio library.
+     *
+     * @param index The input.
+     * @return The block, owned by the caller, or nullptr if none is pending.
+     */
+    audio_block_t* receiveWritable(const unsigned int index = 0) {
+        audio_block_t* block = receiveReadOnly(index);
+        if (block && block->ref_count > 1) {
+            audio_block_t* copy = allocate();
+            std::copy(block->data, block->data + AUDIO_BLOCK_SAMPLES, copy->data);
+            release(block);
+            block = copy;
+        }
+        return block;
+    }
+
+    /**
+     * @brief Transmits a block on an output. The caller keeps its own ownership.
+     *
+     * @param block The block.
+     * @param index The output.
+     */
+    void transmit(audio_block_t* block, const unsigned int index = 0) {
+        if (index >= MAX_OUTPUTS) return;
+        release(outputs[index]);
+        ++block->ref_count;
+        outputs[index] = block;
+    }
+
+private:
+    audio_block_t** inputQueue; ///< Pending block of each input.
+    unsigned char numInputs; ///< Number of inputs.
+    audio_block_t* outputs[MAX_OUTPUTS]{}; ///< Block transmitted on each output by the last update().
+};
+
+#endif
@@ -0,0 +1,616 @@
+#include "FeedbackLoop.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Quantizes a full-scale sample to 16 bits, saturating.
+ *
+ * @param x The sample.
+ * @return The 16-bit sample.
+ */
+static std::int16_t toInt16(const float x) {
+    const long sample = std::lround(x * 32768.0f);
+    return static_cast<std::int16_t>(std::max(-32768L, std::min(32767L, sample)));
+}
+
+/**
+ * @brief Scales a signal to an RMS level.
+ *
+ * @param samples The signal.
+ * @param level The RMS level.
+ */
+static void normalize(std::vector<float>& samples, const float level) {
+    double energy{0.0};
+    for (const float x : samples) energy += static_cast<double>(x) * x;
+    if (energy <= 0.0) return;
+    const auto scale = static_cast<float>(level / std::sqrt(energy / static_cast<double>(samples.size())));
+    for (float& x : samples) x *= scale;
+}
+
+/**
+ * @brief Constructs a FeedbackLoop object around a fresh canceller.
+ *
+ * @param path The impulse response from the loudspeaker to the microphone.
+ * @param settings The settings of the canceller.
+ * @param noiseLevel The RMS level of the noise at the microphone.
+ * @param seed The seed of the noise.
+ */
+FeedbackLoop::FeedbackLoop(const std::vector<float>& path, const LoopSettings& settings, const float noiseLevel, const unsigned int seed)
+    : canceller(std::make_unique<AdaptiveFeedbackCanceller<1>>()), path(path),
+      partitions(std::max<std::size_t>(1, (path.size() + AUDIO_BLOCK_SAMPLES - 1) / AUDIO_BLOCK_SAMPLES)),
+      rng(seed), noise(0.0f, noiseLevel), howlDetection(settings.howlDetector) {
+    canceller->setLMS(settings.lms);
+    canceller->setNotch(settings.notch);
+    canceller->setAdaptiveNotch(!settings.howlDetector);
+#if !defined(AFC_FDAF) && !defined(AFC_SUBBAND)
+    canceller->setAlgorithm(settings.algorithm);
+#endif
+
+    constexpr std::size_t bins = AUDIO_BLOCK_SAMPLES + 1;
+    pathSpectra.resize(partitions * bins);
+    playedSpectra.resize(partitions * bins);
+    float partition[2 * AUDIO_BLOCK_SAMPLES];
+    for (std::size_t p = 0; p < partitions; ++p) {
+        std::fill(partition, partition + 2 * AUDIO_BLOCK_SAMPLES, 0.0f);
+        for (std::size_t i = 0; i < AUDIO_BLOCK_SAMPLES && p * AUDIO_BLOCK_SAMPLES + i < path.size(); ++i) {
+            partition[i] = path[p * AUDIO_BLOCK_SAMPLES + i];
+        }
+        pathFft.forward(partition, pathSpectra.data() + p * bins);
+    }
+
+    window.resize(SPECTRUM_SIZE);
+    for (std::size_t i = 0; i < SPECTRUM_SIZE; ++i) {
+        window[i] = 0.5f - 0.5f * std::cos(2.0f * static_cast<float>(M_PI) * static_cast<float>(i) / SPECTRUM_SIZE);
+    }
+    history.assign(SPECTRUM_SIZE, 0.0f);
+    frame.resize(SPECTRUM_SIZE);
+    spectrum.resize(SPECTRUM_SIZE / 2 + 1);
+    magnitude.resize(SPECTRUM_SIZE / 2);
+}
+
+/**
+ * @brief Runs one block of the loop.
+ *
+ * @param source The AUDIO_BLOCK_SAMPLES samples of the source at the microphone.
+ * @param microphone The AUDIO_BLOCK_SAMPLES samples of the microphone, the input of the canceller.
+ * @param loudspeaker The AUDIO_BLOCK_SAMPLES samples of the canceller output, played during the next block.
+ */
+void FeedbackLoop::processBlock(const float* source, std::int16_t* microphone, std::int16_t* loudspeaker) {
+    listen(source, microphone);
+
+    audio_block_t* block = AudioStream::allocate();
+    std::copy(microphone, microphone + AUDIO_BLOCK_SAMPLES, block->data);
+    canceller->setInputBlock(block);
+
+    const std::uint32_t start = Profiler::cycles();
+    canceller->update();
+    updateCycles += static_cast<std::uint32_t>(Profiler::cycles() - start);
+    samples += AUDIO_BLOCK_SAMPLES;
+
+    probe.setInputBlock(canceller->takeOutputBlock());
+    probe.update();
+
+    if (audio_block_t* output = probe.takeOutputBlock()) {
+        std::copy(output->data, output->data + AUDIO_BLOCK_SAMPLES, loudspeaker);
+        AudioStream::release(output);
+    } else {
+        std::fill(loudspeaker, loudspeaker + AUDIO_BLOCK_SAMPLES, std::int16_t{0});
+    }
+    std::copy(loudspeaker, loudspeaker + AUDIO_BLOCK_SAMPLES, playing);
+
+    if (const FilterSnapshot* snapshot = canceller->acquireSnapshot()) {
+        measure(*snapshot);
+        canceller->releaseSnapshot();
+    }
+    if (howlDetection) analyze(loudspeaker);
+}
+
+/**
+ * @brief Computes the microphone signal of the current block.
+ *
+ * The block played by the loudspeaker is appended to the previous one and transformed; the
+ * spectra of the last partitions frames, each multiplied by the spectrum of its partition of the
+ * path, sum to the spectrum of the echo, whose last block is free of circular wrap-around.
+ *
+ * @param source The samples of the source.
+ * @param microphone The samples of the microphone, quantized to 16 bits.
+ */
+void FeedbackLoop::listen(const float* source, std::int16_t* microphone) {
+    constexpr std::size_t bins = AUDIO_BLOCK_SAMPLES + 1;
+    std::copy(playedFrame + AUDIO_BLOCK_SAMPLES, playedFrame + 2 * AUDIO_BLOCK_SAMPLES, playedFrame);
+    for (std::size_t i = 0; i < AUDIO_BLOCK_SAMPLES; ++i) {
+        playedFrame[AUDIO_BLOCK_SAMPLES + i] = static_cast<float>(playing[i]) / 32768.0f;
+    }
+    playedIndex = (playedIndex == 0 ? partitions : playedIndex) - 1;
+    pathFft.forward(playedFrame, playedSpectra.data() + playedIndex * bins);
+
+    complex_t sum[bins]{};
+    for (std::size_t p = 0; p < partitions; ++p) {
+        const complex_t* played = playedSpectra.data() + ((playedIndex + p) % partitions) * bins;
+        const complex_t* response = pathSpectra.data() + p * bins;
+        for (std::size_t k = 0; k < bins; ++k) {
+            sum[k] += played[k] * response[k];
+        }
+    }
+    pathFft.inverse(sum, echo);
+
+    for (std::size_t i = 0; i < AUDIO_BLOCK_SAMPLES; ++i) {
+        microphone[i] = toInt16(source[i] + echo[AUDIO_BLOCK_SAMPLES + i] + noise(rng));
+    }
+}
+
+/**
+ * @brief Analyses the output every SPECTRUM_PERIOD samples and hands the howls found to the canceller.
+ *
+ * The magnitudes are scaled as AudioAnalyzeFFT1024::read(): a full-scale tone centred on a bin
+ * reads 0.5.
+ *
+ * @param output The AUDIO_BLOCK_SAMPLES samples of the canceller output.
+ */
+void FeedbackLoop::analyze(const std::int16_t* output) {
+    std::copy(history.begin() + AUDIO_BLOCK_SAMPLES, history.end(), history.begin());
+    for (std::size_t i = 0; i < AUDIO_BLOCK_SAMPLES; ++i) {
+        history[SPECTRUM_SIZE - AUDIO_BLOCK_SAMPLES + i] = static_cast<float>(output[i]) / 32768.0f;
+    }
+    sinceSpectrum += AUDIO_BLOCK_SAMPLES;
+    if (sinceSpectrum < SPECTRUM_PERIOD) return;
+    sinceSpectrum = 0;
+
+    for (std::size_t i = 0; i < SPECTRUM_SIZE; ++i) {
+        frame[i] = history[i] * window[i];
+    }
+    spectrumFft.forward(frame.data(), spectrum.data());
+    for (std::size_t k = 0; k < magnitude.size(); ++k) {
+        magnitude[k] = 2.0f * std::abs(spectrum[k]) / SPECTRUM_SIZE;
+    }
+    howlDetector.analyze(magnitude.data());
+
+    float howls[ParameterUpdate::MAX_HOWLS];
+    canceller->trackHowls(howls, howlDetector.getHowls(howls, ParameterUpdate::MAX_HOWLS));
+}
+
+/**
+ * @brief Measures the misalignment from a snapshot of the adaptive filter.
+ *
+ * The taps beyond those of the snapshot are taken as zero.
+ *
+ * @param snapshot The snapshot.
+ */
+void FeedbackLoop::measure(const FilterSnapshot& snapshot) {
+    double energy{0.0}, error{0.0};
+    const std::size_t taps = std::max(afcSnapshotTaps, AUDIO_BLOCK_SAMPLES + path.size());
+    for (std::size_t k = 0; k < taps; ++k) {
+        const double target = k >= AUDIO_BLOCK_SAMPLES ? path[k - AUDIO_BLOCK_SAMPLES] : 0.0;
+        const double estimate = k < afcSnapshotTaps ? static_cast<double>(snapshot.taps[k]) : 0.0;
+        energy += target * target;
+        error += (target - estimate) * (target - estimate);
+    }
+    misalignment = energy > 0.0 ? 10.0 * std::log10(error / energy) : 0.0;
+}
+
+/**
+ * @brief Runs a scene with a gain held at startDb for holdSeconds, ramped in dB to gainDb over rampSeconds, then held.
+ *
+ * The feedback heard by the microphone, its signal less the source, is compared to the source
+ * every HOWL_WINDOW samples. The source level is that of the window or, if higher, its average
+ * over about a second, so that the reverberation in the pauses of speech is not taken for a howl.
+ * A window whose feedback is HOWL_EXCESS_DB above the source is a howl. The output cannot serve,
+ * as a howl saturates it at any gain. The time to suppress is counted from the end of the ramp.
+ *
+ * @param scene The scene.
+ * @param settings The settings of the canceller.
+ * @param startDb The gain at the start of the run, in dB.
+ * @param gainDb The gain at the end of the ramp, in dB.
+ * @param holdSeconds The duration of the start gain, in seconds.
+ * @param rampSeconds The duration of the ramp, in seconds, 0 for a step.
+ * @param seconds The duration of the run, in seconds.
+ * @param recording Receives the microphone and loudspeaker signals as interleaved pairs, or nullptr.
+ * @return The result of the run.
+ */
+LoopResult runScene(const LoopScene& scene, const LoopSettings& settings, const double startDb, const double gainDb,
+                    const double holdSeconds, const double rampSeconds, const double seconds, std::vector<std::int16_t>* recording) {
+    constexpr float noiseFloor{1e-4f};
+    constexpr double averaging{static_cast<double>(HOWL_WINDOW) / AUDIO_SAMPLE_RATE_EXACT};
+
+    const auto blocks = static_cast<std::size_t>(seconds * AUDIO_SAMPLE_RATE_EXACT / AUDIO_BLOCK_SAMPLES);
+    const auto holdBlocks = static_cast<std::size_t>(holdSeconds * AUDIO_SAMPLE_RATE_EXACT / AUDIO_BLOCK_SAMPLES);
+    const auto rampBlocks = static_cast<std::size_t>(rampSeconds * AUDIO_SAMPLE_RATE_EXACT / AUDIO_BLOCK_SAMPLES);
+    const std::size_t stableFrom = blocks - std::min(blocks, static_cast<std::size_t>(STABLE_SECONDS * AUDIO_SAMPLE_RATE_EXACT / AUDIO_BLOCK_SAMPLES));
+    const std::size_t sourceSize = scene.source.size();
+
+    FeedbackLoop loop{scene.path, settings, noiseFloor};
+    LoopResult result;
+    result.peakExcess = -INFINITY;
+    if (recording) recording->assign(2 * blocks * AUDIO_BLOCK_SAMPLES, 0);
+
+    float source[AUDIO_BLOCK_SAMPLES];
+    std::int16_t microphone[AUDIO_BLOCK_SAMPLES], loudspeaker[AUDIO_BLOCK_SAMPLES];
+    double gain{0.0}, appliedDb{NAN}, outputEnergy{0.0}, expectedEnergy{0.0};
+    double sourceEnergy{0.0}, feedbackEnergy{0.0}, sourceAverage{-1.0};
+    std::size_t windowFill{0}, lastHowl{0};
+    bool howling{false};
+
+    for (std::size_t b = 0; b < blocks; ++b) {
+        double db = gainDb;
+        if (b < holdBlocks) {
+            db = startDb;
+        } else if (b < holdBlocks + rampBlocks) {
+            db = startDb + (gainDb - startDb) * static_cast<double>(b - holdBlocks + 1) / static_cast<double>(rampBlocks);
+        }
+        if (db != appliedDb) {
+            gain = std::pow(10.0, db / 20.0);
+            loop.setGain(gain);
+            appliedDb = db;
+        }
+
+        for (std::size_t i = 0; i < AUDIO_BLOCK_SAMPLES; ++i) {
+            source[i] = sourceSize ? scene.source[(b * AUDIO_BLOCK_SAMPLES + i) % sourceSize] : 0.0f;
+        }
+        if (b + 1 == blocks) loop.requestMisalignment();
+        loop.processBlock(source, microphone, loudspeaker);
+
+        for (std::size_t i = 0; i < AUDIO_BLOCK_SAMPLES; ++i) {
+            const double feedback = microphone[i] / 32768.0 - source[i];
+            sourceEnergy += static_cast<double>(source[i]) * source[i];
+            feedbackEnergy += feedback * feedback;
+            if (b >= holdBlocks + rampBlocks) {
+                const double output = loudspeaker[i] / 32768.0;
+                outputEnergy += output * output;
+                expectedEnergy += gain * gain * source[i] * source[i];
+            }
+            if (recording) {
+                (*recording)[2 * (b * AUDIO_BLOCK_SAMPLES + i)] = microphone[i];
+                (*recording)[2 * (b * AUDIO_BLOCK_SAMPLES + i) + 1] = loudspeaker[i];
+            }
+        }
+        windowFill += AUDIO_BLOCK_SAMPLES;
+        if (windowFill < HOWL_WINDOW) continue;
+
+        sourceAverage = sourceAverage < 0.0 ? sourceEnergy : sourceAverage + averaging * (sourceEnergy - sourceAverage);
+        const double excess = 10.0 * std::log10((feedbackEnergy + 1e-12) / (std::max(sourceEnergy, sourceAverage) + 1e-12));
+        result.peakExcess = std::max(result.peakExcess, excess);
+        howling = excess > HOWL_EXCESS_DB;
+        if (howling) {
+            lastHowl = b + 1;
+            if (b >= stableFrom) result.stable = false;
+        }
+        sourceEnergy = feedbackEnergy = 0.0;
+        windowFill = 0;
+    }
+
+    const std::size_t rampEnd = holdBlocks + rampBlocks;
+    if (howling) {
+        result.suppressSeconds = -1.0;
+    } else if (lastHowl > rampEnd) {
+        result.suppressSeconds = static_cast<double>((lastHowl - rampEnd) * AUDIO_BLOCK_SAMPLES) / AUDIO_SAMPLE_RATE_EXACT;
+    }
+    result.outputLevel = 10.0 * std::log10((outputEnergy + 1e-12) / (expectedEnergy + 1e-12));
+    result.misalignment = loop.getMisalignment();
+    result.cyclesPerSample = loop.getCyclesPerSample();
+    return result;
+}
+
+/**
+ * @brief Finds the largest gain at which a scene stays stable, by bisection.
+ *
+ * Each trial ramps the gain from lowDb to the trial gain over MSG_RAMP_SECONDS and holds it
+ * until MSG_RUN_SECONDS, so that the canceller adapts as it would while the gain is raised.
+ *
+ * @param scene The scene.
+ * @param settings The settings of the canceller.
+ * @param lowDb The lowest gain searched, in dB.
+ * @param highDb The highest gain searched, in dB.
+ * @return The maximum stable gain, in dB, lowDb if even lowDb howls and highDb if highDb does not.
+ */
+double findStableGain(const LoopScene& scene, const LoopSettings& settings, double lowDb, double highDb) {
+    const auto stable = [&](const double gainDb) {
+        return runScene(scene, settings, lowDb, gainDb, 0.0, MSG_RAMP_SECONDS, MSG_RUN_SECONDS).stable;
+    };
+    const double floorDb = lowDb;
+    if (!stable(floorDb)) return floorDb;
+    if (stable(highDb)) return highDb;
+    while (highDb - lowDb > MSG_RESOLUTION_DB) {
+        const double middle = 0.5 * (lowDb + highDb);
+        (stable(middle) ? lowDb : highDb) = middle;
+    }
+    return lowDb;
+}
+
+/**
+ * @brief Gets the maximum stable gain of a path without cancellation, from its peak magnitude response.
+ *
+ * The response is sampled on a grid four times finer than its length.
+ *
+ * @param path The impulse response.
+ * @return -20 log10 of the largest magnitude of its frequency response, in dB.
+ */
+double pathStableGain(const std::vector<float>& path) {
+    std::size_t size{1024};
+    while (size < 4 * path.size()) size *= 2;
+    std::vector<float> padded(size, 0.0f);
+    std::copy(path.begin(), path.end(), padded.begin());
+    std::vector<std::complex<float>> response(size / 2 + 1);
+    FFT<float> fft{size};
+    fft.forward(padded.data(), response.data());
+
+    float peak{0.0f};
+    for (const auto& bin : response) peak = std::max(peak, std::abs(bin));
+    return peak > 0.0f ? -20.0 * std::log10(peak) : INFINITY;
+}
+
+/**
+ * @brief Filters a signal in place through a Butterworth biquad (RBJ cookbook).
+ *
+ * @param samples The signal.
+ * @param frequency The cut-off frequency, in Hz.
+ * @param highPass True for a high-pass filter, false for a low-pass filter.
+ */
+static void butterworth(std::vector<float>& samples, const float frequency, const bool highPass) {
+    const float w = 2.0f * static_cast<float>(M_PI) * frequency / AUDIO_SAMPLE_RATE_EXACT;
+    const float alpha = std::sin(w) / std::sqrt(2.0f);
+    const float c = std::cos(w);
+    const float a0 = 1.0f + alpha;
+    const float b1 = (highPass ? -(1.0f + c) : 1.0f - c) / a0;
+    const float b0 = 0.5f * std::abs(b1 * a0) / a0;
+    const float a1 = -2.0f * c / a0, a2 = (1.0f - alpha) / a0;
+
+    float x1{0.0f}, x2{0.0f}, y1{0.0f}, y2{0.0f};
+    for (float& x : samples) {
+        const float y = b0 * x + b1 * x1 + b0 * x2 - a1 * y1 - a2 * y2;
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+        x = y;
+    }
+}
+
+/**
+ * @brief Generates a room impulse response: a bulk delay, a direct path and an exponentially decaying tail.
+ *
+ * A few early reflections follow the direct path, and the diffuse tail decays by 60 dB over the
+ * length of the response. The loudspeaker and the microphone limit the band to 120 Hz - 6 kHz,
+ * within the range of the notches, with a second-order high-pass and a fourth-order low-pass. The
+ * response is scaled so that its maximum stable gain is 0 dB.
+ *
+ * @param length The number of taps.
+ * @param delay The bulk delay, in samples.
+ * @param seed The seed of the tail.
+ * @return The impulse response.
+ */
+std::vector<float> makeRoomPath(const std::size_t length, const std::size_t delay, const unsigned int seed) {
+    std::mt19937 rng{seed};
+    std::normal_distribution<float> diffuse{0.0f, 0.3f};
+    std::uniform_real_distribution<float> amplitude{0.3f, 0.6f};
+    std::uniform_int_distribution<std::size_t> position{delay + 1, delay + std::max<std::size_t>(2, (length - delay) / 10)};
+    std::bernoulli_distribution sign;
+
+    std::vector<float> path(length, 0.0f);
+    path[delay] = 1.0f;
+    const auto decay = static_cast<float>(length - delay);
+    for (std::size_t k = delay + 1; k < length; ++k) {
+        path[k] = diffuse(rng) * std::exp(-6.9f * static_cast<float>(k - delay) / decay);
+    }
+    for (int i = 0; i < 4; ++i) {
+        const std::size_t k = std::min(position(rng), length - 1);
+        path[k] += (sign(rng) ? 1.0f : -1.0f) * amplitude(rng);
+    }
+    butterworth(path, 120.0f, true);
+    butterworth(path, 6000.0f, false);
+    butterworth(path, 6000.0f, false);
+
+    const auto scale = static_cast<float>(std::pow(10.0, pathStableGain(path) / 20.0));
+    for (float& tap : path) tap *= scale;
+    return path;
+}
+
+/**
+ * @brief A two-pole resonator, a formant of the speech source.
+ */
+struct Resonator {
+    float b0{0.0f}; ///< Input gain.
+    float a1{0.0f}; ///< First feedback coefficient.
+    float a2{0.0f}; ///< Second feedback coefficient.
+    float y1{0.0f}; ///< Previous output.
+    float y2{0.0f}; ///< Output before the previous one.
+
+    /**
+     * @brief Tunes the resonator.
+     *
+     * @param frequency The centre frequency, in Hz.
+     * @param bandwidth The bandwidth, in Hz.
+     */
+    void tune(const float frequency, const float bandwidth) {
+        const float r = std::exp(-static_cast<float>(M_PI) * bandwidth / AUDIO_SAMPLE_RATE_EXACT);
+        b0 = 1.0f - r;
+        a1 = 2.0f * r * std::cos(2.0f * static_cast<float>(M_PI) * frequency / AUDIO_SAMPLE_RATE_EXACT);
+        a2 = -r * r;
+    }
+
+    /**
+     * @brief Filters a sample.
+     *
+     * @param x The input sample.
+     * @return The output sample.
+     */
+    float tick(const float x) {
+        const float y = b0 * x + a1 * y1 + a2 * y2;
+        y2 = y1;
+        y1 = y;
+        return y;
+    }
+};
+
+/**
+ * @brief Generates a speech-like source: voiced syllables through moving formants, fricatives and pauses.
+ *
+ * Each syllable is a glottal pulse train whose pitch glides around a speaker fundamental, through
+ * the three formants of a vowel, sometimes preceded by a burst of high-passed noise. Syllables are
+ * separated by short gaps, and phrases of five to nine syllables by longer pauses.
+ *
+ * @param samples The number of samples.
+ * @param level The RMS level.
+ * @param seed The seed of the generator.
+ * @return The samples.
+ */
+std::vector<float> makeSpeech(const std::size_t samples, const float level, const unsigned int seed) {
+    static constexpr float vowels[][3] = {
+        {730.0f, 1090.0f, 2440.0f}, {270.0f, 2290.0f, 3010.0f}, {300.0f, 870.0f, 2240.0f}, {530.0f, 1840.0f, 2480.0f},
+        {570.0f, 840.0f, 2410.0f}, {440.0f, 1020.0f, 2240.0f}, {660.0f, 1720.0f, 2410.0f},
+    };
+    constexpr float bandwidths[3] = {80.0f, 100.0f, 120.0f};
+    constexpr float fs = AUDIO_SAMPLE_RATE_EXACT;
+
+    std::mt19937 rng{seed};
+    std::uniform_real_distribution<float> uniform{0.0f, 1.0f};
+    std::normal_distribution<float> white{0.0f, 1.0f};
+    std::uniform_int_distribution<std::size_t> vowel{0, std::size(vowels) - 1};
+
+    std::vector<float> speech(samples, 0.0f);
+    Resonator formants[3];
+    const float fundamental = 100.0f + 40.0f * uniform(rng);
+    float phase{0.0f}, previousNoise{0.0f};
+    std::size_t position{0}, phrase{0}, phraseLength{5};
+
+    while (position < samples) {
+        const auto length = static_cast<std::size_t>((0.12f + 0.13f * uniform(rng)) * fs);
+        const auto fricative = uniform(rng) < 0.4f ? static_cast<std::size_t>((0.03f + 0.03f * uniform(rng)) * fs) : 0;
+        const float* formant = vowels[vowel(rng)];
+        for (std::size_t f = 0; f < 3; ++f) formants[f].tune(formant[f], bandwidths[f]);
+        const float glide = 0.15f * (uniform(rng) - 0.5f);
+
+        for (std::size_t i = 0; i < fricative + length && position < samples; ++i, ++position) {
+            if (i < fricative) {
+                const float x = white(rng);
+                const float t = static_cast<float>(i) / static_cast<float>(fricative);
+                speech[position] = 0.3f * std::sin(static_cast<float>(M_PI) * t) * (x - previousNoise);
+                previousNoise = x;
+                continue;
+            }
+            const float t = static_cast<float>(i - fricative) / static_cast<float>(length);
+            phase += fundamental * (1.0f + glide * (t - 0.5f)) / fs;
+            float x{0.0f};
+            if (phase >= 1.0f) {
+                phase -= 1.0f;
+                x = 1.0f;
+            }
+            for (Resonator& resonator : formants) x = resonator.tick(x);
+            speech[position] = std::sin(static_cast<float>(M_PI) * t) * x;
+        }
+
+        const float gap = ++phrase >= phraseLength ? 0.3f + 0.3f * uniform(rng) : 0.03f + 0.09f * uniform(rng);
+        if (phrase >= phraseLength) {
+            phrase = 0;
+            phraseLength = 5 + static_cast<std::size_t>(5.0f * uniform(rng));
+        }
+        position += static_cast<std::size_t>(gap * fs);
+    }
+
+    normalize(speech, level);
+    return speech;
+}
+
+/**
+ * @brief A decaying harmonic note of the music source.
+ */
+struct Note {
+    float frequency; ///< Fundamental frequency, in Hz.
+    float amplitude; ///< Current amplitude.
+    float decay; ///< Amplitude factor per sample.
+    float vibrato; ///< Depth of the vibrato, relative to the frequency.
+    double phase; ///< Phase of the fundamental, in cycles.
+};
+
+/**
+ * @brief Gets the frequency of a MIDI note.
+ *
+ * @param note The MIDI note number, 69 for A4.
+ * @return The frequency, in Hz.
+ */
+static float midiFrequency(const int note) {
+    return 440.0f * std::pow(2.0f, static_cast<float>(note - 69) / 12.0f);
+}
+
+/**
+ * @brief Generates a music-like source: a chord progression of decaying harmonic notes and a melody with vibrato.
+ *
+ * A chord of the progression starts every second, with its root an octave down on every beat, and a
+ * melody note of the pentatonic scale, with vibrato, every half beat. Each note has five harmonics
+ * falling as 1/k. Sustained tones are the hardest case for a feedback canceller.
+ *
+ * @param samples The number of samples.
+ * @param level The RMS level.
+ * @param seed The seed of the generator.
+ * @return The samples.
+ */
+std::vector<float> makeMusic(const std::size_t samples, const float level, const unsigned int seed) {
+    static constexpr int chords[][3] = {{60, 64, 67}, {55, 59, 62}, {57, 60, 64}, {53, 57, 60}};
+    static constexpr int scale[] = {72, 74, 76, 79, 81};
+    constexpr float fs = AUDIO_SAMPLE_RATE_EXACT;
+    constexpr std::size_t harmonics{5};
+    const auto beat = static_cast<std::size_t>(0.25f * fs);
+    const auto decay = [fs](const float seconds) { return std::exp(-1.0f / (seconds * fs)); };
+
+    std::mt19937 rng{seed};
+    std::uniform_int_distribution<std::size_t> melody{0, std::size(scale) - 1};
+    std::uniform_real_distribution<double> phase{0.0, 1.0};
+
+    std::vector<float> music(samples, 0.0f);
+    std::vector<Note> notes;
+    for (std::size_t n = 0; n < samples; ++n) {
+        if (n % (beat / 2) == 0) {
+            const std::size_t beatIndex = n / beat;
+            if (n % (4 * beat) == 0) {
+                for (const int note : chords[(beatIndex / 4) % std::size(chords)]) {
+                    notes.push_back({midiFrequency(note), 0.5f, decay(0.6f), 0.0f, phase(rng)});
+                }
+            }
+            if (n % beat == 0) {
+                notes.push_back({midiFrequency(chords[(beatIndex / 4) % std::size(chords)][0] - 12), 0.8f, decay(0.2f), 0.0f, phase(rng)});
+            }
+            notes.push_back({midiFrequency(scale[melody(rng)]), 0.6f, decay(0.3f), 0.004f, phase(rng)});
+            notes.erase(std::remove_if(notes.begin(), notes.end(), [](const Note& note) { return note.amplitude < 1e-3f; }), notes.end());
+        }
+
+        const double t = static_cast<double>(n) / fs;
+        float sample{0.0f};
+        for (Note& note : notes) {
+            const double frequency = note.frequency * (1.0 + note.vibrato * std::sin(2.0 * M_PI * 5.5 * t));
+            note.phase += frequency / fs;
+            note.phase -= std::floor(note.phase);
+            for (std::size_t k = 1; k <= harmonics; ++k) {
+                sample += note.amplitude * static_cast<float>(std::sin(2.0 * M_PI * static_cast<double>(k) * note.phase)) / static_cast<float>(k);
+            }
+            note.amplitude *= note.decay;
+        }
+        music[n] = sample;
+    }
+
+    normalize(music, level);
+    return music;
+}
+
+/**
+ * @brief Generates a stationary pink-ish noise source.
+ *
+ * White noise is coloured by a first-order low-pass filter with a pole at 0.9.
+ *
+ * @param samples The number of samples.
+ * @param level The RMS level.
+ * @param seed The seed of the generator.
+ * @return The samples.
+ */
+std::vector<float> makeNoise(const std::size_t samples, const float level, const unsigned int seed) {
+    std::mt19937 rng{seed};
+    std::normal_distribution<float> white{0.0f, 1.0f};
+    std::vector<float> noise(samples);
+    float colour{0.0f};
+    for (float& x : noise) {
+        colour = 0.9f * colour + white(rng);
+        x = colour;
+    }
+    normalize(noise, level);
+    return noise;
+}
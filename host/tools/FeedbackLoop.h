@@ -0,0 +1,277 @@
+#ifndef FEEDBACK_LOOP_H
+#define FEEDBACK_LOOP_H
+
+#include "AdaptiveFeedbackCanceller.h"
+#include "FFT.h"
+#include "HowlDetector.h"
+#include "LatencyProbe.h"
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Settings of the canceller running in a FeedbackLoop.
+ */
+struct LoopSettings {
+    bool lms{true}; ///< True to enable the LMS filter.
+    bool notch{true}; ///< True to enable the notch filters.
+    bool howlDetector{true}; ///< True to steer the notches from a HowlDetector, as the firmware does, false for the in-filter estimator.
+#if !defined(AFC_FDAF) && !defined(AFC_SUBBAND)
+    LMSAlgorithm algorithm{LMSAlgorithm::DynamicNoise}; ///< Adaptation algorithm of the LMS filter.
+#endif
+};
+
+/**
+ * @brief The FeedbackLoop class closes the loop between AdaptiveFeedbackCanceller and an acoustic path.
+ *
+ * The canceller runs unchanged on the host Audio.h, one AUDIO_BLOCK_SAMPLES block at a time. Its
+ * output is played by the loudspeaker during the next block, as the audio library does, goes
+ * through the impulse response of the loudspeaker-room-microphone path and is added at the
+ * microphone to the source and to a noise floor; the sum is quantized to 16 bits and is the input
+ * of the next update(). The path is convolved by uniformly partitioned overlap-save, so long
+ * responses stay cheap. As in the firmware, the output is also analysed every 512 samples by a
+ * 1024-point Hann-windowed FFT, the stand-in for AudioAnalyzeFFT1024, whose magnitudes feed a
+ * HowlDetector that steers the notches with trackHowls(). A LatencyProbe sits between the canceller
+ * and the loudspeaker, as in the firmware, so the round-trip latency of the loop can be measured
+ * with the same click.
+ *
+ * Signals are in full-scale units: 1 is the largest 16-bit sample.
+ */
+class FeedbackLoop final {
+public:
+    static constexpr std::size_t SPECTRUM_SIZE = 1024; ///< Size of the FFT of the output, as AudioAnalyzeFFT1024.
+    static constexpr std::size_t SPECTRUM_PERIOD = 512; ///< Samples between two spectra of the output.
+
+    /**
+     * @brief Constructs a FeedbackLoop object around a fresh canceller.
+     *
+     * @param path The impulse response from the loudspeaker to the microphone.
+     * @param settings The settings of the canceller.
+     * @param noiseLevel The RMS level of the noise at the microphone.
+     * @param seed The seed of the noise.
+     */
+    FeedbackLoop(const std::vector<float>& path, const LoopSettings& settings, float noiseLevel, unsigned int seed = 1);
+
+    FeedbackLoop(const FeedbackLoop&) = delete;
+    FeedbackLoop& operator=(const FeedbackLoop&) = delete;
+
+    /**
+     * @brief Sets the gain of the canceller, from the start of the next block.
+     *
+     * @param gain The gain, linear.
+     */
+    void setGain(double gain) { canceller->setGain(gain); }
+
+    /**
+     * @brief Runs one block of the loop.
+     *
+     * @param source The AUDIO_BLOCK_SAMPLES samples of the source at the microphone.
+     * @param microphone The AUDIO_BLOCK_SAMPLES samples of the microphone, the input of the canceller.
+     * @param loudspeaker The AUDIO_BLOCK_SAMPLES samples of the canceller output, played during the next block.
+     */
+    void processBlock(const float* source, std::int16_t* microphone, std::int16_t* loudspeaker);
+
+    /**
+     * @brief Asks for the misalignment of the adaptive filter to be measured at the end of the next block.
+     */
+    void requestMisalignment() { canceller->requestSnapshot(); }
+
+    /**
+     * @brief Gets the last misalignment measured, in dB.
+     *
+     * The misalignment is the energy of the difference between the path from the canceller output
+     * to its input, the block of latency included, and the taps of the adaptive filter, relative
+     * to the energy of the path. 0 dB means that the filter has not identified the path at all.
+     *
+     * @return The misalignment, in dB, or 0 if none was measured.
+     */
+    [[nodiscard]] double getMisalignment() const { return misalignment; }
+
+    /**
+     * @brief Gets the cycle counter ticks spent in update() per sample so far.
+     *
+     * @return The ticks per sample.
+     */
+    [[nodiscard]] double getCyclesPerSample() const {
+        return samples ? static_cast<double>(updateCycles) / static_cast<double>(samples) : 0.0;
+    }
+
+    /**
+     * @brief Gets the latency probe between the canceller and the loudspeaker.
+     *
+     * @return The probe.
+     */
+    LatencyProbe& getLatencyProbe() { return probe; }
+
+private:
+    using complex_t = std::complex<float>; ///< Complex type of the spectra.
+
+    std::unique_ptr<AdaptiveFeedbackCanceller<1>> canceller; ///< The canceller under test.
+    LatencyProbe probe; ///< Probe between the canceller and the loudspeaker, passing the output through unless it measures.
+    std::vector<float> path; ///< Impulse response of the acoustic path.
+    std::size_t partitions; ///< Number of AUDIO_BLOCK_SAMPLES partitions of the path.
+    FFT<float> pathFft{2 * AUDIO_BLOCK_SAMPLES}; ///< Transform of the overlap-save frames.
+    std::vector<complex_t> pathSpectra; ///< Spectrum of each partition of the path.
+    std::vector<complex_t> playedSpectra; ///< Spectra of the last frames of the loudspeaker, newest at playedIndex.
+    std::size_t playedIndex{0}; ///< Partition of the newest loudspeaker spectrum.
+    float playedFrame[2 * AUDIO_BLOCK_SAMPLES]{}; ///< The previous and current blocks of the loudspeaker.
+    float echo[2 * AUDIO_BLOCK_SAMPLES]{}; ///< Output of the overlap-save convolution.
+    std::int16_t playing[AUDIO_BLOCK_SAMPLES]{}; ///< Block played by the loudspeaker during the current block.
+
+    std::mt19937 rng; ///< Generator of the noise floor.
+    std::normal_distribution<float> noise; ///< Noise at the microphone.
+
+    bool howlDetection; ///< True to steer the notches from howlDetector.
+    FFT<float> spectrumFft{SPECTRUM_SIZE}; ///< Transform of the output.
+    std::vector<float> window; ///< Hann window of the output.
+    std::vector<float> history; ///< Last SPECTRUM_SIZE output samples, oldest first.
+    std::vector<float> frame; ///< Windowed output.
+    std::vector<complex_t> spectrum; ///< Spectrum of the output.
+    std::vector<float> magnitude; ///< Magnitudes of the bins, as AudioAnalyzeFFT1024::read().
+    HowlDetector<float> howlDetector{SPECTRUM_SIZE / 2, AUDIO_SAMPLE_RATE_EXACT / SPECTRUM_SIZE}; ///< Finds the howls in the spectra.
+    std::size_t sinceSpectrum{0}; ///< Samples since the last spectrum.
+
+    double misalignment{0.0}; ///< Last misalignment measured, in dB.
+    std::uint64_t updateCycles{0}; ///< Cycle counter ticks spent in update().
+    std::uint64_t samples{0}; ///< Samples processed.
+
+    /**
+     * @brief Computes the microphone signal of the current block.
+     *
+     * @param source The samples of the source.
+     * @param microphone The samples of the microphone, quantized to 16 bits.
+     */
+    void listen(const float* source, std::int16_t* microphone);
+
+    /**
+     * @brief Analyses the output every SPECTRUM_PERIOD samples and hands the howls found to the canceller.
+     *
+     * @param output The AUDIO_BLOCK_SAMPLES samples of the canceller output.
+     */
+    void analyze(const std::int16_t* output);
+
+    /**
+     * @brief Measures the misalignment from a snapshot of the adaptive filter.
+     *
+     * @param snapshot The snapshot.
+     */
+    void measure(const FilterSnapshot& snapshot);
+};
+
+constexpr std::size_t HOWL_WINDOW{1024}; ///< Samples over which the feedback is compared to the source.
+constexpr double HOWL_EXCESS_DB{12.0}; ///< Level of the feedback above the source that is taken for a howl, in dB.
+constexpr double STABLE_SECONDS{2.0}; ///< Duration at the end of a run that must be free of howls for the run to be stable.
+constexpr double MSG_RAMP_SECONDS{2.0}; ///< Duration of the gain ramp of a trial of findStableGain().
+constexpr double MSG_RUN_SECONDS{8.0}; ///< Duration of a trial of findStableGain().
+constexpr double MSG_RESOLUTION_DB{0.5}; ///< Resolution of findStableGain(), in dB.
+
+/**
+ * @brief A scene of the simulation: an acoustic path and the source heard by the microphone.
+ */
+struct LoopScene {
+    std::string name; ///< Name of the scene.
+    std::vector<float> path; ///< Impulse response from the loudspeaker to the microphone.
+    std::vector<float> source; ///< The source at the microphone, repeated if shorter than a run.
+};
+
+/**
+ * @brief Result of a run of a scene.
+ */
+struct LoopResult {
+    bool stable{true}; ///< True if no howl was found over the last STABLE_SECONDS of the run.
+    double suppressSeconds{0.0}; ///< Time from the gain step to the end of the last howl, 0 if none, -1 if still howling.
+    double peakExcess{0.0}; ///< Largest level of the feedback above the source, in dB.
+    double outputLevel{0.0}; ///< Level of the output after the ramp relative to the source times the gain, in dB; far below 0 if the canceller removes the source.
+    double misalignment{0.0}; ///< Misalignment of the adaptive filter at the end of the run, in dB.
+    double cyclesPerSample{0.0}; ///< Cycle counter ticks spent in update() per sample.
+};
+
+/**
+ * @brief Runs a scene with a gain held at startDb for holdSeconds, ramped in dB to gainDb over rampSeconds, then held.
+ *
+ * A howl is a window of HOWL_WINDOW samples where the feedback, the microphone minus the source,
+ * is HOWL_EXCESS_DB above the source, measured over the window or on average if it is louder.
+ *
+ * @param scene The scene.
+ * @param settings The settings of the canceller.
+ * @param startDb The gain at the start of the run, in dB.
+ * @param gainDb The gain at the end of the ramp, in dB.
+ * @param holdSeconds The duration of the start gain, in seconds.
+ * @param rampSeconds The duration of the ramp, in seconds, 0 for a step.
+ * @param seconds The duration of the run, in seconds.
+ * @param recording Receives the microphone and loudspeaker signals as interleaved pairs, or nullptr.
+ * @return The result of the run.
+ */
+LoopResult runScene(const LoopScene& scene, const LoopSettings& settings, double startDb, double gainDb, double holdSeconds,
+                    double rampSeconds, double seconds, std::vector<std::int16_t>* recording = nullptr);
+
+/**
+ * @brief Finds the largest gain at which a scene stays stable, by bisection.
+ *
+ * Each trial ramps the gain from lowDb to the trial gain over MSG_RAMP_SECONDS and holds it
+ * until MSG_RUN_SECONDS, so that the canceller adapts as it would while the gain is raised.
+ *
+ * @param scene The scene.
+ * @param settings The settings of the canceller.
+ * @param lowDb The lowest gain searched, in dB.
+ * @param highDb The highest gain searched, in dB.
+ * @return The maximum stable gain, in dB, lowDb if even lowDb howls and highDb if highDb does not.
+ */
+double findStableGain(const LoopScene& scene, const LoopSettings& settings, double lowDb, double highDb);
+
+/**
+ * @brief Gets the maximum stable gain of a path without cancellation, from its peak magnitude response.
+ *
+ * @param path The impulse response.
+ * @return -20 log10 of the largest magnitude of its frequency response, in dB.
+ */
+double pathStableGain(const std::vector<float>& path);
+
+/**
+ * @brief Generates a room impulse response: a bulk delay, a direct path and an exponentially decaying tail.
+ *
+ * The response is scaled so that its maximum stable gain is 0 dB.
+ *
+ * @param length The number of taps.
+ * @param delay The bulk delay, in samples.
+ * @param seed The seed of the tail.
+ * @return The impulse response.
+ */
+std::vector<float> makeRoomPath(std::size_t length, std::size_t delay, unsigned int seed);
+
+/**
+ * @brief Generates a speech-like source: voiced syllables through moving formants, fricatives and pauses.
+ *
+ * @param samples The number of samples.
+ * @param level The RMS level.
+ * @param seed The seed of the generator.
+ * @return The samples.
+ */
+std::vector<float> makeSpeech(std::size_t samples, float level, unsigned int seed);
+
+/**
+ * @brief Generates a music-like source: a chord progression of decaying harmonic notes and a melody with vibrato.
+ *
+ * @param samples The number of samples.
+ * @param level The RMS level.
+ * @param seed The seed of the generator.
+ * @return The samples.
+ */
+std::vector<float> makeMusic(std::size_t samples, float level, unsigned int seed);
+
+/**
+ * @brief Generates a stationary pink-ish noise source.
+ *
+ * @param samples The number of samples.
+ * @param level The RMS level.
+ * @param seed The seed of the generator.
+ * @return The samples.
+ */
+std::vector<float> makeNoise(std::size_t samples, float level, unsigned int seed);
+
+#endif
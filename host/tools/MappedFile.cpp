@@ -0,0 +1,62 @@
+#include "MappedFile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Destroys the MappedFile object and unmaps the file.
+ */
+MappedFile::~MappedFile() {
+    close();
+}
+
+/**
+ * @brief Maps a file, unmapping the previous one.
+ *
+ * @param path The path of the file.
+ * @param error Set to the reason of the failure, if any.
+ * @return True if the file was mapped, false otherwise.
+ */
+bool MappedFile::open(const std::string& path, std::string& error) {
+    close();
+
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        error = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat status{};
+    if (::fstat(descriptor, &status) != 0 || status.st_size <= 0) {
+        error = "cannot map " + path + ": empty or unreadable file";
+        ::close(descriptor);
+        return false;
+    }
+
+    void* mapping = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+    ::close(descriptor);
+    if (mapping == MAP_FAILED) {
+        error = "cannot map " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    ::madvise(mapping, static_cast<std::size_t>(status.st_size), MADV_SEQUENTIAL);
+    bytes = static_cast<const unsigned char*>(mapping);
+    length = static_cast<std::size_t>(status.st_size);
+    return true;
+}
+
+/**
+ * @brief Unmaps the file, if any.
+ */
+void MappedFile::close() {
+    if (bytes) {
+        ::munmap(const_cast<unsigned char*>(bytes), length);
+        bytes = nullptr;
+        length = 0;
+    }
+}
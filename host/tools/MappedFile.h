@@ -0,0 +1,61 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief The MappedFile class maps a file read-only into memory (POSIX).
+ *
+ * The pages are only read from disk when they are touched, and mappings of the same file are
+ * shared by the page cache, so many workers can read one large recording without copying it.
+ */
+class MappedFile final {
+public:
+    /**
+     * @brief Constructs an empty MappedFile object.
+     */
+    MappedFile() = default;
+
+    /**
+     * @brief Destroys the MappedFile object and unmaps the file.
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Maps a file, unmapping the previous one.
+     *
+     * @param path The path of the file.
+     * @param error Set to the reason of the failure, if any.
+     * @return True if the file was mapped, false otherwise.
+     */
+    bool open(const std::string& path, std::string& error);
+
+    /**
+     * @brief Gets the content of the file.
+     *
+     * @return The first byte of the file, or nullptr if no file is mapped.
+     */
+    [[nodiscard]] const unsigned char* data() const { return bytes; }
+
+    /**
+     * @brief Gets the size of the file.
+     *
+     * @return The size of the file, in bytes.
+     */
+    [[nodiscard]] std::size_t size() const { return length; }
+
+private:
+    const unsigned char* bytes{nullptr}; ///< The mapped content.
+    std::size_t length{0}; ///< The size of the mapping, in bytes.
+
+    /**
+     * @brief Unmaps the file, if any.
+     */
+    void close();
+};
+
+#endif
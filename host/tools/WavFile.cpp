@@ -0,0 +1,154 @@
+#include "WavFile.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+/**
+ * @brief Reads a little-endian unsigned integer of the specified size.
+ *
+ * @param bytes The bytes to read from.
+ * @param size The number of bytes, at most 4.
+ * @return The value.
+ */
+static std::uint32_t readLittleEndian(const unsigned char* bytes, const std::size_t size) {
+    std::uint32_t value{0};
+    for (std::size_t i = 0; i < size; ++i) {
+        value |= static_cast<std::uint32_t>(bytes[i]) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief Appends a little-endian unsigned integer of the specified size.
+ *
+ * @param bytes The bytes to append to.
+ * @param value The value.
+ * @param size The number of bytes, at most 4.
+ */
+static void writeLittleEndian(std::vector<unsigned char>& bytes, const std::uint32_t value, const std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+        bytes.push_back(static_cast<unsigned char>(value >> (8 * i)));
+    }
+}
+
+/**
+ * @brief Parses the header of a 16-bit PCM WAV file.
+ *
+ * Plain PCM and WAVE_FORMAT_EXTENSIBLE headers are accepted; chunks other than fmt and data are skipped.
+ *
+ * @param bytes The content of the file.
+ * @param size The size of the file, in bytes.
+ * @param error Set to the reason of the failure, if any.
+ * @return True if the header is valid, false otherwise.
+ */
+bool WavFormat::parse(const unsigned char* bytes, const std::size_t size, std::string& error) {
+    constexpr std::uint16_t formatPcm{1}, formatExtensible{0xFFFE};
+
+    if (size < 12 || std::string(bytes, bytes + 4) != "RIFF" || std::string(bytes + 8, bytes + 12) != "WAVE") {
+        error = "not a WAV file";
+        return false;
+    }
+
+    bool formatFound{false}, dataFound{false};
+    std::size_t offset{12};
+    while (offset + 8 <= size && !dataFound) {
+        const std::string id(bytes + offset, bytes + offset + 4);
+        const std::size_t chunkSize = readLittleEndian(bytes + offset + 4, 4);
+        const std::size_t body = offset + 8;
+
+        if (id == "fmt " && chunkSize >= 16 && body + chunkSize <= size) {
+            std::uint32_t format = readLittleEndian(bytes + body, 2);
+            if (format == formatExtensible && chunkSize >= 26) format = readLittleEndian(bytes + body + 24, 2);
+            const std::uint32_t bitsPerSample = readLittleEndian(bytes + body + 14, 2);
+            if (format != formatPcm || bitsPerSample != 16) {
+                error = "not 16-bit PCM";
+                return false;
+            }
+            channels = static_cast<std::uint16_t>(readLittleEndian(bytes + body + 2, 2));
+            sampleRate = readLittleEndian(bytes + body + 4, 4);
+            formatFound = true;
+        } else if (id == "data" && formatFound) {
+            dataOffset = body;
+            const std::size_t available = std::min(chunkSize, size - body);
+            frameCount = channels ? available / (2 * static_cast<std::size_t>(channels)) : 0;
+            dataFound = true;
+        }
+
+        offset = body + chunkSize + (chunkSize & 1);
+    }
+
+    if (!dataFound || channels == 0) {
+        error = "no PCM data";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads a 16-bit PCM WAV file.
+ *
+ * @param path The path of the file.
+ * @param error Set to the reason of the failure, if any.
+ * @return True if the file was read, false otherwise.
+ */
+bool WavFile::read(const std::string& path, std::string& error) {
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    const std::vector<unsigned char> bytes{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+
+    WavFormat format;
+    if (!format.parse(bytes.data(), bytes.size(), error)) {
+        error = path + ": " + error;
+        return false;
+    }
+
+    sampleRate = format.sampleRate;
+    channels = format.channels;
+    samples.resize(format.frameCount * channels);
+    for (std::size_t frame = 0; frame < format.frameCount; ++frame) {
+        for (std::size_t channel = 0; channel < channels; ++channel) {
+            samples[frame * channels + channel] = format.sample(bytes.data(), frame, channel);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Writes the samples as a 16-bit PCM WAV file.
+ *
+ * @param path The path of the file.
+ * @param error Set to the reason of the failure, if any.
+ * @return True if the file was written, false otherwise.
+ */
+bool WavFile::write(const std::string& path, std::string& error) const {
+    const auto dataSize = static_cast<std::uint32_t>(samples.size() * 2);
+
+    std::vector<unsigned char> bytes;
+    bytes.reserve(44 + dataSize);
+    bytes.insert(bytes.end(), {'R', 'I', 'F', 'F'});
+    writeLittleEndian(bytes, 36 + dataSize, 4);
+    bytes.insert(bytes.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+    writeLittleEndian(bytes, 16, 4);
+    writeLittleEndian(bytes, 1, 2);
+    writeLittleEndian(bytes, channels, 2);
+    writeLittleEndian(bytes, sampleRate, 4);
+    writeLittleEndian(bytes, sampleRate * channels * 2, 4);
+    writeLittleEndian(bytes, channels * 2, 2);
+    writeLittleEndian(bytes, 16, 2);
+    bytes.insert(bytes.end(), {'d', 'a', 't', 'a'});
+    writeLittleEndian(bytes, dataSize, 4);
+    for (const std::int16_t sample : samples) {
+        writeLittleEndian(bytes, static_cast<std::uint16_t>(sample), 2);
+    }
+
+    std::ofstream file{path, std::ios::binary};
+    if (!file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
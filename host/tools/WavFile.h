@@ -0,0 +1,76 @@
+#ifndef WAV_FILE_H
+#define WAV_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The WavFormat struct describes the layout of a 16-bit PCM WAV file.
+ */
+struct WavFormat {
+    std::uint32_t sampleRate{0}; ///< Sample rate, in Hz.
+    std::uint16_t channels{0}; ///< Number of channels.
+    std::size_t dataOffset{0}; ///< Offset of the first sample in the file, in bytes.
+    std::size_t frameCount{0}; ///< Number of frames (samples per channel).
+
+    /**
+     * @brief Parses the header of a 16-bit PCM WAV file.
+     *
+     * @param bytes The content of the file.
+     * @param size The size of the file, in bytes.
+     * @param error Set to the reason of the failure, if any.
+     * @return True if the header is valid, false otherwise.
+     */
+    bool parse(const unsigned char* bytes, std::size_t size, std::string& error);
+
+    /**
+     * @brief Reads one sample of a parsed file.
+     *
+     * @param bytes The content of the file.
+     * @param frame The frame of the sample.
+     * @param channel The channel of the sample.
+     * @return The sample.
+     */
+    [[nodiscard]] std::int16_t sample(const unsigned char* bytes, const std::size_t frame, const std::size_t channel) const {
+        const unsigned char* p = bytes + dataOffset + 2 * (frame * channels + channel);
+        return static_cast<std::int16_t>(static_cast<std::uint16_t>(p[0] | (p[1] << 8)));
+    }
+};
+
+/**
+ * @brief The WavFile struct holds the samples of a 16-bit PCM WAV file.
+ */
+struct WavFile {
+    std::uint32_t sampleRate{0}; ///< Sample rate, in Hz.
+    std::uint16_t channels{0}; ///< Number of channels.
+    std::vector<std::int16_t> samples; ///< Interleaved samples.
+
+    /**
+     * @brief Gets the number of frames (samples per channel).
+     *
+     * @return The number of frames.
+     */
+    [[nodiscard]] std::size_t getFrameCount() const { return channels ? samples.size() / channels : 0; }
+
+    /**
+     * @brief Reads a 16-bit PCM WAV file.
+     *
+     * @param path The path of the file.
+     * @param error Set to the reason of the failure, if any.
+     * @return True if the file was read, false otherwise.
+     */
+    bool read(const std::string& path, std::string& error);
+
+    /**
+     * @brief Writes the samples as a 16-bit PCM WAV file.
+     *
+     * @param path The path of the file.
+     * @param error Set to the reason of the failure, if any.
+     * @return True if the file was written, false otherwise.
+     */
+    bool write(const std::string& path, std::string& error) const;
+};
+
+#endif
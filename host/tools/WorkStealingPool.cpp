@@ -0,0 +1,70 @@
+#include "WorkStealingPool.h"
+
+#include <thread>
+
+/**
+ * @brief Constructs a WorkStealingPool object.
+ *
+ * @param workers The number of threads, at least 1.
+ */
+WorkStealingPool::WorkStealingPool(const std::size_t workers) : queues(workers > 0 ? workers : 1) {}
+
+/**
+ * @brief Runs jobs until all of them are done.
+ *
+ * No job is added while the batch runs, so a worker that finds every queue empty can stop.
+ *
+ * @param jobs The jobs to run.
+ */
+void WorkStealingPool::run(std::vector<Job> jobs) {
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+        queues[i % queues.size()].jobs.push_back(std::move(jobs[i]));
+    }
+
+    const auto work = [this](const std::size_t worker) {
+        Job job;
+        while (take(worker, job)) {
+            job(worker);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(queues.size() - 1);
+    for (std::size_t worker = 1; worker < queues.size(); ++worker) {
+        threads.emplace_back(work, worker);
+    }
+    work(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief Takes the next job of a worker, stealing one if its own queue is empty.
+ *
+ * @param worker The index of the worker.
+ * @param job Set to the job taken.
+ * @return True if a job was taken, false if all the queues are empty.
+ */
+bool WorkStealingPool::take(const std::size_t worker, Job& job) {
+    {
+        Queue& own = queues[worker];
+        const std::lock_guard<std::mutex> lock{own.mutex};
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            return true;
+        }
+    }
+
+    for (std::size_t i = 1; i < queues.size(); ++i) {
+        Queue& victim = queues[(worker + i) % queues.size()];
+        const std::lock_guard<std::mutex> lock{victim.mutex};
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,63 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief The WorkStealingPool class runs a batch of independent jobs on a fixed number of threads.
+ *
+ * The jobs are dealt round-robin into one deque per worker. A worker takes jobs from the back of
+ * its own deque and, once it is empty, steals from the front of the others, so long jobs do not
+ * leave the other workers idle at the end of a batch.
+ */
+class WorkStealingPool final {
+public:
+    using Job = std::function<void(std::size_t worker)>; ///< A job, given the index of the worker running it.
+
+    /**
+     * @brief Constructs a WorkStealingPool object.
+     *
+     * @param workers The number of threads, at least 1.
+     */
+    explicit WorkStealingPool(std::size_t workers);
+
+    /**
+     * @brief Runs jobs until all of them are done.
+     *
+     * @param jobs The jobs to run.
+     */
+    void run(std::vector<Job> jobs);
+
+    /**
+     * @brief Gets the number of threads.
+     *
+     * @return The number of threads.
+     */
+    [[nodiscard]] std::size_t getWorkerCount() const { return queues.size(); }
+
+private:
+    /**
+     * @brief The jobs dealt to one worker.
+     */
+    struct Queue {
+        std::mutex mutex; ///< Guards jobs.
+        std::deque<Job> jobs; ///< The jobs not started yet.
+    };
+
+    std::vector<Queue> queues; ///< One queue per worker.
+
+    /**
+     * @brief Takes the next job of a worker, stealing one if its own queue is empty.
+     *
+     * @param worker The index of the worker.
+     * @param job Set to the job taken.
+     * @return True if a job was taken, false if all the queues are empty.
+     */
+    bool take(std::size_t worker, Job& job);
+};
+
+#endif
@@ -0,0 +1,282 @@
+/**
+ * @file afc_batch.cpp
+ * @brief Host tool re-processing many recordings with many parameter sets across cores.
+ *
+ * Every channel of every input file is processed once per parameter point (filter order, mu and
+ * notch frequency update rate), each as an independent job with its own NotchLMSFilter. The jobs
+ * run on a WorkStealingPool. Inputs are memory-mapped and shared by the jobs; each job prints one
+ * CSV line as soon as it finishes and, with --output-dir, writes its processed channel as a mono WAV.
+ *
+ * With --scaling the batch is run with 1, 2, 4, ... up to the requested number of threads and the
+ * tool reports the aggregate throughput and the scaling efficiency of each thread count instead.
+ *
+ * Usage:
+ *   afc_batch [--threads N] [--scaling] [--order N,...] [--mu X,...] [--rate X,...] [--output-dir DIR] input.wav...
+ */
+#include "MappedFile.h"
+#include "NotchLMSFilter.h"
+#include "WavFile.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief One point of the parameter grid.
+ */
+struct ParameterPoint {
+    std::size_t order; ///< Order of the LMS filter.
+    float mu; ///< Adaptation rate of the LMS filter.
+    float rate; ///< Frequency update rate of the adaptive notches.
+};
+
+/**
+ * @brief Options of the tool.
+ */
+struct Options {
+    std::vector<std::string> inputPaths; ///< Paths of the WAV files to process.
+    std::string outputDir; ///< Directory the processed channels are written to, or empty.
+    std::size_t threads{std::max(1u, std::thread::hardware_concurrency())}; ///< Number of threads.
+    bool scaling{false}; ///< True to measure the scaling from 1 to threads.
+    std::vector<std::size_t> orders{64}; ///< Orders of the grid.
+    std::vector<float> mus{0.01f}; ///< Adaptation rates of the grid, the highest rate of the step control.
+    std::vector<float> rates{0.01f}; ///< Frequency update rates of the grid.
+};
+
+/**
+ * @brief An input file mapped into memory.
+ */
+struct Input {
+    std::string path; ///< Path of the file.
+    MappedFile file; ///< Content of the file.
+    WavFormat format; ///< Layout of the file.
+};
+
+/**
+ * @brief Parses a comma-separated list of numbers.
+ *
+ * @tparam V The type of the numbers.
+ * @param text The list.
+ * @param values Set to the numbers.
+ * @return True if the list is valid, false otherwise.
+ */
+template<typename V>
+static bool parseList(const char* text, std::vector<V>& values) {
+    values.clear();
+    while (*text) {
+        char* end = nullptr;
+        const double value = std::strtod(text, &end);
+        if (end == text || value <= 0.0) return false;
+        values.push_back(static_cast<V>(value));
+        text = *end == ',' ? end + 1 : end;
+        if (*end != ',' && *end != '\0') return false;
+    }
+    return !values.empty();
+}
+
+/**
+ * @brief Prints the usage of the tool.
+ *
+ * @param program The name of the program.
+ */
+static void printUsage(const char* program) {
+    std::fprintf(stderr, "usage: %s [--threads N] [--scaling] [--order N,...] [--mu X,...] [--rate X,...] [--output-dir DIR] input.wav...\n", program);
+}
+
+/**
+ * @brief Parses the command line.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @param options The parsed options.
+ * @return True if the command line is valid, false otherwise.
+ */
+static bool parseOptions(const int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            options.threads = static_cast<std::size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--scaling") == 0) {
+            options.scaling = true;
+        } else if (std::strcmp(argv[i], "--order") == 0 && hasValue) {
+            if (!parseList(argv[++i], options.orders)) return false;
+        } else if (std::strcmp(argv[i], "--mu") == 0 && hasValue) {
+            if (!parseList(argv[++i], options.mus)) return false;
+        } else if (std::strcmp(argv[i], "--rate") == 0 && hasValue) {
+            if (!parseList(argv[++i], options.rates)) return false;
+        } else if (std::strcmp(argv[i], "--output-dir") == 0 && hasValue) {
+            options.outputDir = argv[++i];
+        } else if (argv[i][0] != '-') {
+            options.inputPaths.emplace_back(argv[i]);
+        } else {
+            return false;
+        }
+    }
+    return !options.inputPaths.empty();
+}
+
+/**
+ * @brief Computes the level of an energy accumulated over a number of samples.
+ *
+ * @param energy The sum of the squared samples.
+ * @param count The number of samples.
+ * @return The RMS level in dBFS.
+ */
+static double toDb(const double energy, const std::size_t count) {
+    return 10.0 * std::log10(energy / static_cast<double>(std::max<std::size_t>(count, 1)) + 1e-20);
+}
+
+/**
+ * @brief Builds the name of the file a job writes its output to.
+ *
+ * @param options The options of the tool.
+ * @param input The input file.
+ * @param channel The channel.
+ * @param point The parameter point.
+ * @return The path of the output file.
+ */
+static std::string outputPath(const Options& options, const Input& input, const std::size_t channel, const ParameterPoint& point) {
+    std::string stem = input.path.substr(input.path.find_last_of('/') + 1);
+    stem = stem.substr(0, stem.rfind('.'));
+    char suffix[96];
+    std::snprintf(suffix, sizeof(suffix), "_ch%zu_o%zu_mu%g_r%g.wav", channel, point.order, static_cast<double>(point.mu), static_cast<double>(point.rate));
+    return options.outputDir + "/" + stem + suffix;
+}
+
+/**
+ * @brief Runs the whole grid over all the inputs.
+ *
+ * @param options The options of the tool.
+ * @param inputs The mapped inputs.
+ * @param points The parameter grid.
+ * @param threads The number of threads.
+ * @param report True to print one CSV line per job and write the outputs.
+ * @return The wall-clock time of the batch, in seconds.
+ */
+static double runBatch(const Options& options, const std::vector<std::unique_ptr<Input>>& inputs,
+                       const std::vector<ParameterPoint>& points, const std::size_t threads, const bool report) {
+    using Traits = SampleTraits<float>;
+
+    std::mutex reportMutex;
+    std::vector<WorkStealingPool::Job> jobs;
+
+    for (const auto& input : inputs) {
+        for (std::size_t channel = 0; channel < input->format.channels; ++channel) {
+            for (const ParameterPoint& point : points) {
+                jobs.emplace_back([&options, &input, channel, point, report, &reportMutex](const std::size_t worker) {
+                    const WavFormat& format = input->format;
+                    const unsigned char* bytes = input->file.data();
+
+                    NotchLMSFilter<float> filter{point.order, 2750, 100};
+                    filter.setMu(point.mu);
+                    filter.setFrequencyUpdateRate(point.rate);
+
+                    WavFile output;
+                    if (report && !options.outputDir.empty()) {
+                        output.sampleRate = format.sampleRate;
+                        output.channels = 1;
+                        output.samples.resize(format.frameCount);
+                    }
+
+                    const auto start = std::chrono::steady_clock::now();
+                    float block[AUDIO_BLOCK_SAMPLES];
+                    double inputEnergy{0.0}, outputEnergy{0.0};
+                    for (std::size_t offset = 0; offset < format.frameCount; offset += AUDIO_BLOCK_SAMPLES) {
+                        const std::size_t count = std::min<std::size_t>(AUDIO_BLOCK_SAMPLES, format.frameCount - offset);
+                        for (std::size_t i = 0; i < count; ++i) {
+                            block[i] = Traits::fromInt16(format.sample(bytes, offset + i, channel));
+                            inputEnergy += static_cast<double>(block[i]) * block[i];
+                        }
+                        filter.processBlock(block, block, count);
+                        for (std::size_t i = 0; i < count; ++i) {
+                            outputEnergy += static_cast<double>(block[i]) * block[i];
+                        }
+                        if (!output.samples.empty()) {
+                            std::transform(block, block + count, output.samples.begin() + static_cast<std::ptrdiff_t>(offset), Traits::toInt16);
+                        }
+                    }
+                    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                    if (!report) return;
+
+                    std::string error;
+                    if (!output.samples.empty() && !output.write(outputPath(options, *input, channel, point), error)) {
+                        std::fprintf(stderr, "%s\n", error.c_str());
+                    }
+
+                    const std::lock_guard<std::mutex> lock{reportMutex};
+                    std::printf("%s,%zu,%zu,%g,%g,%.2f,%.2f,%.4f,%zu\n", input->path.c_str(), channel, point.order,
+                                static_cast<double>(point.mu), static_cast<double>(point.rate),
+                                toDb(inputEnergy, format.frameCount), toDb(outputEnergy, format.frameCount), seconds, worker);
+                    std::fflush(stdout);
+                });
+            }
+        }
+    }
+
+    WorkStealingPool pool{threads};
+    const auto start = std::chrono::steady_clock::now();
+    pool.run(std::move(jobs));
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(const int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::vector<std::unique_ptr<Input>> inputs;
+    std::size_t totalSamples{0}, totalChannels{0};
+    for (const std::string& path : options.inputPaths) {
+        auto input = std::make_unique<Input>();
+        input->path = path;
+        std::string error;
+        if (!input->file.open(path, error) || !input->format.parse(input->file.data(), input->file.size(), error)) {
+            std::fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+            return 1;
+        }
+        totalSamples += input->format.frameCount * input->format.channels;
+        totalChannels += input->format.channels;
+        inputs.push_back(std::move(input));
+    }
+
+    std::vector<ParameterPoint> points;
+    for (const std::size_t order : options.orders) {
+        for (const float mu : options.mus) {
+            for (const float rate : options.rates) {
+                points.push_back({order, mu, rate});
+            }
+        }
+    }
+    const auto processed = static_cast<double>(totalSamples * points.size());
+
+    if (options.scaling) {
+        std::printf("%8s %16s %12s\n", "threads", "samples/s", "efficiency");
+        double single{0.0};
+        for (std::size_t threads = 1;; threads = std::min(threads * 2, options.threads)) {
+            const double throughput = processed / runBatch(options, inputs, points, threads, false);
+            if (threads == 1) single = throughput;
+            std::printf("%8zu %16.0f %11.0f%%\n", threads, throughput, 100.0 * throughput / (single * static_cast<double>(threads)));
+            if (threads == options.threads) break;
+        }
+        return 0;
+    }
+
+    std::printf("file,channel,order,mu,rate,input_db,output_db,seconds,worker\n");
+    const double seconds = runBatch(options, inputs, points, options.threads, true);
+    std::printf("# %zu jobs on %zu threads: %.0f samples in %.3f s, %.0f samples/s\n",
+                totalChannels * points.size(), options.threads, processed, seconds, processed / seconds);
+    return 0;
+}
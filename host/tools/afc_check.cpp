@@ -0,0 +1,502 @@
+/**
+ * @file afc_check.cpp
+ * @brief Host tool checking the DSP chain against golden vectors and a timing baseline.
+ *
+ * Every case feeds the same deterministic 16-bit input, tones, a howl that jumps in frequency
+ * halfway and white noise, through one class of the chain built for afc_sample_t: LMSFilter one
+ * sample at a time and by blocks, SelectableLMSFilter with each algorithm, NotchFilter, NotchBank,
+ * NotchLMSFilter, PartitionedFDAFFilter and SubbandCanceller in the floating-point builds, and
+ * AdaptiveFeedbackCanceller through the host Audio.h. Each case is run --repeat times and its cost
+ * is the fastest run, in nanoseconds per sample.
+ *
+ * --record DIR writes the golden vector of every case, every GOLDEN_STRIDE-th output sample, to
+ * DIR/CASE.csv, creating DIR if needed. --check DIR compares against them: a case fails if it has
+ * no golden vector, or if the energy of its difference to the golden vector, relative to the
+ * energy of the golden vector, exceeds --tolerance. A build of the same sources and flags
+ * reproduces its golden vectors exactly; the tolerance absorbs other compilers and flags. Golden
+ * vectors are only comparable within one build variant (sample type and adaptive filter), which
+ * each file records, so record one directory per variant. The vectors of the default build are
+ * kept in host/golden/float-lms.
+ *
+ * Timings only compare on one machine, so they are kept apart: --timing FILE writes the costs to
+ * FILE when recording, and when checking fails a case that is more than --max-slowdown percent
+ * slower than FILE.
+ *
+ * One CSV line is printed per case, prefixed with --label (a commit hash, for instance) so that
+ * runs across commits can be concatenated. The exit status is 0 if every case passed, 1 if one
+ * failed and 2 on a usage or file error.
+ *
+ * Usage:
+ *   afc_check [--tolerance DB] [--max-slowdown PCT] [--repeat N] [--label TEXT] [--timing FILE] (--record DIR | --check DIR)
+ */
+#include "AdaptiveFeedbackCanceller.h"
+#include "LMSFilter.h"
+#include "NotchBank.h"
+#include "NotchFilter.h"
+#include "NotchLMSFilter.h"
+#include "PartitionedFDAFFilter.h"
+#include "SelectableLMSFilter.h"
+#include "SubbandCanceller.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(AFC_SAMPLE_Q15)
+#define CHECK_SAMPLE_NAME "q15"
+#elif defined(AFC_SAMPLE_Q31)
+#define CHECK_SAMPLE_NAME "q31"
+#elif defined(AFC_SAMPLE_DOUBLE)
+#define CHECK_SAMPLE_NAME "double"
+#else
+#define CHECK_SAMPLE_NAME "float"
+#endif
+
+#if defined(AFC_FDAF)
+#define CHECK_FILTER_NAME "fdaf"
+#elif defined(AFC_SUBBAND)
+#define CHECK_FILTER_NAME "subband"
+#else
+#define CHECK_FILTER_NAME "lms"
+#endif
+
+constexpr const char* VARIANT{CHECK_SAMPLE_NAME "-" CHECK_FILTER_NAME}; ///< Build variant the golden vectors belong to.
+constexpr std::size_t INPUT_SAMPLES{AUDIO_BLOCK_SAMPLES * 1024}; ///< Length of the input, about 3 s.
+constexpr std::size_t GOLDEN_STRIDE{64}; ///< Spacing of the output samples kept in a golden vector.
+constexpr std::size_t ORDER{64}; ///< Order of the LMS filters.
+constexpr std::size_t LONG_ORDER{1024}; ///< Order of the frequency-domain and subband filters.
+
+using Traits = SampleTraits<afc_sample_t>; ///< Arithmetic of the sample type.
+
+/**
+ * @brief Options of the tool.
+ */
+struct Options {
+    std::string directory; ///< Directory of the golden vectors.
+    std::string timingPath; ///< Path of the timing baseline, or empty.
+    std::string label; ///< First column of every line.
+    bool record{false}; ///< True to record, false to check.
+    double toleranceDb{-90.0}; ///< Largest relative error energy of a passing case, in dB.
+    double maxSlowdown{10.0}; ///< Largest slowdown of a passing case, in percent.
+    int repeat{5}; ///< Number of timed runs of each case.
+};
+
+/**
+ * @brief A case: runs one class over the input and returns the time spent processing, in nanoseconds.
+ */
+struct Case {
+    std::string name; ///< Name of the case, also the name of its golden vector.
+    std::function<double(const std::vector<std::int16_t>& input, std::vector<float>& output)> run; ///< Runs the case.
+};
+
+/**
+ * @brief Timing baseline of a case.
+ */
+struct Baseline {
+    std::size_t samples{0}; ///< Length of the output.
+    double nsPerSample{0.0}; ///< Cost of the case when recorded.
+};
+
+/**
+ * @brief Prints the usage of the tool.
+ *
+ * @param program The name of the program.
+ */
+static void printUsage(const char* program) {
+    std::fprintf(stderr, "usage: %s [--tolerance DB] [--max-slowdown PCT] [--repeat N] [--label TEXT] [--timing FILE] (--record DIR | --check DIR)\n",
+                 program);
+}
+
+/**
+ * @brief Parses the command line.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @param options The parsed options.
+ * @return True if the command line is valid, false otherwise.
+ */
+static bool parseOptions(const int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        if ((std::strcmp(argv[i], "--record") == 0 || std::strcmp(argv[i], "--check") == 0) && i + 1 < argc) {
+            if (!options.directory.empty()) return false;
+            options.record = std::strcmp(argv[i], "--record") == 0;
+            options.directory = argv[++i];
+        } else if (std::strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            options.toleranceDb = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--max-slowdown") == 0 && i + 1 < argc) {
+            options.maxSlowdown = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            options.repeat = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+            options.label = argv[++i];
+        } else if (std::strcmp(argv[i], "--timing") == 0 && i + 1 < argc) {
+            options.timingPath = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return !options.directory.empty() && options.repeat > 0;
+}
+
+/**
+ * @brief Generates the input: two tones, a howl jumping from 2750 Hz to 3400 Hz halfway and white noise.
+ *
+ * @return The 16-bit input.
+ */
+static std::vector<std::int16_t> makeInput() {
+    std::mt19937 rng{42};
+    std::normal_distribution<double> noise{0.0, 0.05};
+    std::vector<std::int16_t> input(INPUT_SAMPLES);
+    double howlPhase{0.0};
+    for (std::size_t i = 0; i < INPUT_SAMPLES; ++i) {
+        const double t = static_cast<double>(i) / AUDIO_SAMPLE_RATE_EXACT;
+        const double howlFrequency = i < INPUT_SAMPLES / 2 ? 2750.0 : 3400.0;
+        howlPhase += 2.0 * M_PI * howlFrequency / AUDIO_SAMPLE_RATE_EXACT;
+        const double howlLevel = 0.05 + 0.25 * static_cast<double>(i % (INPUT_SAMPLES / 2)) / static_cast<double>(INPUT_SAMPLES / 2);
+        const double x = 0.2 * std::sin(2.0 * M_PI * 440.0 * t) + 0.1 * std::sin(2.0 * M_PI * 1200.0 * t) + howlLevel * std::sin(howlPhase)
+                         + noise(rng);
+        input[i] = static_cast<std::int16_t>(std::lround(std::max(-1.0, std::min(1.0, x)) * 32767.0));
+    }
+    return input;
+}
+
+/**
+ * @brief Runs a filter one sample at a time.
+ *
+ * @tparam Filter The filter type, with a T tick(T) method.
+ * @param filter The filter.
+ * @param input The input.
+ * @param output The output, in full-scale units.
+ * @return The time spent in tick(), in nanoseconds.
+ */
+template<typename Filter>
+static double runTick(Filter& filter, const std::vector<std::int16_t>& input, std::vector<float>& output) {
+    std::vector<afc_sample_t> samples(input.size());
+    for (std::size_t i = 0; i < input.size(); ++i) samples[i] = Traits::fromInt16(input[i]);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (afc_sample_t& sample : samples) sample = filter.tick(sample);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    output.resize(samples.size());
+    for (std::size_t i = 0; i < samples.size(); ++i) output[i] = static_cast<float>(Traits::toReal(samples[i]));
+    return std::chrono::duration<double, std::nano>(elapsed).count();
+}
+
+/**
+ * @brief Runs a filter by blocks of AUDIO_BLOCK_SAMPLES samples, in place.
+ *
+ * @tparam Filter The filter type, with a processBlock(const T*, T*, std::size_t) method.
+ * @param filter The filter.
+ * @param input The input.
+ * @param output The output, in full-scale units.
+ * @return The time spent in processBlock(), in nanoseconds.
+ */
+template<typename Filter>
+static double runBlocks(Filter& filter, const std::vector<std::int16_t>& input, std::vector<float>& output) {
+    std::vector<afc_sample_t> samples(input.size());
+    for (std::size_t i = 0; i < input.size(); ++i) samples[i] = Traits::fromInt16(input[i]);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t offset = 0; offset + AUDIO_BLOCK_SAMPLES <= samples.size(); offset += AUDIO_BLOCK_SAMPLES) {
+        filter.processBlock(&samples[offset], &samples[offset], AUDIO_BLOCK_SAMPLES);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    output.resize(samples.size());
+    for (std::size_t i = 0; i < samples.size(); ++i) output[i] = static_cast<float>(Traits::toReal(samples[i]));
+    return std::chrono::duration<double, std::nano>(elapsed).count();
+}
+
+/**
+ * @brief Runs a single-channel AdaptiveFeedbackCanceller in its default settings through the host Audio.h.
+ *
+ * @param input The input.
+ * @param output The output, in full-scale units.
+ * @return The time spent in update(), in nanoseconds.
+ */
+static double runCanceller(const std::vector<std::int16_t>& input, std::vector<float>& output) {
+    auto canceller = std::make_unique<AdaptiveFeedbackCanceller<1>>();
+    output.assign(input.size(), 0.0f);
+
+    std::chrono::steady_clock::duration elapsed{};
+    for (std::size_t offset = 0; offset + AUDIO_BLOCK_SAMPLES <= input.size(); offset += AUDIO_BLOCK_SAMPLES) {
+        audio_block_t* block = AudioStream::allocate();
+        std::copy_n(&input[offset], AUDIO_BLOCK_SAMPLES, block->data);
+        canceller->setInputBlock(block);
+
+        const auto start = std::chrono::steady_clock::now();
+        canceller->update();
+        elapsed += std::chrono::steady_clock::now() - start;
+
+        if (audio_block_t* processed = canceller->takeOutputBlock()) {
+            for (std::size_t i = 0; i < AUDIO_BLOCK_SAMPLES; ++i) output[offset + i] = static_cast<float>(processed->data[i]) / 32768.0f;
+            AudioStream::release(processed);
+        }
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count();
+}
+
+/**
+ * @brief Lists the cases of this build.
+ *
+ * @return The cases.
+ */
+static std::vector<Case> makeCases() {
+    std::vector<Case> cases;
+    cases.push_back({"lms_tick", [](const std::vector<std::int16_t>& input, std::vector<float>& output) {
+                         LMSFilter<afc_sample_t> filter{ORDER};
+                         return runTick(filter, input, output);
+                     }});
+    cases.push_back({"lms_block", [](const std::vector<std::int16_t>& input, std::vector<float>& output) {
+                         LMSFilter<afc_sample_t> filter{ORDER};
+                         return runBlocks(filter, input, output);
+                     }});
+    for (std::size_t i = 0; i < LMS_ALGORITHM_COUNT; ++i) {
+        const auto algorithm = static_cast<LMSAlgorithm>(i);
+        std::string name = std::string{"lms_"} + lmsAlgorithmName(algorithm);
+        std::transform(name.begin(), name.end(), name.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        cases.push_back({name, [algorithm](const std::vector<std::int16_t>& input, std::vector<float>& output) {
+                             SelectableLMSFilter<afc_sample_t> filter{ORDER};
+                             filter.select(algorithm);
+                             return runBlocks(filter, input, output);
+                         }});
+    }
+    cases.push_back({"notch_tick", [](const std::vector<std::int16_t>& input, std::vector<float>& output) {
+                         NotchFilter<afc_sample_t> filter{2750, 100};
+                         return runTick(filter, input, output);
+                     }});
+    cases.push_back({"notch_bank", [](const std::vector<std::int16_t>& input, std::vector<float>& output) {
+                         NotchBank<afc_sample_t> bank{4};
+                         std::size_t index{0};
+                         for (const float frequency : {440.0f, 1200.0f, 2750.0f, 3400.0f}) {
+                             bank.setNotch(index++, frequency, NotchBank<afc_sample_t>::bandwidthFor(frequency));
+                         }
+                         return runBlocks(bank, input, output);
+                     }});
+    cases.push_back({"notch_lms", [](const std::vector<std::int16_t>& input, std::vector<float>& output) {
+                         NotchLMSFilter<afc_sample_t> filter{ORDER, 2750, 100};
+                         return runBlocks(filter, input, output);
+                     }});
+#if !defined(AFC_SAMPLE_Q15) && !defined(AFC_SAMPLE_Q31)
+    cases.push_back({"fdaf", [](const std::vector<std::int16_t>& input, std::vector<float>& output) {
+                         PartitionedFDAFFilter<afc_sample_t> filter{LONG_ORDER};
+                         return runBlocks(filter, input, output);
+                     }});
+    cases.push_back({"subband", [](const std::vector<std::int16_t>& input, std::vector<float>& output) {
+                         SubbandCanceller<afc_sample_t> filter{LONG_ORDER};
+                         return runBlocks(filter, input, output);
+                     }});
+#endif
+    cases.push_back({"canceller", runCanceller});
+    return cases;
+}
+
+/**
+ * @brief Writes a golden vector: every GOLDEN_STRIDE-th sample of an output.
+ *
+ * @param path The path of the file.
+ * @param output The output.
+ * @return True if the file was written, false otherwise.
+ */
+static bool writeGolden(const std::string& path, const std::vector<float>& output) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+    std::fprintf(file, "# variant %s\nsample,output\n", VARIANT);
+    for (std::size_t i = 0; i < output.size(); i += GOLDEN_STRIDE) {
+        std::fprintf(file, "%zu,%.9g\n", i, static_cast<double>(output[i]));
+    }
+    return std::fclose(file) == 0;
+}
+
+/**
+ * @brief Reads a golden vector.
+ *
+ * @param path The path of the file.
+ * @param variant The build variant it was recorded with.
+ * @param golden The samples of the golden vector.
+ * @return True if the file was read, false otherwise.
+ */
+static bool readGolden(const std::string& path, std::string& variant, std::vector<float>& golden) {
+    std::FILE* file = std::fopen(path.c_str(), "r");
+    if (!file) return false;
+    char line[256], name[128];
+    std::size_t index{0};
+    float sample{0.0f};
+    bool ordered{true};
+    golden.clear();
+    while (std::fgets(line, sizeof(line), file)) {
+        if (std::sscanf(line, "# variant %127s", name) == 1) {
+            variant = name;
+        } else if (std::sscanf(line, "%zu,%f", &index, &sample) == 2) {
+            ordered = ordered && index == golden.size() * GOLDEN_STRIDE;
+            golden.push_back(sample);
+        }
+    }
+    std::fclose(file);
+    return ordered;
+}
+
+/**
+ * @brief Keeps the samples of an output that a golden vector holds.
+ *
+ * @param output The output.
+ * @return Every GOLDEN_STRIDE-th sample of the output.
+ */
+static std::vector<float> decimate(const std::vector<float>& output) {
+    std::vector<float> samples;
+    for (std::size_t i = 0; i < output.size(); i += GOLDEN_STRIDE) samples.push_back(output[i]);
+    return samples;
+}
+
+/**
+ * @brief Reads a timing baseline.
+ *
+ * @param path The path of the baseline.
+ * @param variant The build variant it was recorded with.
+ * @param baselines The baseline of each case.
+ * @return True if the file was read, false otherwise.
+ */
+static bool readBaseline(const std::string& path, std::string& variant, std::map<std::string, Baseline>& baselines) {
+    std::FILE* file = std::fopen(path.c_str(), "r");
+    if (!file) return false;
+    char line[256], name[128];
+    while (std::fgets(line, sizeof(line), file)) {
+        Baseline baseline;
+        if (std::sscanf(line, "# variant %127s", name) == 1) {
+            variant = name;
+        } else if (std::sscanf(line, "%127[^,],%zu,%lf", name, &baseline.samples, &baseline.nsPerSample) == 3) {
+            baselines[name] = baseline;
+        }
+    }
+    std::fclose(file);
+    return true;
+}
+
+/**
+ * @brief Computes the energy of the difference between an output and its golden vector, relative to the golden vector.
+ *
+ * @param golden The golden vector.
+ * @param output The samples of the output the golden vector holds.
+ * @return The relative error energy, in dB, -inf if they are identical.
+ */
+static double relativeError(const std::vector<float>& golden, const std::vector<float>& output) {
+    double goldenEnergy{0.0}, errorEnergy{0.0};
+    for (std::size_t i = 0; i < golden.size(); ++i) {
+        const double error = static_cast<double>(output[i]) - golden[i];
+        goldenEnergy += static_cast<double>(golden[i]) * golden[i];
+        errorEnergy += error * error;
+    }
+    if (errorEnergy == 0.0) return -INFINITY;
+    return 10.0 * std::log10(errorEnergy / (goldenEnergy + 1e-30));
+}
+
+int main(const int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::string variant{VARIANT};
+    std::map<std::string, Baseline> baselines;
+    if (!options.record && !options.timingPath.empty()) {
+        if (!readBaseline(options.timingPath, variant, baselines)) {
+            std::fprintf(stderr, "cannot read %s\n", options.timingPath.c_str());
+            return 2;
+        }
+        if (variant != VARIANT) {
+            std::fprintf(stderr, "%s was recorded with the %s build, this is the %s build\n", options.timingPath.c_str(), variant.c_str(), VARIANT);
+            return 2;
+        }
+    }
+
+    if (options.record) {
+        std::error_code error;
+        std::filesystem::create_directories(options.directory, error);
+        if (error) {
+            std::fprintf(stderr, "cannot create %s: %s\n", options.directory.c_str(), error.message().c_str());
+            return 2;
+        }
+    }
+
+    std::FILE* baselineFile{nullptr};
+    if (options.record && !options.timingPath.empty()) {
+        baselineFile = std::fopen(options.timingPath.c_str(), "w");
+        if (!baselineFile) {
+            std::fprintf(stderr, "cannot write %s\n", options.timingPath.c_str());
+            return 2;
+        }
+        std::fprintf(baselineFile, "# variant %s\ncase,samples,ns_per_sample\n", VARIANT);
+    }
+
+    const std::vector<std::int16_t> input = makeInput();
+    std::printf("label,variant,case,samples,error_db,golden,ns_per_sample,baseline_ns_per_sample,slowdown_pct,timing\n");
+    int failures{0};
+    for (const Case& test : makeCases()) {
+        std::vector<float> output, repeated;
+        double elapsed = test.run(input, output);
+        for (int i = 1; i < options.repeat; ++i) elapsed = std::min(elapsed, test.run(input, repeated));
+        const double nsPerSample = elapsed / static_cast<double>(input.size());
+        const std::string goldenPath = options.directory + "/" + test.name + ".csv";
+
+        if (options.record) {
+            if (!writeGolden(goldenPath, output)) {
+                std::fprintf(stderr, "cannot write %s\n", goldenPath.c_str());
+                return 2;
+            }
+            if (baselineFile) std::fprintf(baselineFile, "%s,%zu,%.3f\n", test.name.c_str(), output.size(), nsPerSample);
+            std::printf("%s,%s,%s,%zu,,recorded,%.3f,,,recorded\n", options.label.c_str(), VARIANT, test.name.c_str(), output.size(), nsPerSample);
+            continue;
+        }
+
+        std::vector<float> golden;
+        std::string goldenVariant;
+        double errorDb{NAN};
+        const char* goldenStatus = "missing";
+        if (readGolden(goldenPath, goldenVariant, golden)) {
+            if (goldenVariant != VARIANT) {
+                std::fprintf(stderr, "%s was recorded with the %s build, this is the %s build\n", goldenPath.c_str(), goldenVariant.c_str(), VARIANT);
+                return 2;
+            }
+            const std::vector<float> samples = decimate(output);
+            if (golden.size() != samples.size()) {
+                goldenStatus = "fail";
+            } else {
+                errorDb = relativeError(golden, samples);
+                goldenStatus = errorDb <= options.toleranceDb ? "pass" : "fail";
+            }
+        }
+
+        double baselineNs{NAN}, slowdown{NAN};
+        const char* timingStatus = "missing";
+        const auto baseline = baselines.find(test.name);
+        if (baseline != baselines.end() && baseline->second.nsPerSample > 0.0) {
+            baselineNs = baseline->second.nsPerSample;
+            slowdown = 100.0 * (nsPerSample / baselineNs - 1.0);
+            timingStatus = slowdown <= options.maxSlowdown ? "pass" : "fail";
+        }
+
+        if (std::strcmp(goldenStatus, "pass") != 0 || std::strcmp(timingStatus, "fail") == 0) ++failures;
+        std::printf("%s,%s,%s,%zu,%.1f,%s,%.3f,%.3f,%.1f,%s\n", options.label.c_str(), VARIANT, test.name.c_str(), output.size(), errorDb,
+                    goldenStatus, nsPerSample, baselineNs, slowdown, timingStatus);
+    }
+
+    if (baselineFile && std::fclose(baselineFile) != 0) {
+        std::fprintf(stderr, "cannot write %s\n", options.timingPath.c_str());
+        return 2;
+    }
+    if (failures > 0) std::fprintf(stderr, "%d case(s) failed\n", failures);
+    return failures > 0 ? 1 : 0;
+}
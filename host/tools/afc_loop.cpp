@@ -0,0 +1,274 @@
+/**
+ * @file afc_loop.cpp
+ * @brief Host tool closing the acoustic feedback loop around AdaptiveFeedbackCanceller.
+ *
+ * The canceller runs in a FeedbackLoop: its output goes through the impulse response of a
+ * loudspeaker-room-microphone path and back into its input, with a source added at the
+ * microphone. The scenes are every pair of a path and a source: by default the synthetic near
+ * (1024 taps) and room (4096 taps) paths and the synthetic speech, music and noise sources, at
+ * -26 dBFS. --path and --source replace them with the first channel of a WAV file; a path file
+ * is taken as it is, in full-scale units. --scene keeps the scene of that name.
+ *
+ * For each scene the tool reports the maximum stable gain (MSG) predicted from the peak of the
+ * path response, and the MSG found by simulation without processing and with the canceller, whose
+ * difference is the added stable gain (ASG). It then holds the gain 10 dB below the MSG without
+ * processing for SETTLE_SECONDS, steps it HOWL_STEP_DB above it and reports the time the howl takes
+ * to be suppressed without processing and with the canceller, the level of the output of the
+ * canceller relative to the source times the gain, which exposes a canceller that buys its stable
+ * gain by removing the source, the misalignment of the adaptive filter at the end, and the cycle
+ * counter ticks of update() per sample.
+ *
+ * With --gain, each scene is run once instead, stepping from 10 dB below that gain to it after
+ * SETTLE_SECONDS; --record then writes the microphone and loudspeaker signals of the single
+ * selected scene as a stereo WAV file.
+ *
+ * With --latency, the loudspeaker is wired straight to the microphone and the LatencyProbe of the
+ * loop sends a click through it, as the firmware does over a loopback cable. The tool reports the
+ * samples the click took from the output of the canceller back to it, the block of the loop and
+ * the algorithmic delay of the canceller, for the block size and sample rate of the build.
+ *
+ * Usage:
+ *   afc_loop [--no-lms] [--no-notch] [--in-filter] [--algorithm NAME] [--path IR.wav] [--source SOURCE.wav]
+ *            [--scene NAME] [--seconds S] [--gain DB [--record FILE]] [--latency]
+ */
+#include "FeedbackLoop.h"
+#include "WavFile.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+constexpr float SOURCE_LEVEL{0.05f}; ///< RMS level of the synthetic sources, -26 dBFS.
+constexpr double SETTLE_SECONDS{4.0}; ///< Duration of the gain below the MSG before the step.
+constexpr double HOWL_STEP_DB{3.0}; ///< Gain of the step above the MSG without processing, in dB.
+constexpr double SEARCH_BELOW_DB{10.0}; ///< Start of the MSG search below the predicted MSG, in dB.
+constexpr double SEARCH_ABOVE_DB{30.0}; ///< End of the MSG search above the predicted MSG, in dB.
+
+/**
+ * @brief Options of the tool.
+ */
+struct Options {
+    LoopSettings settings; ///< Settings of the canceller.
+    std::string pathFile; ///< WAV file of the path, empty for the synthetic paths.
+    std::string sourceFile; ///< WAV file of the source, empty for the synthetic sources.
+    std::string scene; ///< Name of the only scene to run, empty for all.
+    std::string recordPath; ///< WAV file receiving the signals of the run, empty for none.
+    double seconds{8.0}; ///< Duration of a run after the gain step, in seconds.
+    double gainDb{0.0}; ///< Gain of the single run, in dB.
+    bool fixedGain{false}; ///< True to run each scene once at gainDb.
+    bool latency{false}; ///< True to measure the round-trip latency instead of running the scenes.
+};
+
+/**
+ * @brief Prints the usage of the tool.
+ *
+ * @param program The name of the program.
+ */
+static void printUsage(const char* program) {
+    std::fprintf(stderr, "usage: %s [--no-lms] [--no-notch] [--in-filter] [--algorithm NAME] [--path IR.wav] [--source SOURCE.wav]\n"
+                         "       [--scene NAME] [--seconds S] [--gain DB [--record FILE]] [--latency]\n", program);
+}
+
+/**
+ * @brief Parses the command line.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @param options The parsed options.
+ * @return True if the command line is valid, false otherwise.
+ */
+static bool parseOptions(const int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--no-lms") == 0) {
+            options.settings.lms = false;
+        } else if (std::strcmp(argv[i], "--no-notch") == 0) {
+            options.settings.notch = false;
+        } else if (std::strcmp(argv[i], "--in-filter") == 0) {
+            options.settings.howlDetector = false;
+#if !defined(AFC_FDAF) && !defined(AFC_SUBBAND)
+        } else if (std::strcmp(argv[i], "--algorithm") == 0 && i + 1 < argc) {
+            if (!parseLMSAlgorithm(argv[++i], options.settings.algorithm)) return false;
+#endif
+        } else if (std::strcmp(argv[i], "--path") == 0 && i + 1 < argc) {
+            options.pathFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--source") == 0 && i + 1 < argc) {
+            options.sourceFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+            options.scene = argv[++i];
+        } else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            options.seconds = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--gain") == 0 && i + 1 < argc) {
+            options.gainDb = std::atof(argv[++i]);
+            options.fixedGain = true;
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            options.recordPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--latency") == 0) {
+            options.latency = true;
+        } else {
+            return false;
+        }
+    }
+    return options.seconds > 0.0 && (options.recordPath.empty() || options.fixedGain);
+}
+
+/**
+ * @brief Reads the first channel of a WAV file in full-scale units.
+ *
+ * @param path The path of the file.
+ * @param samples The samples.
+ * @return True if the file was read, false otherwise.
+ */
+static bool readSignal(const std::string& path, std::vector<float>& samples) {
+    WavFile file;
+    std::string error;
+    if (!file.read(path, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
+    if (std::abs(static_cast<double>(file.sampleRate) - AUDIO_SAMPLE_RATE_EXACT) > 0.01 * AUDIO_SAMPLE_RATE_EXACT) {
+        std::fprintf(stderr, "warning: %s is sampled at %u Hz, the loop runs at %.0f Hz\n", path.c_str(), file.sampleRate,
+                     static_cast<double>(AUDIO_SAMPLE_RATE_EXACT));
+    }
+    samples.resize(file.getFrameCount());
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = static_cast<float>(file.samples[i * file.channels]) / 32768.0f;
+    }
+    return true;
+}
+
+/**
+ * @brief Formats a time to suppress a howl for the result table.
+ *
+ * @param buffer The output buffer.
+ * @param size The size of the output buffer.
+ * @param seconds The time, 0 if nothing howled, -1 if the howl was never suppressed.
+ * @return The formatted string.
+ */
+static const char* formatSuppression(char* buffer, const std::size_t size, const double seconds) {
+    if (seconds < 0.0) {
+        std::snprintf(buffer, size, "never");
+    } else if (seconds == 0.0) {
+        std::snprintf(buffer, size, "-");
+    } else {
+        std::snprintf(buffer, size, "%.0f", 1000.0 * seconds);
+    }
+    return buffer;
+}
+
+/**
+ * @brief Measures the round-trip latency of the loop with its probe, the loudspeaker wired to the microphone.
+ *
+ * @param settings The settings of the canceller.
+ * @return True if the click came back, false otherwise.
+ */
+static bool measureLatency(const LoopSettings& settings) {
+    FeedbackLoop loop({1.0f}, settings, 0.0f);
+    const float silence[AUDIO_BLOCK_SAMPLES]{};
+    std::int16_t microphone[AUDIO_BLOCK_SAMPLES], loudspeaker[AUDIO_BLOCK_SAMPLES];
+    LatencyProbe& probe = loop.getLatencyProbe();
+    probe.start();
+
+    LatencyResult result{};
+    while (!probe.takeResult(result)) loop.processBlock(silence, microphone, loudspeaker);
+
+    std::printf("block %u samples at %.1f Hz\n", static_cast<unsigned>(AUDIO_BLOCK_SAMPLES), static_cast<double>(AUDIO_SAMPLE_RATE_EXACT));
+    if (!result.detected) {
+        std::printf("no click back after %lu samples\n", static_cast<unsigned long>(result.samples));
+        return false;
+    }
+    std::printf("latency %lu samples, %.2f ms: %u through the loop, %lu of algorithmic delay\n", static_cast<unsigned long>(result.samples),
+                1000.0 * result.samples / AUDIO_SAMPLE_RATE_EXACT, static_cast<unsigned>(AUDIO_BLOCK_SAMPLES),
+                static_cast<unsigned long>(result.samples - AUDIO_BLOCK_SAMPLES));
+    return true;
+}
+
+int main(const int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    if (options.latency) return measureLatency(options.settings) ? 0 : 1;
+
+    const double runSeconds = SETTLE_SECONDS + options.seconds;
+    const auto sourceSamples = static_cast<std::size_t>(std::max(runSeconds, MSG_RUN_SECONDS) * AUDIO_SAMPLE_RATE_EXACT);
+    std::vector<LoopScene> paths, sources;
+    if (options.pathFile.empty()) {
+        paths.push_back({"near", makeRoomPath(1024, 64, 11), {}});
+        paths.push_back({"room", makeRoomPath(4096, 256, 12), {}});
+    } else {
+        paths.push_back({"file", {}, {}});
+        if (!readSignal(options.pathFile, paths.back().path)) return 1;
+    }
+    if (options.sourceFile.empty()) {
+        sources.push_back({"speech", {}, makeSpeech(sourceSamples, SOURCE_LEVEL, 21)});
+        sources.push_back({"music", {}, makeMusic(sourceSamples, SOURCE_LEVEL, 22)});
+        sources.push_back({"noise", {}, makeNoise(sourceSamples, SOURCE_LEVEL, 23)});
+    } else {
+        sources.push_back({"file", {}, {}});
+        if (!readSignal(options.sourceFile, sources.back().source)) return 1;
+    }
+
+    std::vector<LoopScene> scenes;
+    for (const LoopScene& source : sources) {
+        for (const LoopScene& path : paths) {
+            const std::string name = source.name + "/" + path.name;
+            if (options.scene.empty() || options.scene == name) scenes.push_back({name, path.path, source.source});
+        }
+    }
+    if (scenes.empty() || (!options.recordPath.empty() && scenes.size() != 1)) {
+        std::fprintf(stderr, "%s\n", scenes.empty() ? "no scene of that name" : "--record needs a single scene, select it with --scene");
+        return 2;
+    }
+
+    LoopSettings bare = options.settings;
+    bare.lms = bare.notch = bare.howlDetector = false;
+    char off[16], on[16];
+
+    if (options.fixedGain) {
+        std::printf("%-14s %8s %7s %12s %10s %8s %10s %10s\n", "scene", "gain dB", "stable", "suppress ms", "excess dB", "out dB", "misalign", "cycles");
+        for (const LoopScene& scene : scenes) {
+            std::vector<std::int16_t> recording;
+            const LoopResult result = runScene(scene, options.settings, options.gainDb - 10.0, options.gainDb, SETTLE_SECONDS, 0.0,
+                                               runSeconds, options.recordPath.empty() ? nullptr : &recording);
+            std::printf("%-14s %8.1f %7s %12s %10.1f %8.1f %10.2f %10.1f\n", scene.name.c_str(), options.gainDb, result.stable ? "yes" : "no",
+                        formatSuppression(on, sizeof(on), result.suppressSeconds), result.peakExcess, result.outputLevel,
+                        result.misalignment, result.cyclesPerSample);
+
+            if (!options.recordPath.empty()) {
+                WavFile output;
+                output.sampleRate = static_cast<std::uint32_t>(std::lround(AUDIO_SAMPLE_RATE_EXACT));
+                output.channels = 2;
+                output.samples = std::move(recording);
+                std::string error;
+                if (!output.write(options.recordPath, error)) {
+                    std::fprintf(stderr, "%s\n", error.c_str());
+                    return 1;
+                }
+            }
+        }
+        return 0;
+    }
+
+    std::printf("%-14s %7s %8s %8s %6s %13s %12s %7s %9s %8s\n", "scene", "MSG0 dB", "MSG off", "MSG on", "ASG", "suppress off", "suppress on",
+                "out dB", "misalign", "cycles");
+    for (const LoopScene& scene : scenes) {
+        const double predicted = pathStableGain(scene.path);
+        const double low = predicted - SEARCH_BELOW_DB, high = predicted + SEARCH_ABOVE_DB;
+        const double bareGain = findStableGain(scene, bare, low, high);
+        const double cancelledGain = findStableGain(scene, options.settings, low, high);
+
+        const double step = bareGain + HOWL_STEP_DB;
+        const LoopResult bareRun = runScene(scene, bare, bareGain - 10.0, step, SETTLE_SECONDS, 0.0, runSeconds);
+        const LoopResult cancelledRun = runScene(scene, options.settings, bareGain - 10.0, step, SETTLE_SECONDS, 0.0, runSeconds);
+
+        std::printf("%-14s %7.1f %8.1f %8.1f %6.1f %13s %12s %7.1f %9.2f %8.1f\n", scene.name.c_str(), predicted, bareGain, cancelledGain,
+                    cancelledGain - bareGain, formatSuppression(off, sizeof(off), bareRun.suppressSeconds),
+                    formatSuppression(on, sizeof(on), cancelledRun.suppressSeconds), cancelledRun.outputLevel, cancelledRun.misalignment,
+                    cancelledRun.cyclesPerSample);
+    }
+    return 0;
+}
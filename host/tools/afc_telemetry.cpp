@@ -0,0 +1,109 @@
+/**
+ * @file afc_telemetry.cpp
+ * @brief Host tool decoding a binary telemetry stream.
+ *
+ * The input is a raw capture of the firmware serial output, or a file written by
+ * afc_wav --telemetry. Each frame is printed as a CSV line starting with its type and sequence
+ * number; text lines found between frames are printed prefixed with '#'. The numbers of frames
+ * decoded, corrupt and lost are reported on stderr.
+ *
+ * Usage:
+ *   afc_telemetry [FILE]    reads standard input when FILE is absent or '-'
+ */
+#include "Telemetry.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+/**
+ * @brief Prints a decoded frame as a CSV line.
+ *
+ * @param decoder The decoder holding the frame.
+ */
+static void printFrame(const TelemetryDecoder& decoder) {
+    const unsigned sequence = decoder.getSequence();
+    switch (decoder.getType()) {
+        case TelemetryType::Frequency: {
+            TelemetryFrequency value{};
+            if (!decodePayload(decoder.getPayload(), decoder.getLength(), value)) break;
+            std::printf("frequency,%u,%.2f,%.6f\n", sequence, value.frequency, value.magnitude);
+            return;
+        }
+        case TelemetryType::Block: {
+            TelemetryBlock value{};
+            if (!decodePayload(decoder.getPayload(), decoder.getLength(), value)) break;
+            std::printf("block,%u,%u,%u,%u,%.2f,%u\n", sequence, static_cast<unsigned>(value.block),
+                        static_cast<unsigned>(value.inputPeak), static_cast<unsigned>(value.outputPeak),
+                        value.notchFrequency, static_cast<unsigned>(value.activeNotches));
+            return;
+        }
+        case TelemetryType::Ack: {
+            TelemetryAck value{};
+            if (!decodePayload(decoder.getPayload(), decoder.getLength(), value)) break;
+            std::printf("ack,%u,%u,%u\n", sequence, static_cast<unsigned>(value.id), static_cast<unsigned>(value.block));
+            return;
+        }
+        case TelemetryType::Snapshot: {
+            TelemetrySnapshot value{};
+            if (!decodePayload(decoder.getPayload(), decoder.getLength(), value)) break;
+            std::printf("snapshot,%u,%u,%.8f,%.6f,%.2f,%.2f,%u,%u,%u\n", sequence, static_cast<unsigned>(value.block),
+                        value.mu, value.gamma, value.notchFrequency, value.notchBandwidth,
+                        static_cast<unsigned>(value.activeNotches), static_cast<unsigned>(value.tapCount),
+                        static_cast<unsigned>(value.channel));
+            return;
+        }
+        case TelemetryType::Weights: {
+            TelemetryWeights value{};
+            if (!decodePayload(decoder.getPayload(), decoder.getLength(), value)) break;
+            std::printf("weights,%u,%u,%u", sequence, static_cast<unsigned>(value.block), static_cast<unsigned>(value.offset));
+            for (std::size_t i = 0; i < value.count; ++i) {
+                std::printf(",%.8f", value.taps[i]);
+            }
+            std::printf("\n");
+            return;
+        }
+    }
+    std::printf("unknown,%u,%u,%zu\n", sequence, static_cast<unsigned>(decoder.getType()), decoder.getLength());
+}
+
+int main(const int argc, char** argv) {
+    if (argc > 2) {
+        std::fprintf(stderr, "usage: %s [FILE]\n", argv[0]);
+        return 2;
+    }
+
+    std::FILE* input = stdin;
+    if (argc == 2 && std::strcmp(argv[1], "-") != 0 && !(input = std::fopen(argv[1], "rb"))) {
+        std::fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    TelemetryDecoder decoder;
+    std::string line;
+    unsigned long frames{0};
+    for (int c; (c = std::fgetc(input)) != EOF;) {
+        switch (decoder.push(static_cast<std::uint8_t>(c))) {
+            case TelemetryDecoder::Result::Frame:
+                printFrame(decoder);
+                ++frames;
+                break;
+            case TelemetryDecoder::Result::Text:
+                if (c == '\n') {
+                    std::printf("# %s\n", line.c_str());
+                    line.clear();
+                } else if (c != '\r') {
+                    line.push_back(static_cast<char>(c));
+                }
+                break;
+            case TelemetryDecoder::Result::Pending:
+                break;
+        }
+    }
+    if (!line.empty()) std::printf("# %s\n", line.c_str());
+    if (input != stdin) std::fclose(input);
+
+    std::fprintf(stderr, "%lu frames, %u corrupt, %u lost\n", frames, static_cast<unsigned>(decoder.getCorruptFrames()),
+                 static_cast<unsigned>(decoder.getLostFrames()));
+    return 0;
+}
@@ -0,0 +1,458 @@
+/**
+ * @file afc_wav.cpp
+ * @brief Host tool streaming a WAV file through AdaptiveFeedbackCanceller.
+ *
+ * The channels of the input are split into groups of four, two and one, each processed by a
+ * multichannel canceller, one AUDIO_BLOCK_SAMPLES block at a time through the same update() the
+ * firmware runs, and written to the output file. The tool reports the processing throughput in
+ * samples per second and as a multiple of real time. With --telemetry, the per-block metrics of
+ * each group in turn are written to a file as the binary telemetry frames the firmware streams,
+ * to be read back with afc_telemetry, followed every --snapshot-period blocks by a snapshot of
+ * the filter and its taps, on each channel of the group in turn. When built with
+ * AFC_PROFILE, the tool also prints the cycles per block of each profiled stage. --algorithm
+ * selects the adaptation algorithm of the LMS filter by its serial command name (LMS, NLMS, VSS,
+ * KALMAN, DYNAMIC, APA, RLS or IPNLMS), except in the AFC_FDAF and AFC_SUBBAND builds.
+ *
+ * --load-state starts the canceller from a state image, such as a venue slot saved by the
+ * firmware, instead of from zero, and --save-state writes its state at the end of the file into an
+ * image the firmware can load. Both need the input to be processed by a single canceller, so a
+ * file of 1, 2 or 4 channels (1 in the AFC_FDAF and AFC_SUBBAND builds), and an image of the same
+ * build configuration.
+ *
+ * --record writes the input, output and error of the first channel and the frequency of its first
+ * notch through a SignalRecorder into a 4-channel WAV file with a JSON sidecar, exactly as the
+ * firmware records them to its SD card.
+ *
+ * The canceller runs at the sample rate of the file, so a file sampled at 48 or 96 kHz is processed
+ * as the firmware would at that rate. A file within 1% of AUDIO_SAMPLE_RATE_EXACT, such as one at
+ * 44.1 kHz, is taken as recorded by the audio clock of the Teensy, which runs at that rate.
+ *
+ * Usage:
+ *   afc_wav [--gain G] [--no-lms] [--no-notch] [--algorithm NAME] [--telemetry FILE [--snapshot-period BLOCKS]]
+ *           [--load-state FILE] [--save-state FILE] [--record FILE] input.wav output.wav
+ */
+#include "AdaptiveFeedbackCanceller.h"
+#include "Profiler.h"
+#include "Telemetry.h"
+#include "WavFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Options of the tool.
+ */
+struct Options {
+    std::string inputPath; ///< Path of the WAV file to process.
+    std::string outputPath; ///< Path of the processed WAV file.
+    std::string telemetryPath; ///< Path of the telemetry file, empty for none.
+    std::string loadStatePath; ///< Path of the state image the canceller starts from, empty for none.
+    std::string saveStatePath; ///< Path of the state image written at the end, empty for none.
+    std::string recordPath; ///< Path of the recording of the first channel, empty for none.
+    unsigned long snapshotPeriod{0}; ///< Number of blocks between two filter snapshots, 0 for none.
+    double gain{1.0}; ///< Gain of the canceller.
+    bool lms{true}; ///< True to enable the LMS filter.
+    bool notch{true}; ///< True to enable the notch filters.
+#if !defined(AFC_FDAF) && !defined(AFC_SUBBAND)
+    LMSAlgorithm algorithm{LMSAlgorithm::DynamicNoise}; ///< Adaptation algorithm of the LMS filter.
+#endif
+};
+
+/**
+ * @brief Prints the usage of the tool.
+ *
+ * @param program The name of the program.
+ */
+static void printUsage(const char* program) {
+    std::fprintf(stderr, "usage: %s [--gain G] [--no-lms] [--no-notch] [--algorithm NAME] [--telemetry FILE [--snapshot-period BLOCKS]]\n"
+                         "       [--load-state FILE] [--save-state FILE] [--record FILE] input.wav output.wav\n", program);
+}
+
+/**
+ * @brief Parses the command line.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ * @param options The parsed options.
+ * @return True if the command line is valid, false otherwise.
+ */
+static bool parseOptions(const int argc, char** argv, Options& options) {
+    int positional{0};
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--gain") == 0 && i + 1 < argc) {
+            options.gain = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--no-lms") == 0) {
+            options.lms = false;
+        } else if (std::strcmp(argv[i], "--no-notch") == 0) {
+            options.notch = false;
+#if !defined(AFC_FDAF) && !defined(AFC_SUBBAND)
+        } else if (std::strcmp(argv[i], "--algorithm") == 0 && i + 1 < argc) {
+            if (!parseLMSAlgorithm(argv[++i], options.algorithm)) return false;
+#endif
+        } else if (std::strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) {
+            options.telemetryPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--snapshot-period") == 0 && i + 1 < argc) {
+            options.snapshotPeriod = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--load-state") == 0 && i + 1 < argc) {
+            options.loadStatePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--save-state") == 0 && i + 1 < argc) {
+            options.saveStatePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            options.recordPath = argv[++i];
+        } else if (argv[i][0] != '-' && positional < 2) {
+            (positional++ == 0 ? options.inputPath : options.outputPath) = argv[i];
+        } else {
+            return false;
+        }
+    }
+    return positional == 2 && (options.snapshotPeriod == 0 || !options.telemetryPath.empty());
+}
+
+/**
+ * @brief Writes a filter snapshot as a snapshot frame followed by the weights frames of its taps.
+ *
+ * @param snapshot The snapshot.
+ * @param telemetry The file receiving the frames.
+ * @param encoder The encoder numbering the frames.
+ */
+static void writeSnapshot(const FilterSnapshot& snapshot, std::FILE* telemetry, TelemetryEncoder& encoder) {
+    std::uint8_t frame[TelemetryEncoder::MAX_FRAME];
+    const TelemetrySnapshot header{snapshot.block, snapshot.mu, snapshot.gamma, snapshot.notchFrequency,
+                                   snapshot.notchBandwidth, snapshot.activeNotches, static_cast<std::uint16_t>(afcSnapshotTaps),
+                                   snapshot.channel};
+    std::fwrite(frame, 1, encoder.encode(header, frame), telemetry);
+
+    for (std::size_t offset = 0; offset < afcSnapshotTaps; offset += TelemetryWeights::MAX_TAPS) {
+        TelemetryWeights weights{};
+        weights.block = snapshot.block;
+        weights.offset = static_cast<std::uint16_t>(offset);
+        weights.count = static_cast<std::uint8_t>(std::min(TelemetryWeights::MAX_TAPS, afcSnapshotTaps - offset));
+        for (std::size_t i = 0; i < weights.count; ++i) {
+            weights.taps[i] = static_cast<float>(snapshot.taps[offset + i]);
+        }
+        std::fwrite(frame, 1, encoder.encode(weights, frame), telemetry);
+    }
+}
+
+/**
+ * @brief Reads a state image and checks it against the build configuration of a canceller.
+ *
+ * @param path The path of the image.
+ * @param channels The number of channels of the canceller.
+ * @param image The image.
+ * @param payloadSize The size of its payload.
+ * @return True if the image can be loaded, false otherwise.
+ */
+static bool readStateImage(const std::string& path, const std::size_t channels, std::vector<std::uint8_t>& image, std::size_t& payloadSize) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        std::fprintf(stderr, "cannot open %s\n", path.c_str());
+        return false;
+    }
+    std::uint8_t chunk[4096];
+    while (const std::size_t count = std::fread(chunk, 1, sizeof(chunk), file)) {
+        image.insert(image.end(), chunk, chunk + count);
+    }
+    std::fclose(file);
+
+    StateImageInfo info = AdaptiveFeedbackCanceller<1>::getStateInfo();
+    info.channels = static_cast<std::uint16_t>(channels);
+    const StateImageError error = openStateImage(image.data(), image.size(), info, payloadSize);
+    if (error != StateImageError::None) {
+        std::fprintf(stderr, "%s: state image rejected (%s)\n", path.c_str(), stateImageErrorName(error));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief A recording of the signals of the first channel, written as the firmware writes it.
+ */
+struct Recording {
+    std::unique_ptr<SignalRecorder> recorder; ///< The recorder.
+    std::FILE* file{nullptr}; ///< The WAV file.
+    std::vector<RecorderGap> gaps; ///< Gaps read from the recorder.
+    bool failed{false}; ///< True if a chunk could not be written.
+};
+
+/**
+ * @brief Writes the chunks handed over by the recorder and collects its gaps.
+ *
+ * @param recording The recording.
+ */
+static void drainRecording(Recording& recording) {
+    std::size_t blocks;
+    while (const std::int16_t* chunk = recording.recorder->acquireChunk(blocks)) {
+        const std::size_t values = blocks * SignalRecorder::BLOCK_VALUES;
+        if (std::fwrite(chunk, sizeof(std::int16_t), values, recording.file) != values) recording.failed = true;
+        recording.recorder->releaseChunk();
+    }
+    RecorderGap gap;
+    while (recording.recorder->readGap(gap)) {
+        recording.gaps.push_back(gap);
+    }
+}
+
+/**
+ * @brief Gets the sample rate the canceller runs at for a file.
+ *
+ * @param input The input file.
+ * @return The sample rate of the file, or AUDIO_SAMPLE_RATE_EXACT if it is within 1% of it.
+ */
+static float cancellerSampleRate(const WavFile& input) {
+    const auto rate = static_cast<float>(input.sampleRate);
+    return std::abs(rate - AUDIO_SAMPLE_RATE_EXACT) > 0.01f * AUDIO_SAMPLE_RATE_EXACT ? rate : AUDIO_SAMPLE_RATE_EXACT;
+}
+
+/**
+ * @brief Streams adjacent channels of a WAV file through a fresh canceller.
+ *
+ * @tparam Channels The number of channels to process.
+ * @param input The input file.
+ * @param output The output file, with the same layout as the input.
+ * @param first The first channel to process.
+ * @param options The options of the canceller.
+ * @param state The payload of the state image the canceller starts from, or nullptr.
+ * @param stateSize The size of the payload.
+ * @param savedState Receives the state image of the canceller at the end of the file, or nullptr.
+ * @param recording The recording of the first channel of the canceller, or nullptr.
+ * @param telemetry The file receiving the telemetry frames, or nullptr.
+ * @param encoder The encoder numbering the telemetry frames.
+ * @return The time spent in update(), in seconds.
+ */
+template<std::size_t Channels>
+static double processChannels(const WavFile& input, WavFile& output, const std::size_t first, const Options& options,
+                              const std::uint8_t* state, const std::size_t stateSize, std::vector<std::uint8_t>* savedState,
+                              Recording* recording, std::FILE* telemetry, TelemetryEncoder& encoder) {
+    const std::size_t frames = input.getFrameCount();
+    const std::size_t stride = input.channels;
+
+    auto canceller = std::make_unique<AdaptiveFeedbackCanceller<Channels>>(cancellerSampleRate(input));
+    canceller->setGain(options.gain);
+    canceller->setLMS(options.lms);
+    canceller->setNotch(options.notch);
+#if !defined(AFC_FDAF) && !defined(AFC_SUBBAND)
+    canceller->setAlgorithm(options.algorithm);
+#endif
+    canceller->setMetricsEnabled(telemetry != nullptr);
+    if (state) canceller->apply(ParameterUpdate{}.setState(state, stateSize));
+    if (savedState) savedState->resize(canceller->getStateImageSize());
+    if (recording) canceller->setRecorder(recording->recorder.get());
+
+    std::chrono::steady_clock::duration elapsed{};
+    unsigned long blocks{0}, snapshots{0};
+    for (std::size_t offset = 0; offset < frames; offset += AUDIO_BLOCK_SAMPLES) {
+        const std::size_t count = std::min<std::size_t>(AUDIO_BLOCK_SAMPLES, frames - offset);
+        if (options.snapshotPeriod > 0 && ++blocks % options.snapshotPeriod == 0) {
+            canceller->requestSnapshot(snapshots++ % Channels);
+        }
+        if (savedState && offset + AUDIO_BLOCK_SAMPLES >= frames) {
+            canceller->requestState(savedState->data(), savedState->size());
+        }
+
+        for (std::size_t channel = 0; channel < Channels; ++channel) {
+            audio_block_t* block = AudioStream::allocate();
+            for (std::size_t i = 0; i < count; ++i) {
+                block->data[i] = input.samples[(offset + i) * stride + first + channel];
+            }
+            canceller->setInputBlock(block, channel);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        canceller->update();
+        elapsed += std::chrono::steady_clock::now() - start;
+
+        for (std::size_t channel = 0; channel < Channels; ++channel) {
+            if (audio_block_t* processed = canceller->takeOutputBlock(channel)) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    output.samples[(offset + i) * stride + first + channel] = processed->data[i];
+                }
+                AudioStream::release(processed);
+            }
+        }
+
+        TelemetryBlock metrics;
+        while (canceller->readMetrics(metrics)) {
+            std::uint8_t frame[TelemetryEncoder::MAX_FRAME];
+            std::fwrite(frame, 1, encoder.encode(metrics, frame), telemetry);
+        }
+
+        if (const FilterSnapshot* snapshot = canceller->acquireSnapshot()) {
+            writeSnapshot(*snapshot, telemetry, encoder);
+            canceller->releaseSnapshot();
+        }
+
+        if (recording) drainRecording(*recording);
+    }
+
+    if (recording) {
+        // No block follows the last one, so the stop request is served here, as the next block would.
+        recording->recorder->stop();
+        recording->recorder->beginBlock();
+        drainRecording(*recording);
+    }
+
+    std::size_t savedSize{0};
+    if (savedState) savedState->resize(canceller->takeState(savedSize) ? savedSize : 0);
+    return std::chrono::duration<double>(elapsed).count();
+}
+
+/**
+ * @brief Completes the WAV header of a recording and writes its sidecar next to it.
+ *
+ * The sidecar has the path of the recording with a .json extension instead of .wav.
+ *
+ * @param recording The recording.
+ * @param path The path of the recording.
+ * @param sampleRate The sample rate of the recording, in Hz.
+ * @return True if both files were written, false otherwise.
+ */
+static bool finishRecording(Recording& recording, const std::string& path, const float sampleRate) {
+    const std::uint32_t blocks = recording.recorder->getBlocks();
+    std::uint8_t header[RECORDING_HEADER_SIZE];
+    writeRecordingHeader(header, static_cast<std::uint32_t>(std::lround(sampleRate)), blocks * AUDIO_BLOCK_SAMPLES);
+    const bool written = !recording.failed && std::fseek(recording.file, 0, SEEK_SET) == 0 &&
+                         std::fwrite(header, 1, sizeof(header), recording.file) == sizeof(header);
+    if (std::fclose(recording.file) != 0 || !written) {
+        std::fprintf(stderr, "cannot write %s\n", path.c_str());
+        return false;
+    }
+
+    const std::size_t extension = path.size() >= 4 && path.compare(path.size() - 4, 4, ".wav") == 0 ? path.size() - 4 : path.size();
+    const std::string sidecarPath = path.substr(0, extension) + ".json";
+    std::vector<char> text(256 + 32 * recording.gaps.size());
+    const std::size_t length = writeRecordingSidecar(text.data(), text.size(), sampleRate, blocks,
+                                                     recording.recorder->getOverruns(), recording.gaps.data(), recording.gaps.size());
+    std::FILE* sidecar = std::fopen(sidecarPath.c_str(), "w");
+    if (!sidecar || std::fwrite(text.data(), 1, length, sidecar) != length) {
+        std::fprintf(stderr, "cannot write %s\n", sidecarPath.c_str());
+        if (sidecar) std::fclose(sidecar);
+        return false;
+    }
+    std::fclose(sidecar);
+    return true;
+}
+
+int main(const int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    WavFile input;
+    std::string error;
+    if (!input.read(options.inputPath, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    WavFile output;
+    output.sampleRate = input.sampleRate;
+    output.channels = input.channels;
+    output.samples.resize(input.samples.size());
+
+    std::FILE* telemetry{nullptr};
+    if (!options.telemetryPath.empty() && !(telemetry = std::fopen(options.telemetryPath.c_str(), "wb"))) {
+        std::fprintf(stderr, "cannot create %s\n", options.telemetryPath.c_str());
+        return 1;
+    }
+
+    const bool stateful = !options.loadStatePath.empty() || !options.saveStatePath.empty();
+#if !defined(AFC_FDAF) && !defined(AFC_SUBBAND)
+    const bool single = input.channels == 1 || input.channels == 2 || input.channels == 4;
+#else
+    const bool single = input.channels == 1;
+#endif
+    if (stateful && !single) {
+        std::fprintf(stderr, "--load-state and --save-state need a file processed by a single canceller, %u channels is not\n",
+                     static_cast<unsigned>(input.channels));
+        return 2;
+    }
+
+    std::vector<std::uint8_t> loadedState, savedState;
+    std::size_t loadedSize{0};
+    if (!options.loadStatePath.empty() && !readStateImage(options.loadStatePath, input.channels, loadedState, loadedSize)) return 1;
+    const std::uint8_t* state = loadedState.empty() ? nullptr : loadedState.data() + STATE_HEADER_SIZE;
+    std::vector<std::uint8_t>* saved = options.saveStatePath.empty() ? nullptr : &savedState;
+
+    Recording recordingFile;
+    Recording* recording{nullptr};
+    if (!options.recordPath.empty()) {
+        const std::uint8_t header[RECORDING_HEADER_SIZE]{};
+        recordingFile.file = std::fopen(options.recordPath.c_str(), "wb");
+        if (!recordingFile.file || std::fwrite(header, 1, sizeof(header), recordingFile.file) != sizeof(header)) {
+            std::fprintf(stderr, "cannot create %s\n", options.recordPath.c_str());
+            if (recordingFile.file) std::fclose(recordingFile.file);
+            return 1;
+        }
+        recordingFile.recorder = std::make_unique<SignalRecorder>();
+        recordingFile.recorder->start();
+        recording = &recordingFile;
+    }
+
+    TelemetryEncoder encoder;
+    double seconds{0.0};
+    for (std::size_t channel = 0; channel < input.channels;) {
+        Recording* const recorded = channel == 0 ? recording : nullptr;
+#if !defined(AFC_FDAF) && !defined(AFC_SUBBAND)
+        if (input.channels - channel >= 4) {
+            seconds += processChannels<4>(input, output, channel, options, state, loadedSize, saved, recorded, telemetry, encoder);
+            channel += 4;
+            continue;
+        }
+        if (input.channels - channel >= 2) {
+            seconds += processChannels<2>(input, output, channel, options, state, loadedSize, saved, recorded, telemetry, encoder);
+            channel += 2;
+            continue;
+        }
+#endif
+        seconds += processChannels<1>(input, output, channel, options, state, loadedSize, saved, recorded, telemetry, encoder);
+        ++channel;
+    }
+    if (telemetry) std::fclose(telemetry);
+
+    if (recording && !finishRecording(*recording, options.recordPath, cancellerSampleRate(input))) return 1;
+
+    if (saved) {
+        std::FILE* file = savedState.empty() ? nullptr : std::fopen(options.saveStatePath.c_str(), "wb");
+        if (!file || std::fwrite(savedState.data(), 1, savedState.size(), file) != savedState.size()) {
+            std::fprintf(stderr, "cannot write the state image %s\n", options.saveStatePath.c_str());
+            if (file) std::fclose(file);
+            return 1;
+        }
+        std::fclose(file);
+    }
+
+    if (!output.write(options.outputPath, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    const auto samples = static_cast<double>(input.samples.size());
+    const double audioSeconds = samples / static_cast<double>(input.sampleRate);
+    std::printf("%zu frames x %u channels, %.2f s of audio processed in %.3f s\n",
+                input.getFrameCount(), static_cast<unsigned>(input.channels), audioSeconds, seconds);
+    std::printf("%.0f samples/s, %.1fx real time\n", seconds > 0.0 ? samples / seconds : 0.0, seconds > 0.0 ? audioSeconds / seconds : 0.0);
+
+#ifdef AFC_PROFILE
+    std::printf("%-10s %8s %10s %10s %10s  (cycles per block)\n", "stage", "blocks", "min", "mean", "max");
+    for (std::size_t i = 0; i < static_cast<std::size_t>(ProfileStage::Count); ++i) {
+        const auto stage = static_cast<ProfileStage>(i);
+        ProfileStats stats;
+        Profiler::snapshot(stage, stats);
+        if (stats.blocks == 0) continue;
+        std::printf("%-10s %8u %10u %10.0f %10u\n", Profiler::name(stage), static_cast<unsigned>(stats.blocks),
+                    static_cast<unsigned>(stats.min), static_cast<double>(stats.total) / stats.blocks,
+                    static_cast<unsigned>(stats.max));
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,130 @@
+"""
+Reader of the signal recordings written by the feedback canceller.
+
+This mirrors src/SignalRecorder.h. A recording is a 16-bit PCM WAV file of four interleaved
+channels, the input, output and error of the canceller and the frequency of its first notch in Hz
+(held over each audio block, 0 while no notch is active), and a JSON sidecar of the same name
+giving the sample rate, the block size, the number of blocks recorded and dropped, and the gaps
+left by the dropped blocks as [blocks before the gap, blocks dropped] pairs.
+
+Usage:
+    python recording.py [--plot] REC00001.wav
+"""
+
+import json
+import os
+import sys
+import wave
+
+import numpy as np
+
+CHANNELS = ("input", "output", "error", "notch_hz")
+
+
+class Recording:
+    """
+    A signal recording and its sidecar.
+
+    Attributes
+    ----------
+    sample_rate : float
+        The sample rate, in Hz.
+    block_samples : int
+        The number of samples of an audio block.
+    input, output, error : np.ndarray
+        The signals, in full-scale units.
+    notch_hz : np.ndarray
+        The frequency of the first notch during each block, in Hz, 0 while no notch is active.
+    overruns : int
+        The number of blocks dropped.
+    gaps : list
+        The gaps, as (blocks before the gap, blocks dropped) pairs.
+    """
+
+    def __init__(self, samples, sidecar):
+        self.sample_rate = float(sidecar["sample_rate"])
+        self.block_samples = int(sidecar["block_samples"])
+        self.overruns = int(sidecar["overruns"])
+        self.gaps = [tuple(gap) for gap in sidecar["gaps"]]
+        columns = dict(zip(sidecar["channels"], samples.T))
+        self.input = columns["input"] / 32768.0
+        self.output = columns["output"] / 32768.0
+        self.error = columns["error"] / 32768.0
+        self.notch_hz = columns["notch_hz"][::self.block_samples].astype(float)
+
+    def times(self):
+        """
+        Computes the time of each sample, shifted past the dropped blocks.
+
+        Returns
+        -------
+        np.ndarray
+            The times, in seconds.
+        """
+        index = np.arange(len(self.input))
+        for block, dropped in self.gaps:
+            index[block * self.block_samples:] += dropped * self.block_samples
+        return index / self.sample_rate
+
+
+def read_recording(path):
+    """
+    Reads a recording and its sidecar.
+
+    Parameters
+    ----------
+    path : str
+        The path of the WAV file; the sidecar has the same path with a .json extension.
+
+    Returns
+    -------
+    Recording
+        The recording.
+    """
+    with open(os.path.splitext(path)[0] + ".json") as file:
+        sidecar = json.load(file)
+    with wave.open(path, "rb") as file:
+        if file.getnchannels() != len(CHANNELS) or file.getsampwidth() != 2:
+            raise ValueError(f"{path} is not a recording of {len(CHANNELS)} 16-bit channels")
+        frames = file.readframes(file.getnframes())
+    samples = np.frombuffer(frames, dtype="<i2").reshape(-1, len(CHANNELS))
+    return Recording(samples, sidecar)
+
+
+def _level(signal):
+    rms = np.sqrt(np.mean(np.square(signal))) if len(signal) else 0.0
+    return 20 * np.log10(max(rms, 1e-9))
+
+
+def main(arguments):
+    plot = "--plot" in arguments
+    paths = [argument for argument in arguments if argument != "--plot"]
+    if len(paths) != 1:
+        print(__doc__.strip().splitlines()[-1].strip(), file=sys.stderr)
+        return 2
+
+    recording = read_recording(paths[0])
+    print(f"{len(recording.input) / recording.sample_rate:.2f} s at {recording.sample_rate:.1f} Hz, "
+          f"{recording.overruns} blocks dropped in {len(recording.gaps)} gaps")
+    print(f"input {_level(recording.input):.1f} dBFS, output {_level(recording.output):.1f} dBFS, "
+          f"error {_level(recording.error):.1f} dBFS")
+
+    if plot:
+        import matplotlib.pyplot as plt
+
+        times = recording.times()
+        figure, (signals, notch) = plt.subplots(2, 1, sharex=True, figsize=(10, 6))
+        for name in ("input", "error", "output"):
+            signals.plot(times, getattr(recording, name), label=name, linewidth=0.5)
+        signals.set_ylabel("Amplitude")
+        signals.legend()
+        notch.step(times[::recording.block_samples], recording.notch_hz, where="post")
+        notch.set_xlabel("Temps (s)")
+        notch.set_ylabel("Notch (Hz)")
+        figure.tight_layout()
+        plt.show()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
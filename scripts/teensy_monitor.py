@@ -9,6 +9,8 @@ from matplotlib.backends.backend_tkagg import FigureCanvasTkAgg
 import numpy as np
 import queue
 
+from telemetry import TelemetryDecoder, Frequency, Block, Ack, Snapshot, Weights
+
 
 class TeensyMonitorApp:
     """
@@ -27,7 +29,9 @@ class TeensyMonitorApp:
     should_stop : bool
         Flag to stop the reading thread.
     data_queue : queue.Queue
-        Queue to store data read from the serial port.
+        Queue to store the text lines and telemetry frames read from the serial port.
+    decoder : TelemetryDecoder
+        Decoder splitting the serial stream into text lines and telemetry frames.
     time_data : np.array
         Array to store time data for plotting.
     freq_data : np.array
@@ -48,6 +52,14 @@ class TeensyMonitorApp:
         Indicates if the notch filter is enabled.
     muted : bool
         Indicates if the system is muted.
+    perf_clock : float
+        CPU clock of the Teensy, in cycles per second, from the last profile.
+    perf_stats : dict
+        Cycles per block of each profiled stage, from the last profile.
+    sample_rate : float
+        Sample rate of the Teensy, in Hz, as reported by DATA:AUDIO.
+    block_samples : int
+        Number of samples of an audio block of the Teensy, as reported by DATA:AUDIO.
 
     Methods
     -------
@@ -85,6 +97,22 @@ class TeensyMonitorApp:
         Synchronizes the interface state with the current state of the Teensy.
     process_data(data_line):
         Processes the data received from the Teensy.
+    request_profile():
+        Requests the profile of the audio processing.
+    measure_roundtrip():
+        Measures the round-trip latency of the audio chain with a click.
+    show_profile():
+        Plots the profile of the audio processing in a separate window.
+    open_filter_view():
+        Opens the live view of the adaptive filter and starts the snapshot stream.
+    close_filter_view():
+        Stops the snapshot stream and closes the live view of the adaptive filter.
+    show_filter(taps):
+        Plots a snapshot of the adaptive filter in its window.
+    process_frame(frame):
+        Processes a binary telemetry frame received from the Teensy.
+    add_frequency_sample(freq, amplitude):
+        Records a dominant frequency measurement.
     update_plots():
         Updates the plots with the current data.
     log(message):
@@ -111,6 +139,7 @@ class TeensyMonitorApp:
         self.reading_thread = None
         self.should_stop = False
         self.data_queue = queue.Queue()
+        self.decoder = TelemetryDecoder()
 
         self.time_data = np.array([])
         self.freq_data = np.array([])
@@ -124,6 +153,19 @@ class TeensyMonitorApp:
         self.notch_enabled = False
         self.muted = False
 
+        self.perf_clock = None
+        self.perf_stats = {}
+        self.perf_window = None
+
+        self.sample_rate = 44117.64706
+        self.block_samples = 128
+
+        self.snapshot = None
+        self.snapshot_taps = {}
+        self.filter_window = None
+
+        self.recording = False
+
         self.create_widgets()
 
         self.update_timer()
@@ -160,6 +202,10 @@ class TeensyMonitorApp:
         self.freq_label = ttk.Label(controls_frame, text="0.0 Hz")
         self.freq_label.grid(row=0, column=3, padx=5, pady=5, sticky=tk.W)
 
+        ttk.Label(controls_frame, text="Notch:").grid(row=0, column=4, padx=5, pady=5, sticky=tk.W)
+        self.notch_label = ttk.Label(controls_frame, text="-")
+        self.notch_label.grid(row=0, column=5, padx=5, pady=5, sticky=tk.W)
+
         ttk.Label(controls_frame, text="Gain:").grid(row=1, column=0, padx=5, pady=5, sticky=tk.W)
 
         gain_frame = ttk.Frame(controls_frame)
@@ -173,6 +219,13 @@ class TeensyMonitorApp:
         self.gain_label = ttk.Label(gain_frame, text="1.0")
         self.gain_label.pack(side=tk.RIGHT, padx=5)
 
+        ttk.Label(controls_frame, text="Algorithme:").grid(row=1, column=4, padx=5, pady=5, sticky=tk.W)
+        self.algo_var = tk.StringVar(value="DYNAMIC")
+        self.algo_combo = ttk.Combobox(controls_frame, textvariable=self.algo_var, width=10, state="readonly",
+                                       values=["LMS", "NLMS", "VSS", "KALMAN", "DYNAMIC", "APA", "RLS", "IPNLMS"])
+        self.algo_combo.grid(row=1, column=5, padx=5, pady=5, sticky=tk.W)
+        self.algo_combo.bind("<<ComboboxSelected>>", self.on_algorithm_change)
+
         filters_frame = ttk.Frame(controls_frame)
         filters_frame.grid(row=2, column=0, columnspan=4, padx=5, pady=10, sticky=tk.W + tk.E)
 
@@ -198,6 +251,41 @@ class TeensyMonitorApp:
         self.get_status_btn = ttk.Button(filters_frame, text="Obtenir le statut", command=self.get_status)
         self.get_status_btn.pack(side=tk.RIGHT, padx=10)
 
+        self.perf_btn = ttk.Button(filters_frame, text="Profil CPU", command=self.request_profile)
+        self.perf_btn.pack(side=tk.RIGHT, padx=10)
+
+        self.roundtrip_btn = ttk.Button(filters_frame, text="Latence", command=self.measure_roundtrip)
+        self.roundtrip_btn.pack(side=tk.RIGHT, padx=10)
+
+        self.filter_btn = ttk.Button(filters_frame, text="Réponse LMS", command=self.open_filter_view)
+        self.filter_btn.pack(side=tk.RIGHT, padx=10)
+
+        venue_frame = ttk.Frame(controls_frame)
+        venue_frame.grid(row=3, column=0, columnspan=6, padx=5, pady=5, sticky=tk.W + tk.E)
+
+        ttk.Label(venue_frame, text="Lieu:").pack(side=tk.LEFT, padx=5)
+        self.venue_var = tk.StringVar()
+        self.venue_combo = ttk.Combobox(venue_frame, textvariable=self.venue_var, width=18)
+        self.venue_combo.pack(side=tk.LEFT, padx=5)
+
+        self.save_venue_btn = ttk.Button(venue_frame, text="Sauvegarder", command=self.save_venue)
+        self.save_venue_btn.pack(side=tk.LEFT, padx=5)
+
+        self.load_venue_btn = ttk.Button(venue_frame, text="Charger", command=self.load_venue)
+        self.load_venue_btn.pack(side=tk.LEFT, padx=5)
+
+        self.default_venue_btn = ttk.Button(venue_frame, text="Au démarrage", command=self.set_default_venue)
+        self.default_venue_btn.pack(side=tk.LEFT, padx=5)
+
+        self.default_venue_label = ttk.Label(venue_frame, text="Démarrage: -")
+        self.default_venue_label.pack(side=tk.LEFT, padx=10)
+
+        self.record_btn = ttk.Button(venue_frame, text="Enregistrer", command=self.toggle_recording)
+        self.record_btn.pack(side=tk.RIGHT, padx=5)
+
+        self.record_label = ttk.Label(venue_frame, text="")
+        self.record_label.pack(side=tk.RIGHT, padx=5)
+
         indicators_frame = ttk.LabelFrame(main_frame, text="État des filtres", padding="10")
         indicators_frame.pack(fill=tk.X, pady=5)
 
@@ -289,11 +377,20 @@ class TeensyMonitorApp:
             The state to set for the controls (e.g., tk.NORMAL or tk.DISABLED).
         """
         self.gain_slider.config(state=state)
+        self.algo_combo.config(state="readonly" if state == tk.NORMAL else state)
         self.lms_btn.config(state=state)
         self.notch_btn.config(state=state)
         self.mute_btn.config(state=state)
         self.reset_lms_btn.config(state=state)
         self.get_status_btn.config(state=state)
+        self.perf_btn.config(state=state)
+        self.roundtrip_btn.config(state=state)
+        self.filter_btn.config(state=state)
+        self.venue_combo.config(state=state)
+        self.save_venue_btn.config(state=state)
+        self.load_venue_btn.config(state=state)
+        self.default_venue_btn.config(state=state)
+        self.record_btn.config(state=state)
 
     def refresh_ports(self):
         """
@@ -323,7 +420,8 @@ class TeensyMonitorApp:
             return
 
         try:
-            self.serial_port = serial.Serial(port, 115200, timeout=1)
+            self.serial_port = serial.Serial(port, 115200, timeout=0.1)
+            self.decoder = TelemetryDecoder()
             self.is_connected = True
             self.connect_btn.config(text="Déconnecter")
             self.status_var.set(f"Connecté à {port}")
@@ -403,6 +501,17 @@ class TeensyMonitorApp:
             self.current_gain = gain
             self.send_command(f"SET:GAIN:{gain:.2f}")
 
+    def on_algorithm_change(self, event=None):
+        """
+        Selects the adaptation algorithm of the LMS filter chosen in the list.
+
+        Parameters
+        ----------
+        event : optional
+            The event that triggered the change.
+        """
+        self.send_command(f"SET:ALGO:{self.algo_var.get()}")
+
     def toggle_lms(self):
         """
         Enables or disables the LMS filter based on the current state.
@@ -439,6 +548,35 @@ class TeensyMonitorApp:
         """
         self.send_command("RESET:LMS")
 
+    def save_venue(self):
+        """
+        Saves the adaptive state of the canceller under the venue name entered.
+        """
+        name = self.venue_var.get().strip().upper()
+        if name:
+            self.send_command(f"SAVE:VENUE:{name}")
+
+    def load_venue(self):
+        """
+        Loads the adaptive state saved for the venue selected.
+        """
+        name = self.venue_var.get().strip().upper()
+        if name:
+            self.send_command(f"LOAD:VENUE:{name}")
+
+    def set_default_venue(self):
+        """
+        Makes the venue selected the one loaded at power-up, or none if the name is empty.
+        """
+        name = self.venue_var.get().strip().upper()
+        self.send_command(f"SET:VENUE:{name or 'NONE'}")
+
+    def toggle_recording(self):
+        """
+        Starts or stops the recording of the signals to the SD card of the Teensy.
+        """
+        self.send_command("SET:RECORD:OFF" if self.recording else "SET:RECORD:ON")
+
     def get_status(self):
         """
         Requests the current status of the system.
@@ -482,15 +620,17 @@ class TeensyMonitorApp:
     def read_serial_data(self):
         """Reads data from the serial port in a separate thread.
 
-        Continuously reads lines from the serial port and puts them into the data queue
-        until the `should_stop` flag is set to True.
+        Continuously reads bytes from the serial port, splits them into text lines and
+        telemetry frames, and puts them into the data queue until the `should_stop` flag is
+        set to True.
         """
         while not self.should_stop:
             try:
                 if self.serial_port and self.serial_port.is_open:
-                    line = self.serial_port.readline().decode('utf-8').strip()
-                    if line:
-                        self.data_queue.put(line)
+                    data = self.serial_port.read(self.serial_port.in_waiting or 1)
+                    for item in self.decoder.feed(data):
+                        if item:
+                            self.data_queue.put(item)
             except Exception as e:
                 self.log(f"Erreur de lecture: {e}")
                 time.sleep(0.1)
@@ -498,12 +638,14 @@ class TeensyMonitorApp:
     def synchronize_state(self):
         """Synchronizes the interface state with the current state of the Teensy.
 
-        Requests the current status and frequency from the Teensy and updates the interface
-        accordingly.
+        Switches the Teensy to binary telemetry, then requests the current status and
+        frequency and updates the interface accordingly.
         """
         if self.is_connected:
             self.log("Synchronisation de l'état...")
+            self.send_command("SET:TELEMETRY:BINARY")
             self.get_status()
+            self.send_command("GET:VENUES")
             time.sleep(0.2)
             self.send_command("GET:FREQ")
 
@@ -517,7 +659,8 @@ class TeensyMonitorApp:
         data_line : str
             The data line received from the Teensy.
         """
-        self.log(f"Reçu: {data_line}")
+        if not data_line.startswith(("DATA:FILTER:", "DATA:WEIGHTS:")):
+            self.log(f"Reçu: {data_line}")
 
         if not data_line.startswith("DATA:"):
             return
@@ -544,25 +687,7 @@ class TeensyMonitorApp:
                 values = data_value.split(",")
                 freq = float(values[0])
                 amplitude = float(values[1]) if len(values) > 1 else 0.0
-
-                self.current_freq = freq
-                self.freq_label.config(text=f"{freq:.1f} Hz")
-
-                current_time = time.time()
-
-                if len(self.time_data) == 0:
-                    self.start_time = current_time
-
-                relative_time = current_time - self.start_time
-
-                self.time_data = np.append(self.time_data, relative_time)
-                self.freq_data = np.append(self.freq_data, freq)
-                self.amplitude_data = np.append(self.amplitude_data, amplitude)
-
-                if len(self.time_data) > self.max_points:
-                    self.time_data = self.time_data[-self.max_points:]
-                    self.freq_data = self.freq_data[-self.max_points:]
-                    self.amplitude_data = self.amplitude_data[-self.max_points:]
+                self.add_frequency_sample(freq, amplitude)
 
             except Exception as e:
                 self.log(f"Erreur de traitement des données: {e}")
@@ -608,6 +733,114 @@ class TeensyMonitorApp:
 
             self.update_indicators()
 
+        elif data_type == "APPLIED":
+            command_id, _, block = data_value.partition(",")
+            self.log(f"Commande {command_id} appliquée au bloc {block}")
+
+        elif data_type == "ALGO":
+            if data_value == "ERROR":
+                self.log("Algorithme d'adaptation inconnu")
+            else:
+                self.algo_var.set(data_value)
+                self.log(f"Algorithme d'adaptation: {data_value}")
+
+        elif data_type == "VENUES":
+            self.venue_combo.config(values=[v for v in data_value.split(",") if v])
+
+        elif data_type == "VENUE":
+            key, _, value = data_value.partition(":")
+            if key == "DEFAULT":
+                self.default_venue_label.config(text=f"Démarrage: {value if value != 'NONE' else '-'}")
+            elif key == "SAVED":
+                name, _, size = value.partition(",")
+                self.log(f"Lieu {name} sauvegardé ({size} octets)")
+                self.send_command("GET:VENUES")
+            elif key == "LOADED":
+                self.log(f"Lieu {value} chargé")
+            elif key == "BUSY":
+                self.log("Transfert de lieu déjà en cours")
+            elif key == "ERROR":
+                self.log(f"Erreur de lieu: {value}")
+
+        elif data_type == "RECORD":
+            key, _, value = data_value.partition(":")
+            if key == "ON":
+                self.recording = True
+                self.record_btn.config(text="Arrêter")
+                self.record_label.config(text=value, foreground="red")
+            elif key == "OFF":
+                self.recording = False
+                self.record_btn.config(text="Enregistrer")
+                self.record_label.config(text="", foreground="black")
+                if value:
+                    path, blocks, overruns = value.split(",")
+                    self.log(f"Enregistrement {path} terminé: {blocks} blocs, {overruns} blocs perdus")
+            elif key == "STOPPING":
+                self.record_label.config(text="Écriture...", foreground="black")
+            elif key == "OVERRUN":
+                self.log(f"Enregistrement: {value} blocs perdus")
+            elif key == "ERROR":
+                self.log(f"Erreur d'enregistrement: {value}")
+
+        elif data_type == "AUDIO":
+            try:
+                rate, block = data_value.split(",")
+                self.sample_rate = float(rate)
+                self.block_samples = int(block)
+            except Exception as e:
+                self.log(f"Erreur lors du traitement du format audio: {e}")
+
+        elif data_type == "ROUNDTRIP":
+            if data_value == "BUSY":
+                self.log("Mesure de latence déjà en cours")
+            elif data_value == "TIMEOUT":
+                self.log("Latence: clic non revenu, vérifier le câble de bouclage sortie-entrée")
+            elif data_value != "START":
+                try:
+                    samples, audio_us, cycle_us, rate, block = data_value.split(",")
+                    self.log(f"Latence entrée-sortie: {samples} échantillons, {float(audio_us) / 1000:.2f} ms "
+                             f"({float(cycle_us) / 1000:.2f} ms au compteur de cycles), "
+                             f"{float(rate):.0f} Hz, blocs de {block}")
+                except Exception as e:
+                    self.log(f"Erreur lors du traitement de la latence: {e}")
+
+        elif data_type == "HOWL":
+            if data_value == "UNSUPPORTED":
+                self.log("Détecteur de larsen indisponible avec des blocs de moins de 128 échantillons")
+
+        elif data_type == "NOISEWIN":
+            self.log(f"Fenêtre d'estimation du bruit: {data_value} échantillons")
+
+        elif data_type == "FILTER":
+            try:
+                block, mu, gamma, freq, bandwidth, active, channel = data_value.split(",")
+                self.snapshot = Snapshot(None, int(block), float(mu), float(gamma), float(freq),
+                                         float(bandwidth), int(active), 0, int(channel))
+            except Exception as e:
+                self.log(f"Erreur lors du traitement de l'état du filtre: {e}")
+
+        elif data_type == "WEIGHTS":
+            try:
+                if self.snapshot is not None:
+                    self.show_filter([float(v) for v in data_value.split(",")])
+            except Exception as e:
+                self.log(f"Erreur lors du traitement des coefficients: {e}")
+
+        elif data_type == "PERF":
+            try:
+                key, _, values = data_value.partition(":")
+                if key == "CLOCK":
+                    self.perf_clock = float(values)
+                    self.perf_stats = {}
+                elif key == "DISABLED":
+                    self.log("Profilage non compilé (définir AFC_PROFILE)")
+                elif key != "RESET":
+                    numbers = [int(v) for v in values.split(",")]
+                    self.perf_stats[key] = numbers
+                    self.show_profile()
+            except Exception as e:
+                self.log(f"Erreur lors du traitement du profil: {e}")
+
         elif data_type == "STATUS":
             try:
                 status_parts = data_value.split(",")
@@ -624,12 +857,191 @@ class TeensyMonitorApp:
                         elif key == "MUTE":
                             self.muted = (value == "ON")
                             self.mute_var.set(self.muted)
+                        elif key == "ALGO":
+                            self.algo_var.set(value)
 
                 self.update_indicators()
 
             except Exception as e:
                 self.log(f"Erreur lors du traitement du statut: {e}")
 
+    def request_profile(self):
+        """
+        Requests the profile of the audio processing.
+        """
+        self.send_command("GET:PERF")
+
+    def measure_roundtrip(self):
+        """
+        Measures the round-trip latency of the audio chain with a click.
+
+        The output of the Teensy must be looped back to its input, by a cable or a loudspeaker
+        in front of the microphone.
+        """
+        self.send_command("GET:ROUNDTRIP")
+
+    def show_profile(self):
+        """Plots the profile of the audio processing in a separate window.
+
+        The upper plot shows the mean cycles per audio block of each stage, with the minimum and
+        maximum as error bars, in percent of the duration of a block. The lower plot shows the
+        log2 histogram of the cycles per block of the whole update.
+        """
+        if not self.perf_stats or not self.perf_clock:
+            return
+
+        if self.perf_window is None or not self.perf_window.winfo_exists():
+            self.perf_window = tk.Toplevel(self.root)
+            self.perf_window.title("Profil du traitement audio")
+            self.perf_fig, (self.perf_ax1, self.perf_ax2) = plt.subplots(2, 1, figsize=(7, 6), dpi=100)
+            self.perf_canvas = FigureCanvasTkAgg(self.perf_fig, master=self.perf_window)
+            self.perf_canvas.get_tk_widget().pack(fill=tk.BOTH, expand=True)
+
+        block_cycles = self.perf_clock * self.block_samples / self.sample_rate
+        stages = list(self.perf_stats.keys())
+        minimum = np.array([self.perf_stats[s][1] for s in stages]) * 100 / block_cycles
+        mean = np.array([self.perf_stats[s][2] for s in stages]) * 100 / block_cycles
+        maximum = np.array([self.perf_stats[s][3] for s in stages]) * 100 / block_cycles
+
+        self.perf_ax1.clear()
+        self.perf_ax1.bar(stages, mean, yerr=[mean - minimum, maximum - mean], capsize=4, color="tab:blue")
+        self.perf_ax1.set_title("Charge par bloc (moyenne, min-max)", fontsize=12, fontweight='bold')
+        self.perf_ax1.set_ylabel("% du bloc audio")
+        self.perf_ax1.grid(True, axis='y', linestyle='--', alpha=0.7)
+
+        self.perf_ax2.clear()
+        histogram = self.perf_stats.get("UPDATE", [0] * 36)[4:]
+        self.perf_ax2.bar(range(len(histogram)), histogram, color="tab:red")
+        self.perf_ax2.set_title("Histogramme de update()", fontsize=12, fontweight='bold')
+        self.perf_ax2.set_xlabel("log2(cycles par bloc)")
+        self.perf_ax2.set_ylabel("Blocs")
+        self.perf_ax2.grid(True, axis='y', linestyle='--', alpha=0.7)
+
+        self.perf_fig.tight_layout()
+        self.perf_canvas.draw_idle()
+
+    def open_filter_view(self):
+        """
+        Opens the live view of the adaptive filter and starts the snapshot stream.
+        """
+        if self.filter_window is None or not self.filter_window.winfo_exists():
+            self.filter_window = tk.Toplevel(self.root)
+            self.filter_window.title("Chemin de rétroaction estimé")
+            self.filter_window.protocol("WM_DELETE_WINDOW", self.close_filter_view)
+            self.filter_fig, (self.filter_ax1, self.filter_ax2) = plt.subplots(2, 1, figsize=(7, 6), dpi=100)
+            self.filter_canvas = FigureCanvasTkAgg(self.filter_fig, master=self.filter_window)
+            self.filter_canvas.get_tk_widget().pack(fill=tk.BOTH, expand=True)
+        self.send_command("SET:SNAPSHOT:200")
+
+    def close_filter_view(self):
+        """
+        Stops the snapshot stream and closes the live view of the adaptive filter.
+        """
+        self.send_command("SET:SNAPSHOT:0")
+        self.filter_window.destroy()
+        self.filter_window = None
+
+    def show_filter(self, taps):
+        """Plots a snapshot of the adaptive filter in its window.
+
+        The upper plot shows the taps, which are the estimated impulse response of the feedback
+        path. The lower plot shows its magnitude response, with the first notch marked.
+
+        Parameters
+        ----------
+        taps : list of float
+            The taps of the filter.
+        """
+        if self.filter_window is None or not self.filter_window.winfo_exists():
+            return
+
+        sample_rate = self.sample_rate
+        taps = np.asarray(taps)
+        spectrum = np.fft.rfft(taps, n=max(1024, len(taps)))
+        frequencies = np.fft.rfftfreq(max(1024, len(taps)), d=1.0 / sample_rate)
+        magnitude = 20 * np.log10(np.abs(spectrum) + 1e-12)
+
+        self.filter_ax1.clear()
+        self.filter_ax1.plot(np.arange(len(taps)), taps, color="tab:blue", marker=".")
+        self.filter_ax1.set_title(f"Réponse impulsionnelle (voie {self.snapshot.channel}, bloc {self.snapshot.block}, "
+                                  f"mu={self.snapshot.mu:.2e}, gamma={self.snapshot.gamma:.4f})",
+                                  fontsize=11, fontweight='bold')
+        self.filter_ax1.set_xlabel("Coefficient")
+        self.filter_ax1.grid(True, linestyle='--', alpha=0.7)
+
+        self.filter_ax2.clear()
+        self.filter_ax2.plot(frequencies, magnitude, color="tab:red")
+        if self.snapshot.active_notches > 0:
+            self.filter_ax2.axvline(self.snapshot.notch_frequency, color="tab:green", linestyle="--",
+                                    label=f"Notch {self.snapshot.notch_frequency:.0f} Hz "
+                                          f"(±{self.snapshot.notch_bandwidth / 2:.0f} Hz)")
+            self.filter_ax2.legend(loc="upper right")
+        self.filter_ax2.set_title("Réponse en amplitude", fontsize=11, fontweight='bold')
+        self.filter_ax2.set_xlabel("Fréquence (Hz)")
+        self.filter_ax2.set_ylabel("dB")
+        self.filter_ax2.grid(True, linestyle='--', alpha=0.7)
+
+        self.filter_fig.tight_layout()
+        self.filter_canvas.draw_idle()
+
+    def process_frame(self, frame):
+        """Processes a binary telemetry frame received from the Teensy.
+
+        Parameters
+        ----------
+        frame : Frequency, Block, Ack, Snapshot or Weights
+            The decoded frame.
+        """
+        if isinstance(frame, Frequency):
+            self.add_frequency_sample(frame.frequency, frame.magnitude)
+
+        elif isinstance(frame, Block):
+            self.notch_label.config(text=f"{frame.notch_frequency:.1f} Hz ({frame.active_notches} actif(s))")
+
+        elif isinstance(frame, Ack):
+            self.log(f"Commande {frame.id} appliquée au bloc {frame.block}")
+
+        elif isinstance(frame, Snapshot):
+            self.snapshot = frame
+            self.snapshot_taps = {}
+
+        elif isinstance(frame, Weights):
+            if self.snapshot is None or frame.block != self.snapshot.block:
+                return
+            for i, tap in enumerate(frame.taps):
+                self.snapshot_taps[frame.offset + i] = tap
+            if len(self.snapshot_taps) == self.snapshot.tap_count:
+                self.show_filter([self.snapshot_taps[i] for i in range(self.snapshot.tap_count)])
+
+    def add_frequency_sample(self, freq, amplitude):
+        """Records a dominant frequency measurement.
+
+        Parameters
+        ----------
+        freq : float
+            The dominant frequency, in Hz.
+        amplitude : float
+            The magnitude of the dominant frequency.
+        """
+        self.current_freq = freq
+        self.freq_label.config(text=f"{freq:.1f} Hz")
+
+        current_time = time.time()
+
+        if len(self.time_data) == 0:
+            self.start_time = current_time
+
+        relative_time = current_time - self.start_time
+
+        self.time_data = np.append(self.time_data, relative_time)
+        self.freq_data = np.append(self.freq_data, freq)
+        self.amplitude_data = np.append(self.amplitude_data, amplitude)
+
+        if len(self.time_data) > self.max_points:
+            self.time_data = self.time_data[-self.max_points:]
+            self.freq_data = self.freq_data[-self.max_points:]
+            self.amplitude_data = self.amplitude_data[-self.max_points:]
+
     def update_plots(self):
         """Updates the plots with the current data.
 
@@ -669,7 +1081,10 @@ class TeensyMonitorApp:
         """
         while not self.data_queue.empty():
             data = self.data_queue.get()
-            self.process_data(data)
+            if isinstance(data, str):
+                self.process_data(data)
+            else:
+                self.process_frame(data)
 
         self.update_plots()
 
@@ -0,0 +1,143 @@
+"""
+Decoder of the binary telemetry frames streamed by the feedback canceller.
+
+This mirrors src/Telemetry.h. A frame is laid out as
+
+    0xA5 0x5A | type | length | sequence (2) | payload (length) | CRC (2)
+
+with multi-byte fields in little-endian order, the CRC being the CRC-16/CCITT-FALSE of the
+type, length, sequence and payload bytes. Bytes outside frames are the text replies to the
+commands and are returned as lines.
+"""
+
+import struct
+from collections import namedtuple
+
+SYNC0 = 0xA5
+SYNC1 = 0x5A
+MAX_PAYLOAD = 64
+
+TYPE_FREQUENCY = 1
+TYPE_BLOCK = 2
+TYPE_ACK = 3
+TYPE_SNAPSHOT = 4
+TYPE_WEIGHTS = 5
+
+Frequency = namedtuple("Frequency", "sequence frequency magnitude")
+Block = namedtuple("Block", "sequence block input_peak output_peak notch_frequency active_notches")
+Ack = namedtuple("Ack", "sequence id block")
+Snapshot = namedtuple("Snapshot", "sequence block mu gamma notch_frequency notch_bandwidth active_notches tap_count channel")
+Weights = namedtuple("Weights", "sequence block offset taps")
+
+_PAYLOADS = {
+    TYPE_FREQUENCY: (struct.Struct("<ff"), Frequency),
+    TYPE_BLOCK: (struct.Struct("<IHHfB"), Block),
+    TYPE_ACK: (struct.Struct("<II"), Ack),
+    TYPE_SNAPSHOT: (struct.Struct("<IffffBHB"), Snapshot),
+    TYPE_WEIGHTS: (struct.Struct("<IHB12f"),
+                   lambda sequence, block, offset, count, *taps: Weights(sequence, block, offset, taps[:count])),
+}
+
+
+def crc16(data, crc=0xFFFF):
+    """
+    Computes the CRC-16/CCITT-FALSE of a run of bytes.
+
+    Parameters
+    ----------
+    data : bytes
+        The bytes.
+    crc : int
+        The CRC of the preceding bytes, to chain calls.
+
+    Returns
+    -------
+    int
+        The CRC.
+    """
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021 if crc & 0x8000 else crc << 1) & 0xFFFF
+    return crc
+
+
+class TelemetryDecoder:
+    """
+    Extracts telemetry frames and text lines from the serial byte stream.
+
+    Attributes
+    ----------
+    corrupt_frames : int
+        Number of frames dropped for a bad CRC or length.
+    lost_frames : int
+        Number of frames missing from the sequence numbers received.
+    """
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.text = bytearray()
+        self.next_sequence = None
+        self.corrupt_frames = 0
+        self.lost_frames = 0
+
+    def feed(self, data):
+        """
+        Decodes the next bytes of the stream.
+
+        Parameters
+        ----------
+        data : bytes
+            The bytes read from the serial port.
+
+        Returns
+        -------
+        list
+            The complete items, in stream order: str for a text line, Frequency, Block, Ack, Snapshot or Weights for a
+            frame, or a (type, sequence, payload) tuple for a frame of unknown type.
+        """
+        self.buffer += data
+        items = []
+        while self.buffer:
+            if self.buffer[0] != SYNC0:
+                self._text_byte(self.buffer.pop(0), items)
+                continue
+            if len(self.buffer) < 2:
+                break
+            if self.buffer[1] != SYNC1:
+                del self.buffer[0]
+                continue
+            if len(self.buffer) < 6:
+                break
+            length = self.buffer[3]
+            if length > MAX_PAYLOAD:
+                self.corrupt_frames += 1
+                del self.buffer[:2]
+                continue
+            size = 6 + length + 2
+            if len(self.buffer) < size:
+                break
+            frame = bytes(self.buffer[:size])
+            del self.buffer[:size]
+            if crc16(frame[2:-2]) != struct.unpack_from("<H", frame, size - 2)[0]:
+                self.corrupt_frames += 1
+                continue
+            items.append(self._frame(frame[2], struct.unpack_from("<H", frame, 4)[0], frame[6:-2]))
+        return items
+
+    def _text_byte(self, byte, items):
+        if byte == ord("\n"):
+            items.append(self.text.decode("utf-8", errors="replace").strip())
+            self.text.clear()
+        else:
+            self.text.append(byte)
+
+    def _frame(self, frame_type, sequence, payload):
+        if self.next_sequence is not None:
+            self.lost_frames += (sequence - self.next_sequence) & 0xFFFF
+        self.next_sequence = (sequence + 1) & 0xFFFF
+
+        layout = _PAYLOADS.get(frame_type)
+        if layout is None or layout[0].size != len(payload):
+            return frame_type, sequence, payload
+        return layout[1](sequence, *layout[0].unpack(payload))
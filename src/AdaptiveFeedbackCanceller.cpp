@@ -1,41 +1,119 @@
 #include "AdaptiveFeedbackCanceller.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 
-#define MULT_16 32767
-constexpr unsigned char audioOutputs{1};
-constexpr unsigned int channel{0};
+/**
+ * @brief Gets the peak absolute sample of a block.
+ *
+ * @param data The AUDIO_BLOCK_SAMPLES samples of the block.
+ * @return The peak absolute sample.
+ */
+static std::uint16_t peak(const std::int16_t* data) {
+    int value{0};
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+        value = std::max(value, std::abs(static_cast<int>(data[i])));
+    }
+    return static_cast<std::uint16_t>(value);
+}
+
+/**
+ * @brief Gets the peak absolute sample of the blocks of several channels.
+ *
+ * @param blocks The block of each channel, nullptr for a missing one.
+ * @param channels The number of channels.
+ * @return The peak absolute sample.
+ */
+static std::uint16_t peak(const audio_block_t* const* blocks, const std::size_t channels) {
+    std::uint16_t value{0};
+    for (std::size_t channel = 0; channel < channels; channel++) {
+        if (blocks[channel]) value = std::max(value, peak(blocks[channel]->data));
+    }
+    return value;
+}
 
 /**
  * @brief Constructs an AdaptiveFeedbackCanceller object.
+ *
+ * The size of a state image is measured here, by writing the state with a counting writer before
+ * the audio interrupt runs.
+ *
+ * @param sampleRate The sample rate, in Hz.
  */
-AdaptiveFeedbackCanceller::AdaptiveFeedbackCanceller()
-    : AudioStream(audioOutputs, new audio_block_t*[audioOutputs]) {}
+template<std::size_t Channels>
+AdaptiveFeedbackCanceller<Channels>::AdaptiveFeedbackCanceller(const float sampleRate)
+    : AudioStream(Channels, new audio_block_t*[Channels]), sampleRate(sampleRate), notchLMSFilter(afcFilterOrder, 2750, 100, sampleRate) {
+    muCurrent = muTarget = notchLMSFilter.getRequestedMu();
+    requested.mu = static_cast<float>(muCurrent);
+
+    StateWriter counter;
+    notchLMSFilter.saveState(counter);
+    statePayloadSize = counter.size();
+}
 
 /**
  * @brief Destroys the AdaptiveFeedbackCanceller object.
  */
-AdaptiveFeedbackCanceller::~AdaptiveFeedbackCanceller() = default;
+template<std::size_t Channels>
+AdaptiveFeedbackCanceller<Channels>::~AdaptiveFeedbackCanceller() = default;
+
+/**
+ * @brief Queues a group of parameter changes, applied at the start of the next audio block.
+ *
+ * @param update The changes.
+ * @return True if the changes were queued, false if the queue is full.
+ */
+template<std::size_t Channels>
+bool AdaptiveFeedbackCanceller<Channels>::apply(const ParameterUpdate& update) {
+    if (!updates.push(update)) return false;
+
+    if (update.fields & ParameterUpdate::Gain) requested.gain = update.gain;
+    if (update.fields & ParameterUpdate::Mu) requested.mu = update.mu;
+    if (update.fields & ParameterUpdate::LMS) requested.lms = update.lms;
+    if (update.fields & ParameterUpdate::Notch) requested.notch = update.notch;
+    if (update.fields & ParameterUpdate::Mute) requested.mute = update.mute;
+    if (update.fields & ParameterUpdate::AdaptiveNotch) requested.adaptiveNotch = update.adaptiveNotch;
+    if (update.fields & ParameterUpdate::Algorithm) requested.algorithm = update.algorithm;
+    return true;
+}
 
 /**
  * @brief Sets the gain for the feedback canceller.
  *
  * @param gain The new gain value.
  */
-void AdaptiveFeedbackCanceller::setGain(const double gain) {
-    this->gain = gain;
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::setGain(const double gain) {
+    apply(ParameterUpdate{}.setGain(gain));
+}
+
+/**
+ * @brief Sets the adaptation rate of the adaptive filter, ramped from the rate last requested.
+ *
+ * The step controls that set the rate themselves take it as the highest rate they set.
+ *
+ * @param mu The new adaptation rate.
+ */
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::setMu(const double mu) {
+    apply(ParameterUpdate{}.setMu(mu));
 }
 
 /**
  * @brief Changes the mode of the feedback canceller.
  */
-void AdaptiveFeedbackCanceller::changeMode() {
-    mode = !mode;
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::changeMode() {
+    apply(ParameterUpdate{}.changeMode());
 }
 
 /**
  * @brief Resets the LMS filter.
  */
-void AdaptiveFeedbackCanceller::resetLMS() {
-    notchLMSFilter.LMSReset();
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::resetLMS() {
+    apply(ParameterUpdate{}.resetLMS());
 }
 
 /**
@@ -43,8 +121,9 @@ void AdaptiveFeedbackCanceller::resetLMS() {
  *
  * @param enabled True to enable the LMS filter, false to disable it.
  */
-void AdaptiveFeedbackCanceller::setLMS(const bool enabled) {
-    notchLMSFilter.enableLMS(enabled);
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::setLMS(const bool enabled) {
+    apply(ParameterUpdate{}.setLMS(enabled));
 }
 
 /**
@@ -52,8 +131,9 @@ void AdaptiveFeedbackCanceller::setLMS(const bool enabled) {
  *
  * @param enabled True to enable the notch filter, false to disable it.
  */
-void AdaptiveFeedbackCanceller::setNotch(const bool enabled) {
-    notchLMSFilter.enableNotch(enabled);
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::setNotch(const bool enabled) {
+    apply(ParameterUpdate{}.setNotch(enabled));
 }
 
 /**
@@ -61,40 +141,399 @@ void AdaptiveFeedbackCanceller::setNotch(const bool enabled) {
  *
  * @param muted True to mute the feedback canceller, false to unmute it.
  */
-void AdaptiveFeedbackCanceller::setMute(const bool muted) {
-    this->muted = muted;
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::setMute(const bool muted) {
+    apply(ParameterUpdate{}.setMute(muted));
+}
+
+/**
+ * @brief Enables or disables the in-filter frequency estimators that steer the notches.
+ *
+ * @param enabled True to enable the estimators, false to disable them.
+ */
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::setAdaptiveNotch(const bool enabled) {
+    apply(ParameterUpdate{}.setAdaptiveNotch(enabled));
+}
+
+#ifndef AFC_FDAF
+/**
+ * @brief Clamps the length of the window over which the LMS filter estimates its noise parameters.
+ *
+ * @param size The requested window length, in samples.
+ * @return The window length the filter accepts.
+ */
+template<std::size_t Channels>
+std::size_t AdaptiveFeedbackCanceller<Channels>::clampNoiseWindow(const std::size_t size) {
+    return std::max(Adaptive::MIN_ESTIMATION_WINDOW, std::min(Adaptive::MAX_ESTIMATION_WINDOW, size));
+}
+#endif
+
+#if !defined(AFC_FDAF) && !defined(AFC_SUBBAND)
+/**
+ * @brief Selects the adaptation algorithm of the LMS filter of every channel.
+ *
+ * @param algorithm The adaptation algorithm.
+ */
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::setAlgorithm(const LMSAlgorithm algorithm) {
+    apply(ParameterUpdate{}.setAlgorithm(algorithm));
+}
+#endif
+
+/**
+ * @brief Applies the queued changes and advances the adaptation rate ramp.
+ *
+ * The queue is drained whole, so the changes queued since the last block all take effect in
+ * this one.
+ */
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::applyUpdates() {
+    ParameterUpdate update;
+    while (updates.pop(update)) {
+        const std::uint16_t fields = update.fields;
+        if (fields & ParameterUpdate::Gain) targetGain = Traits::toGain(static_cast<typename Traits::real_t>(update.gain));
+        if (fields & ParameterUpdate::Mu) {
+            muTarget = static_cast<typename Traits::real_t>(update.mu);
+            muStep = (muTarget - muCurrent) / MU_RAMP_BLOCKS;
+            muRampBlocks = MU_RAMP_BLOCKS;
+        }
+        if (fields & ParameterUpdate::LMS) notchLMSFilter.enableLMS(update.lms);
+        if (fields & ParameterUpdate::Notch) notchLMSFilter.enableNotch(update.notch);
+        if (fields & ParameterUpdate::Mute) muted = update.mute;
+        if (fields & ParameterUpdate::Mode) mode = !mode;
+        if (fields & ParameterUpdate::ResetLMS) notchLMSFilter.LMSReset();
+        if (fields & ParameterUpdate::AdaptiveNotch) notchLMSFilter.enableAdaptiveNotch(update.adaptiveNotch);
+        if (fields & ParameterUpdate::Howls) {
+            typename Traits::real_t howls[ParameterUpdate::MAX_HOWLS];
+            std::copy(update.howls, update.howls + update.howlCount, howls);
+            notchLMSFilter.trackHowls(howls, update.howlCount);
+        }
+#ifndef AFC_FDAF
+        if (fields & ParameterUpdate::NoiseWindow) notchLMSFilter.getAdaptiveFilter().setEstimationWindow(update.noiseWindow);
+#endif
+#if !defined(AFC_FDAF) && !defined(AFC_SUBBAND)
+        if (fields & ParameterUpdate::Algorithm) {
+            notchLMSFilter.getAdaptiveFilter().select(update.algorithm);
+            // Until a rate is requested, each algorithm keeps its own default one.
+            if (muRampBlocks == 0) muCurrent = muTarget = notchLMSFilter.getRequestedMu();
+        }
+#endif
+        if (fields & ParameterUpdate::LoadState) {
+            StateReader reader(update.state, update.stateSize);
+            if (!notchLMSFilter.loadState(reader)) notchLMSFilter.LMSReset();
+        }
+        if (update.id != 0) acks.push(ParameterAck{update.id, blockCount});
+    }
+
+    if (muRampBlocks > 0) {
+        muCurrent = --muRampBlocks > 0 ? muCurrent + muStep : muTarget;
+        notchLMSFilter.setMu(muCurrent);
+    }
+
+    // The gain is not applied while processing is toggled off, so there is nothing to ramp.
+    if (mode) gain = targetGain;
 }
 
 /**
  * @brief Updates the audio stream with the processed output.
+ *
+ * When the output would equal the input (processing toggled off by changeMode(), or both
+ * filters off at unity gain, and not muted), the input blocks are forwarded as is. Otherwise
+ * the input blocks are processed in place and transmitted, so a block is never allocated.
+ * Nothing happens until at least one channel has a block. While a recorder records, the block
+ * of channel 0 is also written into it, straight into its chunk.
  */
-void AdaptiveFeedbackCanceller::update() {
-    audio_block_t* inBlock{receiveReadOnly(0)};
-    if (!inBlock) return;
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::update() {
+    AFC_PROFILE_BLOCK();
+    applyUpdates();
 
-    audio_block_t* outBlock{allocate()};
-    if (!outBlock) {
-        release(inBlock);
-        return;
+    const bool unity = gain == Traits::toGain(1.0) && targetGain == gain;
+    const bool bypass = !muted && (mode || (!notchLMSFilter.isLMSEnabled() && !notchLMSFilter.isNotchEnabled() && unity));
+
+    audio_block_t* blocks[Channels];
+    bool received{false};
+    for (std::size_t channel = 0; channel < Channels; channel++) {
+        blocks[channel] = bypass ? receiveReadOnly(channel) : receiveWritable(channel);
+        received = received || blocks[channel];
     }
+    if (!received) return;
 
-    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
-        auto currentSample{static_cast<double>(inBlock->data[i]) / static_cast<double>(MULT_16)};
+    // The error is the input unless process() runs the filters and writes it over.
+    recordFrame = recorder ? recorder->beginBlock() : nullptr;
+    if (recordFrame) {
+        const std::int16_t* input = blocks[0] ? blocks[0]->data : nullptr;
+        record(RecordChannel::Input, input);
+        record(RecordChannel::Error, input);
+    }
+
+    if (bypass) {
+        if (metricsEnabled) {
+            const std::uint16_t level = peak(blocks, Channels);
+            recordMetrics(level, level);
+        }
+    } else {
+        const bool recording = metricsEnabled;
+        const std::uint16_t inputPeak = recording ? peak(blocks, Channels) : 0;
 
         if (!mode) {
-            currentSample = notchLMSFilter.tick(currentSample);
-            currentSample *= gain;
+            process(blocks);
         }
 
         if (muted) {
-            currentSample = 0.0;
+            for (audio_block_t* block : blocks) {
+                if (block) std::fill(block->data, block->data + AUDIO_BLOCK_SAMPLES, std::int16_t{0});
+            }
+        }
+
+        if (recording) {
+            recordMetrics(inputPeak, peak(blocks, Channels));
+        }
+    }
+    if (recordFrame) {
+        record(RecordChannel::Output, blocks[0] ? blocks[0]->data : nullptr);
+        const auto& notchBank = notchLMSFilter.getNotchBank();
+        const auto frequency = notchBank.getActiveCount() > 0 ? std::lround(static_cast<double>(notchBank.getFrequency(0))) : 0L;
+        const auto notch = static_cast<std::int16_t>(std::min(frequency, 32767L));
+        for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+            recordFrame[i * SignalRecorder::CHANNELS + static_cast<std::size_t>(RecordChannel::NotchFrequency)] = notch;
+        }
+        recorder->endBlock();
+    }
+    if (snapshotRequested) publishSnapshot();
+    if (stateRequested) saveState();
+    blockCount++;
+
+    for (std::size_t channel = 0; channel < Channels; channel++) {
+        if (!blocks[channel]) continue;
+        transmit(blocks[channel], channel);
+        release(blocks[channel]);
+    }
+}
+
+/**
+ * @brief Runs the filters and the gain on the blocks of 16-bit samples of the channels, in place.
+ *
+ * The Q15 build filters the samples where they are; the other builds convert them to
+ * afc_sample_t and back.
+ *
+ * @param blocks The block of each channel, nullptr for a channel filtered as silence.
+ */
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::process(audio_block_t* const* blocks) {
+#if defined(AFC_SAMPLE_Q15)
+    afc_sample_t silence[Channels][AUDIO_BLOCK_SAMPLES];
+    afc_sample_t* samples[Channels];
+    for (std::size_t channel = 0; channel < Channels; channel++) {
+        if (blocks[channel]) {
+            samples[channel] = blocks[channel]->data;
+        } else {
+            std::fill(silence[channel], silence[channel] + AUDIO_BLOCK_SAMPLES, afc_sample_t{0});
+            samples[channel] = silence[channel];
+        }
+    }
+
+    notchLMSFilter.processBlock(samples, samples, AUDIO_BLOCK_SAMPLES);
+    if (recordFrame) {
+        for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+            recordFrame[i * SignalRecorder::CHANNELS + static_cast<std::size_t>(RecordChannel::Error)] = Traits::toInt16(samples[0][i]);
+        }
+    }
+    applyGain(samples);
+#else
+    afc_sample_t buffers[Channels][AUDIO_BLOCK_SAMPLES];
+    afc_sample_t* samples[Channels];
+    for (std::size_t channel = 0; channel < Channels; channel++) {
+        samples[channel] = buffers[channel];
+        if (!blocks[channel]) {
+            std::fill(buffers[channel], buffers[channel] + AUDIO_BLOCK_SAMPLES, afc_sample_t{});
+            continue;
+        }
+        for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+            buffers[channel][i] = Traits::fromInt16(blocks[channel]->data[i]);
+        }
+    }
+
+    notchLMSFilter.processBlock(samples, samples, AUDIO_BLOCK_SAMPLES);
+    if (recordFrame) {
+        for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+            recordFrame[i * SignalRecorder::CHANNELS + static_cast<std::size_t>(RecordChannel::Error)] = Traits::toInt16(samples[0][i]);
+        }
+    }
+    applyGain(samples);
+
+    for (std::size_t channel = 0; channel < Channels; channel++) {
+        if (!blocks[channel]) continue;
+        for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+            blocks[channel]->data[i] = Traits::toInt16(buffers[channel][i]);
         }
+    }
+#endif
+}
+
+/**
+ * @brief Applies the gain to the block of each channel, ramping it if it changed.
+ *
+ * The gain moves linearly from its previous value to targetGain over the block, so a gain
+ * change does not click.
+ *
+ * @param samples The AUDIO_BLOCK_SAMPLES samples of the block of each channel.
+ */
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::applyGain(afc_sample_t* const* samples) {
+    if (gain == targetGain) {
+        for (std::size_t channel = 0; channel < Channels; channel++) {
+            for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+                samples[channel][i] = Traits::applyGain(samples[channel][i], gain);
+            }
+        }
+        return;
+    }
+
+    const typename Traits::gain_t delta = targetGain - gain;
+    for (std::size_t channel = 0; channel < Channels; channel++) {
+        for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+            const typename Traits::gain_t rampGain = gain + delta * static_cast<typename Traits::gain_t>(i + 1) / static_cast<typename Traits::gain_t>(AUDIO_BLOCK_SAMPLES);
+            samples[channel][i] = Traits::applyGain(samples[channel][i], rampGain);
+        }
+    }
+    gain = targetGain;
+}
 
-        currentSample = max(-1.0, min(1.0, currentSample));
-        outBlock->data[i] = static_cast<int16_t>(currentSample * MULT_16);
+/**
+ * @brief Writes a block of samples into a channel of the recorded frame.
+ *
+ * @param channel The channel of the recording.
+ * @param samples The AUDIO_BLOCK_SAMPLES samples, or nullptr for silence.
+ */
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::record(const RecordChannel channel, const std::int16_t* samples) {
+    std::int16_t* frame = recordFrame + static_cast<std::size_t>(channel);
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++) {
+        frame[i * SignalRecorder::CHANNELS] = samples ? samples[i] : std::int16_t{0};
     }
+}
+
+/**
+ * @brief Queues the metrics of a block.
+ *
+ * @param inputPeak The peak absolute input sample.
+ * @param outputPeak The peak absolute output sample.
+ */
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::recordMetrics(const std::uint16_t inputPeak, const std::uint16_t outputPeak) {
+    const auto& notchBank = notchLMSFilter.getNotchBank();
+    TelemetryBlock block{};
+    block.block = blockCount;
+    block.inputPeak = inputPeak;
+    block.outputPeak = outputPeak;
+    block.notchFrequency = static_cast<float>(notchBank.getFrequency(0));
+    block.activeNotches = static_cast<std::uint8_t>(notchBank.getActiveCount());
+    metrics.push(block);
+}
+
+/**
+ * @brief Takes a snapshot of the filters of the requested channel and publishes it.
+ *
+ * The snapshot is written straight into the free slot of the double buffer. If loop() still
+ * holds it, the request stays pending until the next block.
+ */
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::publishSnapshot() {
+    FilterSnapshot* snapshot = snapshots.beginWrite();
+    if (!snapshot) return;
+
+    auto& adaptiveFilter = notchLMSFilter.getAdaptiveFilter();
+    const std::size_t channel = snapshotChannel;
+    const auto& notchBank = notchLMSFilter.getNotchBank(channel);
+    snapshot->block = blockCount;
+    snapshot->channel = static_cast<std::uint8_t>(channel);
+    snapshot->mu = static_cast<float>(adaptiveFilter.getMu(channel));
+    snapshot->gamma = static_cast<float>(adaptiveFilter.getGamma(channel));
+    snapshot->notchFrequency = static_cast<float>(notchBank.getFrequency(0));
+    snapshot->notchBandwidth = static_cast<float>(notchBank.getBandwidth(0));
+    snapshot->activeNotches = static_cast<std::uint8_t>(notchBank.getActiveCount());
+    adaptiveFilter.getImpulseResponse(snapshot->taps, afcSnapshotTaps, channel);
+
+    snapshots.publish();
+    snapshotRequested = false;
+}
+
+/**
+ * @brief Gets the build configuration written in the state images, which an image must match to be loaded.
+ *
+ * @return The build configuration.
+ */
+template<std::size_t Channels>
+StateImageInfo AdaptiveFeedbackCanceller<Channels>::getStateInfo() {
+#if defined(AFC_SAMPLE_Q15)
+    constexpr StateSample sample{StateSample::Q15};
+#elif defined(AFC_SAMPLE_Q31)
+    constexpr StateSample sample{StateSample::Q31};
+#elif defined(AFC_SAMPLE_DOUBLE)
+    constexpr StateSample sample{StateSample::Double};
+#else
+    constexpr StateSample sample{StateSample::Float};
+#endif
+#if defined(AFC_FDAF)
+    constexpr StateFilter filter{StateFilter::FDAF};
+#elif defined(AFC_SUBBAND)
+    constexpr StateFilter filter{StateFilter::Subband};
+#else
+    constexpr StateFilter filter{StateFilter::Selectable};
+#endif
+    return StateImageInfo{sample, filter, static_cast<std::uint16_t>(Channels), static_cast<std::uint32_t>(afcFilterOrder)};
+}
+
+/**
+ * @brief Asks for the adaptive state to be written into a state image at the end of the next audio block.
+ *
+ * @param image The buffer of the image.
+ * @param capacity The size of the buffer, at least getStateImageSize().
+ */
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::requestState(std::uint8_t* image, const std::size_t capacity) {
+    stateImage = image;
+    stateCapacity = capacity;
+    stateReady = false;
+    stateRequested = true;
+}
+
+/**
+ * @brief Completes the state image requested by requestState(), once the audio interrupt has written it.
+ *
+ * @param size The size of the image, 0 if the buffer was too small.
+ * @return True if the requested image was written, false if it is still pending.
+ */
+template<std::size_t Channels>
+bool AdaptiveFeedbackCanceller<Channels>::takeState(std::size_t& size) {
+    if (!stateReady) return false;
+
+    stateReady = false;
+    size = stateWritten > 0 ? sealStateImage(stateImage, getStateInfo(), stateWritten) : 0;
+    return true;
+}
+
+/**
+ * @brief Writes the payload of the requested state image.
+ *
+ * Only the payload is written in the audio interrupt; its CRC is left to takeState().
+ */
+template<std::size_t Channels>
+void AdaptiveFeedbackCanceller<Channels>::saveState() {
+    stateWritten = 0;
+    if (stateCapacity > STATE_HEADER_SIZE) {
+        StateWriter writer(stateImage + STATE_HEADER_SIZE, stateCapacity - STATE_HEADER_SIZE);
+        notchLMSFilter.saveState(writer);
+        if (!writer.overflowed()) stateWritten = writer.size();
+    }
+    stateRequested = false;
+    stateReady = true;
+}
 
-    transmit(outBlock, channel);
-    release(outBlock);
-    release(inBlock);
-}
\ No newline at end of file
+template class AdaptiveFeedbackCanceller<1>;
+#if !defined(AFC_FDAF) && !defined(AFC_SUBBAND)
+template class AdaptiveFeedbackCanceller<2>;
+template class AdaptiveFeedbackCanceller<4>;
+#endif
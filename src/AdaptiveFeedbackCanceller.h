@@ -2,19 +2,230 @@
 #define ADAPTIVE_FEEDBACK_CANCELLER_H
 
 #include "Audio.h"
+#include "DoubleBuffer.h"
 #include "NotchLMSFilter.h"
+#include "RingBuffer.h"
+#include "SignalRecorder.h"
+#include "StateImage.h"
+#include "Telemetry.h"
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(AFC_SAMPLE_Q15)
+using afc_sample_t = q15_t; ///< Sample type of the feedback canceller.
+#elif defined(AFC_SAMPLE_Q31)
+using afc_sample_t = q31_t; ///< Sample type of the feedback canceller.
+#elif defined(AFC_SAMPLE_DOUBLE)
+using afc_sample_t = double; ///< Sample type of the feedback canceller.
+#else
+using afc_sample_t = float; ///< Sample type of the feedback canceller.
+#endif
+
+#ifdef AFC_FDAF
+template<std::size_t Channels>
+using afc_adaptive_filter_t = PartitionedFDAFFilter<afc_sample_t>; ///< Adaptive filter of the feedback canceller, single-channel only.
+constexpr std::size_t afcFilterOrder{4096}; ///< Number of taps of the adaptive filter.
+#elif defined(AFC_SUBBAND)
+template<std::size_t Channels>
+using afc_adaptive_filter_t = SubbandCanceller<afc_sample_t>; ///< Adaptive filter of the feedback canceller, single-channel only.
+constexpr std::size_t afcFilterOrder{1024}; ///< Number of taps of the fullband filter modelled by the adaptive filter.
+#else
+template<std::size_t Channels>
+using afc_adaptive_filter_t = SelectableLMSFilter<afc_sample_t, Channels>; ///< Adaptive filter of a feedback canceller of Channels channels.
+constexpr std::size_t afcFilterOrder{64}; ///< Number of taps of the adaptive filter.
+#endif
+
+#if defined(AFC_FDAF) || defined(AFC_SUBBAND)
+static_assert(std::is_floating_point_v<afc_sample_t>, "AFC_FDAF and AFC_SUBBAND need a floating-point sample type");
+#endif
+
+constexpr std::size_t afcSnapshotTaps{afcFilterOrder < 128 ? afcFilterOrder : 128}; ///< Number of taps in a FilterSnapshot.
+
+/**
+ * @brief State of the adaptive filter and of the first notch of a channel, taken at the end of an audio block.
+ */
+struct FilterSnapshot {
+    std::uint32_t block; ///< Index of the block the snapshot was taken at.
+    std::uint8_t channel; ///< Channel the snapshot was taken on.
+    float mu; ///< Adaptation rate of the adaptive filter.
+    float gamma; ///< Leakage factor of the adaptive filter.
+    float notchFrequency; ///< Frequency of the first notch, in Hz.
+    float notchBandwidth; ///< Bandwidth of the first notch, in Hz.
+    std::uint8_t activeNotches; ///< Number of active notches.
+    SampleTraits<afc_sample_t>::real_t taps[afcSnapshotTaps]; ///< First taps of the estimated feedback path.
+};
+
+/**
+ * @brief A group of parameter changes for the feedback canceller.
+ *
+ * The changes of a group are applied together at the start of the same audio block. Each setter
+ * marks its parameter as changed and returns the group, so that changes can be chained.
+ */
+struct ParameterUpdate {
+    /**
+     * @brief Flags of the parameters changed by a group.
+     */
+    enum Field : std::uint16_t {
+        Gain = 1 << 0, ///< gain is set.
+        Mu = 1 << 1, ///< mu is set.
+        LMS = 1 << 2, ///< lms is set.
+        Notch = 1 << 3, ///< notch is set.
+        Mute = 1 << 4, ///< mute is set.
+        Mode = 1 << 5, ///< The mode is toggled.
+        ResetLMS = 1 << 6, ///< The LMS filter is reset.
+        NoiseWindow = 1 << 7, ///< noiseWindow is set.
+        AdaptiveNotch = 1 << 8, ///< adaptiveNotch is set.
+        Howls = 1 << 9, ///< howls and howlCount are set.
+        Algorithm = 1 << 10, ///< algorithm is set.
+        LoadState = 1 << 11, ///< state and stateSize are set.
+    };
+
+    static constexpr std::size_t MAX_HOWLS = 4; ///< Maximum number of howl frequencies in a group.
+
+    std::uint16_t fields{0}; ///< The parameters changed, as Field flags.
+    std::uint32_t id{0}; ///< Identifier echoed by the acknowledgement, 0 for no acknowledgement.
+    float gain{1.0f}; ///< The new gain.
+    float mu{0.0f}; ///< The new adaptation rate of the adaptive filter.
+    bool lms{true}; ///< True to enable the LMS filter.
+    bool notch{true}; ///< True to enable the notch filter.
+    bool mute{false}; ///< True to mute the output.
+    std::uint16_t noiseWindow{0}; ///< The new noise estimation window, in samples.
+    bool adaptiveNotch{true}; ///< True to steer the notches from the in-filter frequency estimators.
+    std::uint8_t howlCount{0}; ///< The number of howl frequencies.
+    float howls[MAX_HOWLS]{}; ///< The howl frequencies the notches track, in Hz, loudest first.
+    LMSAlgorithm algorithm{LMSAlgorithm::DynamicNoise}; ///< The new adaptation algorithm of the adaptive filter.
+    const std::uint8_t* state{nullptr}; ///< The payload of the state image to load, not owned.
+    std::uint32_t stateSize{0}; ///< The size of the payload.
+
+    /**
+     * @brief Sets the gain.
+     */
+    ParameterUpdate& setGain(const double value) { gain = static_cast<float>(value); fields |= Gain; return *this; }
+
+    /**
+     * @brief Sets the adaptation rate of the adaptive filter.
+     */
+    ParameterUpdate& setMu(const double value) { mu = static_cast<float>(value); fields |= Mu; return *this; }
+
+    /**
+     * @brief Enables or disables the LMS filter.
+     */
+    ParameterUpdate& setLMS(const bool enabled) { lms = enabled; fields |= LMS; return *this; }
+
+    /**
+     * @brief Enables or disables the notch filter.
+     */
+    ParameterUpdate& setNotch(const bool enabled) { notch = enabled; fields |= Notch; return *this; }
+
+    /**
+     * @brief Mutes or unmutes the output.
+     */
+    ParameterUpdate& setMute(const bool muted) { mute = muted; fields |= Mute; return *this; }
+
+    /**
+     * @brief Toggles the mode.
+     */
+    ParameterUpdate& changeMode() { fields ^= Mode; return *this; }
+
+    /**
+     * @brief Resets the LMS filter.
+     */
+    ParameterUpdate& resetLMS() { fields |= ResetLMS; return *this; }
+
+    /**
+     * @brief Sets the noise estimation window of the LMS filter.
+     */
+    ParameterUpdate& setNoiseWindow(const std::size_t size) { noiseWindow = static_cast<std::uint16_t>(std::min<std::size_t>(size, UINT16_MAX)); fields |= NoiseWindow; return *this; }
+
+    /**
+     * @brief Enables or disables the in-filter frequency estimators that steer the notches.
+     */
+    ParameterUpdate& setAdaptiveNotch(const bool enabled) { adaptiveNotch = enabled; fields |= AdaptiveNotch; return *this; }
+
+    /**
+     * @brief Sets the howl frequencies the notches track, keeping the first MAX_HOWLS.
+     */
+    ParameterUpdate& setHowls(const float* frequencies, const std::size_t count) {
+        howlCount = static_cast<std::uint8_t>(std::min(count, MAX_HOWLS));
+        std::copy(frequencies, frequencies + howlCount, howls);
+        fields |= Howls;
+        return *this;
+    }
+
+    /**
+     * @brief Sets the adaptation algorithm of the adaptive filter.
+     */
+    ParameterUpdate& setAlgorithm(const LMSAlgorithm value) { algorithm = value; fields |= Algorithm; return *this; }
+
+    /**
+     * @brief Loads the payload of a state image checked by openStateImage(), which must stay valid until the group is applied.
+     */
+    ParameterUpdate& setState(const std::uint8_t* payload, const std::size_t size) {
+        state = payload;
+        stateSize = static_cast<std::uint32_t>(size);
+        fields |= LoadState;
+        return *this;
+    }
+};
+
+/**
+ * @brief Acknowledgement of a group of parameter changes.
+ */
+struct ParameterAck {
+    std::uint32_t id; ///< Identifier of the group.
+    std::uint32_t block; ///< Index of the first audio block processed with the changes.
+};
 
 /**
  * @brief The AdaptiveFeedbackCanceller class implements an adaptive feedback canceller for audio processing.
  *
  * This class provides methods to apply adaptive feedback cancellation using a combination of notch and LMS filters.
+ * The processing chain runs on afc_sample_t, selected at build time with AFC_SAMPLE_Q15, AFC_SAMPLE_Q31 or
+ * AFC_SAMPLE_DOUBLE (float by default). The adaptive filter is a 64-tap SelectableLMSFilter whose adaptation
+ * algorithm can be switched at runtime with setAlgorithm(). Defining AFC_FDAF replaces it with a 4096-tap
+ * PartitionedFDAFFilter, and defining AFC_SUBBAND with a SubbandCanceller modelling 1024 taps (floating-point
+ * sample types and a single channel only).
+ *
+ * The canceller has Channels inputs and as many outputs, input i being filtered to output i. Each channel
+ * has its own notches and adaptive filter state, but a single update() runs them all, and the LMS filter
+ * interleaves the channels so that each tap is updated on every channel with one SIMD operation. The
+ * parameters are shared by the channels. A channel whose block is missing is filtered as silence and
+ * nothing is transmitted on its output.
+ *
+ * The parameters are changed from loop() while update() runs in the audio interrupt. The setters
+ * do not touch the filters: they queue a ParameterUpdate in a lock-free queue that update()
+ * drains at the start of each block, so a change never lands in the middle of a block. The
+ * getters report the parameters as last requested.
+ *
+ * The adaptive state of the filters (the weights and delay lines, the estimates of the step
+ * control and the notches) can be saved into a state image with requestState() and takeState(),
+ * and loaded back with a ParameterUpdate::setState() group, so that a known venue starts from the
+ * state it converged to instead of from zero. Both happen in update(), between two blocks.
+ *
+ * With setRecorder(), the input, output and error of channel 0 and the frequency of its first
+ * notch are written into a SignalRecorder at every block, for loop() to stream to a file.
+ *
+ * The block size is AUDIO_BLOCK_SAMPLES, fixed when the audio library is built: 128 samples by
+ * default, or 16, 32 or 64 for a shorter round trip. The sample rate is given to the constructor.
+ * The time constants that are counted in blocks are scaled so that they last as long whatever
+ * the block size.
+ *
+ * @tparam Channels The number of channels (default is 1).
  */
+template<std::size_t Channels = 1>
 class AdaptiveFeedbackCanceller final : public AudioStream {
 public:
+    static constexpr std::size_t CHANNELS = Channels; ///< Number of channels.
+
+    static_assert(AUDIO_BLOCK_SAMPLES >= 16 && 128 % AUDIO_BLOCK_SAMPLES == 0, "audio blocks must be of 16, 32, 64 or 128 samples");
+
     /**
      * @brief Constructs an AdaptiveFeedbackCanceller object.
+     *
+     * @param sampleRate The sample rate, in Hz (default is AUDIO_SAMPLE_RATE_EXACT).
      */
-    AdaptiveFeedbackCanceller();
+    explicit AdaptiveFeedbackCanceller(float sampleRate = AUDIO_SAMPLE_RATE_EXACT);
 
     /**
      * @brief Destroys the AdaptiveFeedbackCanceller object.
@@ -23,9 +234,30 @@ public:
 
     /**
      * @brief Updates the audio stream with the processed output.
+     *
+     * The input blocks are processed in place, or forwarded untouched when processing is off.
      */
     void update() override;
 
+    /**
+     * @brief Queues a group of parameter changes, applied at the start of the next audio block.
+     *
+     * A gain change is ramped over that block, and an adaptation rate change over MU_RAMP_BLOCKS
+     * blocks. If the group has an id, an acknowledgement is queued once it has been applied.
+     *
+     * @param update The changes.
+     * @return True if the changes were queued, false if the queue is full.
+     */
+    bool apply(const ParameterUpdate& update);
+
+    /**
+     * @brief Takes the oldest acknowledgement of an applied group of changes.
+     *
+     * @param ack The acknowledgement.
+     * @return True if an acknowledgement was available, false otherwise.
+     */
+    bool readAck(ParameterAck& ack) { return acks.pop(ack); }
+
     /**
      * @brief Sets the gain for the feedback canceller.
      *
@@ -33,6 +265,15 @@ public:
      */
     void setGain(double gain);
 
+    /**
+     * @brief Sets the adaptation rate of the adaptive filter, ramped from the rate last requested.
+     *
+     * The step controls that set the rate themselves take it as the highest rate they set.
+     *
+     * @param mu The new adaptation rate.
+     */
+    void setMu(double mu);
+
     /**
      * @brief Changes the mode of the feedback canceller.
      */
@@ -62,14 +303,14 @@ public:
      *
      * @return True if the LMS filter is enabled, false otherwise.
      */
-    [[nodiscard]] bool isLMSEnabled() const { return notchLMSFilter.isLMSEnabled(); }
+    [[nodiscard]] bool isLMSEnabled() const { return requested.lms; }
 
     /**
      * @brief Checks if the notch filter is enabled.
      *
      * @return True if the notch filter is enabled, false otherwise.
      */
-    [[nodiscard]] bool isNotchEnabled() const { return notchLMSFilter.isNotchEnabled(); }
+    [[nodiscard]] bool isNotchEnabled() const { return requested.notch; }
 
     /**
      * @brief Mutes or unmutes the feedback canceller.
@@ -78,19 +319,264 @@ public:
      */
     void setMute(bool muted);
 
+    /**
+     * @brief Enables or disables the in-filter frequency estimators that steer the notches.
+     *
+     * Disable them when the notches are steered by trackHowls() instead.
+     *
+     * @param enabled True to enable the estimators, false to disable them.
+     */
+    void setAdaptiveNotch(bool enabled);
+
+    /**
+     * @brief Checks if the in-filter frequency estimators steer the notches.
+     *
+     * @return True if they do, false otherwise.
+     */
+    [[nodiscard]] bool isAdaptiveNotchEnabled() const { return requested.adaptiveNotch; }
+
+    /**
+     * @brief Hands howl frequencies found outside the audio interrupt to the notches of every channel.
+     *
+     * The frequencies are queued like the other parameters and tracked by
+     * NotchLMSFilter::trackHowls() at the start of the next block. Call it for every analysis,
+     * with no frequency when no howl was found, so that the notches age.
+     *
+     * @param frequencies The howl frequencies in Hz, loudest first.
+     * @param count The number of frequencies, at most ParameterUpdate::MAX_HOWLS are kept.
+     * @return True if the frequencies were queued, false if the queue is full.
+     */
+    bool trackHowls(const float* frequencies, std::size_t count) { return apply(ParameterUpdate{}.setHowls(frequencies, count)); }
+
     /**
      * @brief Checks if the feedback canceller is muted.
      *
      * @return True if the feedback canceller is muted, false otherwise.
      */
-    [[nodiscard]] bool isMuted() const { return muted; }
+    [[nodiscard]] bool isMuted() const { return requested.mute; }
+
+    /**
+     * @brief Enables or disables the per-block metrics.
+     *
+     * When enabled, update() queues a TelemetryBlock for every audio block, to be collected with
+     * readMetrics(). Blocks are dropped while the queue is full. The peaks are taken over all the
+     * channels, and the notch fields are those of channel 0.
+     *
+     * @param enabled True to record the metrics, false to stop.
+     */
+    void setMetricsEnabled(const bool enabled) { metricsEnabled = enabled; }
+
+    /**
+     * @brief Takes the metrics of the oldest recorded audio block.
+     *
+     * Safe to call from loop() while update() runs in the audio interrupt.
+     *
+     * @param block The metrics of the block.
+     * @return True if metrics were available, false otherwise.
+     */
+    bool readMetrics(TelemetryBlock& block) { return metrics.pop(block); }
+
+    /**
+     * @brief Asks for a snapshot of the filters of a channel at the end of the next audio block.
+     *
+     * The snapshot is published in a double buffer, to be collected with acquireSnapshot().
+     *
+     * @param channel The channel (default is 0).
+     */
+    void requestSnapshot(const std::size_t channel = 0) {
+        snapshotChannel = static_cast<std::uint8_t>(std::min(channel, Channels - 1));
+        snapshotRequested = true;
+    }
+
+    /**
+     * @brief Takes the latest snapshot of the filters, if it has not been taken yet.
+     *
+     * The snapshot is read in place and stays valid until releaseSnapshot() is called. Safe to
+     * call from loop() while update() runs in the audio interrupt.
+     *
+     * @return The snapshot, or nullptr if none was published since the last call.
+     */
+    const FilterSnapshot* acquireSnapshot() { return snapshots.acquire(); }
+
+    /**
+     * @brief Gives the snapshot taken by acquireSnapshot() back to the audio interrupt.
+     */
+    void releaseSnapshot() { snapshots.release(); }
+
+    /**
+     * @brief Gets the build configuration written in the state images, which an image must match to be loaded.
+     *
+     * @return The build configuration.
+     */
+    static StateImageInfo getStateInfo();
+
+    /**
+     * @brief Gets the size of a state image of this canceller.
+     *
+     * The size is fixed by the build configuration, so a buffer of this size holds every image.
+     *
+     * @return The size, in bytes.
+     */
+    [[nodiscard]] std::size_t getStateImageSize() const { return STATE_HEADER_SIZE + statePayloadSize; }
+
+    /**
+     * @brief Asks for the adaptive state to be written into a state image at the end of the next audio block.
+     *
+     * The payload is written by the audio interrupt; the image is completed by takeState(). The
+     * image must not be touched until then.
+     *
+     * @param image The buffer of the image.
+     * @param capacity The size of the buffer, at least getStateImageSize().
+     */
+    void requestState(std::uint8_t* image, std::size_t capacity);
+
+    /**
+     * @brief Completes the state image requested by requestState(), once the audio interrupt has written it.
+     *
+     * The header and its CRC are written here, outside the audio interrupt.
+     *
+     * @param size The size of the image, 0 if the buffer was too small.
+     * @return True if the requested image was written, false if it is still pending.
+     */
+    bool takeState(std::size_t& size);
+
+    /**
+     * @brief Gets the sample rate the canceller was constructed for.
+     *
+     * @return The sample rate, in Hz.
+     */
+    [[nodiscard]] float getSampleRate() const { return sampleRate; }
+
+    /**
+     * @brief Sets the recorder the signals of channel 0 are written into while it records.
+     *
+     * Must be called before the audio starts.
+     *
+     * @param recorder The recorder, or nullptr for none.
+     */
+    void setRecorder(SignalRecorder* recorder) { this->recorder = recorder; }
+
+#ifndef AFC_FDAF
+    /**
+     * @brief Clamps the length of the window over which the LMS filter estimates its noise parameters.
+     *
+     * The window is set through apply(), with ParameterUpdate::setNoiseWindow() and the clamped length.
+     *
+     * @param size The requested window length, in samples.
+     * @return The window length the filter accepts.
+     */
+    static std::size_t clampNoiseWindow(std::size_t size);
+#endif
+
+#if !defined(AFC_FDAF) && !defined(AFC_SUBBAND)
+    /**
+     * @brief Selects the adaptation algorithm of the LMS filter of every channel.
+     *
+     * The algorithm takes over the weights identified so far at the start of the next block.
+     *
+     * @param algorithm The adaptation algorithm.
+     */
+    void setAlgorithm(LMSAlgorithm algorithm);
+
+    /**
+     * @brief Gets the adaptation algorithm of the LMS filter.
+     *
+     * @return The adaptation algorithm as last requested.
+     */
+    [[nodiscard]] LMSAlgorithm getAlgorithm() const { return requested.algorithm; }
+#endif
 
 private:
-    NotchLMSFilter notchLMSFilter{64, 2750, 100}; ///< The notch and LMS filter used for feedback cancellation.
-    double gain{1.0}; ///< The gain of the feedback canceller.
+    using Traits = SampleTraits<afc_sample_t>; ///< Arithmetic of the sample type.
+    using Adaptive = afc_adaptive_filter_t<Channels>; ///< The adaptive filter.
+
+    static_assert(Adaptive::CHANNELS == Channels, "the adaptive filter does not support this number of channels");
+
+    static constexpr std::size_t UPDATE_CAPACITY = 32; ///< Number of groups of changes queued.
+    static constexpr unsigned int MU_RAMP_BLOCKS = 1024 / AUDIO_BLOCK_SAMPLES; ///< Number of blocks an adaptation rate change is ramped over, 1024 samples.
+
+    float sampleRate; ///< The sample rate, in Hz.
+    NotchLMSFilter<afc_sample_t, Adaptive> notchLMSFilter; ///< The notch and LMS filters of the channels used for feedback cancellation.
+    Traits::gain_t gain{Traits::toGain(1.0)}; ///< The gain applied at the end of the last block.
+    Traits::gain_t targetGain{Traits::toGain(1.0)}; ///< The gain the current block ramps to.
     bool mode{false}; ///< The mode of the feedback canceller.
 
     bool muted{false}; ///< Indicates if the feedback canceller is muted.
+
+    Traits::real_t muCurrent{0}; ///< The requested adaptation rate, as far as the ramp has reached.
+    Traits::real_t muTarget{0}; ///< The requested adaptation rate the ramp ends at.
+    Traits::real_t muStep{0}; ///< Change of the adaptation rate per block while it ramps.
+    unsigned int muRampBlocks{0}; ///< Number of blocks left in the adaptation rate ramp.
+
+    ParameterUpdate requested{}; ///< The parameters as last requested from loop(); fields is unused.
+    RingBuffer<ParameterUpdate, UPDATE_CAPACITY> updates; ///< Changes waiting for the next block.
+    RingBuffer<ParameterAck, UPDATE_CAPACITY> acks; ///< Acknowledgements waiting for loop().
+
+    static constexpr std::size_t METRICS_CAPACITY = 8192 / AUDIO_BLOCK_SAMPLES; ///< Number of blocks of metrics queued, about 0.19 s at 44.1 kHz.
+    RingBuffer<TelemetryBlock, METRICS_CAPACITY> metrics; ///< Metrics of the recorded blocks, read by loop().
+    volatile bool metricsEnabled{false}; ///< True to record the metrics of each block.
+    std::uint32_t blockCount{0}; ///< Number of blocks processed.
+
+    DoubleBuffer<FilterSnapshot> snapshots; ///< Latest snapshots of the filters, read by loop().
+    volatile bool snapshotRequested{false}; ///< True to take a snapshot at the end of the next block.
+    volatile std::uint8_t snapshotChannel{0}; ///< Channel of the requested snapshot.
+
+    std::size_t statePayloadSize{0}; ///< Size of the payload of a state image.
+    std::uint8_t* stateImage{nullptr}; ///< Buffer of the requested state image.
+    std::size_t stateCapacity{0}; ///< Size of the buffer of the requested state image.
+    std::size_t stateWritten{0}; ///< Size of the payload written, 0 if it did not fit.
+    volatile bool stateRequested{false}; ///< True to write the state image at the end of the next block.
+    volatile bool stateReady{false}; ///< True once the payload of the requested image is written.
+
+    SignalRecorder* recorder{nullptr}; ///< Recorder of the signals of channel 0, or nullptr.
+    std::int16_t* recordFrame{nullptr}; ///< Frame of the current block in the recorder, nullptr if it is not recorded.
+
+    /**
+     * @brief Runs the filters and the gain on the blocks of 16-bit samples of the channels, in place.
+     *
+     * @param blocks The block of each channel, nullptr for a channel filtered as silence.
+     */
+    void process(audio_block_t* const* blocks);
+
+    /**
+     * @brief Applies the gain to the block of each channel, ramping it if it changed.
+     *
+     * @param samples The AUDIO_BLOCK_SAMPLES samples of the block of each channel.
+     */
+    void applyGain(afc_sample_t* const* samples);
+
+    /**
+     * @brief Writes a block of samples into a channel of the recorded frame.
+     *
+     * @param channel The channel of the recording.
+     * @param samples The AUDIO_BLOCK_SAMPLES samples, or nullptr for silence.
+     */
+    void record(RecordChannel channel, const std::int16_t* samples);
+
+    /**
+     * @brief Applies the queued changes and advances the adaptation rate ramp.
+     *
+     * Runs in update(), at the start of each block.
+     */
+    void applyUpdates();
+
+    /**
+     * @brief Queues the metrics of a block.
+     *
+     * @param inputPeak The peak absolute input sample.
+     * @param outputPeak The peak absolute output sample.
+     */
+    void recordMetrics(std::uint16_t inputPeak, std::uint16_t outputPeak);
+
+    /**
+     * @brief Takes a snapshot of the filters of the requested channel and publishes it.
+     */
+    void publishSnapshot();
+
+    /**
+     * @brief Writes the payload of the requested state image.
+     */
+    void saveState();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "AutocorrelationEstimator.h"
+
+/**
+ * @brief Constructs an AutocorrelationEstimator object.
+ *
+ * @param sampleRate The sample rate of the input, in Hz.
+ */
+template<typename R>
+AutocorrelationEstimator<R>::AutocorrelationEstimator(const R sampleRate) : sampleRate(sampleRate) {}
+
+/**
+ * @brief Feeds samples to the estimator.
+ *
+ * @param samples The input samples.
+ * @param n The number of samples.
+ */
+template<typename R>
+void AutocorrelationEstimator<R>::process(const R* samples, const std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        history[historyIndex] = samples[i];
+        historyIndex = (historyIndex + 1) % WINDOW_SIZE;
+    }
+}
+
+/**
+ * @brief Estimates the dominant frequency of the most recent samples.
+ *
+ * Lags below a fifth of the maximum lag are ignored, as in the original estimator.
+ *
+ * @param minFrequency The lowest frequency to consider, in Hz.
+ * @param maxFrequency The highest frequency to consider, in Hz.
+ * @return The estimated frequency in Hz, or 0 if no component was found.
+ */
+template<typename R>
+R AutocorrelationEstimator<R>::estimate(const R minFrequency, const R maxFrequency) {
+    constexpr std::size_t MAX_LAG = WINDOW_SIZE / 2;
+    R window[WINDOW_SIZE];
+    R autocorr[MAX_LAG];
+
+    for (std::size_t i = 0; i < WINDOW_SIZE; ++i) {
+        window[i] = history[(historyIndex + i) % WINDOW_SIZE];
+    }
+
+    for (std::size_t lag = 0; lag < MAX_LAG; ++lag) {
+        autocorr[lag] = 0;
+        for (std::size_t i = 0; i < WINDOW_SIZE - lag; ++i) {
+            autocorr[lag] += window[i] * window[i + lag];
+        }
+    }
+
+    std::size_t peakLag = 0;
+    R peakValue = 0;
+
+    for (std::size_t lag = MAX_LAG / 5; lag < MAX_LAG - 1; ++lag) {
+        const R frequency = sampleRate / static_cast<R>(lag);
+        if (frequency < minFrequency || frequency > maxFrequency) continue;
+        if (autocorr[lag] > autocorr[lag - 1] && autocorr[lag] > autocorr[lag + 1] && autocorr[lag] > peakValue) {
+            peakLag = lag;
+            peakValue = autocorr[lag];
+        }
+    }
+
+    return peakLag > 0 ? sampleRate / static_cast<R>(peakLag) : R{0};
+}
+
+/**
+ * @brief Clears the history of the estimator.
+ */
+template<typename R>
+void AutocorrelationEstimator<R>::reset() {
+    for (R& sample : history) {
+        sample = R{0};
+    }
+    historyIndex = 0;
+}
+
+/**
+ * @brief Sets the sample rate of the input and clears the history of the estimator.
+ *
+ * @param sampleRate The sample rate of the input, in Hz.
+ */
+template<typename R>
+void AutocorrelationEstimator<R>::setSampleRate(const R sampleRate) {
+    this->sampleRate = sampleRate;
+    reset();
+}
+
+template class AutocorrelationEstimator<double>;
+template class AutocorrelationEstimator<float>;
@@ -0,0 +1,64 @@
+#ifndef AUTOCORRELATION_ESTIMATOR_H
+#define AUTOCORRELATION_ESTIMATOR_H
+
+#include "FrequencyEstimator.h"
+#include <Audio.h>
+
+/**
+ * @brief The AutocorrelationEstimator class estimates the dominant frequency from the autocorrelation peak.
+ *
+ * The autocorrelation of the last WINDOW_SIZE samples is computed for lags up to WINDOW_SIZE / 2 and the
+ * frequency is the sample rate over the lag of its highest local maximum. The cost is O(WINDOW_SIZE²) per
+ * estimate and the resolution is that of an integer lag, which gets coarse at high frequencies. This is
+ * the estimator NotchLMSFilter originally used; it is kept for comparison.
+ *
+ * @tparam R The real type (float or double).
+ */
+template<typename R>
+class AutocorrelationEstimator final : public FrequencyEstimator<R> {
+public:
+    static constexpr std::size_t WINDOW_SIZE = 128; ///< Number of samples in the analysis window.
+
+    /**
+     * @brief Constructs an AutocorrelationEstimator object.
+     *
+     * @param sampleRate The sample rate of the input, in Hz.
+     */
+    explicit AutocorrelationEstimator(R sampleRate = AUDIO_SAMPLE_RATE_EXACT);
+
+    /**
+     * @brief Feeds samples to the estimator.
+     *
+     * @param samples The input samples.
+     * @param n The number of samples.
+     */
+    void process(const R* samples, std::size_t n) override;
+
+    /**
+     * @brief Estimates the dominant frequency of the most recent samples.
+     *
+     * @param minFrequency The lowest frequency to consider, in Hz.
+     * @param maxFrequency The highest frequency to consider, in Hz.
+     * @return The estimated frequency in Hz, or 0 if no component was found.
+     */
+    R estimate(R minFrequency, R maxFrequency) override;
+
+    /**
+     * @brief Clears the history of the estimator.
+     */
+    void reset() override;
+
+    /**
+     * @brief Sets the sample rate of the input and clears the history of the estimator.
+     *
+     * @param sampleRate The sample rate of the input, in Hz.
+     */
+    void setSampleRate(R sampleRate) override;
+
+private:
+    R sampleRate; ///< The sample rate of the input.
+    R history[WINDOW_SIZE]{}; ///< Ring buffer of the most recent samples.
+    std::size_t historyIndex{0}; ///< Position of the oldest sample in the ring buffer.
+};
+
+#endif
@@ -0,0 +1,144 @@
+#include "BulkDelayEstimator.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief Gets the smallest power of two above a delay.
+ *
+ * @param maxDelay The longest delay to estimate, in samples.
+ * @return The number of samples per block, at least 2.
+ */
+static std::size_t blockLength(const std::size_t maxDelay) {
+    std::size_t length{2};
+    while (length <= maxDelay) length *= 2;
+    return length;
+}
+
+/**
+ * @brief Constructs a BulkDelayEstimator object.
+ *
+ * @param maxDelay The longest delay to estimate, in samples.
+ * @param smoothing The smoothing factor of the spectra from one block to the next, in [0, 1).
+ */
+template<typename R>
+BulkDelayEstimator<R>::BulkDelayEstimator(const std::size_t maxDelay, const R smoothing)
+    : maxDelay(maxDelay), length(blockLength(maxDelay)), smoothing(smoothing), fft(2 * length) {
+    referenceFrame = new R[2 * length];
+    desiredFrame = new R[2 * length];
+    referenceSpectrum = new complex_t[length + 1];
+    desiredSpectrum = new complex_t[length + 1];
+    crossSpectrum = new complex_t[length + 1];
+    referencePower = new R[length + 1];
+    response = new R[2 * length];
+
+    reset();
+}
+
+/**
+ * @brief Destroys the BulkDelayEstimator object and releases allocated resources.
+ */
+template<typename R>
+BulkDelayEstimator<R>::~BulkDelayEstimator() {
+    delete[] referenceFrame;
+    delete[] desiredFrame;
+    delete[] referenceSpectrum;
+    delete[] desiredSpectrum;
+    delete[] crossSpectrum;
+    delete[] referencePower;
+    delete[] response;
+}
+
+/**
+ * @brief Clears the history and the smoothed spectra.
+ */
+template<typename R>
+void BulkDelayEstimator<R>::reset() {
+    std::fill(referenceFrame, referenceFrame + 2 * length, R{0});
+    std::fill(desiredFrame, desiredFrame + 2 * length, R{0});
+    std::fill(crossSpectrum, crossSpectrum + length + 1, complex_t{});
+    std::fill(referencePower, referencePower + length + 1, R{0});
+    fill = 0;
+    onset = 0;
+    found = false;
+}
+
+/**
+ * @brief Feeds samples of the input and the output of the path to the estimator.
+ *
+ * @param reference The samples entering the path.
+ * @param desired The samples leaving the path.
+ * @param n The number of samples.
+ */
+template<typename R>
+void BulkDelayEstimator<R>::process(const R* reference, const R* desired, const std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        referenceFrame[length + fill] = reference[i];
+        desiredFrame[length + fill] = desired[i];
+        if (++fill == length) {
+            analyzeBlock();
+            std::copy(referenceFrame + length, referenceFrame + 2 * length, referenceFrame);
+            fill = 0;
+        }
+    }
+}
+
+/**
+ * @brief Updates the spectra and the estimate with the current block.
+ *
+ * The desired frame is zero over the previous block, so the circular cross-correlation of the
+ * frames equals the linear one over the lags of a block: lag k pairs each desired sample with
+ * the reference sample k samples older.
+ */
+template<typename R>
+void BulkDelayEstimator<R>::analyzeBlock() {
+    constexpr R onsetFraction{0.25};
+    constexpr R peakRatio{8.0};
+    constexpr R floorFraction{1e-3};
+
+    fft.forward(referenceFrame, referenceSpectrum);
+    fft.forward(desiredFrame, desiredSpectrum);
+
+    R meanPower{0};
+    for (std::size_t k = 0; k <= length; ++k) {
+        crossSpectrum[k] = smoothing * crossSpectrum[k] + (R{1} - smoothing) * desiredSpectrum[k] * std::conj(referenceSpectrum[k]);
+        referencePower[k] = smoothing * referencePower[k] + (R{1} - smoothing) * std::norm(referenceSpectrum[k]);
+        meanPower += referencePower[k];
+    }
+    meanPower /= static_cast<R>(length + 1);
+
+    const R powerFloor = floorFraction * meanPower + std::numeric_limits<R>::min();
+    for (std::size_t k = 0; k <= length; ++k) {
+        desiredSpectrum[k] = crossSpectrum[k] / (referencePower[k] + powerFloor);
+    }
+    fft.inverse(desiredSpectrum, response);
+
+    R peak{0}, mean{0};
+    for (std::size_t lag = 0; lag < length; ++lag) {
+        const R magnitude = std::abs(response[lag]);
+        peak = std::max(peak, magnitude);
+        mean += magnitude;
+    }
+    mean /= static_cast<R>(length);
+
+    found = peak > peakRatio * mean;
+    if (!found) return;
+    onset = 0;
+    while (std::abs(response[onset]) < onsetFraction * peak) ++onset;
+    onset = std::min(onset, maxDelay);
+}
+
+/**
+ * @brief Gets the bulk delay estimated at the end of the last complete block.
+ *
+ * @param delay The estimated delay, in samples, set if an estimate is available.
+ * @return True if the response of the path stands out of its noise floor, false otherwise.
+ */
+template<typename R>
+bool BulkDelayEstimator<R>::estimate(std::size_t& delay) const {
+    if (found) delay = onset;
+    return found;
+}
+
+template class BulkDelayEstimator<float>;
+template class BulkDelayEstimator<double>;
@@ -0,0 +1,98 @@
+#ifndef BULK_DELAY_ESTIMATOR_H
+#define BULK_DELAY_ESTIMATOR_H
+
+#include "FFT.h"
+#include <complex>
+#include <cstddef>
+
+/**
+ * @brief The BulkDelayEstimator class estimates the bulk delay of a path from its input and output.
+ *
+ * The reference and desired signals are cut into blocks of a power of two samples covering the
+ * longest delay. For each block the cross-spectrum of the desired block with the reference of the
+ * block and the previous one, and the power spectrum of the reference, are computed by FFT and
+ * exponentially smoothed. Their ratio is the transfer function of the path, whitened from the
+ * colour of the reference, and its inverse transform the impulse response over the lags of a
+ * block. The bulk delay is the first lag whose response reaches a fraction of the strongest one.
+ * The cost is three FFTs of two blocks per block of samples.
+ *
+ * The estimate is meant for LMSFilter::setBulkDelay(), less a few samples of margin so that the
+ * onset of the path stays within the taps.
+ *
+ * @tparam R The real type (float or double).
+ */
+template<typename R>
+class BulkDelayEstimator final {
+public:
+    using complex_t = std::complex<R>; ///< Complex type of the spectra.
+
+    /**
+     * @brief Constructs a BulkDelayEstimator object.
+     *
+     * @param maxDelay The longest delay to estimate, in samples.
+     * @param smoothing The smoothing factor of the spectra from one block to the next, in [0, 1) (default is 0.9).
+     */
+    explicit BulkDelayEstimator(std::size_t maxDelay, R smoothing = 0.9);
+
+    /**
+     * @brief Destroys the BulkDelayEstimator object.
+     */
+    ~BulkDelayEstimator();
+
+    BulkDelayEstimator(const BulkDelayEstimator&) = delete;
+    BulkDelayEstimator& operator=(const BulkDelayEstimator&) = delete;
+
+    /**
+     * @brief Feeds samples of the input and the output of the path to the estimator.
+     *
+     * @param reference The samples entering the path.
+     * @param desired The samples leaving the path.
+     * @param n The number of samples.
+     */
+    void process(const R* reference, const R* desired, std::size_t n);
+
+    /**
+     * @brief Gets the bulk delay estimated at the end of the last complete block.
+     *
+     * @param delay The estimated delay, in samples, set if an estimate is available.
+     * @return True if the response of the path stands out of its noise floor, false otherwise.
+     */
+    bool estimate(std::size_t& delay) const;
+
+    /**
+     * @brief Clears the history and the smoothed spectra.
+     */
+    void reset();
+
+    /**
+     * @brief Gets the number of samples per analysed block, which bounds the estimated delay.
+     *
+     * @return The number of samples per block.
+     */
+    [[nodiscard]] std::size_t getBlockSize() const { return length; }
+
+private:
+    std::size_t maxDelay; ///< The longest delay to estimate, in samples.
+    std::size_t length; ///< Number of samples per block, a power of two above maxDelay.
+    R smoothing; ///< Smoothing factor of the spectra.
+    FFT<R> fft; ///< Transform of two blocks.
+
+    R* referenceFrame; ///< Reference samples of the previous and current blocks.
+    R* desiredFrame; ///< Zeros followed by the desired samples of the current block.
+    std::size_t fill{0}; ///< Number of samples of the current block received so far.
+    complex_t* referenceSpectrum; ///< Spectrum of referenceFrame.
+    complex_t* desiredSpectrum; ///< Spectrum of desiredFrame, then the transfer function of the path.
+    complex_t* crossSpectrum; ///< Smoothed cross-spectrum of the desired and reference frames.
+    R* referencePower; ///< Smoothed power spectrum of the reference frame.
+    R* response; ///< Impulse response of the path over the lags of two blocks.
+
+    std::size_t onset{0}; ///< Delay estimated at the end of the last block.
+    bool found{false}; ///< True if the last block gave an estimate.
+
+    /**
+     * @brief Updates the spectra and the estimate with the current block.
+     */
+    void analyzeBlock();
+};
+
+#endif
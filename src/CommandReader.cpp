@@ -0,0 +1,42 @@
+#include "CommandReader.h"
+
+/**
+ * @brief Checks if a byte is whitespace trimmed from commands.
+ */
+static bool isSpace(const char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * @brief Pushes the next byte received.
+ *
+ * @param c The byte.
+ * @return True if the byte completes a non-empty command, available through line().
+ */
+bool CommandReader::push(const char c) {
+    if (complete) {
+        complete = false;
+        length = 0;
+    }
+
+    if (c == '\n') {
+        const bool valid = !overflow;
+        overflow = false;
+        while (length > 0 && isSpace(buffer[length - 1])) length--;
+        if (!valid || length == 0) {
+            length = 0;
+            return false;
+        }
+        buffer[length] = '\0';
+        complete = true;
+        return true;
+    }
+
+    if (length == 0 && isSpace(c)) return false;
+    if (length < CAPACITY) {
+        buffer[length++] = c;
+    } else {
+        overflow = true;
+    }
+    return false;
+}
@@ -0,0 +1,46 @@
+#ifndef COMMAND_READER_H
+#define COMMAND_READER_H
+
+#include <cstddef>
+
+/**
+ * @brief The CommandReader class assembles serial commands one byte at a time.
+ *
+ * Bytes are pushed as they arrive, so reading never waits for the end of a line. A command is
+ * a line terminated by '\n', with '\r' and surrounding whitespace removed. The line is kept in a
+ * fixed buffer; a line longer than CAPACITY is discarded whole.
+ */
+class CommandReader {
+public:
+    static constexpr std::size_t CAPACITY = 63; ///< Longest command, in characters.
+
+    /**
+     * @brief Pushes the next byte received.
+     *
+     * @param c The byte.
+     * @return True if the byte completes a non-empty command, available through line().
+     */
+    bool push(char c);
+
+    /**
+     * @brief Gets the last complete command.
+     *
+     * @return The command, valid until the next call to push().
+     */
+    [[nodiscard]] const char* line() const { return buffer; }
+
+    /**
+     * @brief Checks if no command is partially received.
+     *
+     * @return True if the next byte starts a new command, false otherwise.
+     */
+    [[nodiscard]] bool isEmpty() const { return length == 0 || complete; }
+
+private:
+    char buffer[CAPACITY + 1]{}; ///< The command being received, then the complete command.
+    std::size_t length{0}; ///< Number of characters in the buffer.
+    bool complete{false}; ///< True once the buffer holds a complete command.
+    bool overflow{false}; ///< True if the command being received is too long.
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef DOUBLE_BUFFER_H
+#define DOUBLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief The DoubleBuffer class hands the latest value written by one context to another, without locks.
+ *
+ * The writer fills a slot in place and publishes it; the reader takes the latest published slot,
+ * reads it in place and releases it. Neither side copies the value nor waits: the writer always
+ * fills the slot that is neither published nor held by the reader, and when the reader still
+ * holds the only other slot, beginWrite() returns nullptr and that value is skipped. The published
+ * and held slots and whether the reader has seen the published one are packed into one atomic
+ * byte, so the audio interrupt can publish while loop() reads.
+ *
+ * @tparam T The value type.
+ */
+template<typename T>
+class DoubleBuffer {
+public:
+    /**
+     * @brief Gets the slot to fill with the next value.
+     *
+     * @return The slot, or nullptr if the reader holds it.
+     */
+    T* beginWrite() {
+        const std::uint8_t state = this->state.load(std::memory_order_acquire);
+        const std::uint8_t published = state & SLOT_MASK;
+        const std::uint8_t held = state >> HELD_SHIFT & SLOT_MASK;
+        const std::uint8_t target = published == NONE ? (held == 0 ? 1 : 0) : 1 - published;
+        if (target == held) return nullptr;
+        writing = target;
+        return &slots[target];
+    }
+
+    /**
+     * @brief Publishes the slot filled since beginWrite(), which becomes the latest value.
+     */
+    void publish() {
+        std::uint8_t state = this->state.load(std::memory_order_relaxed);
+        while (!this->state.compare_exchange_weak(state, static_cast<std::uint8_t>((state & ~SLOT_MASK) | writing | FRESH),
+                                                  std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * @brief Takes the latest value, if it has not been taken yet.
+     *
+     * The value stays valid until release() is called.
+     *
+     * @return The value, or nullptr if no value was published since the last call.
+     */
+    const T* acquire() {
+        std::uint8_t state = this->state.load(std::memory_order_relaxed);
+        std::uint8_t published;
+        do {
+            if (!(state & FRESH)) return nullptr;
+            published = state & SLOT_MASK;
+        } while (!this->state.compare_exchange_weak(state, static_cast<std::uint8_t>(published | published << HELD_SHIFT),
+                                                    std::memory_order_acquire, std::memory_order_relaxed));
+        return &slots[published];
+    }
+
+    /**
+     * @brief Gives the value taken by acquire() back to the writer.
+     */
+    void release() { state.fetch_or(NONE << HELD_SHIFT, std::memory_order_release); }
+
+private:
+    static constexpr std::uint8_t NONE = 3; ///< Slot index meaning no slot.
+    static constexpr std::uint8_t SLOT_MASK = 3; ///< Mask of a slot index.
+    static constexpr std::uint8_t HELD_SHIFT = 2; ///< Position of the held slot index.
+    static constexpr std::uint8_t FRESH = 1 << 4; ///< Set while the published slot has not been acquired.
+
+    T slots[2]{}; ///< The two values.
+    std::atomic<std::uint8_t> state{NONE | NONE << HELD_SHIFT}; ///< Published slot, held slot and FRESH flag.
+    std::uint8_t writing{0}; ///< Slot returned by the last beginWrite(), only used by the writer.
+};
+
+#endif
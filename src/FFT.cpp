@@ -0,0 +1,126 @@
+#include "FFT.h"
+#include <cmath>
+
+/**
+ * @brief Constructs an FFT object for the specified transform size.
+ *
+ * @param size The size of the real transform, a power of two of at least 4.
+ */
+template<typename R>
+FFT<R>::FFT(const std::size_t size) : size(size), half(size / 2) {
+    twiddles = new complex_t[half / 2];
+    splitTwiddles = new complex_t[half + 1];
+    bitReverse = new std::size_t[half];
+    scratch = new complex_t[half];
+
+    const double pi = M_PI;
+    for (std::size_t k = 0; k < half / 2; ++k) {
+        const double angle = -2.0 * pi * static_cast<double>(k) / static_cast<double>(half);
+        twiddles[k] = complex_t(static_cast<R>(std::cos(angle)), static_cast<R>(std::sin(angle)));
+    }
+    for (std::size_t k = 0; k <= half; ++k) {
+        const double angle = -2.0 * pi * static_cast<double>(k) / static_cast<double>(size);
+        splitTwiddles[k] = complex_t(static_cast<R>(std::cos(angle)), static_cast<R>(std::sin(angle)));
+    }
+
+    std::size_t bits = 0;
+    while ((std::size_t{1} << bits) < half) ++bits;
+    for (std::size_t i = 0; i < half; ++i) {
+        std::size_t reversed = 0;
+        for (std::size_t b = 0; b < bits; ++b) {
+            reversed |= ((i >> b) & 1u) << (bits - 1 - b);
+        }
+        bitReverse[i] = reversed;
+    }
+}
+
+/**
+ * @brief Destroys the FFT object and releases allocated resources.
+ */
+template<typename R>
+FFT<R>::~FFT() {
+    delete[] twiddles;
+    delete[] splitTwiddles;
+    delete[] bitReverse;
+    delete[] scratch;
+}
+
+/**
+ * @brief Computes an in-place forward complex transform of size half.
+ *
+ * @param data The data to transform.
+ */
+template<typename R>
+void FFT<R>::transform(complex_t* data) const {
+    for (std::size_t i = 0; i < half; ++i) {
+        if (const std::size_t j = bitReverse[i]; i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+
+    for (std::size_t length = 2; length <= half; length *= 2) {
+        const std::size_t stride = half / length;
+        for (std::size_t start = 0; start < half; start += length) {
+            for (std::size_t k = 0; k < length / 2; ++k) {
+                const complex_t t = twiddles[k * stride] * data[start + k + length / 2];
+                data[start + k + length / 2] = data[start + k] - t;
+                data[start + k] += t;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Computes the spectrum of a real signal.
+ *
+ * The even and odd samples are packed into the real and imaginary parts of a
+ * half-size complex signal, and the split step separates their spectra.
+ *
+ * @param input The size real input samples.
+ * @param spectrum The size / 2 + 1 output bins.
+ */
+template<typename R>
+void FFT<R>::forward(const R* input, complex_t* spectrum) {
+    for (std::size_t i = 0; i < half; ++i) {
+        scratch[i] = complex_t(input[2 * i], input[2 * i + 1]);
+    }
+    transform(scratch);
+
+    const R halfScale{0.5};
+    for (std::size_t k = 0; k <= half; ++k) {
+        const complex_t z = scratch[k == half ? 0 : k];
+        const complex_t zMirror = std::conj(scratch[k == 0 ? 0 : half - k]);
+        const complex_t even = (z + zMirror) * halfScale;
+        const complex_t odd = (z - zMirror) * complex_t(0, -halfScale);
+        spectrum[k] = even + splitTwiddles[k] * odd;
+    }
+}
+
+/**
+ * @brief Computes the real signal of a spectrum.
+ *
+ * @param spectrum The size / 2 + 1 input bins.
+ * @param output The size real output samples.
+ */
+template<typename R>
+void FFT<R>::inverse(const complex_t* spectrum, R* output) {
+    const R halfScale{0.5};
+    for (std::size_t k = 0; k < half; ++k) {
+        const complex_t x = spectrum[k];
+        const complex_t xMirror = std::conj(spectrum[half - k]);
+        const complex_t even = (x + xMirror) * halfScale;
+        const complex_t odd = (x - xMirror) * std::conj(splitTwiddles[k]) * halfScale;
+        // Inverse transform through the forward one: conj(FFT(conj(z))).
+        scratch[k] = std::conj(even + complex_t(0, 1) * odd);
+    }
+    transform(scratch);
+
+    const R scale = R{1} / static_cast<R>(half);
+    for (std::size_t i = 0; i < half; ++i) {
+        output[2 * i] = scratch[i].real() * scale;
+        output[2 * i + 1] = -scratch[i].imag() * scale;
+    }
+}
+
+template class FFT<double>;
+template class FFT<float>;
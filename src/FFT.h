@@ -0,0 +1,83 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+#include <cstddef>
+
+/**
+ * @brief The FFT class implements a real-input fast Fourier transform.
+ *
+ * A real transform of size N is computed with a radix-2 complex transform of size N / 2
+ * and a split step, using twiddle factors and a bit-reversal table computed once in the
+ * constructor. The forward transform is unnormalized and the inverse transform is scaled
+ * by 1 / N, so inverse(forward(x)) == x.
+ *
+ * @tparam R The real type (float or double).
+ */
+template<typename R>
+class FFT final {
+public:
+    using complex_t = std::complex<R>; ///< Complex type of the spectrum.
+
+    /**
+     * @brief Constructs an FFT object for the specified transform size.
+     *
+     * @param size The size of the real transform, a power of two of at least 4.
+     */
+    explicit FFT(std::size_t size);
+
+    /**
+     * @brief Destroys the FFT object.
+     */
+    ~FFT();
+
+    FFT(const FFT&) = delete;
+    FFT& operator=(const FFT&) = delete;
+
+    /**
+     * @brief Computes the spectrum of a real signal.
+     *
+     * @param input The size real input samples.
+     * @param spectrum The size / 2 + 1 output bins.
+     */
+    void forward(const R* input, complex_t* spectrum);
+
+    /**
+     * @brief Computes the real signal of a spectrum.
+     *
+     * @param spectrum The size / 2 + 1 input bins.
+     * @param output The size real output samples.
+     */
+    void inverse(const complex_t* spectrum, R* output);
+
+    /**
+     * @brief Gets the size of the real transform.
+     *
+     * @return The size of the real transform.
+     */
+    [[nodiscard]] std::size_t getSize() const { return size; }
+
+    /**
+     * @brief Gets the number of bins of the spectrum.
+     *
+     * @return The number of bins, size / 2 + 1.
+     */
+    [[nodiscard]] std::size_t getBinCount() const { return size / 2 + 1; }
+
+private:
+    std::size_t size; ///< The size of the real transform.
+    std::size_t half; ///< The size of the complex transform.
+    complex_t* twiddles; ///< Twiddle factors of the complex transform.
+    complex_t* splitTwiddles; ///< Twiddle factors of the real split step.
+    std::size_t* bitReverse; ///< Bit-reversal permutation of the complex transform.
+    complex_t* scratch; ///< Working buffer of the complex transform.
+
+    /**
+     * @brief Computes an in-place forward complex transform of size half.
+     *
+     * @param data The data to transform.
+     */
+    void transform(complex_t* data) const;
+};
+
+#endif
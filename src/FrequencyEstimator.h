@@ -0,0 +1,137 @@
+#ifndef FREQUENCY_ESTIMATOR_H
+#define FREQUENCY_ESTIMATOR_H
+
+#include <cmath>
+#include <cstddef>
+
+/**
+ * @brief The FrequencyEstimator class is the interface of the dominant-frequency estimators.
+ *
+ * An estimator is fed with the input signal as it arrives and estimates, on demand, the
+ * frequency of the strongest component of its most recent samples, or of its few strongest
+ * components. NotchLMSFilter uses it to steer its adaptive notches.
+ *
+ * @tparam R The real type (float or double).
+ */
+template<typename R>
+class FrequencyEstimator {
+public:
+    /**
+     * @brief Destroys the FrequencyEstimator object.
+     */
+    virtual ~FrequencyEstimator() = default;
+
+    /**
+     * @brief Feeds samples to the estimator.
+     *
+     * @param samples The input samples.
+     * @param n The number of samples.
+     */
+    virtual void process(const R* samples, std::size_t n) = 0;
+
+    /**
+     * @brief Estimates the dominant frequency of the most recent samples.
+     *
+     * @param minFrequency The lowest frequency to consider, in Hz.
+     * @param maxFrequency The highest frequency to consider, in Hz.
+     * @return The estimated frequency in Hz, or 0 if no component was found.
+     */
+    virtual R estimate(R minFrequency, R maxFrequency) = 0;
+
+    /**
+     * @brief Estimates the frequencies of the strongest components of the most recent samples.
+     *
+     * The default implementation reports the single component found by estimate().
+     *
+     * @param minFrequency The lowest frequency to consider, in Hz.
+     * @param maxFrequency The highest frequency to consider, in Hz.
+     * @param frequencies The estimated frequencies in Hz, strongest first.
+     * @param maxPeaks The maximum number of frequencies to report.
+     * @return The number of frequencies reported.
+     */
+    virtual std::size_t estimatePeaks(const R minFrequency, const R maxFrequency, R* frequencies, const std::size_t maxPeaks) {
+        if (maxPeaks == 0) return 0;
+        frequencies[0] = estimate(minFrequency, maxFrequency);
+        return frequencies[0] > R{0} ? 1 : 0;
+    }
+
+    /**
+     * @brief Clears the history of the estimator.
+     */
+    virtual void reset() = 0;
+
+    /**
+     * @brief Sets the sample rate of the input and clears the history of the estimator.
+     *
+     * @param sampleRate The sample rate of the input, in Hz.
+     */
+    virtual void setSampleRate(R sampleRate) = 0;
+
+protected:
+    static constexpr std::size_t MAX_PEAKS = 16; ///< Maximum number of peaks reported by findPeaks.
+    static constexpr R PEAK_FLOOR{0.01}; ///< Power of the weakest reported peak relative to the strongest.
+
+    /**
+     * @brief Locates the strongest local maxima of a power spectrum.
+     *
+     * Only local maxima within PEAK_FLOOR of the strongest one are reported, each interpolated
+     * with interpolatePeak(). The bins at the ends of the search range count as maxima when they
+     * exceed their neighbour inside the range. The bins around the search range must be valid.
+     *
+     * @param power The power of each bin.
+     * @param firstBin The first bin of the search range, at least 1.
+     * @param lastBin The last bin of the search range, followed by a valid bin.
+     * @param binWidth The frequency spacing of the bins, in Hz.
+     * @param frequencies The estimated frequencies in Hz, strongest first.
+     * @param maxPeaks The maximum number of frequencies to report, at most MAX_PEAKS.
+     * @return The number of frequencies reported.
+     */
+    static std::size_t findPeaks(const R* power, const std::size_t firstBin, const std::size_t lastBin, const R binWidth,
+                                 R* frequencies, std::size_t maxPeaks) {
+        maxPeaks = maxPeaks < MAX_PEAKS ? maxPeaks : MAX_PEAKS;
+        std::size_t peakBins[MAX_PEAKS];
+        std::size_t count = 0;
+
+        for (std::size_t k = firstBin; k <= lastBin; ++k) {
+            if (power[k] <= R{0}) continue;
+            if (k > firstBin && power[k] <= power[k - 1]) continue;
+            if (k < lastBin && power[k] < power[k + 1]) continue;
+
+            std::size_t slot = count < maxPeaks ? count++ : maxPeaks;
+            while (slot > 0 && power[peakBins[slot - 1]] < power[k]) {
+                if (slot < maxPeaks) peakBins[slot] = peakBins[slot - 1];
+                --slot;
+            }
+            if (slot < maxPeaks) peakBins[slot] = k;
+        }
+
+        std::size_t reported = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            const std::size_t k = peakBins[i];
+            if (power[k] < PEAK_FLOOR * power[peakBins[0]]) break;
+            frequencies[reported++] = (static_cast<R>(k) + interpolatePeak(power[k - 1], power[k], power[k + 1])) * binWidth;
+        }
+        return reported;
+    }
+
+    /**
+     * @brief Locates a spectral peak between bins by fitting a parabola to the logarithm of its power.
+     *
+     * With a Hann window, the quadratic fit on the log power is accurate to a few hundredths of a bin.
+     *
+     * @param left The power of the bin below the peak.
+     * @param centre The power of the peak bin.
+     * @param right The power of the bin above the peak.
+     * @return The offset of the peak from the centre bin, between -0.5 and 0.5.
+     */
+    static R interpolatePeak(const R left, const R centre, const R right) {
+        constexpr R floor{1e-30};
+        const R l = std::log(left + floor), c = std::log(centre + floor), r = std::log(right + floor);
+        const R curvature = l - R{2} * c + r;
+        if (curvature >= R{0}) return R{0};
+        const R offset = R{0.5} * (l - r) / curvature;
+        return offset < R{-0.5} ? R{-0.5} : (offset > R{0.5} ? R{0.5} : offset);
+    }
+};
+
+#endif
@@ -0,0 +1,244 @@
+#include "HowlDetector.h"
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+
+/**
+ * @brief Constructs a HowlDetector object.
+ *
+ * @param bins The number of bins of the magnitude spectra.
+ * @param binWidth The frequency spacing of the bins, in Hz.
+ */
+template<typename R>
+HowlDetector<R>::HowlDetector(const std::size_t bins, const R binWidth)
+    : bins(bins), binWidth(binWidth), firstBin(1), lastBin(bins - 2) {
+    level = new R[bins]();
+    setFrequencyLimits(R{100}, R{8000});
+}
+
+/**
+ * @brief Destroys the HowlDetector object and releases allocated resources.
+ */
+template<typename R>
+HowlDetector<R>::~HowlDetector() {
+    delete[] level;
+}
+
+/**
+ * @brief Analyzes the next magnitude spectrum and updates the candidates.
+ *
+ * The candidates age by one spectrum, then the strongest peaks are matched with them, loudest
+ * first, and the candidates left without a howl in their history are dropped.
+ *
+ * @param magnitude The linear magnitude of each bin, bin 0 being DC.
+ */
+template<typename R>
+void HowlDetector<R>::analyze(const R* magnitude) {
+    constexpr R floor{1e-10};
+
+    std::size_t strongest = 0;
+    peakMagnitude = R{0};
+    for (std::size_t k = 0; k < bins; ++k) {
+        if (magnitude[k] > peakMagnitude) {
+            peakMagnitude = magnitude[k];
+            strongest = k;
+        }
+        level[k] = R{20} * std::log10(magnitude[k] + floor);
+    }
+    peakFrequency = static_cast<R>(strongest) * binWidth;
+
+    R power{0};
+    for (std::size_t k = firstBin; k <= lastBin; ++k) {
+        power += magnitude[k] * magnitude[k];
+    }
+    const R average = R{10} * std::log10(power / static_cast<R>(lastBin - firstBin + 1) + floor * floor);
+
+    std::size_t peakBins[MAX_PEAKS];
+    std::size_t count = 0;
+    for (std::size_t k = firstBin; k <= lastBin; ++k) {
+        if (level[k] <= level[k - 1] || level[k] < level[k + 1] || level[k] - average < paprThreshold) continue;
+
+        std::size_t slot = count < MAX_PEAKS ? count++ : MAX_PEAKS;
+        while (slot > 0 && level[peakBins[slot - 1]] < level[k]) {
+            if (slot < MAX_PEAKS) peakBins[slot] = peakBins[slot - 1];
+            --slot;
+        }
+        if (slot < MAX_PEAKS) peakBins[slot] = k;
+    }
+
+    for (std::size_t i = 0; i < candidateCount; ++i) {
+        candidates[i].hits = static_cast<std::uint8_t>(candidates[i].hits << 1);
+        if (candidates[i].frames < UINT16_MAX) ++candidates[i].frames;
+    }
+
+    std::uint32_t matched = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::size_t k = peakBins[i];
+
+        const R curvature = level[k - 1] - R{2} * level[k] + level[k + 1];
+        const R offset = curvature < R{0} ? std::clamp(R{0.5} * (level[k - 1] - level[k + 1]) / curvature, R{-0.5}, R{0.5}) : R{0};
+        const R bin = static_cast<R>(k) + offset;
+
+        R neighbours = average;
+        for (std::size_t m = NEIGHBOUR_FIRST; m <= NEIGHBOUR_LAST; ++m) {
+            if (k >= m) neighbours = std::max(neighbours, level[k - m]);
+            if (k + m < bins) neighbours = std::max(neighbours, level[k + m]);
+        }
+
+        R harmonics = average;
+        for (const R factor : {R{0.5}, R{2}, R{3}}) {
+            harmonics = std::max(harmonics, levelAround(bin * factor, average));
+        }
+
+        Candidate peak{};
+        peak.frequency = bin * binWidth;
+        peak.level = level[k];
+        peak.papr = level[k] - average;
+        peak.phpr = level[k] - harmonics;
+        peak.pnpr = level[k] - neighbours;
+        match(peak, peak.phpr >= phprThreshold && peak.pnpr >= pnprThreshold, matched);
+    }
+
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < candidateCount; ++i) {
+        if (candidates[i].hits != 0) candidates[kept++] = candidates[i];
+    }
+    candidateCount = kept;
+}
+
+/**
+ * @brief Gets the frequencies of the candidates reported as howls.
+ *
+ * @param frequencies The frequencies in Hz, loudest first.
+ * @param maxHowls The maximum number of frequencies to report.
+ * @return The number of frequencies reported.
+ */
+template<typename R>
+std::size_t HowlDetector<R>::getHowls(R* frequencies, const std::size_t maxHowls) const {
+    const Candidate* howls[MAX_CANDIDATES];
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < candidateCount; ++i) {
+        if (!isHowl(candidates[i])) continue;
+
+        std::size_t slot = count++;
+        while (slot > 0 && howls[slot - 1]->level < candidates[i].level) {
+            howls[slot] = howls[slot - 1];
+            --slot;
+        }
+        howls[slot] = &candidates[i];
+    }
+
+    count = std::min(count, maxHowls);
+    for (std::size_t i = 0; i < count; ++i) {
+        frequencies[i] = howls[i]->frequency;
+    }
+    return count;
+}
+
+/**
+ * @brief Checks if a candidate is reported as a howl.
+ *
+ * @param candidate The candidate.
+ * @return True if it looked like a howl in at least `persistence` of the last HISTORY_FRAMES spectra.
+ */
+template<typename R>
+bool HowlDetector<R>::isHowl(const Candidate& candidate) const {
+    return std::bitset<HISTORY_FRAMES>(candidate.hits).count() >= persistence;
+}
+
+/**
+ * @brief Sets the band searched for howls.
+ *
+ * The band is clamped to the bins that have a neighbour on each side.
+ *
+ * @param minFreq The lowest frequency, in Hz.
+ * @param maxFreq The highest frequency, in Hz.
+ */
+template<typename R>
+void HowlDetector<R>::setFrequencyLimits(const R minFreq, const R maxFreq) {
+    firstBin = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(std::max(minFreq, R{0}) / binWidth)));
+    lastBin = std::min(bins - 2, static_cast<std::size_t>(std::max(maxFreq, R{0}) / binWidth));
+    lastBin = std::max(lastBin, firstBin);
+}
+
+/**
+ * @brief Forgets the candidates.
+ */
+template<typename R>
+void HowlDetector<R>::reset() {
+    candidateCount = 0;
+    peakFrequency = R{0};
+    peakMagnitude = R{0};
+}
+
+/**
+ * @brief Gets the highest level around a frequency, to compare a peak with.
+ *
+ * @param bin The bin of the frequency, possibly fractional.
+ * @param average The level used beyond the spectrum, in dB.
+ * @return The highest level of the nearest bin and its two neighbours, in dB.
+ */
+template<typename R>
+R HowlDetector<R>::levelAround(const R bin, const R average) const {
+    const auto nearest = static_cast<std::size_t>(bin + R{0.5});
+    if (nearest < 1 || nearest + 1 >= bins) return average;
+    return std::max({level[nearest - 1], level[nearest], level[nearest + 1]});
+}
+
+/**
+ * @brief Matches a peak with a candidate, or creates one for it if it looks like a howl.
+ *
+ * The peak goes to the nearest candidate within MATCH_BINS not matched yet in this spectrum. A
+ * new candidate takes a free slot, or replaces the candidate with the fewest hits if it is not a
+ * howl.
+ *
+ * @param peak The frequency, level and ratios of the peak; its hits and frames are ignored.
+ * @param howl True if the peak looks like a howl.
+ * @param matched The candidates already matched in this spectrum, one bit each.
+ */
+template<typename R>
+void HowlDetector<R>::match(const Candidate& peak, const bool howl, std::uint32_t& matched) {
+    std::size_t slot = candidateCount;
+    R distance = MATCH_BINS * binWidth;
+    for (std::size_t i = 0; i < candidateCount; ++i) {
+        if (matched & 1u << i) continue;
+        if (const R d = std::abs(candidates[i].frequency - peak.frequency); d <= distance) {
+            distance = d;
+            slot = i;
+        }
+    }
+
+    if (slot < candidateCount) {
+        Candidate& candidate = candidates[slot];
+        const std::uint8_t hits = candidate.hits;
+        const std::uint16_t frames = candidate.frames;
+        candidate = peak;
+        candidate.hits = static_cast<std::uint8_t>(hits | (howl ? 1 : 0));
+        candidate.frames = frames;
+        matched |= 1u << slot;
+        return;
+    }
+    if (!howl) return;
+
+    if (candidateCount < MAX_CANDIDATES) {
+        slot = candidateCount++;
+    } else {
+        std::size_t fewest = HISTORY_FRAMES + 1;
+        for (std::size_t i = 0; i < candidateCount; ++i) {
+            if (matched & 1u << i || isHowl(candidates[i])) continue;
+            if (const std::size_t hits = std::bitset<HISTORY_FRAMES>(candidates[i].hits).count(); hits < fewest) {
+                fewest = hits;
+                slot = i;
+            }
+        }
+        if (slot == candidateCount) return;
+    }
+
+    candidates[slot] = peak;
+    candidates[slot].hits = 1;
+    candidates[slot].frames = 1;
+    matched |= 1u << slot;
+}
+
+template class HowlDetector<double>;
+template class HowlDetector<float>;
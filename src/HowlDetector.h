@@ -0,0 +1,190 @@
+#ifndef HOWL_DETECTOR_H
+#define HOWL_DETECTOR_H
+
+#include <Audio.h>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The HowlDetector class finds howl frequencies in a stream of magnitude spectra.
+ *
+ * It is fed the spectra the firmware already computes with AudioAnalyzeFFT1024, outside the
+ * audio interrupt. In each spectrum, the local maxima of the log magnitude within the search band
+ * that stand paprThreshold above the average level are examined. A peak looks like a howl when
+ * it also stands above its neighbouring bins (peak-to-neighbouring power ratio, PNPR) and above
+ * the bins at its half, double and triple frequencies (peak-to-harmonic power ratio, PHPR): a
+ * howl is a pure tone, whereas voices and instruments spread their energy over harmonics.
+ *
+ * Peaks are tracked across spectra in a table of up to MAX_CANDIDATES candidates. A candidate
+ * remembers which of the last HISTORY_FRAMES spectra it looked like a howl in, and is reported as
+ * a howl once it did in at least `persistence` of them (interframe peak magnitude persistence).
+ * A candidate that did not look like a howl in any of them is dropped.
+ *
+ * @tparam R The real type (float or double).
+ */
+template<typename R>
+class HowlDetector final {
+public:
+    static constexpr std::size_t MAX_CANDIDATES = 8; ///< Maximum number of tracked candidates.
+    static constexpr std::size_t MAX_PEAKS = 8; ///< Maximum number of peaks examined per spectrum.
+    static constexpr std::size_t HISTORY_FRAMES = 8; ///< Number of spectra the persistence is counted over.
+
+    /**
+     * @brief A peak tracked across spectra.
+     */
+    struct Candidate {
+        R frequency; ///< Frequency of the peak in the last spectrum it was seen in, in Hz.
+        R level; ///< Log magnitude of the peak, in dB.
+        R papr; ///< Peak-to-average power ratio, in dB.
+        R phpr; ///< Smallest peak-to-harmonic power ratio, in dB.
+        R pnpr; ///< Smallest peak-to-neighbouring power ratio, in dB.
+        std::uint8_t hits; ///< One bit per spectrum, set if the peak looked like a howl, the latest in bit 0.
+        std::uint16_t frames; ///< Number of spectra since the candidate was created, saturating.
+    };
+
+    /**
+     * @brief Constructs a HowlDetector object.
+     *
+     * @param bins The number of bins of the magnitude spectra (default is 512, as AudioAnalyzeFFT1024).
+     * @param binWidth The frequency spacing of the bins, in Hz.
+     */
+    explicit HowlDetector(std::size_t bins = 512, R binWidth = AUDIO_SAMPLE_RATE_EXACT / 1024);
+
+    /**
+     * @brief Destroys the HowlDetector object.
+     */
+    ~HowlDetector();
+
+    HowlDetector(const HowlDetector&) = delete;
+    HowlDetector& operator=(const HowlDetector&) = delete;
+
+    /**
+     * @brief Analyzes the next magnitude spectrum and updates the candidates.
+     *
+     * @param magnitude The linear magnitude of each bin, bin 0 being DC.
+     */
+    void analyze(const R* magnitude);
+
+    /**
+     * @brief Gets the frequencies of the candidates reported as howls.
+     *
+     * @param frequencies The frequencies in Hz, loudest first.
+     * @param maxHowls The maximum number of frequencies to report.
+     * @return The number of frequencies reported.
+     */
+    std::size_t getHowls(R* frequencies, std::size_t maxHowls) const;
+
+    /**
+     * @brief Checks if a candidate is reported as a howl.
+     *
+     * @param candidate The candidate.
+     * @return True if it looked like a howl in at least `persistence` of the last HISTORY_FRAMES spectra.
+     */
+    [[nodiscard]] bool isHowl(const Candidate& candidate) const;
+
+    /**
+     * @brief Gets the number of tracked candidates.
+     *
+     * @return The number of candidates.
+     */
+    [[nodiscard]] std::size_t getCandidateCount() const { return candidateCount; }
+
+    /**
+     * @brief Gets a tracked candidate.
+     *
+     * @param index The index of the candidate, below getCandidateCount().
+     * @return The candidate.
+     */
+    [[nodiscard]] const Candidate& getCandidate(const std::size_t index) const { return candidates[index]; }
+
+    /**
+     * @brief Gets the frequency of the strongest bin of the last spectrum.
+     *
+     * @return The frequency of the bin, in Hz.
+     */
+    [[nodiscard]] R getPeakFrequency() const { return peakFrequency; }
+
+    /**
+     * @brief Gets the magnitude of the strongest bin of the last spectrum.
+     *
+     * @return The linear magnitude of the bin.
+     */
+    [[nodiscard]] R getPeakMagnitude() const { return peakMagnitude; }
+
+    /**
+     * @brief Sets the band searched for howls.
+     *
+     * @param minFreq The lowest frequency, in Hz.
+     * @param maxFreq The highest frequency, in Hz.
+     */
+    void setFrequencyLimits(R minFreq, R maxFreq);
+
+    /**
+     * @brief Sets the power ratios a peak must exceed to look like a howl.
+     *
+     * @param papr The peak-to-average power ratio, in dB.
+     * @param phpr The peak-to-harmonic power ratio, in dB.
+     * @param pnpr The peak-to-neighbouring power ratio, in dB.
+     */
+    void setThresholds(const R papr, const R phpr, const R pnpr) {
+        paprThreshold = papr;
+        phprThreshold = phpr;
+        pnprThreshold = pnpr;
+    }
+
+    /**
+     * @brief Sets the number of the last HISTORY_FRAMES spectra a candidate must look like a howl in.
+     *
+     * @param frames The number of spectra, between 1 and HISTORY_FRAMES.
+     */
+    void setPersistence(const std::size_t frames) {
+        persistence = frames < 1 ? 1 : (frames > HISTORY_FRAMES ? HISTORY_FRAMES : frames);
+    }
+
+    /**
+     * @brief Forgets the candidates.
+     */
+    void reset();
+
+private:
+    static constexpr std::size_t NEIGHBOUR_FIRST = 3; ///< Offset of the nearest neighbouring bin, beyond the Hann main lobe.
+    static constexpr std::size_t NEIGHBOUR_LAST = 5; ///< Offset of the farthest neighbouring bin.
+    static constexpr R MATCH_BINS{1.5}; ///< Largest distance between a peak and its candidate, in bins.
+
+    std::size_t bins; ///< The number of bins of the spectra.
+    R binWidth; ///< The frequency spacing of the bins, in Hz.
+    std::size_t firstBin; ///< The first bin searched.
+    std::size_t lastBin; ///< The last bin searched.
+
+    R paprThreshold{10}; ///< Peak-to-average power ratio of a peak, in dB.
+    R phprThreshold{10}; ///< Peak-to-harmonic power ratio of a howl, in dB.
+    R pnprThreshold{15}; ///< Peak-to-neighbouring power ratio of a howl, in dB.
+    std::size_t persistence{5}; ///< Spectra of the last HISTORY_FRAMES a howl must be seen in.
+
+    R* level; ///< Log magnitude of each bin of the last spectrum, in dB.
+    R peakFrequency{0}; ///< Frequency of the strongest bin of the last spectrum, in Hz.
+    R peakMagnitude{0}; ///< Magnitude of the strongest bin of the last spectrum.
+
+    Candidate candidates[MAX_CANDIDATES]{}; ///< The tracked candidates.
+    std::size_t candidateCount{0}; ///< The number of tracked candidates.
+
+    /**
+     * @brief Gets the highest level around a frequency, to compare a peak with.
+     *
+     * @param bin The bin of the frequency, possibly fractional.
+     * @param average The level used beyond the spectrum, in dB.
+     * @return The highest level of the nearest bin and its two neighbours, in dB.
+     */
+    R levelAround(R bin, R average) const;
+
+    /**
+     * @brief Matches a peak with a candidate, or creates one for it if it looks like a howl.
+     *
+     * @param peak The frequency, level and ratios of the peak; its hits and frames are ignored.
+     * @param howl True if the peak looks like a howl.
+     * @param matched The candidates already matched in this spectrum, one bit each.
+     */
+    void match(const Candidate& peak, bool howl, std::uint32_t& matched);
+};
+
+#endif
@@ -1,15 +1,21 @@
 #include "LMSFilter.h"
+#include <algorithm>
 
 /**
  * @brief Constructs an LMSFilter object with the specified order and adaptation rate.
  *
  * @param order The order of the filter.
- * @param mu The adaptation rate.
+ * @param mu The adaptation rate of every channel.
+ * @param maxDelay The longest bulk delay ahead of the taps, in samples.
  */
-LMSFilter::LMSFilter(const std::size_t order, const double mu)
-    : order(order), mu(mu) {
-    reference_buffer = new double[order];
-    weights = new double[order];
+template<typename T, std::size_t Channels, template<typename, std::size_t> class Update, template<typename, std::size_t> class Control>
+LMSFilter<T, Channels, Update, Control>::LMSFilter(const std::size_t order, const real_t mu, const std::size_t maxDelay)
+    : order(order), maxDelay(maxDelay), span(maxDelay + order + update_t::HISTORY), update(order) {
+    reference_buffer = new T[2 * span * Channels];
+    weights = new T[order * Channels];
+
+    std::fill(this->mu, this->mu + Channels, mu);
+    std::fill(gamma, gamma + Channels, leakage);
 
     reset();
 }
@@ -17,178 +23,330 @@ LMSFilter::LMSFilter(const std::size_t order, const double mu)
 /**
  * @brief Destroys the LMSFilter object and releases allocated resources.
  */
-LMSFilter::~LMSFilter() {
+template<typename T, std::size_t Channels, template<typename, std::size_t> class Update, template<typename, std::size_t> class Control>
+LMSFilter<T, Channels, Update, Control>::~LMSFilter() {
     delete[] reference_buffer;
     delete[] weights;
 }
 
 /**
  * @brief Resets the LMS filter by initializing the reference buffer and weights.
+ *
+ * The estimates of the step control and the bulk delay are kept.
  */
-void LMSFilter::reset() {
-    for (std::size_t i = 0; i < order; ++i) {
-        reference_buffer[i] = 0.0;
-        weights[i] = 0.0;
+template<typename T, std::size_t Channels, template<typename, std::size_t> class Update, template<typename, std::size_t> class Control>
+void LMSFilter<T, Channels, Update, Control>::reset() {
+    for (std::size_t i = 0; i < 2 * span * Channels; ++i) {
+        reference_buffer[i] = T{};
+    }
+    for (std::size_t i = 0; i < order * Channels; ++i) {
+        weights[i] = T{};
     }
     index = 0;
-#ifdef NLMS
-    power = 0.0;
-#endif
+    update.reset();
 }
 
-#ifdef KALMAN
 /**
- * @brief Updates the Kalman variance estimates.
+ * @brief Sets the adaptation rate (mu) requested for every channel.
  *
- * @param currentEstimate The current estimate.
- * @param estimationError The estimation error.
- * @param measurement The measurement value.
- * @param processNoise The process noise.
- * @param measurementNoise The measurement noise.
- * @return The updated estimate.
+ * @param new_mu The new adaptation rate.
  */
-double updateKalmanVariance(const double currentEstimate, double& estimationError, const double measurement, const double processNoise, const double measurementNoise) {
-    const double prediction = currentEstimate;
-    const double predictionError = estimationError + processNoise;
-
-    const double kalmanGain = predictionError / (predictionError + measurementNoise);
-    const double newEstimate = prediction + kalmanGain * (measurement - prediction);
-    const double newEstimationError = (1.0 - kalmanGain) * predictionError;
-
-    estimationError = newEstimationError;
-    return newEstimate;
+template<typename T, std::size_t Channels, template<typename, std::size_t> class Update, template<typename, std::size_t> class Control>
+void LMSFilter<T, Channels, Update, Control>::setMu(const real_t new_mu) {
+    control.setMu(new_mu, mu);
 }
-#endif
 
-#ifdef DYNAMIC_NOISE
 /**
- * @brief Updates the noise parameters based on the error signal.
+ * @brief Processes one sample of every channel.
+ *
+ * The delay line holds every frame twice, at index and index + span, so the
+ * last span frames are always contiguous starting at the newest one. Within a
+ * frame the channels are adjacent, so the filter and update loops run with unit
+ * stride over taps and channels, and filter() sums the taps in interleaved
+ * partial sums that vectorize. The taps start delay frames after the newest
+ * one. The step control then sets the adaptation rate and leakage of each
+ * channel, and the weight update adapts the weights.
  *
- * @param error The error signal.
+ * @param reference The Channels reference samples fed into the delay lines.
+ * @param desired The Channels desired samples the filter outputs are subtracted from.
+ * @param error The Channels error samples.
  */
-void LMSFilter::updateNoiseParameters(const double error) {
-    signalValues[windowIndex] = reference_buffer[index] * reference_buffer[index];
-    errorValues[windowIndex] = error * error;
-
-    windowIndex = (windowIndex + 1) % ESTIMATION_WINDOW;
-    if (windowIndex == 0) windowFilled = true;
-
-    if (!windowFilled) return;
-
-    double signalMean = 0.0, errorMean = 0.0;
-    double signalVar = 0.0, errorVar = 0.0;
-
-    for (int i = 0; i < ESTIMATION_WINDOW; i++) {
-        signalMean += signalValues[i];
-        errorMean += errorValues[i];
+template<typename T, std::size_t Channels, template<typename, std::size_t> class Update, template<typename, std::size_t> class Control>
+void LMSFilter<T, Channels, Update, Control>::tickFrame(const T* reference, const T* desired, T* error) {
+    index = (index == 0 ? span : index) - 1;
+    T* newest = reference_buffer + index * Channels;
+    const T* taps = newest + delay * Channels;
+
+    update.retire(taps + (order + update_t::HISTORY) * Channels);
+    for (std::size_t c = 0; c < Channels; ++c) {
+        newest[c] = reference[c];
+        newest[span * Channels + c] = reference[c];
     }
-    signalMean /= ESTIMATION_WINDOW;
-    errorMean /= ESTIMATION_WINDOW;
-
-    for (int i = 0; i < ESTIMATION_WINDOW; i++) {
-        signalVar += (signalValues[i] - signalMean) * (signalValues[i] - signalMean);
-        errorVar += (errorValues[i] - errorMean) * (errorValues[i] - errorMean);
-    }
-    signalVar /= ESTIMATION_WINDOW;
-    errorVar /= ESTIMATION_WINDOW;
-
-    signalMeasurementNoise = std::max(0.01, std::min(1.0, signalVar * 0.1));
-    errorMeasurementNoise = std::max(0.01, std::min(1.0, errorVar * 0.1));
 
-    double signalMeanFirst = 0.0, signalMeanLast = 0.0;
-    double errorMeanFirst = 0.0, errorMeanLast = 0.0;
-    constexpr int subWindowSize = ESTIMATION_WINDOW / 5;
+    typename Traits::acc_t estimation[Channels];
+    filter(taps, estimation);
 
-    for (int i = 0; i < subWindowSize; i++) {
-        signalMeanFirst += signalValues[i];
-        errorMeanFirst += errorValues[i];
-        signalMeanLast += signalValues[ESTIMATION_WINDOW - 1 - i];
-        errorMeanLast += errorValues[ESTIMATION_WINDOW - 1 - i];
+    real_t inputs[Channels];
+    real_t errors[Channels];
+    for (std::size_t c = 0; c < Channels; ++c) {
+        error[c] = Traits::sub(desired[c], Traits::fromAcc(estimation[c]));
+        errors[c] = Traits::toReal(error[c]);
+        inputs[c] = Traits::toReal(taps[c]);
     }
 
-    signalMeanFirst /= subWindowSize;
-    errorMeanFirst /= subWindowSize;
-    signalMeanLast /= subWindowSize;
-    errorMeanLast /= subWindowSize;
-
-    const double signalChange = std::abs(signalMeanLast - signalMeanFirst) / signalMean;
-    const double errorChange = std::abs(errorMeanLast - errorMeanFirst) / errorMean;
-
-    signalProcessNoise = std::max(0.001, std::min(0.1, signalChange * 0.05));
-    errorProcessNoise = std::max(0.001, std::min(0.1, errorChange * 0.05));
+    control.adapt(inputs, errors, mu, gamma, leakage);
+    update.adapt(weights, taps, desired, errors, mu, gamma);
 }
-#endif
 
 /**
- * @brief Processes an input sample and returns the filtered output.
+ * @brief Computes the filter output of every channel over the taps.
  *
- * @param micSample The input sample to be filtered.
- * @return The filtered output sample.
+ * The taps are summed in MAC_LANES interleaved partial sums, so that the multiply-accumulates of
+ * consecutive taps do not wait on each other and a single-channel filter vectorizes across the
+ * lanes. The partial sums are added at the end, followed by the taps left over.
+ *
+ * @param taps The first tap frame of the delay line.
+ * @param estimation The Channels accumulated outputs.
  */
-double LMSFilter::tick(const double micSample) {
-#ifdef NLMS
-    power -= reference_buffer[index] * reference_buffer[index];
-#endif
-    reference_buffer[index] = micSample;
-
-    double estimation = 0.0;
-    for (std::size_t i = 0; i < order; ++i) {
-        estimation += weights[i] * reference_buffer[(index - i + order) % order];
+template<typename T, std::size_t Channels, template<typename, std::size_t> class Update, template<typename, std::size_t> class Control>
+void LMSFilter<T, Channels, Update, Control>::filter(const T* taps, typename Traits::acc_t* estimation) const {
+    constexpr std::size_t width = MAC_LANES * Channels;
+    const std::size_t bulk = order / MAC_LANES * width;
+
+    typename Traits::acc_t lanes[width]{};
+    for (std::size_t i = 0; i < bulk; i += width) {
+        for (std::size_t k = 0; k < width; ++k) {
+            lanes[k] = Traits::mac(lanes[k], weights[i + k], taps[i + k]);
+        }
     }
 
-    const double error = reference_buffer[index] - estimation;
-
-#ifdef DYNAMIC_NOISE
-    updateNoiseParameters(error);
-#endif
-
-    double gamma{leakage};
-
-#ifdef ADAPTIVE_GAMMA
-    const double signalMeasurement = micSample * micSample;
-    const double errorMeasurement = error * error;
-
-#ifdef KALMAN
-    signalVarianceEstimate = updateKalmanVariance(signalVarianceEstimate,signalVarianceError,signalMeasurement, signalProcessNoise, signalMeasurementNoise);
-    errorVarianceEstimate = updateKalmanVariance(errorVarianceEstimate,errorVarianceError,errorMeasurement, errorProcessNoise, errorMeasurementNoise);
-#else
-    signalVarianceEstimate = alpha * signalVarianceEstimate + (1.0 - alpha) * micSample * micSample;
-    errorVarianceEstimate = alpha * errorVarianceEstimate + (1.0 - alpha) * error * error;
-#endif
-
-    const double snr = (signalVarianceEstimate > 1e-10) ? (signalVarianceEstimate / (errorVarianceEstimate + 1e-10)) : 1.0;
-
-    if (snr > 10.0) {
-        mu = muMax;
-    } else if (snr < 2.0) {
-        mu = muMin;
-    } else {
-        mu = muMin + (muMax - muMin) * (snr - 2.0) / 8.0;
+    for (std::size_t c = 0; c < Channels; ++c) {
+        estimation[c] = lanes[c];
+        for (std::size_t l = 1; l < MAC_LANES; ++l) {
+            estimation[c] += lanes[l * Channels + c];
+        }
     }
+    for (std::size_t i = bulk; i < order * Channels; i += Channels) {
+        for (std::size_t c = 0; c < Channels; ++c) {
+            estimation[c] = Traits::mac(estimation[c], weights[i + c], taps[i + c]);
+        }
+    }
+}
 
-    if (errorVarianceEstimate > 0.1) {
-        gamma = gammaMin;
-    } else if (errorVarianceEstimate < 0.01) {
-        gamma = gammaMax;
+/**
+ * @brief Sets the bulk delay between the newest reference frame and the first tap.
+ *
+ * @param newDelay The new delay, in samples, clamped to maxDelay.
+ */
+template<typename T, std::size_t Channels, template<typename, std::size_t> class Update, template<typename, std::size_t> class Control>
+void LMSFilter<T, Channels, Update, Control>::setBulkDelay(const std::size_t newDelay) {
+    const std::size_t next = std::min(newDelay, maxDelay);
+    if (next == delay) return;
+
+    const std::size_t shift = std::min(next > delay ? next - delay : delay - next, order) * Channels;
+    T* end = weights + order * Channels;
+    if (next > delay) {
+        std::copy(weights + shift, end, weights);
+        std::fill(end - shift, end, T{});
     } else {
-        gamma = gammaMin + (gammaMax - gammaMin) * (0.1 - errorVarianceEstimate) / 0.09;
+        std::copy_backward(weights, end - shift, end);
+        std::fill(weights, weights + shift, T{});
     }
-#endif
 
-#ifdef NLMS
-    constexpr double epsilon{1e-6};
-    power += reference_buffer[index] * reference_buffer[index];
+    delay = next;
+    update.restart(weights, reference_buffer + (index + delay) * Channels);
+}
 
-    const double mu_eff = mu / (power + epsilon);
-#else
-    const double mu_eff = mu;
-#endif
+/**
+ * @brief Writes the weights, the bulk delay, the delay line and the state of the step control.
+ *
+ * The shape of the filter comes first, so that loadState() can reject the state of another
+ * filter before it changes anything. The span frames of the delay line are written newest first.
+ *
+ * @param writer The writer of the state image.
+ */
+template<typename T, std::size_t Channels, template<typename, std::size_t> class Update, template<typename, std::size_t> class Control>
+void LMSFilter<T, Channels, Update, Control>::saveState(StateWriter& writer) const {
+    writer.writeSize(order);
+    writer.writeSize(span);
+    writer.writeSize(Channels);
+    writer.writeSize(delay);
+    writer.write(weights, order * Channels);
+    writer.write(reference_buffer + index * Channels, span * Channels);
+    control.saveState(writer);
+}
 
-    for (std::size_t i = 0; i < order; ++i) {
-        weights[i] = weights[i] * gamma + mu_eff * error * reference_buffer[(index - i + order) % order];
+/**
+ * @brief Reads back the state written by saveState() from a filter of the same shape.
+ *
+ * The delay line is rebuilt with its newest frame at index 0, and the weight update restarts
+ * from the weights and the delay line.
+ *
+ * @param reader The reader of the state image.
+ * @return True if the state was read, false otherwise.
+ */
+template<typename T, std::size_t Channels, template<typename, std::size_t> class Update, template<typename, std::size_t> class Control>
+bool LMSFilter<T, Channels, Update, Control>::loadState(StateReader& reader) {
+    std::size_t savedOrder{0}, savedSpan{0}, savedChannels{0}, savedDelay{0};
+    reader.readSize(savedOrder);
+    reader.readSize(savedSpan);
+    reader.readSize(savedChannels);
+    reader.readSize(savedDelay);
+    if (!reader.ok() || savedOrder != order || savedSpan != span || savedChannels != Channels) return false;
+
+    reader.read(weights, order * Channels);
+    reader.read(reference_buffer, span * Channels);
+    std::copy(reference_buffer, reference_buffer + span * Channels, reference_buffer + span * Channels);
+    index = 0;
+    delay = std::min(savedDelay, maxDelay);
+    update.restart(weights, reference_buffer + delay * Channels);
+    return control.loadState(reader) && reader.ok();
+}
+
+/**
+ * @brief Processes a block of reference samples of every channel against separate desired samples.
+ *
+ * The weights change at every sample, so the block runs one tickFrame() per sample and gives the
+ * same output as the sample-by-sample path.
+ *
+ * @param reference The reference samples fed into the delay lines, one buffer per channel.
+ * @param desired The desired samples the filter outputs are subtracted from, one buffer per channel.
+ * @param error The error samples, one buffer per channel.
+ * @param n The number of samples in the block.
+ */
+template<typename T, std::size_t Channels, template<typename, std::size_t> class Update, template<typename, std::size_t> class Control>
+void LMSFilter<T, Channels, Update, Control>::processBlock(const T* const* reference, const T* const* desired, T* const* error, const std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        T referenceFrame[Channels], desiredFrame[Channels], errorFrame[Channels];
+        for (std::size_t c = 0; c < Channels; ++c) {
+            referenceFrame[c] = reference[c][i];
+            desiredFrame[c] = desired[c][i];
+        }
+        tickFrame(referenceFrame, desiredFrame, errorFrame);
+        for (std::size_t c = 0; c < Channels; ++c) {
+            error[c][i] = errorFrame[c];
+        }
     }
+}
 
-    index = (index + 1) % order;
+/**
+ * @brief Gets the first taps of the impulse response of a channel, which are its weights.
+ *
+ * @param impulseResponse The output taps.
+ * @param count The number of taps to read, at most getOrder().
+ * @param channel The channel.
+ */
+template<typename T, std::size_t Channels, template<typename, std::size_t> class Update, template<typename, std::size_t> class Control>
+void LMSFilter<T, Channels, Update, Control>::getImpulseResponse(real_t* impulseResponse, const std::size_t count, const std::size_t channel) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        impulseResponse[i] = Traits::toReal(weights[i * Channels + channel]);
+    }
+}
 
-    return error;
-}
\ No newline at end of file
+template class LMSFilter<double>;
+template class LMSFilter<float>;
+template class LMSFilter<q15_t>;
+template class LMSFilter<q31_t>;
+template class LMSFilter<double, 2>;
+template class LMSFilter<float, 2>;
+template class LMSFilter<q15_t, 2>;
+template class LMSFilter<q31_t, 2>;
+template class LMSFilter<double, 4>;
+template class LMSFilter<float, 4>;
+template class LMSFilter<q15_t, 4>;
+template class LMSFilter<q31_t, 4>;
+template class LMSFilter<double, 8>;
+template class LMSFilter<float, 8>;
+template class LMSFilter<double, 16>;
+template class LMSFilter<float, 16>;
+
+template class LMSFilter<double, 1, LMSUpdate, FixedStep>;
+template class LMSFilter<float, 1, LMSUpdate, FixedStep>;
+template class LMSFilter<q15_t, 1, LMSUpdate, FixedStep>;
+template class LMSFilter<q31_t, 1, LMSUpdate, FixedStep>;
+template class LMSFilter<double, 2, LMSUpdate, FixedStep>;
+template class LMSFilter<float, 2, LMSUpdate, FixedStep>;
+template class LMSFilter<q15_t, 2, LMSUpdate, FixedStep>;
+template class LMSFilter<q31_t, 2, LMSUpdate, FixedStep>;
+template class LMSFilter<double, 4, LMSUpdate, FixedStep>;
+template class LMSFilter<float, 4, LMSUpdate, FixedStep>;
+template class LMSFilter<q15_t, 4, LMSUpdate, FixedStep>;
+template class LMSFilter<q31_t, 4, LMSUpdate, FixedStep>;
+
+template class LMSFilter<double, 1, NLMSUpdate, FixedStep>;
+template class LMSFilter<float, 1, NLMSUpdate, FixedStep>;
+template class LMSFilter<q15_t, 1, NLMSUpdate, FixedStep>;
+template class LMSFilter<q31_t, 1, NLMSUpdate, FixedStep>;
+template class LMSFilter<double, 2, NLMSUpdate, FixedStep>;
+template class LMSFilter<float, 2, NLMSUpdate, FixedStep>;
+template class LMSFilter<q15_t, 2, NLMSUpdate, FixedStep>;
+template class LMSFilter<q31_t, 2, NLMSUpdate, FixedStep>;
+template class LMSFilter<double, 4, NLMSUpdate, FixedStep>;
+template class LMSFilter<float, 4, NLMSUpdate, FixedStep>;
+template class LMSFilter<q15_t, 4, NLMSUpdate, FixedStep>;
+template class LMSFilter<q31_t, 4, NLMSUpdate, FixedStep>;
+
+template class LMSFilter<double, 1, NLMSUpdate, SmoothedStep>;
+template class LMSFilter<float, 1, NLMSUpdate, SmoothedStep>;
+template class LMSFilter<q15_t, 1, NLMSUpdate, SmoothedStep>;
+template class LMSFilter<q31_t, 1, NLMSUpdate, SmoothedStep>;
+template class LMSFilter<double, 2, NLMSUpdate, SmoothedStep>;
+template class LMSFilter<float, 2, NLMSUpdate, SmoothedStep>;
+template class LMSFilter<q15_t, 2, NLMSUpdate, SmoothedStep>;
+template class LMSFilter<q31_t, 2, NLMSUpdate, SmoothedStep>;
+template class LMSFilter<double, 4, NLMSUpdate, SmoothedStep>;
+template class LMSFilter<float, 4, NLMSUpdate, SmoothedStep>;
+template class LMSFilter<q15_t, 4, NLMSUpdate, SmoothedStep>;
+template class LMSFilter<q31_t, 4, NLMSUpdate, SmoothedStep>;
+
+template class LMSFilter<double, 1, NLMSUpdate, KalmanStep>;
+template class LMSFilter<float, 1, NLMSUpdate, KalmanStep>;
+template class LMSFilter<q15_t, 1, NLMSUpdate, KalmanStep>;
+template class LMSFilter<q31_t, 1, NLMSUpdate, KalmanStep>;
+template class LMSFilter<double, 2, NLMSUpdate, KalmanStep>;
+template class LMSFilter<float, 2, NLMSUpdate, KalmanStep>;
+template class LMSFilter<q15_t, 2, NLMSUpdate, KalmanStep>;
+template class LMSFilter<q31_t, 2, NLMSUpdate, KalmanStep>;
+template class LMSFilter<double, 4, NLMSUpdate, KalmanStep>;
+template class LMSFilter<float, 4, NLMSUpdate, KalmanStep>;
+template class LMSFilter<q15_t, 4, NLMSUpdate, KalmanStep>;
+template class LMSFilter<q31_t, 4, NLMSUpdate, KalmanStep>;
+
+template class LMSFilter<double, 1, AffineProjectionUpdate, FixedStep>;
+template class LMSFilter<float, 1, AffineProjectionUpdate, FixedStep>;
+template class LMSFilter<q15_t, 1, AffineProjectionUpdate, FixedStep>;
+template class LMSFilter<q31_t, 1, AffineProjectionUpdate, FixedStep>;
+template class LMSFilter<double, 2, AffineProjectionUpdate, FixedStep>;
+template class LMSFilter<float, 2, AffineProjectionUpdate, FixedStep>;
+template class LMSFilter<q15_t, 2, AffineProjectionUpdate, FixedStep>;
+template class LMSFilter<q31_t, 2, AffineProjectionUpdate, FixedStep>;
+template class LMSFilter<double, 4, AffineProjectionUpdate, FixedStep>;
+template class LMSFilter<float, 4, AffineProjectionUpdate, FixedStep>;
+template class LMSFilter<q15_t, 4, AffineProjectionUpdate, FixedStep>;
+template class LMSFilter<q31_t, 4, AffineProjectionUpdate, FixedStep>;
+
+template class LMSFilter<double, 1, FastRLSUpdate, FixedStep>;
+template class LMSFilter<float, 1, FastRLSUpdate, FixedStep>;
+template class LMSFilter<q15_t, 1, FastRLSUpdate, FixedStep>;
+template class LMSFilter<q31_t, 1, FastRLSUpdate, FixedStep>;
+template class LMSFilter<double, 2, FastRLSUpdate, FixedStep>;
+template class LMSFilter<float, 2, FastRLSUpdate, FixedStep>;
+template class LMSFilter<q15_t, 2, FastRLSUpdate, FixedStep>;
+template class LMSFilter<q31_t, 2, FastRLSUpdate, FixedStep>;
+template class LMSFilter<double, 4, FastRLSUpdate, FixedStep>;
+template class LMSFilter<float, 4, FastRLSUpdate, FixedStep>;
+template class LMSFilter<q15_t, 4, FastRLSUpdate, FixedStep>;
+template class LMSFilter<q31_t, 4, FastRLSUpdate, FixedStep>;
+
+template class LMSFilter<double, 1, ProportionateUpdate, FixedStep>;
+template class LMSFilter<float, 1, ProportionateUpdate, FixedStep>;
+template class LMSFilter<q15_t, 1, ProportionateUpdate, FixedStep>;
+template class LMSFilter<q31_t, 1, ProportionateUpdate, FixedStep>;
+template class LMSFilter<double, 2, ProportionateUpdate, FixedStep>;
+template class LMSFilter<float, 2, ProportionateUpdate, FixedStep>;
+template class LMSFilter<q15_t, 2, ProportionateUpdate, FixedStep>;
+template class LMSFilter<q31_t, 2, ProportionateUpdate, FixedStep>;
+template class LMSFilter<double, 4, ProportionateUpdate, FixedStep>;
+template class LMSFilter<float, 4, ProportionateUpdate, FixedStep>;
+template class LMSFilter<q15_t, 4, ProportionateUpdate, FixedStep>;
+template class LMSFilter<q31_t, 4, ProportionateUpdate, FixedStep>;
@@ -1,54 +1,156 @@
 #ifndef LMS_FILTER_H
 #define LMS_FILTER_H
 
+#include "LMSPolicies.h"
+#include "SampleTraits.h"
 #include <cstddef>
 #include <algorithm>
-
-#define NLMS
-#define ADAPTIVE_GAMMA
-#define KALMAN
-#define DYNAMIC_NOISE
-
-#if defined(KALMAN) || defined(DYNAMIC_NOISE)
-#ifndef ADAPTIVE_GAMMA
-#define ADAPTIVE_GAMMA
-#endif
-#endif
-
-#ifdef DYNAMIC_NOISE
-#ifndef KALMAN
-#define KALMAN
-#endif
-#endif
+#include <type_traits>
+#include <utility>
 
 /**
  * @brief The LMSFilter class implements an adaptive LMS filter.
  *
  * This class provides methods to apply an adaptive LMS filter to an input signal,
  * allowing for noise reduction and adaptive filtering.
+ *
+ * The filter can run several independent channels in lock step, one sample of each at a time.
+ * The delay line and the weights of the channels are interleaved, tap by tap, so that the filter
+ * and update loops process the same tap of every channel in one inner loop that the compiler
+ * turns into SIMD operations. The adaptation control (step size, leakage, noise estimation) of
+ * each channel is kept in per-channel arrays for the same reason.
+ *
+ * The adaptation algorithm is composed at compile time of two policies, see LMSPolicies.h: the
+ * step control sets the adaptation rate and the leakage of each channel from the reference and
+ * error samples, and the weight update adapts the weights from the delay line. The default,
+ * NLMS with the Kalman step control whose noise parameters are estimated over a sliding window,
+ * is the algorithm the filter has always run. The policies are plain members called directly,
+ * so an instantiation only pays for the algorithm it runs.
+ *
+ * The delay line can hold a bulk delay of up to maxDelay frames ahead of the taps, so that a
+ * filter of a few taps covers the active region of a path whose first echo arrives late. The
+ * delay is set with setBulkDelay(), for example from the estimate of a BulkDelayEstimator.
+ *
+ * saveState() and loadState() carry the adaptive state over to another run: the weights, the
+ * bulk delay, the delay line and the estimates of the step control. The weight update rebuilds
+ * its state from them on load, as it does on takeOver().
+ *
+ * @tparam T The sample and coefficient type (double, float, q15_t or q31_t).
+ * @tparam Channels The number of channels (default is 1).
+ * @tparam Update The weight update policy (default is NLMSUpdate).
+ * @tparam Control The step control policy (default is DynamicNoiseStep).
  */
+template<typename T, std::size_t Channels = 1, template<typename, std::size_t> class Update = NLMSUpdate,
+         template<typename, std::size_t> class Control = DynamicNoiseStep>
 class LMSFilter final {
 public:
+    using Traits = SampleTraits<T>; ///< Arithmetic of the sample type.
+    using real_t = typename Traits::real_t; ///< Type used for the adaptation control logic.
+    using update_t = Update<T, Channels>; ///< The weight update policy.
+    using control_t = Control<real_t, Channels>; ///< The step control policy.
+
+    static constexpr std::size_t CHANNELS = Channels; ///< Number of channels.
+    static constexpr std::size_t MIN_ESTIMATION_WINDOW = EstimationWindow::MIN; ///< Minimum window size for noise estimation.
+    static constexpr std::size_t MAX_ESTIMATION_WINDOW = EstimationWindow::MAX; ///< Maximum window size for noise estimation.
+
     /**
      * @brief Constructs an LMSFilter object with the specified order and adaptation rate.
      *
      * @param order The order of the filter.
-     * @param mu The adaptation rate (default is 0.0001).
+     * @param mu The adaptation rate of every channel (default is 0.0001).
+     * @param maxDelay The longest bulk delay ahead of the taps, in samples (default is 0).
      */
-    explicit LMSFilter(std::size_t order, double mu = 0.0001);
+    explicit LMSFilter(std::size_t order, real_t mu = 0.0001, std::size_t maxDelay = 0);
 
     /**
      * @brief Destroys the LMSFilter object.
      */
     ~LMSFilter();
 
+    LMSFilter(const LMSFilter&) = delete;
+    LMSFilter& operator=(const LMSFilter&) = delete;
+
     /**
-     * @brief Processes an input sample and returns the filtered output.
+     * @brief Processes an input sample of a single-channel filter and returns the filtered output.
      *
      * @param micSample The input sample to be filtered.
      * @return The filtered output sample.
      */
-    double tick(double micSample);
+    template<std::size_t C = Channels, std::enable_if_t<C == 1, int> = 0>
+    T tick(const T micSample) { return tick(micSample, micSample); }
+
+    /**
+     * @brief Processes a reference sample of a single-channel filter against a separate desired sample and returns the error.
+     *
+     * @param reference The reference sample fed into the delay line.
+     * @param desired The desired sample the filter output is subtracted from.
+     * @return The error sample.
+     */
+    template<std::size_t C = Channels, std::enable_if_t<C == 1, int> = 0>
+    T tick(const T reference, const T desired) {
+        T error;
+        tickFrame(&reference, &desired, &error);
+        return error;
+    }
+
+    /**
+     * @brief Processes one sample of every channel.
+     *
+     * @param reference The Channels reference samples fed into the delay lines.
+     * @param desired The Channels desired samples the filter outputs are subtracted from.
+     * @param error The Channels error samples.
+     */
+    void tickFrame(const T* reference, const T* desired, T* error);
+
+    /**
+     * @brief Processes a block of input samples of a single-channel filter and writes the filtered output.
+     *
+     * The input and output buffers may alias.
+     *
+     * @param in The input samples to be filtered.
+     * @param out The filtered output samples.
+     * @param n The number of samples in the block.
+     */
+    template<std::size_t C = Channels, std::enable_if_t<C == 1, int> = 0>
+    void processBlock(const T* in, T* out, const std::size_t n) { processBlock(&in, &in, &out, n); }
+
+    /**
+     * @brief Processes a block of reference samples of a single-channel filter against separate desired samples.
+     *
+     * The buffers may alias.
+     *
+     * @param reference The reference samples fed into the delay line.
+     * @param desired The desired samples the filter output is subtracted from.
+     * @param error The error samples.
+     * @param n The number of samples in the block.
+     */
+    template<std::size_t C = Channels, std::enable_if_t<C == 1, int> = 0>
+    void processBlock(const T* reference, const T* desired, T* error, const std::size_t n) {
+        processBlock(&reference, &desired, &error, n);
+    }
+
+    /**
+     * @brief Processes a block of input samples of every channel and writes the filtered output.
+     *
+     * The input and output buffers of a channel may alias.
+     *
+     * @param in The input samples to be filtered, one buffer per channel.
+     * @param out The filtered output samples, one buffer per channel.
+     * @param n The number of samples in the block.
+     */
+    void processBlock(const T* const* in, T* const* out, const std::size_t n) { processBlock(in, in, out, n); }
+
+    /**
+     * @brief Processes a block of reference samples of every channel against separate desired samples.
+     *
+     * The buffers of a channel may alias.
+     *
+     * @param reference The reference samples fed into the delay lines, one buffer per channel.
+     * @param desired The desired samples the filter outputs are subtracted from, one buffer per channel.
+     * @param error The error samples, one buffer per channel.
+     * @param n The number of samples in the block.
+     */
+    void processBlock(const T* const* reference, const T* const* desired, T* const* error, std::size_t n);
 
     /**
      * @brief Resets the LMS filter.
@@ -56,90 +158,198 @@ public:
     void reset();
 
     /**
-     * @brief Sets the adaptation rate (mu) for the LMS filter.
+     * @brief Sets the adaptation rate (mu) requested for every channel.
+     *
+     * A fixed step control keeps it as the rate of every channel. A step control that sets the
+     * rate itself takes it as the highest rate it sets.
      *
      * @param new_mu The new adaptation rate.
      */
-    void setMu(double new_mu);
+    void setMu(real_t new_mu);
 
     /**
-     * @brief Gets the current adaptation rate (mu) of the LMS filter.
+     * @brief Gets the adaptation rate (mu) requested for every channel, as set by setMu().
      *
+     * @return The requested adaptation rate.
+     */
+    [[nodiscard]] real_t getRequestedMu() const { return control.getRequestedMu(mu); }
+
+    /**
+     * @brief Gets the current adaptation rate (mu) of a channel.
+     *
+     * @param channel The channel (default is 0).
      * @return The current adaptation rate.
      */
-    [[nodiscard]] double getMu() const { return mu; }
+    [[nodiscard]] real_t getMu(const std::size_t channel = 0) const { return mu[channel]; }
+
+    /**
+     * @brief Gets the leakage factor (gamma) applied to the weights of a channel at the last update.
+     *
+     * @param channel The channel (default is 0).
+     * @return The last gamma value.
+     */
+    [[nodiscard]] real_t getGamma(const std::size_t channel = 0) const { return gamma[channel]; }
 
-#ifdef LEAKAGE
     /**
-     * @brief Sets the leakage factor for the LMS filter.
+     * @brief Gets the number of taps of the filter.
      *
-     * @param newLeakage The new leakage factor.
+     * @return The number of taps.
      */
-    void setLeakage(const double newLeakage) { leakage = newLeakage; }
+    [[nodiscard]] std::size_t getOrder() const { return order; }
+
+    /**
+     * @brief Sets the bulk delay between the newest reference frame and the first tap.
+     *
+     * The weights are shifted by the change of delay, so the taps that still fall in the active
+     * region keep their values, and the weight update rebuilds its state.
+     *
+     * @param newDelay The new delay, in samples, clamped to getMaxDelay().
+     */
+    void setBulkDelay(std::size_t newDelay);
+
+    /**
+     * @brief Gets the bulk delay between the newest reference frame and the first tap.
+     *
+     * @return The delay, in samples.
+     */
+    [[nodiscard]] std::size_t getBulkDelay() const { return delay; }
+
+    /**
+     * @brief Gets the longest bulk delay the delay line can hold.
+     *
+     * @return The longest delay, in samples.
+     */
+    [[nodiscard]] std::size_t getMaxDelay() const { return maxDelay; }
+
+    /**
+     * @brief Gets the first taps of the impulse response of a channel after the bulk delay, which are its weights.
+     *
+     * @param impulseResponse The output taps.
+     * @param count The number of taps to read, at most getOrder().
+     * @param channel The channel (default is 0).
+     */
+    void getImpulseResponse(real_t* impulseResponse, std::size_t count, std::size_t channel = 0) const;
+
+    /**
+     * @brief Sets the length of the window over which the noise parameters are estimated.
+     *
+     * Only available with a step control estimating its noise parameters over a window. The length
+     * is clamped to [MIN_ESTIMATION_WINDOW, MAX_ESTIMATION_WINDOW] and the window is refilled.
+     *
+     * @param size The new window length, in samples.
+     */
+    template<typename C = control_t>
+    auto setEstimationWindow(const std::size_t size) -> decltype(std::declval<C&>().setEstimationWindow(size)) {
+        control.setEstimationWindow(size);
+    }
+
+    /**
+     * @brief Gets the length of the window over which the noise parameters are estimated.
+     *
+     * @return The window length, in samples.
+     */
+    template<typename C = control_t>
+    [[nodiscard]] auto getEstimationWindow() const -> decltype(std::declval<const C&>().getEstimationWindow()) {
+        return control.getEstimationWindow();
+    }
+
+    /**
+     * @brief Sets the leakage factor applied to the weights by the step controls that keep it.
+     *
+     * @param newLeakage The new leakage factor, 1 for none.
+     */
+    void setLeakage(const real_t newLeakage) { leakage = newLeakage; }
 
     /**
      * @brief Gets the current leakage factor of the LMS filter.
      *
      * @return The current leakage factor.
      */
-    [[nodiscard]] double getLeakage() const { return leakage; }
-#endif
+    [[nodiscard]] real_t getLeakage() const { return leakage; }
+
+    /**
+     * @brief Gets the weight update policy.
+     *
+     * @return The weight update policy.
+     */
+    update_t& getUpdate() { return update; }
+
+    /**
+     * @brief Gets the step control policy.
+     *
+     * @return The step control policy.
+     */
+    control_t& getControl() { return control; }
+
+    /**
+     * @brief Takes over the weights, the bulk delay and the delay line of another filter of the same order.
+     *
+     * The newest frames of the other filter become those of this one and the weight update
+     * rebuilds its state from them, so that switching algorithms carries on from the model
+     * identified so far. The step control keeps its own estimates.
+     *
+     * @param other The filter taken over.
+     */
+    template<template<typename, std::size_t> class OtherUpdate, template<typename, std::size_t> class OtherControl>
+    void takeOver(const LMSFilter<T, Channels, OtherUpdate, OtherControl>& other) {
+        const std::size_t frames = std::min(span, other.span) * Channels;
+        const T* source = other.reference_buffer + other.index * Channels;
+        std::fill(reference_buffer, reference_buffer + 2 * span * Channels, T{});
+        std::copy(source, source + frames, reference_buffer);
+        std::copy(source, source + frames, reference_buffer + span * Channels);
+        std::copy(other.weights, other.weights + std::min(order, other.order) * Channels, weights);
+        index = 0;
+        delay = std::min(other.delay, maxDelay);
+        update.restart(weights, reference_buffer + delay * Channels);
+    }
+
+    /**
+     * @brief Writes the weights, the bulk delay, the delay line and the state of the step control.
+     *
+     * @param writer The writer of the state image.
+     */
+    void saveState(StateWriter& writer) const;
+
+    /**
+     * @brief Reads back the state written by saveState() from a filter of the same shape.
+     *
+     * The adaptation rate and the leakage are settings and are kept.
+     *
+     * @param reader The reader of the state image.
+     * @return True if the state was read, false if it is truncated or was saved from a filter of another order, span or number of channels.
+     */
+    bool loadState(StateReader& reader);
 
 private:
+    template<typename, std::size_t, template<typename, std::size_t> class, template<typename, std::size_t> class>
+    friend class LMSFilter;
+
     std::size_t order; ///< The order of the filter.
-    double mu; ///< The adaptation rate.
-    double* reference_buffer; ///< Buffer for reference signal.
-    double* weights; ///< Weights of the filter.
-    std::size_t index{0}; ///< Current index in the buffer.
+    std::size_t maxDelay; ///< The longest bulk delay, in samples.
+    std::size_t delay{0}; ///< The bulk delay between the newest frame and the first tap, in samples.
+    std::size_t span; ///< Number of frames of the delay line: the longest bulk delay, the order and the history of the weight update.
+    real_t mu[Channels]; ///< The adaptation rate of each channel.
+    T* reference_buffer; ///< Mirrored delay line of 2 * span frames, newest frame first, channels interleaved.
+    T* weights; ///< Weights of the filter, channels interleaved.
+    std::size_t index{0}; ///< Position of the newest frame in the delay line.
 
-#ifdef NLMS
-    double power{0.0}; ///< Power of the input signal.
-#endif
+    real_t leakage{1.0}; ///< Leakage factor set by the user.
+    real_t gamma[Channels]; ///< Leakage factor applied to each channel at the last update.
 
-#ifdef LEAKAGE
-    double leakage{0.001}; ///< Leakage factor.
-#else
-    double leakage{1.0}; ///< Default leakage factor.
-#endif
+    update_t update; ///< The weight update policy.
+    control_t control; ///< The step control policy.
 
-#ifdef ADAPTIVE_GAMMA
-    double signalVarianceEstimate{0.0}; ///< Estimate of the signal variance.
-    double errorVarianceEstimate{0.0}; ///< Estimate of the error variance.
-
-    double muMin{0.00001}; ///< Minimum adaptation rate.
-    double muMax{0.01}; ///< Maximum adaptation rate.
-    double gammaMin{0.990}; ///< Minimum gamma value.
-    double gammaMax{0.9999}; ///< Maximum gamma value.
-
-#ifdef KALMAN
-    double signalVarianceError{1.0}; ///< Error in signal variance estimate.
-    double signalProcessNoise{0.01}; ///< Process noise for signal variance.
-    double signalMeasurementNoise{0.1}; ///< Measurement noise for signal variance.
-
-    double errorVarianceError{1.0}; ///< Error in error variance estimate.
-    double errorProcessNoise{0.01}; ///< Process noise for error variance.
-    double errorMeasurementNoise{0.1}; ///< Measurement noise for error variance.
-#else
-    double alpha{0.95}; ///< Alpha value for non-Kalman adaptive gamma.
-#endif
+    bool noiseReduction{false}; ///< Flag indicating if noise reduction is enabled.
 
-#ifdef DYNAMIC_NOISE
-    static constexpr int ESTIMATION_WINDOW = 50; ///< Window size for noise estimation.
-    double signalValues[ESTIMATION_WINDOW]{}; ///< Buffer for signal values.
-    double errorValues[ESTIMATION_WINDOW]{}; ///< Buffer for error values.
-    int windowIndex = 0; ///< Current index in the estimation window.
-    bool windowFilled = false; ///< Flag indicating if the window is filled.
+    static constexpr std::size_t MAC_LANES = 4; ///< Number of partial sums of the filter loop.
 
     /**
-     * @brief Updates the noise parameters based on the error signal.
+     * @brief Computes the filter output of every channel over the taps.
      *
-     * @param error The error signal.
+     * @param taps The first tap frame of the delay line.
+     * @param estimation The Channels accumulated outputs.
      */
-    void updateNoiseParameters(double error);
-#endif
-#endif
-
-    bool noiseReduction{false}; ///< Flag indicating if noise reduction is enabled.
+    void filter(const T* taps, typename Traits::acc_t* estimation) const;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,1068 @@
+#include "LMSPolicies.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <type_traits>
+
+/**
+ * @brief Sets the adaptation rate and gamma of each channel for the current sample.
+ *
+ * @param mu The adaptation rate of each channel, left unchanged.
+ * @param gamma The leakage factor of each channel, set to leakage.
+ * @param leakage The leakage factor set by the user.
+ */
+template<typename R, std::size_t Channels>
+void FixedStep<R, Channels>::adapt(const R*, const R*, R*, R* gamma, const R leakage) {
+    std::fill(gamma, gamma + Channels, leakage);
+}
+
+/**
+ * @brief Sets the adaptation rate requested by the user, which every channel keeps.
+ *
+ * @param requested The requested adaptation rate.
+ * @param mu The adaptation rate of each channel, set to requested.
+ */
+template<typename R, std::size_t Channels>
+void FixedStep<R, Channels>::setMu(const R requested, R* mu) {
+    std::fill(mu, mu + Channels, requested);
+}
+
+/**
+ * @brief Sets the adaptation rate and gamma of a channel from its variance estimates.
+ *
+ * @param channel The channel.
+ * @param mu The adaptation rate of the channel.
+ * @param gamma The leakage factor of the channel.
+ */
+template<typename R, std::size_t Channels>
+void VarianceStep<R, Channels>::map(const std::size_t channel, R& mu, R& gamma) const {
+    constexpr R varianceFloor{1e-10};
+    constexpr R snrHigh{10.0}, snrLow{2.0}, snrSpan{8.0};
+    constexpr R errorVarianceHigh{0.1}, errorVarianceLow{0.01}, errorVarianceSpan{0.09};
+
+    const R signalVariance = signalVarianceEstimate[channel];
+    const R errorVariance = errorVarianceEstimate[channel];
+    const R snr = (signalVariance > varianceFloor) ? (signalVariance / (errorVariance + varianceFloor)) : R{1};
+
+    if (snr > snrHigh) {
+        mu = muMax;
+    } else if (snr < snrLow) {
+        mu = muMin;
+    } else {
+        mu = muMin + (muMax - muMin) * (snr - snrLow) / snrSpan;
+    }
+
+    if (errorVariance > errorVarianceHigh) {
+        gamma = gammaMin;
+    } else if (errorVariance < errorVarianceLow) {
+        gamma = gammaMax;
+    } else {
+        gamma = gammaMin + (gammaMax - gammaMin) * (errorVarianceHigh - errorVariance) / errorVarianceSpan;
+    }
+}
+
+/**
+ * @brief Writes the variance estimates of every channel.
+ *
+ * @param writer The writer of the state image.
+ */
+template<typename R, std::size_t Channels>
+void VarianceStep<R, Channels>::saveState(StateWriter& writer) const {
+    writer.write(signalVarianceEstimate, Channels);
+    writer.write(errorVarianceEstimate, Channels);
+}
+
+/**
+ * @brief Reads back the variance estimates written by saveState().
+ *
+ * @param reader The reader of the state image.
+ * @return True if the state was read, false otherwise.
+ */
+template<typename R, std::size_t Channels>
+bool VarianceStep<R, Channels>::loadState(StateReader& reader) {
+    reader.read(signalVarianceEstimate, Channels);
+    reader.read(errorVarianceEstimate, Channels);
+    return reader.ok();
+}
+
+/**
+ * @brief Sets the adaptation rate and gamma of each channel for the current sample.
+ *
+ * @param input The reference sample of each channel.
+ * @param error The error sample of each channel.
+ * @param mu The adaptation rate of each channel.
+ * @param gamma The leakage factor of each channel.
+ */
+template<typename R, std::size_t Channels>
+void SmoothedStep<R, Channels>::adapt(const R* input, const R* error, R* mu, R* gamma, R) {
+    for (std::size_t c = 0; c < Channels; ++c) {
+        const R signalMeasurement = input[c] * input[c];
+        const R errorMeasurement = error[c] * error[c];
+        this->signalVarianceEstimate[c] = alpha * this->signalVarianceEstimate[c] + (R{1} - alpha) * signalMeasurement;
+        this->errorVarianceEstimate[c] = alpha * this->errorVarianceEstimate[c] + (R{1} - alpha) * errorMeasurement;
+        this->map(c, mu[c], gamma[c]);
+    }
+}
+
+/**
+ * @brief Constructs a KalmanStep object.
+ */
+template<typename R, std::size_t Channels>
+KalmanStep<R, Channels>::KalmanStep() {
+    std::fill(signalVarianceError, signalVarianceError + Channels, R{1.0});
+    std::fill(signalProcessNoise, signalProcessNoise + Channels, R{0.01});
+    std::fill(signalMeasurementNoise, signalMeasurementNoise + Channels, R{0.1});
+    std::fill(errorVarianceError, errorVarianceError + Channels, R{1.0});
+    std::fill(errorProcessNoise, errorProcessNoise + Channels, R{0.01});
+    std::fill(errorMeasurementNoise, errorMeasurementNoise + Channels, R{0.1});
+}
+
+/**
+ * @brief Updates the Kalman variance estimates.
+ *
+ * @param currentEstimate The current estimate.
+ * @param estimationError The estimation error.
+ * @param measurement The measurement value.
+ * @param processNoise The process noise.
+ * @param measurementNoise The measurement noise.
+ * @return The updated estimate.
+ */
+template<typename R>
+static R updateKalmanVariance(const R currentEstimate, R& estimationError, const R measurement, const R processNoise, const R measurementNoise) {
+    const R prediction = currentEstimate;
+    const R predictionError = estimationError + processNoise;
+
+    const R kalmanGain = predictionError / (predictionError + measurementNoise);
+    const R newEstimate = prediction + kalmanGain * (measurement - prediction);
+    const R newEstimationError = (R{1} - kalmanGain) * predictionError;
+
+    estimationError = newEstimationError;
+    return newEstimate;
+}
+
+/**
+ * @brief Sets the adaptation rate and gamma of each channel for the current sample.
+ *
+ * @param input The reference sample of each channel.
+ * @param error The error sample of each channel.
+ * @param mu The adaptation rate of each channel.
+ * @param gamma The leakage factor of each channel.
+ */
+template<typename R, std::size_t Channels>
+void KalmanStep<R, Channels>::adapt(const R* input, const R* error, R* mu, R* gamma, R) {
+    for (std::size_t c = 0; c < Channels; ++c) {
+        const R signalMeasurement = input[c] * input[c];
+        const R errorMeasurement = error[c] * error[c];
+        this->signalVarianceEstimate[c] = updateKalmanVariance(this->signalVarianceEstimate[c], signalVarianceError[c], signalMeasurement, signalProcessNoise[c], signalMeasurementNoise[c]);
+        this->errorVarianceEstimate[c] = updateKalmanVariance(this->errorVarianceEstimate[c], errorVarianceError[c], errorMeasurement, errorProcessNoise[c], errorMeasurementNoise[c]);
+        this->map(c, mu[c], gamma[c]);
+    }
+}
+
+/**
+ * @brief Writes the variance estimates, their errors and the noise parameters of every channel.
+ *
+ * @param writer The writer of the state image.
+ */
+template<typename R, std::size_t Channels>
+void KalmanStep<R, Channels>::saveState(StateWriter& writer) const {
+    VarianceStep<R, Channels>::saveState(writer);
+    writer.write(signalVarianceError, Channels);
+    writer.write(signalProcessNoise, Channels);
+    writer.write(signalMeasurementNoise, Channels);
+    writer.write(errorVarianceError, Channels);
+    writer.write(errorProcessNoise, Channels);
+    writer.write(errorMeasurementNoise, Channels);
+}
+
+/**
+ * @brief Reads back the state written by saveState().
+ *
+ * @param reader The reader of the state image.
+ * @return True if the state was read, false otherwise.
+ */
+template<typename R, std::size_t Channels>
+bool KalmanStep<R, Channels>::loadState(StateReader& reader) {
+    VarianceStep<R, Channels>::loadState(reader);
+    reader.read(signalVarianceError, Channels);
+    reader.read(signalProcessNoise, Channels);
+    reader.read(signalMeasurementNoise, Channels);
+    reader.read(errorVarianceError, Channels);
+    reader.read(errorProcessNoise, Channels);
+    reader.read(errorMeasurementNoise, Channels);
+    return reader.ok();
+}
+
+/**
+ * @brief Sets the adaptation rate and gamma of each channel for the current sample.
+ *
+ * @param input The reference sample of each channel.
+ * @param error The error sample of each channel.
+ * @param mu The adaptation rate of each channel.
+ * @param gamma The leakage factor of each channel.
+ * @param leakage The leakage factor set by the user, unused.
+ */
+template<typename R, std::size_t Channels>
+void DynamicNoiseStep<R, Channels>::adapt(const R* input, const R* error, R* mu, R* gamma, const R leakage) {
+    updateNoiseParameters(input, error);
+    KalmanStep<R, Channels>::adapt(input, error, mu, gamma, leakage);
+}
+
+/**
+ * @brief Sets the length of the window over which the noise parameters are estimated.
+ *
+ * The length is clamped to [EstimationWindow::MIN, EstimationWindow::MAX] and the window is refilled.
+ *
+ * @param size The new window length, in samples.
+ */
+template<typename R, std::size_t Channels>
+void DynamicNoiseStep<R, Channels>::setEstimationWindow(const std::size_t size) {
+    estimationWindow = std::max(EstimationWindow::MIN, std::min(EstimationWindow::MAX, size));
+    subWindowSize = estimationWindow / 5;
+
+    std::fill(signalStatistics, signalStatistics + Channels, WindowStatistics{});
+    std::fill(errorStatistics, errorStatistics + Channels, WindowStatistics{});
+    windowIndex = 0;
+    windowCount = 0;
+}
+
+/**
+ * @brief Reads back the state written by KalmanStep::saveState() and refills the estimation window.
+ *
+ * @param reader The reader of the state image.
+ * @return True if the state was read, false otherwise.
+ */
+template<typename R, std::size_t Channels>
+bool DynamicNoiseStep<R, Channels>::loadState(StateReader& reader) {
+    setEstimationWindow(estimationWindow);
+    return KalmanStep<R, Channels>::loadState(reader);
+}
+
+/**
+ * @brief Adds a value of one channel to the estimation window and updates its running statistics.
+ *
+ * Once the window is filled, the new value replaces the oldest one at windowIndex and the
+ * window moments are updated from these two values alone, so the cost does not depend on the
+ * window length. The moments of the current pass through the buffer are accumulated from scratch
+ * with Welford's algorithm and replace the window moments every time the buffer wraps, so the
+ * rounding errors of the sliding updates never build up beyond one window.
+ *
+ * @param values The window buffer.
+ * @param statistics The running statistics of the window of the channel.
+ * @param value The new value.
+ * @param channel The channel.
+ */
+template<typename R, std::size_t Channels>
+void DynamicNoiseStep<R, Channels>::slideWindow(R* values, WindowStatistics& statistics, const R value, const std::size_t channel) const {
+    WindowMoments& pass = statistics.pass;
+    const R delta = value - pass.mean;
+    pass.mean += delta / static_cast<R>(windowIndex + 1);
+    pass.m2 += delta * (value - pass.mean);
+    if (windowIndex < subWindowSize) pass.firstSum += value;
+    if (windowIndex >= estimationWindow - subWindowSize) pass.lastSum += value;
+
+    if (windowCount == estimationWindow) {
+        WindowMoments& window = statistics.window;
+        const R oldest = values[windowIndex * Channels + channel];
+        const R previousMean = window.mean;
+        window.mean += (value - oldest) / static_cast<R>(estimationWindow);
+        window.m2 += (value - oldest) * (value - window.mean + oldest - previousMean);
+        window.firstSum += values[(windowIndex + subWindowSize) % estimationWindow * Channels + channel] - oldest;
+        window.lastSum += value - values[(windowIndex + estimationWindow - subWindowSize) % estimationWindow * Channels + channel];
+    }
+
+    values[windowIndex * Channels + channel] = value;
+
+    if (windowIndex + 1 == estimationWindow) {
+        statistics.window = pass;
+        pass = WindowMoments{};
+    }
+}
+
+/**
+ * @brief Updates the noise parameters from the reference and error samples.
+ *
+ * The channels share the window position, as they advance in lock step.
+ *
+ * @param input The reference sample of each channel.
+ * @param error The error sample of each channel.
+ */
+template<typename R, std::size_t Channels>
+void DynamicNoiseStep<R, Channels>::updateNoiseParameters(const R* input, const R* error) {
+    AFC_PROFILE_SCOPE(ProfileStage::NoiseParameters);
+    for (std::size_t c = 0; c < Channels; ++c) {
+        slideWindow(signalValues, signalStatistics[c], input[c] * input[c], c);
+        slideWindow(errorValues, errorStatistics[c], error[c] * error[c], c);
+    }
+
+    windowIndex = (windowIndex + 1) % estimationWindow;
+    if (windowCount < estimationWindow) ++windowCount;
+
+    if (windowCount < estimationWindow) return;
+
+    const auto windowSize = static_cast<R>(estimationWindow);
+    const auto subWindow = static_cast<R>(subWindowSize);
+    constexpr R measurementNoiseMin{0.01}, measurementNoiseMax{1.0}, measurementNoiseScale{0.1};
+    constexpr R processNoiseMin{0.001}, processNoiseMax{0.1}, processNoiseScale{0.05};
+    for (std::size_t c = 0; c < Channels; ++c) {
+        const WindowMoments& signal = signalStatistics[c].window;
+        const WindowMoments& errors = errorStatistics[c].window;
+        const R signalMean = signal.mean;
+        const R errorMean = errors.mean;
+        const R signalVar = std::max(R{0}, signal.m2) / windowSize;
+        const R errorVar = std::max(R{0}, errors.m2) / windowSize;
+
+        this->signalMeasurementNoise[c] = std::max(measurementNoiseMin, std::min(measurementNoiseMax, signalVar * measurementNoiseScale));
+        this->errorMeasurementNoise[c] = std::max(measurementNoiseMin, std::min(measurementNoiseMax, errorVar * measurementNoiseScale));
+
+        const R signalChange = std::abs(signal.lastSum - signal.firstSum) / subWindow / signalMean;
+        const R errorChange = std::abs(errors.lastSum - errors.firstSum) / subWindow / errorMean;
+
+        this->signalProcessNoise[c] = std::max(processNoiseMin, std::min(processNoiseMax, signalChange * processNoiseScale));
+        this->errorProcessNoise[c] = std::max(processNoiseMin, std::min(processNoiseMax, errorChange * processNoiseScale));
+    }
+}
+
+/**
+ * @brief Gets the floating-point weights adapted by a policy.
+ *
+ * The weight update policies adapt fixed-point weights through a floating-point copy, so that
+ * updates smaller than one LSB of the sample type accumulate, and write the copy back after each
+ * update.
+ *
+ * @param weights The weights of the filter.
+ * @param shadow The floating-point copy of fixed-point weights.
+ * @return The weights themselves if they are floating-point, else their copy.
+ */
+template<typename T, typename R>
+static R* realWeights(T* weights, R* shadow) {
+    if constexpr (std::is_same_v<T, R>) {
+        return weights;
+    } else {
+        return shadow;
+    }
+}
+
+/**
+ * @brief Constructs a GradientUpdate object.
+ *
+ * @param order The order of the filter.
+ */
+template<typename T, std::size_t Channels, bool Normalized>
+GradientUpdate<T, Channels, Normalized>::GradientUpdate(const std::size_t order)
+    : order(order) {
+    shadow = std::is_same_v<T, real_t> ? nullptr : new real_t[order * Channels];
+    reset();
+}
+
+/**
+ * @brief Destroys the GradientUpdate object and releases allocated resources.
+ */
+template<typename T, std::size_t Channels, bool Normalized>
+GradientUpdate<T, Channels, Normalized>::~GradientUpdate() {
+    delete[] shadow;
+}
+
+/**
+ * @brief Clears the state.
+ */
+template<typename T, std::size_t Channels, bool Normalized>
+void GradientUpdate<T, Channels, Normalized>::reset() {
+    if (shadow) std::fill(shadow, shadow + order * Channels, real_t{0.0});
+    std::fill(power, power + Channels, 0.0);
+}
+
+/**
+ * @brief Takes note of the frame leaving the delay line, before the newest frame overwrites it.
+ *
+ * @param oldest The Channels samples of the frame.
+ */
+template<typename T, std::size_t Channels, bool Normalized>
+void GradientUpdate<T, Channels, Normalized>::retire(const T* oldest) {
+    if constexpr (Normalized) {
+        for (std::size_t c = 0; c < Channels; ++c) {
+            const double sample = Traits::toReal(oldest[c]);
+            power[c] -= sample * sample;
+        }
+    }
+}
+
+/**
+ * @brief Updates the weights once the error of the newest frame is known.
+ *
+ * The newest sample enters the power of the delay line here, after the step control, as the
+ * oldest one left it in retire(). The running sum is clamped at zero, which rounding could
+ * otherwise cross after a long loud passage followed by silence.
+ *
+ * @param weights The weights, channels interleaved.
+ * @param newest The delay line from the newest frame, channels interleaved.
+ * @param error The Channels error samples.
+ * @param mu The adaptation rate of each channel.
+ * @param gamma The leakage factor of each channel.
+ */
+template<typename T, std::size_t Channels, bool Normalized>
+void GradientUpdate<T, Channels, Normalized>::adapt(T* weights, const T* newest, const T*, const real_t* error, const real_t* mu, const real_t* gamma) {
+    real_t* w = realWeights(weights, shadow);
+    real_t step[Channels];
+    bool leaky{false};
+    for (std::size_t c = 0; c < Channels; ++c) {
+        real_t mu_eff = mu[c];
+        if constexpr (Normalized) {
+            constexpr real_t epsilon{1e-6};
+            const double newestSample = Traits::toReal(newest[c]);
+            power[c] = std::max(0.0, power[c] + newestSample * newestSample);
+
+            mu_eff = mu[c] / (static_cast<real_t>(power[c]) + epsilon);
+        }
+
+        step[c] = mu_eff * error[c];
+        leaky = leaky || gamma[c] != real_t{1};
+    }
+
+    if (leaky) {
+        for (std::size_t i = 0; i < order; ++i) {
+            for (std::size_t c = 0; c < Channels; ++c) {
+                real_t& weight = w[i * Channels + c];
+                weight = weight * gamma[c] + step[c] * Traits::toReal(newest[i * Channels + c]);
+            }
+        }
+    } else {
+        for (std::size_t i = 0; i < order; ++i) {
+            for (std::size_t c = 0; c < Channels; ++c) {
+                w[i * Channels + c] += step[c] * Traits::toReal(newest[i * Channels + c]);
+            }
+        }
+    }
+    if (shadow) {
+        for (std::size_t i = 0; i < order * Channels; ++i) {
+            weights[i] = Traits::fromReal(shadow[i]);
+        }
+    }
+}
+
+/**
+ * @brief Rebuilds the state from the weights and the delay line taken over from another filter.
+ *
+ * @param weights The weights, channels interleaved.
+ * @param newest The delay line from the newest frame, channels interleaved.
+ */
+template<typename T, std::size_t Channels, bool Normalized>
+void GradientUpdate<T, Channels, Normalized>::restart(const T* weights, const T* newest) {
+    reset();
+    if (shadow) {
+        for (std::size_t i = 0; i < order * Channels; ++i) {
+            shadow[i] = Traits::toReal(weights[i]);
+        }
+    }
+    if constexpr (Normalized) {
+        for (std::size_t i = 0; i < order; ++i) {
+            for (std::size_t c = 0; c < Channels; ++c) {
+                const double sample = Traits::toReal(newest[i * Channels + c]);
+                power[c] += sample * sample;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Constructs a ProportionateUpdate object.
+ *
+ * @param order The order of the filter.
+ */
+template<typename T, std::size_t Channels>
+ProportionateUpdate<T, Channels>::ProportionateUpdate(const std::size_t order)
+    : order(order) {
+    shadow = std::is_same_v<T, real_t> ? nullptr : new real_t[order * Channels];
+    gains = new real_t[order * Channels];
+    reset();
+}
+
+/**
+ * @brief Destroys the ProportionateUpdate object and releases allocated resources.
+ */
+template<typename T, std::size_t Channels>
+ProportionateUpdate<T, Channels>::~ProportionateUpdate() {
+    delete[] shadow;
+    delete[] gains;
+}
+
+/**
+ * @brief Clears the state.
+ */
+template<typename T, std::size_t Channels>
+void ProportionateUpdate<T, Channels>::reset() {
+    if (shadow) std::fill(shadow, shadow + order * Channels, real_t{0.0});
+    refresh = 0;
+}
+
+/**
+ * @brief Sets how much the step is concentrated on the largest taps.
+ *
+ * The gains are recomputed at the next sample.
+ *
+ * @param newAlpha The proportionality, from -1 (NLMS) to just below 1 (PNLMS), clamped.
+ */
+template<typename T, std::size_t Channels>
+void ProportionateUpdate<T, Channels>::setProportionality(const real_t newAlpha) {
+    alpha = std::max(real_t{-1.0}, std::min(real_t{0.99}, newAlpha));
+    refresh = 0;
+}
+
+/**
+ * @brief Recomputes the gains of the taps from the magnitudes of the weights.
+ *
+ * The gains of a channel sum to one, or to (1 - alpha) / 2 while its weights are all zero, which
+ * the normalization of the step cancels.
+ *
+ * @param weights The floating-point weights, channels interleaved.
+ */
+template<typename T, std::size_t Channels>
+void ProportionateUpdate<T, Channels>::computeGains(const real_t* weights) {
+    constexpr real_t epsilon{1e-9};
+    real_t norm[Channels]{};
+    for (std::size_t i = 0; i < order; ++i) {
+        for (std::size_t c = 0; c < Channels; ++c) {
+            norm[c] += std::abs(weights[i * Channels + c]);
+        }
+    }
+
+    const real_t uniform = (real_t{1} - alpha) / static_cast<real_t>(2 * order);
+    real_t proportionate[Channels];
+    for (std::size_t c = 0; c < Channels; ++c) {
+        proportionate[c] = (real_t{1} + alpha) / (real_t{2} * norm[c] + epsilon);
+    }
+    for (std::size_t i = 0; i < order; ++i) {
+        for (std::size_t c = 0; c < Channels; ++c) {
+            gains[i * Channels + c] = uniform + proportionate[c] * std::abs(weights[i * Channels + c]);
+        }
+    }
+}
+
+/**
+ * @brief Updates the weights once the error of the newest frame is known.
+ *
+ * @param weights The weights, channels interleaved.
+ * @param newest The delay line from the newest frame, channels interleaved.
+ * @param error The Channels error samples.
+ * @param mu The adaptation rate of each channel, between 0 and 1.
+ * @param gamma The leakage factor of each channel.
+ */
+template<typename T, std::size_t Channels>
+void ProportionateUpdate<T, Channels>::adapt(T* weights, const T* newest, const T*, const real_t* error, const real_t* mu, const real_t* gamma) {
+    real_t* w = realWeights(weights, shadow);
+    if (refresh == 0) {
+        computeGains(w);
+        refresh = GAIN_REFRESH;
+    }
+    --refresh;
+
+    real_t power[Channels]{};
+    for (std::size_t i = 0; i < order; ++i) {
+        for (std::size_t c = 0; c < Channels; ++c) {
+            const real_t sample = Traits::toReal(newest[i * Channels + c]);
+            power[c] += gains[i * Channels + c] * sample * sample;
+        }
+    }
+
+    const real_t epsilon = real_t{1e-6} / static_cast<real_t>(order);
+    real_t step[Channels];
+    for (std::size_t c = 0; c < Channels; ++c) {
+        step[c] = mu[c] * error[c] / (power[c] + epsilon);
+    }
+
+    for (std::size_t i = 0; i < order; ++i) {
+        for (std::size_t c = 0; c < Channels; ++c) {
+            real_t& weight = w[i * Channels + c];
+            weight = weight * gamma[c] + step[c] * gains[i * Channels + c] * Traits::toReal(newest[i * Channels + c]);
+        }
+    }
+    if (shadow) {
+        for (std::size_t i = 0; i < order * Channels; ++i) {
+            weights[i] = Traits::fromReal(shadow[i]);
+        }
+    }
+}
+
+/**
+ * @brief Rebuilds the state from the weights and the delay line taken over from another filter.
+ *
+ * @param weights The weights, channels interleaved.
+ */
+template<typename T, std::size_t Channels>
+void ProportionateUpdate<T, Channels>::restart(const T* weights, const T*) {
+    reset();
+    if (shadow) {
+        for (std::size_t i = 0; i < order * Channels; ++i) {
+            shadow[i] = Traits::toReal(weights[i]);
+        }
+    }
+}
+
+/**
+ * @brief Constructs an AffineProjectionUpdate object.
+ *
+ * @param order The order of the filter.
+ */
+template<typename T, std::size_t Channels>
+AffineProjectionUpdate<T, Channels>::AffineProjectionUpdate(const std::size_t order)
+    : order(order) {
+    shadow = std::is_same_v<T, real_t> ? nullptr : new real_t[order * Channels];
+    reset();
+}
+
+/**
+ * @brief Destroys the AffineProjectionUpdate object and releases allocated resources.
+ */
+template<typename T, std::size_t Channels>
+AffineProjectionUpdate<T, Channels>::~AffineProjectionUpdate() {
+    delete[] shadow;
+}
+
+/**
+ * @brief Clears the state.
+ */
+template<typename T, std::size_t Channels>
+void AffineProjectionUpdate<T, Channels>::reset() {
+    if (shadow) std::fill(shadow, shadow + order * Channels, real_t{0.0});
+    std::fill(std::begin(desiredHistory), std::end(desiredHistory), real_t{0.0});
+    std::fill(std::begin(correlation), std::end(correlation), real_t{0.0});
+    newestRow = 0;
+    refresh = 0;
+}
+
+/**
+ * @brief Recomputes the rows of the Gram matrix from the delay line.
+ *
+ * Row j holds the products of the reference vector at sample n - j with the vectors at samples
+ * n - j to n - j - PROJECTIONS + 1, which span 2 * PROJECTIONS - 1 frames beyond the order.
+ *
+ * @param newest The delay line from the newest frame, channels interleaved.
+ */
+template<typename T, std::size_t Channels>
+void AffineProjectionUpdate<T, Channels>::computeRows(const T* newest) {
+    for (std::size_t j = 0; j < PROJECTIONS; ++j) {
+        real_t* row = correlation + (newestRow + j) % PROJECTIONS * PROJECTIONS * Channels;
+        std::fill(row, row + PROJECTIONS * Channels, real_t{0.0});
+        for (std::size_t k = 0; k < PROJECTIONS; ++k) {
+            for (std::size_t i = 0; i < order; ++i) {
+                for (std::size_t c = 0; c < Channels; ++c) {
+                    row[k * Channels + c] += Traits::toReal(newest[(j + i) * Channels + c]) * Traits::toReal(newest[(j + k + i) * Channels + c]);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Updates the weights once the error of the newest frame is known.
+ *
+ * The a priori errors of the older reference vectors are computed with the current weights, then
+ * the regularized Gram system is solved by Cholesky decomposition. A channel whose system is not
+ * positive definite skips the update.
+ *
+ * @param weights The weights, channels interleaved.
+ * @param newest The delay line from the newest frame, channels interleaved.
+ * @param desired The Channels desired samples.
+ * @param error The Channels error samples.
+ * @param mu The adaptation rate of each channel, between 0 and 1.
+ * @param gamma The leakage factor of each channel.
+ */
+template<typename T, std::size_t Channels>
+void AffineProjectionUpdate<T, Channels>::adapt(T* weights, const T* newest, const T* desired, const real_t* error, const real_t* mu, const real_t* gamma) {
+    constexpr std::size_t P = PROJECTIONS;
+    constexpr real_t epsilon{1e-6};
+    const auto x = [newest](const std::size_t i, const std::size_t c) { return Traits::toReal(newest[i * Channels + c]); };
+
+    std::copy_backward(desiredHistory, desiredHistory + (P - 1) * Channels, desiredHistory + P * Channels);
+    for (std::size_t c = 0; c < Channels; ++c) {
+        desiredHistory[c] = Traits::toReal(desired[c]);
+    }
+
+    newestRow = (newestRow + P - 1) % P;
+    if (refresh == 0) {
+        computeRows(newest);
+        refresh = order;
+    } else {
+        real_t* row = correlation + newestRow * P * Channels;
+        const real_t* previous = correlation + (newestRow + 1) % P * P * Channels;
+        for (std::size_t k = 0; k < P; ++k) {
+            for (std::size_t c = 0; c < Channels; ++c) {
+                row[k * Channels + c] = previous[k * Channels + c] + x(0, c) * x(k, c) - x(order, c) * x(order + k, c);
+            }
+        }
+    }
+    --refresh;
+
+    real_t* w = realWeights(weights, shadow);
+    for (std::size_t c = 0; c < Channels; ++c) {
+        real_t e[P];
+        e[0] = error[c];
+        for (std::size_t j = 1; j < P; ++j) {
+            real_t estimation{0.0};
+            for (std::size_t i = 0; i < order; ++i) {
+                estimation += w[i * Channels + c] * x(j + i, c);
+            }
+            e[j] = desiredHistory[j * Channels + c] - estimation;
+        }
+
+        const real_t delta = epsilon + regularization * correlation[newestRow * P * Channels + c];
+        real_t lower[P][P];
+        bool positive = true;
+        for (std::size_t j = 0; j < P && positive; ++j) {
+            for (std::size_t k = 0; k <= j; ++k) {
+                real_t sum = correlation[(newestRow + k) % P * P * Channels + (j - k) * Channels + c];
+                if (j == k) sum += delta;
+                for (std::size_t m = 0; m < k; ++m) {
+                    sum -= lower[j][m] * lower[k][m];
+                }
+                if (j == k) {
+                    positive = sum > real_t{0};
+                    lower[j][j] = positive ? std::sqrt(sum) : real_t{1};
+                } else {
+                    lower[j][k] = sum / lower[k][k];
+                }
+            }
+        }
+        if (!positive) continue;
+
+        real_t a[P];
+        for (std::size_t j = 0; j < P; ++j) {
+            real_t sum = e[j];
+            for (std::size_t m = 0; m < j; ++m) {
+                sum -= lower[j][m] * a[m];
+            }
+            a[j] = sum / lower[j][j];
+        }
+        for (std::size_t j = P; j-- > 0;) {
+            real_t sum = a[j];
+            for (std::size_t m = j + 1; m < P; ++m) {
+                sum -= lower[m][j] * a[m];
+            }
+            a[j] = sum / lower[j][j];
+        }
+        for (real_t& coefficient : a) {
+            coefficient *= mu[c];
+        }
+
+        for (std::size_t i = 0; i < order; ++i) {
+            real_t step{0.0};
+            for (std::size_t j = 0; j < P; ++j) {
+                step += a[j] * x(j + i, c);
+            }
+            real_t& weight = w[i * Channels + c];
+            weight = weight * gamma[c] + step;
+            if (shadow) weights[i * Channels + c] = Traits::fromReal(weight);
+        }
+    }
+}
+
+/**
+ * @brief Rebuilds the state from the weights and the delay line taken over from another filter.
+ *
+ * The desired samples of the older reference vectors are unknown, so they are estimated with the
+ * weights taken over, which makes their a priori errors zero until they are replaced.
+ *
+ * @param weights The weights, channels interleaved.
+ * @param newest The delay line from the newest frame, channels interleaved.
+ */
+template<typename T, std::size_t Channels>
+void AffineProjectionUpdate<T, Channels>::restart(const T* weights, const T* newest) {
+    reset();
+    real_t* w = shadow;
+    if (shadow) {
+        for (std::size_t i = 0; i < order * Channels; ++i) {
+            shadow[i] = Traits::toReal(weights[i]);
+        }
+    }
+    for (std::size_t j = 0; j < PROJECTIONS; ++j) {
+        for (std::size_t c = 0; c < Channels; ++c) {
+            real_t estimation{0.0};
+            for (std::size_t i = 0; i < order; ++i) {
+                estimation += (w ? w[i * Channels + c] : Traits::toReal(weights[i * Channels + c])) * Traits::toReal(newest[(j + i) * Channels + c]);
+            }
+            desiredHistory[j * Channels + c] = estimation;
+        }
+    }
+}
+
+/**
+ * @brief Constructs a FastRLSUpdate object.
+ *
+ * @param order The order of the filter.
+ */
+template<typename T, std::size_t Channels>
+FastRLSUpdate<T, Channels>::FastRLSUpdate(const std::size_t order)
+    : order(order), lambda(real_t{1} - real_t{1} / static_cast<real_t>(4 * order)) {
+    shadow = std::is_same_v<T, real_t> ? nullptr : new real_t[order * Channels];
+    forward = new real_t[order * Channels];
+    backward = new real_t[order * Channels];
+    gain = new real_t[order * Channels];
+    reset();
+}
+
+/**
+ * @brief Destroys the FastRLSUpdate object and releases allocated resources.
+ */
+template<typename T, std::size_t Channels>
+FastRLSUpdate<T, Channels>::~FastRLSUpdate() {
+    delete[] shadow;
+    delete[] forward;
+    delete[] backward;
+    delete[] gain;
+}
+
+/**
+ * @brief Clears the state.
+ */
+template<typename T, std::size_t Channels>
+void FastRLSUpdate<T, Channels>::reset() {
+    if (shadow) std::fill(shadow, shadow + order * Channels, real_t{0.0});
+    for (std::size_t c = 0; c < Channels; ++c) {
+        restartChannel(c);
+    }
+    rescues = 0;
+}
+
+/**
+ * @brief Restarts the predictors and the gain of a channel.
+ *
+ * The initial energies are those of the least squares problem regularized by delta times
+ * diag(1, 1 / lambda, ..., 1 / lambda^order), whose order + 1 and order tap solutions are
+ * consistent, so the algorithm starts exactly on the RLS solution. They assume that the frames
+ * before the restart are zero, so adapt() reads them as such until they leave the delay line.
+ *
+ * @param channel The channel.
+ */
+template<typename T, std::size_t Channels>
+void FastRLSUpdate<T, Channels>::restartChannel(const std::size_t channel) {
+    for (std::size_t i = 0; i < order; ++i) {
+        forward[i * Channels + channel] = real_t{0.0};
+        backward[i * Channels + channel] = real_t{0.0};
+        gain[i * Channels + channel] = real_t{0.0};
+    }
+    forwardEnergy[channel] = delta;
+    backwardEnergy[channel] = delta * std::pow(lambda, -static_cast<real_t>(order));
+    inverseConversion[channel] = real_t{1.0};
+    seen[channel] = 0;
+}
+
+/**
+ * @brief Updates the weights once the error of the newest frame is known.
+ *
+ * The forward predictor extends the a priori gain to order + 1 taps, then the backward predictor
+ * brings it back to order taps, one frame later. The backward prediction error is computed both
+ * directly and from the extended gain, equal in exact arithmetic. Their mix 1.5 * direct - 0.5 *
+ * from gain updates the conversion factor and the backward predictor, and the direct one updates
+ * the backward energy, which feeds the numerical errors back with a decaying gain instead of
+ * letting them grow.
+ *
+ * @param weights The weights, channels interleaved.
+ * @param newest The delay line from the newest frame, channels interleaved.
+ * @param error The Channels error samples.
+ */
+template<typename T, std::size_t Channels>
+void FastRLSUpdate<T, Channels>::adapt(T* weights, const T* newest, const T*, const real_t* error, const real_t*, const real_t*) {
+    const auto x = [newest](const std::size_t i, const std::size_t c) { return Traits::toReal(newest[i * Channels + c]); };
+    const std::size_t last = (order - 1) * Channels;
+
+    real_t* w = realWeights(weights, shadow);
+    for (std::size_t c = 0; c < Channels; ++c) {
+        seen[c] = std::min(seen[c] + 1, order + 1);
+        const std::size_t valid = seen[c] - 1;
+        real_t forwardError = x(0, c);
+        real_t backwardDirect = valid == order ? x(order, c) : real_t{0};
+        for (std::size_t i = 0; i < valid; ++i) {
+            forwardError -= forward[i * Channels + c] * x(i + 1, c);
+            backwardDirect -= backward[i * Channels + c] * x(i, c);
+        }
+        if (valid < order) backwardDirect -= backward[valid * Channels + c] * x(valid, c);
+
+        const real_t previousForward = lambda * forwardEnergy[c];
+        const real_t extension = forwardError / previousForward;
+        const real_t extendedInverse = inverseConversion[c] + forwardError * extension;
+        const real_t forwardPosterior = forwardError / inverseConversion[c];
+        forwardEnergy[c] = previousForward + forwardError * forwardPosterior;
+
+        const real_t extendedLast = gain[last + c] - extension * forward[last + c];
+        forward[last + c] += gain[last + c] * forwardPosterior;
+        for (std::size_t i = order - 1; i > 0; --i) {
+            const std::size_t k = i * Channels + c;
+            const real_t extended = gain[k - Channels] - extension * forward[k - Channels];
+            forward[k - Channels] += gain[k - Channels] * forwardPosterior;
+            gain[k] = extended + extendedLast * backward[k];
+        }
+        gain[c] = extension + extendedLast * backward[c];
+
+        const real_t backwardGain = lambda * backwardEnergy[c] * extendedLast;
+        const auto mix = [backwardDirect, backwardGain](const real_t kappa) { return kappa * backwardDirect + (real_t{1} - kappa) * backwardGain; };
+        const real_t backwardMixed = mix(real_t{1.5});
+        inverseConversion[c] = extendedInverse - extendedLast * backwardMixed;
+
+        if (!(inverseConversion[c] >= real_t{1}) || !std::isfinite(inverseConversion[c]) || !(forwardEnergy[c] > real_t{0})) {
+            restartChannel(c);
+            ++rescues;
+            continue;
+        }
+
+        const real_t conversion = real_t{1} / inverseConversion[c];
+        backwardEnergy[c] = lambda * backwardEnergy[c] + backwardDirect * backwardDirect * conversion;
+        const real_t backwardPosterior = backwardMixed * conversion;
+        const real_t step = error[c] * conversion;
+        for (std::size_t i = 0; i < order; ++i) {
+            const std::size_t k = i * Channels + c;
+            backward[k] += gain[k] * backwardPosterior;
+            w[k] += gain[k] * step;
+            if (shadow) weights[k] = Traits::fromReal(w[k]);
+        }
+    }
+}
+
+/**
+ * @brief Sets the forgetting factor.
+ *
+ * The predictors restart, as their initial energies depend on it; the weights are kept.
+ *
+ * @param factor The forgetting factor, just below 1.
+ */
+template<typename T, std::size_t Channels>
+void FastRLSUpdate<T, Channels>::setForgetting(const real_t factor) {
+    lambda = factor;
+    for (std::size_t c = 0; c < Channels; ++c) {
+        restartChannel(c);
+    }
+}
+
+/**
+ * @brief Rebuilds the state from the weights and the delay line taken over from another filter.
+ *
+ * The predictors restart from zero, as if the delay line were empty; the weights carry on from
+ * those taken over.
+ *
+ * @param weights The weights, channels interleaved.
+ */
+template<typename T, std::size_t Channels>
+void FastRLSUpdate<T, Channels>::restart(const T* weights, const T*) {
+    reset();
+    if (shadow) {
+        for (std::size_t i = 0; i < order * Channels; ++i) {
+            shadow[i] = Traits::toReal(weights[i]);
+        }
+    }
+}
+
+template class FixedStep<double, 1>;
+template class FixedStep<float, 1>;
+template class FixedStep<double, 2>;
+template class FixedStep<float, 2>;
+template class FixedStep<double, 4>;
+template class FixedStep<float, 4>;
+
+template class VarianceStep<double, 1>;
+template class VarianceStep<float, 1>;
+template class VarianceStep<double, 2>;
+template class VarianceStep<float, 2>;
+template class VarianceStep<double, 4>;
+template class VarianceStep<float, 4>;
+template class VarianceStep<double, 8>;
+template class VarianceStep<float, 8>;
+template class VarianceStep<double, 16>;
+template class VarianceStep<float, 16>;
+
+template class SmoothedStep<double, 1>;
+template class SmoothedStep<float, 1>;
+template class SmoothedStep<double, 2>;
+template class SmoothedStep<float, 2>;
+template class SmoothedStep<double, 4>;
+template class SmoothedStep<float, 4>;
+
+template class KalmanStep<double, 1>;
+template class KalmanStep<float, 1>;
+template class KalmanStep<double, 2>;
+template class KalmanStep<float, 2>;
+template class KalmanStep<double, 4>;
+template class KalmanStep<float, 4>;
+template class KalmanStep<double, 8>;
+template class KalmanStep<float, 8>;
+template class KalmanStep<double, 16>;
+template class KalmanStep<float, 16>;
+
+template class DynamicNoiseStep<double, 1>;
+template class DynamicNoiseStep<float, 1>;
+template class DynamicNoiseStep<double, 2>;
+template class DynamicNoiseStep<float, 2>;
+template class DynamicNoiseStep<double, 4>;
+template class DynamicNoiseStep<float, 4>;
+template class DynamicNoiseStep<double, 8>;
+template class DynamicNoiseStep<float, 8>;
+template class DynamicNoiseStep<double, 16>;
+template class DynamicNoiseStep<float, 16>;
+
+template class GradientUpdate<double, 1, false>;
+template class GradientUpdate<float, 1, false>;
+template class GradientUpdate<q15_t, 1, false>;
+template class GradientUpdate<q31_t, 1, false>;
+template class GradientUpdate<double, 2, false>;
+template class GradientUpdate<float, 2, false>;
+template class GradientUpdate<q15_t, 2, false>;
+template class GradientUpdate<q31_t, 2, false>;
+template class GradientUpdate<double, 4, false>;
+template class GradientUpdate<float, 4, false>;
+template class GradientUpdate<q15_t, 4, false>;
+template class GradientUpdate<q31_t, 4, false>;
+
+template class GradientUpdate<double, 1, true>;
+template class GradientUpdate<float, 1, true>;
+template class GradientUpdate<q15_t, 1, true>;
+template class GradientUpdate<q31_t, 1, true>;
+template class GradientUpdate<double, 2, true>;
+template class GradientUpdate<float, 2, true>;
+template class GradientUpdate<q15_t, 2, true>;
+template class GradientUpdate<q31_t, 2, true>;
+template class GradientUpdate<double, 4, true>;
+template class GradientUpdate<float, 4, true>;
+template class GradientUpdate<q15_t, 4, true>;
+template class GradientUpdate<q31_t, 4, true>;
+template class GradientUpdate<double, 8, true>;
+template class GradientUpdate<float, 8, true>;
+template class GradientUpdate<double, 16, true>;
+template class GradientUpdate<float, 16, true>;
+
+template class ProportionateUpdate<double, 1>;
+template class ProportionateUpdate<float, 1>;
+template class ProportionateUpdate<q15_t, 1>;
+template class ProportionateUpdate<q31_t, 1>;
+template class ProportionateUpdate<double, 2>;
+template class ProportionateUpdate<float, 2>;
+template class ProportionateUpdate<q15_t, 2>;
+template class ProportionateUpdate<q31_t, 2>;
+template class ProportionateUpdate<double, 4>;
+template class ProportionateUpdate<float, 4>;
+template class ProportionateUpdate<q15_t, 4>;
+template class ProportionateUpdate<q31_t, 4>;
+
+template class AffineProjectionUpdate<double, 1>;
+template class AffineProjectionUpdate<float, 1>;
+template class AffineProjectionUpdate<q15_t, 1>;
+template class AffineProjectionUpdate<q31_t, 1>;
+template class AffineProjectionUpdate<double, 2>;
+template class AffineProjectionUpdate<float, 2>;
+template class AffineProjectionUpdate<q15_t, 2>;
+template class AffineProjectionUpdate<q31_t, 2>;
+template class AffineProjectionUpdate<double, 4>;
+template class AffineProjectionUpdate<float, 4>;
+template class AffineProjectionUpdate<q15_t, 4>;
+template class AffineProjectionUpdate<q31_t, 4>;
+
+template class FastRLSUpdate<double, 1>;
+template class FastRLSUpdate<float, 1>;
+template class FastRLSUpdate<q15_t, 1>;
+template class FastRLSUpdate<q31_t, 1>;
+template class FastRLSUpdate<double, 2>;
+template class FastRLSUpdate<float, 2>;
+template class FastRLSUpdate<q15_t, 2>;
+template class FastRLSUpdate<q31_t, 2>;
+template class FastRLSUpdate<double, 4>;
+template class FastRLSUpdate<float, 4>;
+template class FastRLSUpdate<q15_t, 4>;
+template class FastRLSUpdate<q31_t, 4>;
@@ -0,0 +1,675 @@
+#ifndef LMS_POLICIES_H
+#define LMS_POLICIES_H
+
+#include "SampleTraits.h"
+#include "StateImage.h"
+#include <cstddef>
+
+/**
+ * @brief Bounds of the window over which DynamicNoiseStep estimates its noise parameters.
+ */
+struct EstimationWindow {
+    static constexpr std::size_t MIN = 5; ///< Minimum window size for noise estimation.
+    static constexpr std::size_t MAX = 512; ///< Maximum window size for noise estimation.
+};
+
+/**
+ * @brief Step control policy keeping the adaptation rate (mu) set by the user and the leakage as gamma.
+ *
+ * A step control policy sets the adaptation rate and the leakage factor (gamma) of each channel of an
+ * LMSFilter once per sample, from the reference and error samples of the channel.
+ *
+ * @tparam R The real type of the adaptation control (float or double).
+ * @tparam Channels The number of channels.
+ */
+template<typename R, std::size_t Channels>
+class FixedStep final {
+public:
+    /**
+     * @brief Sets the adaptation rate and gamma of each channel for the current sample.
+     *
+     * @param input The reference sample of each channel.
+     * @param error The error sample of each channel.
+     * @param mu The adaptation rate of each channel, left unchanged.
+     * @param gamma The leakage factor of each channel, set to leakage.
+     * @param leakage The leakage factor set by the user.
+     */
+    void adapt(const R* input, const R* error, R* mu, R* gamma, R leakage);
+
+    /**
+     * @brief Sets the adaptation rate requested by the user, which every channel keeps.
+     *
+     * @param requested The requested adaptation rate.
+     * @param mu The adaptation rate of each channel, set to requested.
+     */
+    void setMu(R requested, R* mu);
+
+    /**
+     * @brief Gets the adaptation rate requested by the user.
+     *
+     * @param mu The adaptation rate of each channel.
+     * @return The adaptation rate of channel 0.
+     */
+    [[nodiscard]] R getRequestedMu(const R* mu) const { return mu[0]; }
+
+    /**
+     * @brief Writes the adaptive state of the step control, which has none.
+     */
+    void saveState(StateWriter&) const {}
+
+    /**
+     * @brief Reads back the adaptive state written by saveState(), which has none.
+     *
+     * @return True.
+     */
+    bool loadState(StateReader&) { return true; }
+};
+
+/**
+ * @brief Base of the step control policies mapping signal and error variance estimates to mu and gamma.
+ *
+ * The adaptation rate rises from muMin to muMax as the ratio of the signal variance to the error variance
+ * rises from 2 to 10, and gamma falls from gammaMax to gammaMin as the error variance rises from 0.01 to 0.1.
+ * The adaptation rate requested by the user sets muMax, and muMin stays MU_RANGE times lower.
+ *
+ * @tparam R The real type of the adaptation control (float or double).
+ * @tparam Channels The number of channels.
+ */
+template<typename R, std::size_t Channels>
+class VarianceStep {
+public:
+    static constexpr R MU_RANGE{1000}; ///< Ratio of muMax to muMin.
+
+    /**
+     * @brief Sets the adaptation rate requested by the user as the highest one the mapping reaches.
+     *
+     * @param requested The requested adaptation rate, the new muMax.
+     */
+    void setMu(const R requested, R*) {
+        muMax = requested;
+        muMin = requested / MU_RANGE;
+    }
+
+    /**
+     * @brief Gets the adaptation rate requested by the user.
+     *
+     * @return The highest adaptation rate the mapping reaches, muMax.
+     */
+    [[nodiscard]] R getRequestedMu(const R*) const { return muMax; }
+
+    /**
+     * @brief Writes the variance estimates of every channel.
+     *
+     * @param writer The writer of the state image.
+     */
+    void saveState(StateWriter& writer) const;
+
+    /**
+     * @brief Reads back the variance estimates written by saveState().
+     *
+     * @param reader The reader of the state image.
+     * @return True if the state was read, false otherwise.
+     */
+    bool loadState(StateReader& reader);
+
+protected:
+    R signalVarianceEstimate[Channels]{}; ///< Estimate of the signal variance.
+    R errorVarianceEstimate[Channels]{}; ///< Estimate of the error variance.
+
+    R muMin{0.00001}; ///< Minimum adaptation rate.
+    R muMax{0.01}; ///< Maximum adaptation rate.
+    R gammaMin{0.990}; ///< Minimum gamma value.
+    R gammaMax{0.9999}; ///< Maximum gamma value.
+
+    /**
+     * @brief Sets the adaptation rate and gamma of a channel from its variance estimates.
+     *
+     * @param channel The channel.
+     * @param mu The adaptation rate of the channel.
+     * @param gamma The leakage factor of the channel.
+     */
+    void map(std::size_t channel, R& mu, R& gamma) const;
+};
+
+/**
+ * @brief Step control policy estimating the variances with exponential smoothing (variable step-size NLMS).
+ *
+ * @tparam R The real type of the adaptation control (float or double).
+ * @tparam Channels The number of channels.
+ */
+template<typename R, std::size_t Channels>
+class SmoothedStep final : public VarianceStep<R, Channels> {
+public:
+    /**
+     * @brief Sets the adaptation rate and gamma of each channel for the current sample.
+     *
+     * @param input The reference sample of each channel.
+     * @param error The error sample of each channel.
+     * @param mu The adaptation rate of each channel.
+     * @param gamma The leakage factor of each channel.
+     * @param leakage The leakage factor set by the user, unused.
+     */
+    void adapt(const R* input, const R* error, R* mu, R* gamma, R leakage);
+
+private:
+    R alpha{0.95}; ///< Smoothing factor of the variance estimates.
+};
+
+/**
+ * @brief Step control policy estimating the variances with scalar Kalman filters of fixed noise parameters.
+ *
+ * @tparam R The real type of the adaptation control (float or double).
+ * @tparam Channels The number of channels.
+ */
+template<typename R, std::size_t Channels>
+class KalmanStep : public VarianceStep<R, Channels> {
+public:
+    /**
+     * @brief Constructs a KalmanStep object.
+     */
+    KalmanStep();
+
+    /**
+     * @brief Sets the adaptation rate and gamma of each channel for the current sample.
+     *
+     * @param input The reference sample of each channel.
+     * @param error The error sample of each channel.
+     * @param mu The adaptation rate of each channel.
+     * @param gamma The leakage factor of each channel.
+     * @param leakage The leakage factor set by the user, unused.
+     */
+    void adapt(const R* input, const R* error, R* mu, R* gamma, R leakage);
+
+    /**
+     * @brief Writes the variance estimates, their errors and the noise parameters of every channel.
+     *
+     * @param writer The writer of the state image.
+     */
+    void saveState(StateWriter& writer) const;
+
+    /**
+     * @brief Reads back the state written by saveState().
+     *
+     * @param reader The reader of the state image.
+     * @return True if the state was read, false otherwise.
+     */
+    bool loadState(StateReader& reader);
+
+protected:
+    R signalVarianceError[Channels]; ///< Error in signal variance estimate.
+    R signalProcessNoise[Channels]; ///< Process noise for signal variance.
+    R signalMeasurementNoise[Channels]; ///< Measurement noise for signal variance.
+
+    R errorVarianceError[Channels]; ///< Error in error variance estimate.
+    R errorProcessNoise[Channels]; ///< Process noise for error variance.
+    R errorMeasurementNoise[Channels]; ///< Measurement noise for error variance.
+};
+
+/**
+ * @brief Step control policy of KalmanStep whose noise parameters are estimated over a sliding window.
+ *
+ * @tparam R The real type of the adaptation control (float or double).
+ * @tparam Channels The number of channels.
+ */
+template<typename R, std::size_t Channels>
+class DynamicNoiseStep final : public KalmanStep<R, Channels> {
+public:
+    /**
+     * @brief Sets the adaptation rate and gamma of each channel for the current sample.
+     *
+     * @param input The reference sample of each channel.
+     * @param error The error sample of each channel.
+     * @param mu The adaptation rate of each channel.
+     * @param gamma The leakage factor of each channel.
+     * @param leakage The leakage factor set by the user, unused.
+     */
+    void adapt(const R* input, const R* error, R* mu, R* gamma, R leakage);
+
+    /**
+     * @brief Sets the length of the window over which the noise parameters are estimated.
+     *
+     * The length is clamped to [EstimationWindow::MIN, EstimationWindow::MAX] and the window is refilled.
+     *
+     * @param size The new window length, in samples.
+     */
+    void setEstimationWindow(std::size_t size);
+
+    /**
+     * @brief Gets the length of the window over which the noise parameters are estimated.
+     *
+     * @return The window length, in samples.
+     */
+    [[nodiscard]] std::size_t getEstimationWindow() const { return estimationWindow; }
+
+    /**
+     * @brief Reads back the state written by KalmanStep::saveState() and refills the estimation window.
+     *
+     * The noise parameters are restored as they were saved and are estimated again once the
+     * window has been refilled. The length of the window is a setting and is kept.
+     *
+     * @param reader The reader of the state image.
+     * @return True if the state was read, false otherwise.
+     */
+    bool loadState(StateReader& reader);
+
+private:
+    /**
+     * @brief Moments of a run of values of the estimation window.
+     */
+    struct WindowMoments {
+        R mean{0.0}; ///< Mean of the values.
+        R m2{0.0}; ///< Sum of the squared deviations from the mean (Welford).
+        R firstSum{0.0}; ///< Sum of the oldest sub-window.
+        R lastSum{0.0}; ///< Sum of the newest sub-window.
+    };
+
+    /**
+     * @brief Running statistics of the values in the estimation window.
+     */
+    struct WindowStatistics {
+        WindowMoments window; ///< Moments of the whole window, updated as it slides.
+        WindowMoments pass; ///< Moments of the values written since windowIndex was last 0.
+    };
+
+    std::size_t estimationWindow{50}; ///< Window size for noise estimation.
+    std::size_t subWindowSize{10}; ///< Size of the oldest and newest sub-windows, a fifth of the window.
+    R signalValues[EstimationWindow::MAX * Channels]{}; ///< Buffer for signal values, channels interleaved.
+    R errorValues[EstimationWindow::MAX * Channels]{}; ///< Buffer for error values, channels interleaved.
+    WindowStatistics signalStatistics[Channels]; ///< Running statistics of the signal values of each channel.
+    WindowStatistics errorStatistics[Channels]; ///< Running statistics of the error values of each channel.
+    std::size_t windowIndex{0}; ///< Position of the next value, the oldest one once the window is filled.
+    std::size_t windowCount{0}; ///< Number of values in the window.
+
+    /**
+     * @brief Adds a value of one channel to the estimation window and updates its running statistics.
+     *
+     * @param values The window buffer.
+     * @param statistics The running statistics of the window of the channel.
+     * @param value The new value.
+     * @param channel The channel.
+     */
+    void slideWindow(R* values, WindowStatistics& statistics, R value, std::size_t channel) const;
+
+    /**
+     * @brief Updates the noise parameters from the reference and error samples.
+     *
+     * @param input The reference sample of each channel.
+     * @param error The error sample of each channel.
+     */
+    void updateNoiseParameters(const R* input, const R* error);
+};
+
+/**
+ * @brief Weight update policy of the LMS and NLMS algorithms: a gradient step along the reference vector.
+ *
+ * A weight update policy updates the weights of an LMSFilter once per sample, after the filter output and
+ * error have been computed from the delay line. The delay line holds the order newest frames of the
+ * reference, plus HISTORY older frames for the policies that need them.
+ *
+ * With Normalized, the step of each channel is divided by the power of its reference over the delay line.
+ * A leakage factor of exactly one skips the leakage multiply.
+ *
+ * @tparam T The sample and coefficient type (double, float, q15_t or q31_t).
+ * @tparam Channels The number of channels.
+ * @tparam Normalized True for NLMS, false for LMS.
+ */
+template<typename T, std::size_t Channels, bool Normalized>
+class GradientUpdate final {
+public:
+    using Traits = SampleTraits<T>; ///< Arithmetic of the sample type.
+    using real_t = typename Traits::real_t; ///< Type used for the adaptation control logic.
+
+    static constexpr std::size_t HISTORY = 0; ///< Number of delay line frames needed beyond the order.
+
+    /**
+     * @brief Constructs a GradientUpdate object.
+     *
+     * @param order The order of the filter.
+     */
+    explicit GradientUpdate(std::size_t order);
+
+    /**
+     * @brief Destroys the GradientUpdate object.
+     */
+    ~GradientUpdate();
+
+    GradientUpdate(const GradientUpdate&) = delete;
+    GradientUpdate& operator=(const GradientUpdate&) = delete;
+
+    /**
+     * @brief Clears the state.
+     */
+    void reset();
+
+    /**
+     * @brief Takes note of the frame leaving the delay line, before the newest frame overwrites it.
+     *
+     * @param oldest The Channels samples of the frame.
+     */
+    void retire(const T* oldest);
+
+    /**
+     * @brief Updates the weights once the error of the newest frame is known.
+     *
+     * @param weights The weights, channels interleaved.
+     * @param newest The delay line from the newest frame, channels interleaved.
+     * @param desired The Channels desired samples.
+     * @param error The Channels error samples.
+     * @param mu The adaptation rate of each channel.
+     * @param gamma The leakage factor of each channel.
+     */
+    void adapt(T* weights, const T* newest, const T* desired, const real_t* error, const real_t* mu, const real_t* gamma);
+
+    /**
+     * @brief Rebuilds the state from the weights and the delay line taken over from another filter.
+     *
+     * @param weights The weights, channels interleaved.
+     * @param newest The delay line from the newest frame, channels interleaved.
+     */
+    void restart(const T* weights, const T* newest);
+
+private:
+    std::size_t order; ///< The order of the filter.
+    real_t* shadow; ///< Floating-point copy of fixed-point weights, nullptr for floating-point weights.
+    double power[Channels]{}; ///< Power of the reference of each channel over the delay line, a running sum kept in double so that it does not drift.
+};
+
+template<typename T, std::size_t Channels>
+using LMSUpdate = GradientUpdate<T, Channels, false>; ///< Weight update of the LMS algorithm.
+
+template<typename T, std::size_t Channels>
+using NLMSUpdate = GradientUpdate<T, Channels, true>; ///< Weight update of the NLMS algorithm.
+
+/**
+ * @brief Weight update policy of the improved proportionate NLMS algorithm (IPNLMS).
+ *
+ * Each tap gets its own share of the step, proportionate to its magnitude: the gain of tap k is
+ * (1 - alpha) / (2 * order) + (1 + alpha) * |w_k| / (2 * sum |w|), and the step is normalized by the
+ * reference power weighted by these gains. On a sparse path, a bulk delay followed by a few
+ * strong reflections, the active taps then adapt much faster than the inactive ones and the
+ * filter converges faster than NLMS, to which it reduces with alpha = -1. Alpha close to 1 gives
+ * the proportionate NLMS (PNLMS). The gains are recomputed every GAIN_REFRESH samples only, which
+ * adds one pass over the taps per sample to the cost of NLMS.
+ *
+ * @tparam T The sample and coefficient type (double, float, q15_t or q31_t).
+ * @tparam Channels The number of channels.
+ */
+template<typename T, std::size_t Channels>
+class ProportionateUpdate final {
+public:
+    using Traits = SampleTraits<T>; ///< Arithmetic of the sample type.
+    using real_t = typename Traits::real_t; ///< Type used for the adaptation control logic.
+
+    static constexpr std::size_t HISTORY = 0; ///< Number of delay line frames needed beyond the order.
+    static constexpr std::size_t GAIN_REFRESH = 16; ///< Number of samples between two computations of the tap gains.
+
+    /**
+     * @brief Constructs a ProportionateUpdate object.
+     *
+     * @param order The order of the filter.
+     */
+    explicit ProportionateUpdate(std::size_t order);
+
+    /**
+     * @brief Destroys the ProportionateUpdate object.
+     */
+    ~ProportionateUpdate();
+
+    ProportionateUpdate(const ProportionateUpdate&) = delete;
+    ProportionateUpdate& operator=(const ProportionateUpdate&) = delete;
+
+    /**
+     * @brief Clears the state.
+     */
+    void reset();
+
+    /**
+     * @brief Takes note of the frame leaving the delay line, unused.
+     */
+    void retire(const T*) {}
+
+    /**
+     * @brief Updates the weights once the error of the newest frame is known.
+     *
+     * @param weights The weights, channels interleaved.
+     * @param newest The delay line from the newest frame, channels interleaved.
+     * @param desired The Channels desired samples.
+     * @param error The Channels error samples.
+     * @param mu The adaptation rate of each channel, between 0 and 1.
+     * @param gamma The leakage factor of each channel.
+     */
+    void adapt(T* weights, const T* newest, const T* desired, const real_t* error, const real_t* mu, const real_t* gamma);
+
+    /**
+     * @brief Rebuilds the state from the weights and the delay line taken over from another filter.
+     *
+     * @param weights The weights, channels interleaved.
+     * @param newest The delay line from the newest frame, channels interleaved.
+     */
+    void restart(const T* weights, const T* newest);
+
+    /**
+     * @brief Sets how much the step is concentrated on the largest taps.
+     *
+     * @param alpha The proportionality, from -1 (NLMS) to just below 1 (PNLMS), clamped.
+     */
+    void setProportionality(real_t alpha);
+
+    /**
+     * @brief Gets how much the step is concentrated on the largest taps.
+     *
+     * @return The proportionality.
+     */
+    [[nodiscard]] real_t getProportionality() const { return alpha; }
+
+private:
+    std::size_t order; ///< The order of the filter.
+    real_t alpha{-0.5}; ///< Proportionality of the tap gains.
+    real_t* shadow; ///< Floating-point copy of fixed-point weights, nullptr for floating-point weights.
+    real_t* gains; ///< Gain of each tap, channels interleaved.
+    std::size_t refresh{0}; ///< Number of samples until the gains are recomputed.
+
+    /**
+     * @brief Recomputes the gains of the taps from the magnitudes of the weights.
+     *
+     * @param weights The floating-point weights, channels interleaved.
+     */
+    void computeGains(const real_t* weights);
+};
+
+/**
+ * @brief Weight update policy of the affine projection algorithm (APA).
+ *
+ * The weights are projected on the PROJECTIONS newest reference vectors at once: the a priori errors
+ * of these vectors, computed with the current weights, are decorrelated by the inverse of their
+ * regularized Gram matrix, which whitens coloured input much better than NLMS, the APA of order 1.
+ * The Gram matrix is Toeplitz-like: its rows are the newest row of the PROJECTIONS latest samples, each
+ * updated recursively from the previous one and recomputed from the delay line every order samples.
+ *
+ * @tparam T The sample and coefficient type (double, float, q15_t or q31_t).
+ * @tparam Channels The number of channels.
+ */
+template<typename T, std::size_t Channels>
+class AffineProjectionUpdate final {
+public:
+    using Traits = SampleTraits<T>; ///< Arithmetic of the sample type.
+    using real_t = typename Traits::real_t; ///< Type used for the adaptation control logic.
+
+    static constexpr std::size_t PROJECTIONS = 4; ///< Number of reference vectors projected on.
+    static constexpr std::size_t HISTORY = 2 * PROJECTIONS - 1; ///< Number of delay line frames needed beyond the order.
+
+    /**
+     * @brief Constructs an AffineProjectionUpdate object.
+     *
+     * @param order The order of the filter.
+     */
+    explicit AffineProjectionUpdate(std::size_t order);
+
+    /**
+     * @brief Destroys the AffineProjectionUpdate object.
+     */
+    ~AffineProjectionUpdate();
+
+    AffineProjectionUpdate(const AffineProjectionUpdate&) = delete;
+    AffineProjectionUpdate& operator=(const AffineProjectionUpdate&) = delete;
+
+    /**
+     * @brief Clears the state.
+     */
+    void reset();
+
+    /**
+     * @brief Takes note of the frame leaving the delay line, unused.
+     */
+    void retire(const T*) {}
+
+    /**
+     * @brief Updates the weights once the error of the newest frame is known.
+     *
+     * @param weights The weights, channels interleaved.
+     * @param newest The delay line from the newest frame, channels interleaved.
+     * @param desired The Channels desired samples.
+     * @param error The Channels error samples.
+     * @param mu The adaptation rate of each channel, between 0 and 1.
+     * @param gamma The leakage factor of each channel.
+     */
+    void adapt(T* weights, const T* newest, const T* desired, const real_t* error, const real_t* mu, const real_t* gamma);
+
+    /**
+     * @brief Rebuilds the state from the weights and the delay line taken over from another filter.
+     *
+     * @param weights The weights, channels interleaved.
+     * @param newest The delay line from the newest frame, channels interleaved.
+     */
+    void restart(const T* weights, const T* newest);
+
+private:
+    std::size_t order; ///< The order of the filter.
+    real_t regularization{0.01}; ///< Regularization added to the diagonal of the Gram matrix, relative to the reference power.
+    real_t* shadow; ///< Floating-point copy of fixed-point weights, nullptr for floating-point weights.
+    real_t desiredHistory[PROJECTIONS * Channels]{}; ///< The PROJECTIONS newest desired samples, newest first.
+    real_t correlation[PROJECTIONS * PROJECTIONS * Channels]{}; ///< Row 0 of the Gram matrix at each of the PROJECTIONS latest samples, channels interleaved.
+    std::size_t newestRow{0}; ///< Position of the newest row in correlation.
+    std::size_t refresh{0}; ///< Number of samples until the Gram matrix is recomputed.
+
+    /**
+     * @brief Recomputes the rows of the Gram matrix from the delay line.
+     *
+     * @param newest The delay line from the newest frame, channels interleaved.
+     */
+    void computeRows(const T* newest);
+};
+
+/**
+ * @brief Weight update policy of the stabilized fast transversal filter (FTF), a fast RLS algorithm.
+ *
+ * The gain vector of the recursive least squares solution is propagated with forward and backward
+ * linear predictors in O(order) operations per sample instead of O(order^2). The backward prediction
+ * error is computed twice and the two values are mixed to feed back the numerical errors (Slock and
+ * Kailath), and a channel whose conversion factor leaves (0, 1] is restarted. In exact arithmetic the
+ * weights are those of the conventional RLS algorithm. The adaptation rate is
+ * unused; the memory of the algorithm is set by the forgetting factor.
+ *
+ * @tparam T The sample and coefficient type (double, float, q15_t or q31_t).
+ * @tparam Channels The number of channels.
+ */
+template<typename T, std::size_t Channels>
+class FastRLSUpdate final {
+public:
+    using Traits = SampleTraits<T>; ///< Arithmetic of the sample type.
+    using real_t = typename Traits::real_t; ///< Type used for the adaptation control logic.
+
+    static constexpr std::size_t HISTORY = 1; ///< Number of delay line frames needed beyond the order.
+
+    /**
+     * @brief Constructs a FastRLSUpdate object.
+     *
+     * @param order The order of the filter.
+     */
+    explicit FastRLSUpdate(std::size_t order);
+
+    /**
+     * @brief Destroys the FastRLSUpdate object.
+     */
+    ~FastRLSUpdate();
+
+    FastRLSUpdate(const FastRLSUpdate&) = delete;
+    FastRLSUpdate& operator=(const FastRLSUpdate&) = delete;
+
+    /**
+     * @brief Clears the state.
+     */
+    void reset();
+
+    /**
+     * @brief Takes note of the frame leaving the delay line, unused.
+     */
+    void retire(const T*) {}
+
+    /**
+     * @brief Updates the weights once the error of the newest frame is known.
+     *
+     * @param weights The weights, channels interleaved.
+     * @param newest The delay line from the newest frame, channels interleaved.
+     * @param desired The Channels desired samples.
+     * @param error The Channels error samples.
+     * @param mu The adaptation rate of each channel, unused.
+     * @param gamma The leakage factor of each channel, unused.
+     */
+    void adapt(T* weights, const T* newest, const T* desired, const real_t* error, const real_t* mu, const real_t* gamma);
+
+    /**
+     * @brief Rebuilds the state from the weights and the delay line taken over from another filter.
+     *
+     * @param weights The weights, channels interleaved.
+     * @param newest The delay line from the newest frame, channels interleaved.
+     */
+    void restart(const T* weights, const T* newest);
+
+    /**
+     * @brief Sets the forgetting factor.
+     *
+     * The predictors restart, as their initial energies depend on it; the weights are kept. Factors
+     * below the default 1 - 1 / (4 * order) shorten the memory but make restarts more likely.
+     *
+     * @param factor The forgetting factor, just below 1.
+     */
+    void setForgetting(real_t factor);
+
+    /**
+     * @brief Gets the forgetting factor.
+     *
+     * @return The forgetting factor.
+     */
+    [[nodiscard]] real_t getForgetting() const { return lambda; }
+
+    /**
+     * @brief Gets the number of times a channel was restarted because of numerical errors.
+     *
+     * @return The number of restarts.
+     */
+    [[nodiscard]] std::size_t getRescues() const { return rescues; }
+
+private:
+    std::size_t order; ///< The order of the filter.
+    real_t lambda; ///< Forgetting factor, 1 - 1 / (4 * order) by default.
+    real_t delta{0.01}; ///< Initial forward and backward prediction error energies.
+    real_t* shadow; ///< Floating-point copy of fixed-point weights, nullptr for floating-point weights.
+    real_t* forward; ///< Forward predictor of each channel, channels interleaved.
+    real_t* backward; ///< Backward predictor of each channel, channels interleaved.
+    real_t* gain; ///< A priori normalized gain vector of each channel, channels interleaved.
+    real_t forwardEnergy[Channels]; ///< Forward prediction error energy.
+    real_t backwardEnergy[Channels]; ///< Backward prediction error energy.
+    real_t inverseConversion[Channels]; ///< Inverse of the conversion factor.
+    std::size_t seen[Channels]; ///< Number of frames since the restart of each channel, at most order + 1.
+    std::size_t rescues{0}; ///< Number of channel restarts.
+
+    /**
+     * @brief Restarts the predictors and the gain of a channel.
+     *
+     * @param channel The channel.
+     */
+    void restartChannel(std::size_t channel);
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "LatencyProbe.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+/**
+ * @brief Passes the input block through, or runs the measurement.
+ *
+ * While it measures, the input is only watched and the output is silence, the click at the start
+ * of the first block.
+ */
+void LatencyProbe::update() {
+    const std::uint8_t current = state.load(std::memory_order_acquire);
+    audio_block_t* block = receiveReadOnly();
+    if (current != Armed && current != Listening) {
+        if (block) {
+            transmit(block);
+            release(block);
+        }
+        return;
+    }
+
+    const std::uint32_t cycles = Profiler::cycles();
+    if (current == Listening) listen(block, cycles);
+    if (block) release(block);
+
+    audio_block_t* output = allocate();
+    if (!output) return;
+    std::fill(output->data, output->data + AUDIO_BLOCK_SAMPLES, std::int16_t{0});
+    if (current == Armed) {
+        std::fill(output->data, output->data + std::min<std::size_t>(CLICK_SAMPLES, AUDIO_BLOCK_SAMPLES), CLICK_LEVEL);
+        elapsed = 0;
+        startCycles = cycles;
+        state.store(Listening, std::memory_order_release);
+    }
+    transmit(output);
+    release(output);
+}
+
+/**
+ * @brief Looks for the returning click in an input block and ends the measurement if it is found or given up.
+ *
+ * The input block of the update() after the click starts AUDIO_BLOCK_SAMPLES samples after it,
+ * since the graph passes its input to its output within the same update().
+ *
+ * @param block The input block, or nullptr if none arrived.
+ * @param cycles The cycle counter at the start of the update().
+ */
+void LatencyProbe::listen(const audio_block_t* block, const std::uint32_t cycles) {
+    elapsed += AUDIO_BLOCK_SAMPLES;
+    const std::uint32_t blocks = elapsed / AUDIO_BLOCK_SAMPLES;
+    if (block) {
+        for (std::size_t i = 0; i < AUDIO_BLOCK_SAMPLES; ++i) {
+            if (std::abs(block->data[i]) >= THRESHOLD) {
+                result = LatencyResult{true, elapsed + static_cast<std::uint32_t>(i), blocks, cycles - startCycles};
+                state.store(Done, std::memory_order_release);
+                return;
+            }
+        }
+    }
+    if (elapsed >= TIMEOUT_SAMPLES) {
+        result = LatencyResult{false, elapsed, blocks, cycles - startCycles};
+        state.store(Done, std::memory_order_release);
+    }
+}
+
+/**
+ * @brief Sends a click at the next audio block and starts watching for its return.
+ *
+ * @return True if the measurement started, false if one is already running.
+ */
+bool LatencyProbe::start() {
+    if (isRunning()) return false;
+    state.store(Armed, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Takes the result of the measurement, once it is over.
+ *
+ * @param result The result.
+ * @return True if the measurement is over, false if it is still running or none was started.
+ */
+bool LatencyProbe::takeResult(LatencyResult& result) {
+    if (state.load(std::memory_order_acquire) != Done) return false;
+    result = this->result;
+    state.store(Idle, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,94 @@
+#ifndef LATENCY_PROBE_H
+#define LATENCY_PROBE_H
+
+#include <Audio.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Result of a latency measurement.
+ */
+struct LatencyResult {
+    bool detected; ///< True if the click came back before LatencyProbe::TIMEOUT_SAMPLES.
+    std::uint32_t samples; ///< Samples from the click leaving the probe to its return, counted by the audio clock.
+    std::uint32_t blocks; ///< Audio blocks from the update() that sent the click to the one that found it.
+    std::uint32_t cycles; ///< Cycle counter ticks between those two update() calls.
+};
+
+/**
+ * @brief The LatencyProbe class measures the input-to-output latency of the audio chain with a click.
+ *
+ * The probe sits between the canceller and the output and passes its input through. A measurement
+ * replaces the output with silence and a click of CLICK_SAMPLES samples at the start of a block,
+ * then watches the input of the probe for the first sample at or above THRESHOLD. With the output
+ * looped back to the input, the click returns through the converters, the buffers of the audio
+ * library and the canceller, so the samples it took, counted by the audio clock, are the latency
+ * from the input of the chain to its output, the algorithmic delay of the adaptive filter included.
+ *
+ * The cycle counter is read at the update() that sends the click and at the one that finds it, so
+ * the same latency can be checked against the CPU clock, which also exposes an audio clock that
+ * does not run at the sample rate the build assumes. The output stays muted until the click is
+ * found or the measurement times out, so the click does not circulate.
+ */
+class LatencyProbe final : public AudioStream {
+public:
+    static constexpr std::size_t CLICK_SAMPLES = 4; ///< Length of the click.
+    static constexpr std::int16_t CLICK_LEVEL = 16384; ///< Level of the click, -6 dBFS.
+    static constexpr std::int16_t THRESHOLD = 4096; ///< Level the returning click must reach, -18 dBFS.
+    static constexpr std::uint32_t TIMEOUT_SAMPLES = 32768; ///< Samples after which a click is given up, about 0.7 s at 44.1 kHz.
+
+    /**
+     * @brief Constructs a LatencyProbe object passing its input through.
+     */
+    LatencyProbe() : AudioStream(1, inputQueueArray) {}
+
+    /**
+     * @brief Passes the input block through, or runs the measurement.
+     */
+    void update() override;
+
+    /**
+     * @brief Sends a click at the next audio block and starts watching for its return.
+     *
+     * @return True if the measurement started, false if one is already running.
+     */
+    bool start();
+
+    /**
+     * @brief Takes the result of the measurement, once it is over.
+     *
+     * @param result The result.
+     * @return True if the measurement is over, false if it is still running or none was started.
+     */
+    bool takeResult(LatencyResult& result);
+
+    /**
+     * @brief Checks if a measurement is running.
+     *
+     * @return True from start() until the click is found or given up, false otherwise.
+     */
+    [[nodiscard]] bool isRunning() const {
+        const std::uint8_t current = state.load(std::memory_order_acquire);
+        return current == Armed || current == Listening;
+    }
+
+private:
+    enum State : std::uint8_t { Idle, Armed, Listening, Done };
+
+    audio_block_t* inputQueueArray[1]; ///< Pending block of the input.
+    std::atomic<std::uint8_t> state{Idle}; ///< State of the measurement.
+    std::uint32_t elapsed{0}; ///< Samples from the click to the start of the current block.
+    std::uint32_t startCycles{0}; ///< Cycle counter at the update() that sent the click.
+    LatencyResult result{}; ///< Result of the last measurement, written by the audio interrupt.
+
+    /**
+     * @brief Looks for the returning click in an input block and ends the measurement if it is found or given up.
+     *
+     * @param block The input block, or nullptr if none arrived.
+     * @param cycles The cycle counter at the start of the update().
+     */
+    void listen(const audio_block_t* block, std::uint32_t cycles);
+};
+
+#endif
@@ -0,0 +1,403 @@
+#include "NotchBank.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Constructs a NotchBank object with no notch allocated.
+ *
+ * @param stageCount The number of cascaded notches, between 1 and MAX_NOTCHES.
+ * @param sampleRate The sample rate, in Hz.
+ */
+template<typename T>
+NotchBank<T>::NotchBank(const std::size_t stageCount, const real_t sampleRate)
+    : stageCount(std::max<std::size_t>(1, std::min(stageCount, MAX_NOTCHES))), sampleRate(sampleRate) {
+    setHoldTime(holdTime);
+    for (std::size_t i = 0; i < MAX_NOTCHES; ++i) {
+        computeCoefficients(i);
+    }
+    std::copy(targetB1, targetB1 + MAX_NOTCHES, b1);
+    std::copy(targetB2, targetB2 + MAX_NOTCHES, b2);
+    std::copy(targetA1, targetA1 + MAX_NOTCHES, a1);
+    std::copy(targetA2, targetA2 + MAX_NOTCHES, a2);
+    std::fill(rampRemaining, rampRemaining + MAX_NOTCHES, std::size_t{0});
+    rampingStages = 0;
+}
+
+/**
+ * @brief Processes an input sample and returns the filtered output.
+ *
+ * @param x0 The input sample to be filtered.
+ * @return The filtered output sample.
+ */
+template<typename T>
+T NotchBank<T>::tick(const T x0) {
+    T y0;
+    processBlock(&x0, &y0, 1);
+    return y0;
+}
+
+/**
+ * @brief Processes a block of input samples through all the stages and writes the filtered output.
+ *
+ * At step t, stage i filters sample t - i. The first and last stageCount - 1 steps only run the
+ * stages that have a sample to filter, the steps in between run all of them. A ramp moves each
+ * stage along with the samples it filters, so every stage sees the same ramp position for a sample.
+ *
+ * @param input The input samples to be filtered.
+ * @param output The filtered output samples.
+ * @param n The number of samples in the block.
+ */
+template<typename T>
+void NotchBank<T>::processBlock(const T* input, T* output, const std::size_t n) {
+    const std::size_t lastStage = stageCount - 1;
+    const std::size_t fullStart = std::min(lastStage, n);
+    std::size_t t = 0;
+
+    for (; t < fullStart; ++t) {
+        if (rampingStages > 0) advanceRamp(0, t + 1);
+        T* stageIn = pipelines[t & 1];
+        stageIn[0] = input[t];
+        step(stageIn, pipelines[(t + 1) & 1], 0, t + 1);
+    }
+
+    for (; t < n; ++t) {
+        if (rampingStages > 0) advanceRamp(0, stageCount);
+        T* stageIn = pipelines[t & 1];
+        T* stageOut = pipelines[(t + 1) & 1];
+        stageIn[0] = input[t];
+        step(stageIn, stageOut, 0, stageCount);
+        output[t - lastStage] = stageOut[stageCount];
+    }
+
+    for (; t < n + lastStage; ++t) {
+        if (rampingStages > 0) advanceRamp(t - n + 1, stageCount);
+        T* stageOut = pipelines[(t + 1) & 1];
+        step(pipelines[t & 1], stageOut, t - n + 1, stageCount);
+        output[t - lastStage] = stageOut[stageCount];
+    }
+}
+
+/**
+ * @brief Runs one pipeline step of a range of stages.
+ *
+ * Stage i reads stageIn[i] and writes stageOut[i + 1], so the stages are independent.
+ *
+ * @param stageIn The input of each stage.
+ * @param stageOut The output of each stage, shifted by one.
+ * @param first The first stage.
+ * @param last The stage after the last one.
+ */
+template<typename T>
+void NotchBank<T>::step(const T* stageIn, T* stageOut, const std::size_t first, const std::size_t last) {
+    for (std::size_t i = first; i < last; ++i) {
+        const T x0 = stageIn[i];
+        typename Traits::acc_t acc{};
+        acc = Traits::mac(acc, b0[i], x0);
+        acc = Traits::mac(acc, b1[i], x1[i]);
+        acc = Traits::mac(acc, b2[i], x2[i]);
+        acc = Traits::msub(acc, a1[i], y1[i]);
+        acc = Traits::msub(acc, a2[i], y2[i]);
+        const T y0 = Traits::fromAcc(acc, Traits::coefShift);
+
+        x2[i] = x1[i];
+        x1[i] = x0;
+        y2[i] = y1[i];
+        y1[i] = y0;
+        stageOut[i + 1] = y0;
+    }
+}
+
+/**
+ * @brief Sets the number of cascaded notches. The notches beyond the new count are released.
+ *
+ * @param count The new number of notches, clamped between 1 and MAX_NOTCHES.
+ */
+template<typename T>
+void NotchBank<T>::setStageCount(const std::size_t count) {
+    stageCount = std::max<std::size_t>(1, std::min(count, MAX_NOTCHES));
+    for (std::size_t i = stageCount; i < MAX_NOTCHES; ++i) {
+        releaseNotch(i);
+    }
+    pendingCount = 0;
+}
+
+/**
+ * @brief Allocates a notch, or retunes it if it is already allocated, and restarts its lifetime.
+ *
+ * @param index The index of the notch.
+ * @param frequency The center frequency of the notch.
+ * @param bandwidth The bandwidth of the notch.
+ */
+template<typename T>
+void NotchBank<T>::setNotch(const std::size_t index, const real_t frequency, const real_t bandwidth) {
+    this->frequency[index] = frequency;
+    this->bandwidth[index] = bandwidth;
+    lifetime[index] = holdSamples;
+    computeCoefficients(index);
+}
+
+/**
+ * @brief Releases a notch, which then passes its input through.
+ *
+ * @param index The index of the notch.
+ */
+template<typename T>
+void NotchBank<T>::releaseNotch(const std::size_t index) {
+    lifetime[index] = 0;
+    computeCoefficients(index);
+}
+
+/**
+ * @brief Gets the number of allocated notches.
+ *
+ * @return The number of allocated notches.
+ */
+template<typename T>
+std::size_t NotchBank<T>::getActiveCount() const {
+    return static_cast<std::size_t>(std::count_if(lifetime, lifetime + stageCount, [](const std::size_t l) { return l > 0; }));
+}
+
+/**
+ * @brief Computes the bandwidth given to a notch at the specified frequency.
+ *
+ * @param frequency The center frequency of the notch.
+ * @return The bandwidth of the notch.
+ */
+template<typename T>
+typename NotchBank<T>::real_t NotchBank<T>::bandwidthFor(const real_t frequency) {
+    constexpr real_t minBandwidth{50.0}, relativeBandwidth{0.1};
+    return std::max(minBandwidth, frequency * relativeBandwidth);
+}
+
+/**
+ * @brief Sets the sample rate, keeping the frequencies and bandwidths of the notches in Hz.
+ *
+ * @param sampleRate The new sample rate, in Hz.
+ */
+template<typename T>
+void NotchBank<T>::setSampleRate(const real_t sampleRate) {
+    this->sampleRate = sampleRate;
+    setHoldTime(holdTime);
+    for (std::size_t i = 0; i < MAX_NOTCHES; ++i) {
+        computeCoefficients(i);
+    }
+}
+
+/**
+ * @brief Sets the time without a candidate after which a notch is released.
+ *
+ * The hold time is kept in seconds and converted to at least one sample at the sample rate.
+ *
+ * @param seconds The hold time, in seconds.
+ */
+template<typename T>
+void NotchBank<T>::setHoldTime(const real_t seconds) {
+    holdTime = std::max(seconds, real_t{0});
+    holdSamples = std::max<std::size_t>(1, static_cast<std::size_t>(std::lround(holdTime * sampleRate)));
+}
+
+/**
+ * @brief Writes the frequency, the bandwidth and the lifetime of each notch.
+ *
+ * @param writer The writer of the state image.
+ */
+template<typename T>
+void NotchBank<T>::saveState(StateWriter& writer) const {
+    writer.writeSize(stageCount);
+    for (std::size_t i = 0; i < stageCount; ++i) {
+        writer.write(frequency[i]);
+        writer.write(bandwidth[i]);
+        writer.writeSize(lifetime[i]);
+    }
+}
+
+/**
+ * @brief Reads back the notches written by saveState() and ramps the stages toward them.
+ *
+ * @param reader The reader of the state image.
+ * @return True if the state was read, false otherwise.
+ */
+template<typename T>
+bool NotchBank<T>::loadState(StateReader& reader) {
+    std::size_t count{0};
+    if (!reader.readSize(count) || count > MAX_NOTCHES) return false;
+
+    real_t savedFrequency[MAX_NOTCHES], savedBandwidth[MAX_NOTCHES];
+    std::size_t savedLifetime[MAX_NOTCHES];
+    for (std::size_t i = 0; i < count; ++i) {
+        reader.read(savedFrequency[i]);
+        reader.read(savedBandwidth[i]);
+        reader.readSize(savedLifetime[i]);
+    }
+    if (!reader.ok()) return false;
+
+    for (std::size_t i = 0; i < stageCount; ++i) {
+        if (i < count) {
+            frequency[i] = savedFrequency[i];
+            bandwidth[i] = savedBandwidth[i];
+            lifetime[i] = savedLifetime[i];
+        } else {
+            lifetime[i] = 0;
+        }
+        computeCoefficients(i);
+    }
+    pendingCount = 0;
+    return true;
+}
+
+/**
+ * @brief Allocates, retunes and releases the notches from the howl frequencies found by one estimate.
+ *
+ * @param candidates The candidate frequencies, strongest first.
+ * @param count The number of candidates.
+ * @param updateRate The fraction of the distance to its candidate a notch moves by.
+ * @param elapsed The number of samples since the previous estimate.
+ * @param allocate True to let the remaining candidates progress toward a notch, false to leave the waiting candidates as they are.
+ */
+template<typename T>
+void NotchBank<T>::track(const real_t* candidates, std::size_t count, const real_t updateRate, const std::size_t elapsed, const bool allocate) {
+    count = std::min(count, MAX_NOTCHES);
+    bool claimed[MAX_NOTCHES]{};
+    bool confirmed[MAX_NOTCHES]{};
+
+    for (std::size_t c = 0; c < count; ++c) {
+        std::size_t nearest = stageCount;
+        real_t nearestDistance{0};
+        for (std::size_t i = 0; i < stageCount; ++i) {
+            const real_t distance = std::abs(candidates[c] - frequency[i]);
+            if (lifetime[i] > 0 && distance <= bandwidth[i] && (nearest == stageCount || distance < nearestDistance)) {
+                nearest = i;
+                nearestDistance = distance;
+            }
+        }
+        if (nearest == stageCount) continue;
+
+        claimed[c] = true;
+        if (!confirmed[nearest]) {
+            confirmed[nearest] = true;
+            const real_t newFrequency = frequency[nearest] + (candidates[c] - frequency[nearest]) * updateRate;
+            setNotch(nearest, newFrequency, bandwidthFor(newFrequency));
+        }
+    }
+
+    for (std::size_t i = 0; i < stageCount; ++i) {
+        if (confirmed[i] || lifetime[i] == 0) continue;
+        if (lifetime[i] > elapsed) {
+            lifetime[i] -= elapsed;
+        } else {
+            releaseNotch(i);
+        }
+    }
+
+    if (!allocate) return;
+
+    real_t nextFrequency[MAX_NOTCHES];
+    std::size_t nextHits[MAX_NOTCHES];
+    std::size_t nextCount = 0;
+
+    for (std::size_t c = 0; c < count; ++c) {
+        if (claimed[c]) continue;
+
+        std::size_t hits = 1;
+        for (std::size_t p = 0; p < pendingCount; ++p) {
+            if (std::abs(candidates[c] - pendingFrequency[p]) <= bandwidthFor(pendingFrequency[p])) {
+                hits = pendingHits[p] + 1;
+                break;
+            }
+        }
+
+        if (hits >= attackEstimates) {
+            const std::size_t* freeSlot = std::find(lifetime, lifetime + stageCount, std::size_t{0});
+            if (freeSlot != lifetime + stageCount) {
+                setNotch(static_cast<std::size_t>(freeSlot - lifetime), candidates[c], bandwidthFor(candidates[c]));
+                continue;
+            }
+        }
+
+        nextFrequency[nextCount] = candidates[c];
+        nextHits[nextCount] = hits;
+        ++nextCount;
+    }
+
+    std::copy(nextFrequency, nextFrequency + nextCount, pendingFrequency);
+    std::copy(nextHits, nextHits + nextCount, pendingHits);
+    pendingCount = nextCount;
+}
+
+/**
+ * @brief Computes the coefficients of a notch, or pass-through coefficients if it is released, and ramps toward them.
+ *
+ * The ramp restarts for every stage, from its current coefficients to its target ones. The stages
+ * beyond the stage count filter nothing and take their target coefficients at once.
+ *
+ * @param index The index of the notch.
+ */
+template<typename T>
+void NotchBank<T>::computeCoefficients(const std::size_t index) {
+    using acc_t = typename Traits::acc_t;
+
+    b0[index] = Traits::fromCoefficient(1.0);
+    if (lifetime[index] == 0) {
+        targetB1[index] = targetB2[index] = targetA1[index] = targetA2[index] = T{};
+    } else {
+        const real_t r = NotchFilter<T>::computeR(bandwidth[index], sampleRate);
+        const real_t w0 = real_t{2} * static_cast<real_t>(M_PI) * frequency[index] / sampleRate;
+        const real_t cosW0 = TrigTable<real_t>::cosine(w0);
+        targetB1[index] = Traits::fromCoefficient(real_t{-2} * cosW0);
+        targetB2[index] = Traits::fromCoefficient(1.0);
+        targetA1[index] = Traits::fromCoefficient(real_t{-2} * r * cosW0);
+        targetA2[index] = Traits::fromCoefficient(r * r);
+    }
+
+    const auto samples = static_cast<acc_t>(NotchFilter<T>::RAMP_SAMPLES);
+    const auto increment = [samples](const T target, const T current) {
+        return static_cast<T>((static_cast<acc_t>(target) - static_cast<acc_t>(current)) / samples);
+    };
+    for (std::size_t i = 0; i < stageCount; ++i) {
+        stepB1[i] = increment(targetB1[i], b1[i]);
+        stepB2[i] = increment(targetB2[i], b2[i]);
+        stepA1[i] = increment(targetA1[i], a1[i]);
+        stepA2[i] = increment(targetA2[i], a2[i]);
+        rampRemaining[i] = NotchFilter<T>::RAMP_SAMPLES;
+    }
+    for (std::size_t i = stageCount; i < MAX_NOTCHES; ++i) {
+        b1[i] = targetB1[i];
+        b2[i] = targetB2[i];
+        a1[i] = targetA1[i];
+        a2[i] = targetA2[i];
+        rampRemaining[i] = 0;
+    }
+    rampingStages = stageCount;
+}
+
+/**
+ * @brief Moves the coefficients of a range of stages one sample further along the ramp.
+ *
+ * The last step of a stage lands exactly on its targets, whatever the rounding of the increments.
+ *
+ * @param first The first stage.
+ * @param last The stage after the last one.
+ */
+template<typename T>
+void NotchBank<T>::advanceRamp(const std::size_t first, const std::size_t last) {
+    for (std::size_t i = first; i < last; ++i) {
+        if (rampRemaining[i] == 0) continue;
+        if (--rampRemaining[i] == 0) {
+            b1[i] = targetB1[i];
+            b2[i] = targetB2[i];
+            a1[i] = targetA1[i];
+            a2[i] = targetA2[i];
+            --rampingStages;
+        } else {
+            b1[i] += stepB1[i];
+            b2[i] += stepB2[i];
+            a1[i] += stepA1[i];
+            a2[i] += stepA2[i];
+        }
+    }
+}
+
+template class NotchBank<double>;
+template class NotchBank<float>;
+template class NotchBank<q15_t>;
+template class NotchBank<q31_t>;
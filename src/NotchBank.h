@@ -0,0 +1,254 @@
+#ifndef NOTCH_BANK_H
+#define NOTCH_BANK_H
+
+#include "NotchFilter.h"
+#include "StateImage.h"
+#include <cstddef>
+
+/**
+ * @brief The NotchBank class implements a cascade of up to MAX_NOTCHES notch filters that track howl frequencies.
+ *
+ * Each notch is a biquad with the response of NotchFilter. The stages are stored as arrays of
+ * coefficients and states and processed as a pipeline: at each step, stage i filters the sample
+ * that stage i - 1 filtered at the previous step, so all the stages run in one loop without
+ * dependencies between iterations and the compiler can vectorize it. A block is fully drained
+ * before processBlock() returns, so the pipeline adds no latency.
+ *
+ * Notches are allocated and released by track() with hysteresis: a candidate frequency gets a
+ * notch after it has been reported by attackEstimates consecutive estimates, and a notch is
+ * released after the hold time without a candidate near its frequency. The lifetime of a notch
+ * is counted in samples, so the hold time does not depend on the rate of the estimates. Stages
+ * without a notch pass their input through.
+ *
+ * Allocating, retuning or releasing a notch ramps the coefficients of every stage linearly toward
+ * their new values over NotchFilter<T>::RAMP_SAMPLES samples, so that the notches move without clicks.
+ *
+ * The frequencies and bandwidths are in Hz, at the sample rate given to the constructor or to
+ * setSampleRate().
+ *
+ * @tparam T The sample and coefficient type (double, float, q15_t or q31_t).
+ */
+template<typename T>
+class NotchBank final {
+public:
+    using Traits = SampleTraits<T>; ///< Arithmetic of the sample type.
+    using real_t = typename Traits::real_t; ///< Type used for frequencies and coefficient design.
+
+    static constexpr std::size_t MAX_NOTCHES = 16; ///< Maximum number of cascaded notches.
+
+    /**
+     * @brief Constructs a NotchBank object with no notch allocated.
+     *
+     * @param stageCount The number of cascaded notches, between 1 and MAX_NOTCHES (default is 1).
+     * @param sampleRate The sample rate, in Hz (default is AUDIO_SAMPLE_RATE_EXACT).
+     */
+    explicit NotchBank(std::size_t stageCount = 1, real_t sampleRate = AUDIO_SAMPLE_RATE_EXACT);
+
+    /**
+     * @brief Processes an input sample and returns the filtered output.
+     *
+     * @param x0 The input sample to be filtered.
+     * @return The filtered output sample.
+     */
+    T tick(T x0);
+
+    /**
+     * @brief Processes a block of input samples through all the stages and writes the filtered output.
+     *
+     * The input and output buffers may alias.
+     *
+     * @param input The input samples to be filtered.
+     * @param output The filtered output samples.
+     * @param n The number of samples in the block.
+     */
+    void processBlock(const T* input, T* output, std::size_t n);
+
+    /**
+     * @brief Sets the number of cascaded notches. The notches beyond the new count are released.
+     *
+     * @param count The new number of notches, clamped between 1 and MAX_NOTCHES.
+     */
+    void setStageCount(std::size_t count);
+
+    /**
+     * @brief Gets the number of cascaded notches.
+     *
+     * @return The number of notches.
+     */
+    [[nodiscard]] std::size_t getStageCount() const { return stageCount; }
+
+    /**
+     * @brief Allocates a notch, or retunes it if it is already allocated, and restarts its lifetime.
+     *
+     * @param index The index of the notch.
+     * @param frequency The center frequency of the notch.
+     * @param bandwidth The bandwidth of the notch.
+     */
+    void setNotch(std::size_t index, real_t frequency, real_t bandwidth);
+
+    /**
+     * @brief Releases a notch, which then passes its input through.
+     *
+     * @param index The index of the notch.
+     */
+    void releaseNotch(std::size_t index);
+
+    /**
+     * @brief Checks if a notch is allocated.
+     *
+     * @param index The index of the notch.
+     * @return True if the notch is allocated, false otherwise.
+     */
+    [[nodiscard]] bool isActive(const std::size_t index) const { return lifetime[index] > 0; }
+
+    /**
+     * @brief Gets the center frequency of a notch.
+     *
+     * @param index The index of the notch.
+     * @return The center frequency of the notch, or its last one if it is released.
+     */
+    [[nodiscard]] real_t getFrequency(const std::size_t index) const { return frequency[index]; }
+
+    /**
+     * @brief Gets the bandwidth of a notch.
+     *
+     * @param index The index of the notch.
+     * @return The bandwidth of the notch, or its last one if it is released.
+     */
+    [[nodiscard]] real_t getBandwidth(const std::size_t index) const { return bandwidth[index]; }
+
+    /**
+     * @brief Gets the number of allocated notches.
+     *
+     * @return The number of allocated notches.
+     */
+    [[nodiscard]] std::size_t getActiveCount() const;
+
+    /**
+     * @brief Allocates, retunes and releases the notches from the howl frequencies found by one estimate.
+     *
+     * A notch within its bandwidth of a candidate moves toward it at the given rate and restarts its
+     * lifetime; the others age by the samples elapsed since the previous estimate. The remaining candidates must be reported by
+     * attackEstimates consecutive allocating estimates before a free notch is allocated to them.
+     *
+     * @param candidates The candidate frequencies, strongest first.
+     * @param count The number of candidates.
+     * @param updateRate The fraction of the distance to its candidate a notch moves by.
+     * @param elapsed The number of samples since the previous estimate.
+     * @param allocate True to let the remaining candidates progress toward a notch, false to leave the waiting candidates as they are.
+     */
+    void track(const real_t* candidates, std::size_t count, real_t updateRate, std::size_t elapsed, bool allocate = true);
+
+    /**
+     * @brief Sets the number of consecutive estimates a candidate must be reported by before it gets a notch.
+     *
+     * @param estimates The number of estimates, at least 1.
+     */
+    void setAttackEstimates(const std::size_t estimates) { attackEstimates = estimates > 0 ? estimates : 1; }
+
+    /**
+     * @brief Sets the time without a candidate after which a notch is released.
+     *
+     * @param seconds The hold time, in seconds.
+     */
+    void setHoldTime(real_t seconds);
+
+    /**
+     * @brief Sets the sample rate, keeping the frequencies and bandwidths of the notches in Hz.
+     *
+     * The stages ramp toward their coefficients at the new rate.
+     *
+     * @param sampleRate The new sample rate, in Hz.
+     */
+    void setSampleRate(real_t sampleRate);
+
+    /**
+     * @brief Gets the sample rate.
+     *
+     * @return The sample rate, in Hz.
+     */
+    [[nodiscard]] real_t getSampleRate() const { return sampleRate; }
+
+    /**
+     * @brief Computes the bandwidth given to a notch at the specified frequency.
+     *
+     * @param frequency The center frequency of the notch.
+     * @return The bandwidth of the notch.
+     */
+    static real_t bandwidthFor(real_t frequency);
+
+    /**
+     * @brief Writes the frequency, the bandwidth and the lifetime of each notch.
+     *
+     * @param writer The writer of the state image.
+     */
+    void saveState(StateWriter& writer) const;
+
+    /**
+     * @brief Reads back the notches written by saveState() and ramps the stages toward them.
+     *
+     * The number of stages is a setting and is kept: the notches saved beyond it are dropped, and
+     * the stages beyond the notches saved are released. The candidates waiting for a notch are
+     * forgotten.
+     *
+     * @param reader The reader of the state image.
+     * @return True if the state was read, false otherwise.
+     */
+    bool loadState(StateReader& reader);
+
+private:
+    std::size_t stageCount; ///< The number of cascaded notches.
+    real_t sampleRate; ///< The sample rate, in Hz.
+    std::size_t attackEstimates{3}; ///< Consecutive estimates before a candidate gets a notch.
+    real_t holdTime{5}; ///< Time without a candidate before a notch is released, in seconds.
+    std::size_t holdSamples; ///< The hold time, in samples.
+
+    real_t frequency[MAX_NOTCHES]{}; ///< Center frequency of each notch.
+    real_t bandwidth[MAX_NOTCHES]{}; ///< Bandwidth of each notch.
+    std::size_t lifetime[MAX_NOTCHES]{}; ///< Samples left before each notch is released, 0 if it is released.
+
+    real_t pendingFrequency[MAX_NOTCHES]{}; ///< Frequency of each candidate waiting for a notch.
+    std::size_t pendingHits[MAX_NOTCHES]{}; ///< Consecutive estimates that reported each waiting candidate.
+    std::size_t pendingCount{0}; ///< Number of candidates waiting for a notch.
+
+    T b0[MAX_NOTCHES]{}, b1[MAX_NOTCHES]{}, b2[MAX_NOTCHES]{}; ///< Feedforward coefficients, scaled down by Traits::coefShift bits.
+    T a1[MAX_NOTCHES]{}, a2[MAX_NOTCHES]{}; ///< Feedback coefficients, scaled down by Traits::coefShift bits.
+    T targetB1[MAX_NOTCHES], targetB2[MAX_NOTCHES]; ///< Feedforward coefficients the ramp ends at.
+    T targetA1[MAX_NOTCHES], targetA2[MAX_NOTCHES]; ///< Feedback coefficients the ramp ends at.
+    T stepB1[MAX_NOTCHES]{}, stepB2[MAX_NOTCHES]{}; ///< Per-sample increments of the feedforward coefficients.
+    T stepA1[MAX_NOTCHES]{}, stepA2[MAX_NOTCHES]{}; ///< Per-sample increments of the feedback coefficients.
+    std::size_t rampRemaining[MAX_NOTCHES]{}; ///< Number of samples left in the ramp of each stage.
+    std::size_t rampingStages{0}; ///< Number of stages whose ramp has not ended.
+
+    T x1[MAX_NOTCHES]{}, x2[MAX_NOTCHES]{}; ///< Previous input samples of each stage.
+    T y1[MAX_NOTCHES]{}, y2[MAX_NOTCHES]{}; ///< Previous output samples of each stage.
+
+    T pipelines[2][MAX_NOTCHES + 1]{}; ///< Input of each stage at the current and next pipeline steps, alternately.
+
+    /**
+     * @brief Computes the coefficients of a notch, or pass-through coefficients if it is released, and ramps toward them.
+     *
+     * @param index The index of the notch.
+     */
+    void computeCoefficients(std::size_t index);
+
+    /**
+     * @brief Moves the coefficients of a range of stages one sample further along the ramp.
+     *
+     * @param first The first stage.
+     * @param last The stage after the last one.
+     */
+    void advanceRamp(std::size_t first, std::size_t last);
+
+    /**
+     * @brief Runs one pipeline step of a range of stages.
+     *
+     * @param stageIn The input of each stage.
+     * @param stageOut The output of each stage, shifted by one.
+     * @param first The first stage.
+     * @param last The stage after the last one.
+     */
+    void step(const T* stageIn, T* stageOut, std::size_t first, std::size_t last);
+};
+
+#endif
@@ -5,29 +5,100 @@
  *
  * @param frequency The center frequency of the notch filter.
  * @param bandwidth The bandwidth of the notch filter.
+ * @param sampleRate The sample rate, in Hz.
  */
-NotchFilter::NotchFilter(const double frequency, const double bandwidth) : frequency(frequency), r(computeR(bandwidth)) {
+template<typename T>
+NotchFilter<T>::NotchFilter(const real_t frequency, const real_t bandwidth, const real_t sampleRate)
+	: sampleRate(sampleRate), frequency(frequency), r(computeR(bandwidth, sampleRate)) {
 	computeCoefficient();
+	a1 = targetA1;
+	a2 = targetA2;
+	b1 = targetB1;
+	rampRemaining = 0;
 }
 
 /**
- * @brief Computes the filter coefficients based on the current frequency and bandwidth.
+ * @brief Computes the filter coefficients based on the current frequency and bandwidth and ramps toward them.
  */
-void NotchFilter::computeCoefficient() {
-	w0 = 2.0f * M_PI * frequency / AUDIO_SAMPLE_RATE_EXACT;
-	b1 = -2.0f * cos(w0);
-	a1 = -2.0f * r * cos(w0);
-	a2 = r * r;
+template<typename T>
+void NotchFilter<T>::computeCoefficient() {
+	using acc_t = typename Traits::acc_t;
+
+	w0 = real_t{2} * static_cast<real_t>(M_PI) * frequency / sampleRate;
+	const real_t cosW0 = TrigTable<real_t>::cosine(w0);
+	targetB1 = Traits::fromCoefficient(real_t{-2} * cosW0);
+	targetA1 = Traits::fromCoefficient(real_t{-2} * r * cosW0);
+	targetA2 = Traits::fromCoefficient(r * r);
+
+	const auto samples = static_cast<acc_t>(RAMP_SAMPLES);
+	stepB1 = static_cast<T>((static_cast<acc_t>(targetB1) - static_cast<acc_t>(b1)) / samples);
+	stepA1 = static_cast<T>((static_cast<acc_t>(targetA1) - static_cast<acc_t>(a1)) / samples);
+	stepA2 = static_cast<T>((static_cast<acc_t>(targetA2) - static_cast<acc_t>(a2)) / samples);
+	rampRemaining = RAMP_SAMPLES;
+}
+
+/**
+ * @brief Moves the coefficients one sample further along the ramp.
+ *
+ * The last step lands exactly on the target, whatever the rounding of the increments.
+ */
+template<typename T>
+void NotchFilter<T>::advanceRamp() {
+	if (--rampRemaining == 0) {
+		a1 = targetA1;
+		a2 = targetA2;
+		b1 = targetB1;
+		return;
+	}
+	a1 += stepA1;
+	a2 += stepA2;
+	b1 += stepB1;
+}
+
+/**
+ * @brief Sets the center frequency of the notch filter.
+ *
+ * @param frequency The new center frequency.
+ */
+template<typename T>
+void NotchFilter<T>::setFrequency(const real_t frequency) {
+	this->frequency = frequency;
+	computeCoefficient();
+}
+
+/**
+ * @brief Sets the bandwidth of the notch filter.
+ *
+ * @param bandwidth The new bandwidth.
+ */
+template<typename T>
+void NotchFilter<T>::setBandwidth(const real_t bandwidth) {
+	r = computeR(bandwidth, sampleRate);
+	computeCoefficient();
+}
+
+/**
+ * @brief Sets the sample rate, keeping the center frequency and the bandwidth in Hz.
+ *
+ * @param sampleRate The new sample rate, in Hz.
+ */
+template<typename T>
+void NotchFilter<T>::setSampleRate(const real_t sampleRate) {
+	const real_t bandwidth = getBandwidth();
+	this->sampleRate = sampleRate;
+	setBandwidth(bandwidth);
 }
 
 /**
  * @brief Computes the radius (r) based on the given bandwidth.
  *
  * @param bandwidth The bandwidth of the notch filter.
+ * @param sampleRate The sample rate, in Hz.
  * @return The computed radius (r).
  */
-double NotchFilter::computeR(const double bandwidth) {
-	return exp(-(M_PI * bandwidth) / AUDIO_SAMPLE_RATE_EXACT);
+template<typename T>
+typename NotchFilter<T>::real_t NotchFilter<T>::computeR(const real_t bandwidth, const real_t sampleRate) {
+	return std::exp(-(static_cast<real_t>(M_PI) * bandwidth) / sampleRate);
 }
 
 /**
@@ -36,8 +107,19 @@ double NotchFilter::computeR(const double bandwidth) {
  * @param x0 The input sample to be filtered.
  * @return The filtered output sample.
  */
-double NotchFilter::tick(const double x0) {
-	const double y0 = b0 * x0 + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+template<typename T>
+T NotchFilter<T>::tick(const T x0) {
+	if (rampRemaining > 0) {
+		advanceRamp();
+	}
+
+	typename Traits::acc_t acc{};
+	acc = Traits::mac(acc, b0, x0);
+	acc = Traits::mac(acc, b1, x1);
+	acc = Traits::mac(acc, b2, x2);
+	acc = Traits::msub(acc, a1, y1);
+	acc = Traits::msub(acc, a2, y2);
+	const T y0 = Traits::fromAcc(acc, Traits::coefShift);
 
 	x2 = x1;
 	x1 = x0;
@@ -46,4 +128,9 @@ double NotchFilter::tick(const double x0) {
 	y1 = y0;
 
 	return y0;
-}
\ No newline at end of file
+}
+
+template class NotchFilter<double>;
+template class NotchFilter<float>;
+template class NotchFilter<q15_t>;
+template class NotchFilter<q31_t>;
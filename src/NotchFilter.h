@@ -3,22 +3,41 @@
 
 #include <Audio.h>
 #include <cmath>
+#include "SampleTraits.h"
+#include "TrigTable.h"
+#include <cstddef>
 
 /**
  * @brief The NotchFilter class implements a notch filter for audio processing.
  *
  * This class provides methods to apply a notch filter to an input signal,
  * allowing for the attenuation of a specific frequency band.
+ *
+ * Retuning does not make the coefficients jump: they ramp linearly to their new values
+ * over RAMP_SAMPLES samples, which avoids clicks. The cosine of the center frequency
+ * comes from TrigTable instead of libm.
+ *
+ * The sample rate is a parameter, AUDIO_SAMPLE_RATE_EXACT by default, so that the same filter
+ * runs at 44.1, 48 or 96 kHz.
+ *
+ * @tparam T The sample and coefficient type (double, float, q15_t or q31_t).
  */
+template<typename T>
 class NotchFilter {
 public:
+    using Traits = SampleTraits<T>; ///< Arithmetic of the sample type.
+    using real_t = typename Traits::real_t; ///< Type used for frequencies and coefficient design.
+
+    static constexpr std::size_t RAMP_SAMPLES = 128; ///< Number of samples over which retuned coefficients ramp, whatever the block size.
+
     /**
      * @brief Constructs a NotchFilter object with the specified frequency and bandwidth.
      *
      * @param frequency The center frequency of the notch filter.
      * @param bandwidth The bandwidth of the notch filter.
+     * @param sampleRate The sample rate, in Hz (default is AUDIO_SAMPLE_RATE_EXACT).
      */
-    NotchFilter(double frequency, double bandwidth);
+    NotchFilter(real_t frequency, real_t bandwidth, real_t sampleRate = AUDIO_SAMPLE_RATE_EXACT);
 
     /**
      * @brief Processes an input sample and returns the filtered output.
@@ -26,10 +45,10 @@ public:
      * @param x0 The input sample to be filtered.
      * @return The filtered output sample.
      */
-    double tick(double x0);
+    T tick(T x0);
 
     /**
-     * @brief Computes the filter coefficients based on the current frequency and bandwidth.
+     * @brief Computes the filter coefficients based on the current frequency and bandwidth and ramps toward them.
      */
     void computeCoefficient();
 
@@ -37,49 +56,74 @@ public:
      * @brief Computes the radius (r) based on the given bandwidth.
      *
      * @param bandwidth The bandwidth of the notch filter.
+     * @param sampleRate The sample rate, in Hz.
      * @return The computed radius (r).
      */
-    static double computeR(double bandwidth);
+    static real_t computeR(real_t bandwidth, real_t sampleRate);
 
     /**
      * @brief Sets the center frequency of the notch filter.
      *
      * @param frequency The new center frequency.
      */
-    void setFrequency(const double frequency) { this->frequency = frequency; }
+    void setFrequency(real_t frequency);
 
     /**
      * @brief Gets the current center frequency of the notch filter.
      *
      * @return The current center frequency.
      */
-    [[nodiscard]] double getCenterFrequency() const { return frequency; }
+    [[nodiscard]] real_t getCenterFrequency() const { return frequency; }
 
     /**
      * @brief Sets the bandwidth of the notch filter.
      *
      * @param bandwidth The new bandwidth.
      */
-    void setBandwidth(const double bandwidth) { r = computeR(bandwidth); }
+    void setBandwidth(real_t bandwidth);
 
     /**
      * @brief Gets the current bandwidth of the notch filter.
      *
      * @return The current bandwidth.
      */
-    [[nodiscard]] double getBandwidth() const { return -log(r) * AUDIO_SAMPLE_RATE_EXACT / M_PI; }
+    [[nodiscard]] real_t getBandwidth() const { return -std::log(r) * sampleRate / static_cast<real_t>(M_PI); }
+
+    /**
+     * @brief Sets the sample rate, keeping the center frequency and the bandwidth in Hz.
+     *
+     * @param sampleRate The new sample rate, in Hz.
+     */
+    void setSampleRate(real_t sampleRate);
+
+    /**
+     * @brief Gets the sample rate.
+     *
+     * @return The sample rate, in Hz.
+     */
+    [[nodiscard]] real_t getSampleRate() const { return sampleRate; }
 
 private:
-    double frequency; ///< The center frequency of the notch filter.
-    double r; ///< The radius (r) of the filter.
+    real_t sampleRate; ///< The sample rate, in Hz.
+    real_t frequency; ///< The center frequency of the notch filter.
+    real_t r; ///< The radius (r) of the filter.
 
-    double x1{0}, x2{0}; ///< Previous input samples.
-    double y1{0}, y2{0}; ///< Previous output samples.
+    T x1{}, x2{}; ///< Previous input samples.
+    T y1{}, y2{}; ///< Previous output samples.
 
-    double w0{}; ///< Angular frequency.
+    real_t w0{}; ///< Angular frequency.
 
-    double a1{}, a2{}; ///< Filter coefficients.
-    double b0{1.0f}, b1{}, b2{1.0f}; ///< Filter coefficients.
+    T a1{}, a2{}; ///< Filter coefficients, scaled down by Traits::coefShift bits.
+    T b0{Traits::fromCoefficient(1.0)}, b1{}, b2{Traits::fromCoefficient(1.0)}; ///< Filter coefficients, scaled down by Traits::coefShift bits.
+
+    T targetA1{}, targetA2{}, targetB1{}; ///< Coefficients the ramp ends at.
+    T stepA1{}, stepA2{}, stepB1{}; ///< Per-sample increments of the ramp.
+    std::size_t rampRemaining{0}; ///< Number of samples left in the ramp.
+
+    /**
+     * @brief Moves the coefficients one sample further along the ramp.
+     */
+    void advanceRamp();
 };
 
 #endif
\ No newline at end of file
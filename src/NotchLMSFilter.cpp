@@ -1,4 +1,6 @@
 #include "NotchLMSFilter.h"
+#include "Profiler.h"
+#include <algorithm>
 #include <cmath>
 
 /**
@@ -7,117 +9,265 @@
  * @param order The order of the filter.
  * @param initialCenterFreq The initial center frequency of the notch filter.
  * @param initialBandwidth The initial bandwidth of the notch filter.
+ * @param sampleRate The sample rate, in Hz.
  */
-NotchLMSFilter::NotchLMSFilter(const std::size_t order, const double initialCenterFreq, const double initialBandwidth)
-    : notchFilter(initialCenterFreq, initialBandwidth), lmsFilter(order) {
-    for (double & i : spectralBuffer) {
-        i = 0.0;
+template<typename T, typename Adaptive>
+NotchLMSFilter<T, Adaptive>::NotchLMSFilter(const std::size_t order, const real_t initialCenterFreq, const real_t initialBandwidth,
+                                            const real_t sampleRate)
+    : lmsFilter(order) {
+    for (std::size_t channel = 0; channel < CHANNELS; ++channel) {
+        estimator[channel] = &defaultEstimator[channel];
+    }
+    setSampleRate(sampleRate);
+    for (NotchBank<T>& bank : notchBank) {
+        bank.setNotch(0, initialCenterFreq, initialBandwidth);
     }
 }
 
 /**
  * @brief Destroys the NotchLMSFilter object.
  */
-NotchLMSFilter::~NotchLMSFilter() = default;
+template<typename T, typename Adaptive>
+NotchLMSFilter<T, Adaptive>::~NotchLMSFilter() = default;
 
 /**
- * @brief Processes an input sample and returns the filtered output.
+ * @brief Processes a block of input samples of every channel and writes the filtered output.
+ *
+ * Each stage runs over a whole chunk of samples before the next one starts,
+ * so the LMS filter sees a contiguous block instead of one sample at a time,
+ * and the LMS filter runs the chunks of all the channels together. Chunks end
+ * where the spectral buffers wrap, which is where the adaptive notch update
+ * happens.
  *
- * @param inputSample The input sample to be filtered.
- * @return The filtered output sample.
+ * @param input The input samples to be filtered, one buffer per channel.
+ * @param output The filtered output samples, one buffer per channel.
+ * @param n The number of samples in the block.
  */
-double NotchLMSFilter::tick(const double inputSample) {
-    double notchOutput{};
-    if (notchEnabled) {
-        notchOutput = notchFilter.tick(inputSample);
-    }
+template<typename T, typename Adaptive>
+void NotchLMSFilter<T, Adaptive>::processBlock(const T* const* input, T* const* output, const std::size_t n) {
+    std::size_t offset = 0;
+    while (offset < n) {
+        const std::size_t count = std::min(SPECTRAL_BUFFER_SIZE - spectralBufferIndex, n - offset);
+        const T* in[CHANNELS];
+        T* out[CHANNELS];
+        for (std::size_t channel = 0; channel < CHANNELS; ++channel) {
+            in[channel] = input[channel] + offset;
+            out[channel] = output[channel] + offset;
+        }
 
-    double lmsOutput{inputSample};
-    if (lmsEnabled) {
-        lmsOutput = lmsFilter.tick(notchEnabled ? notchOutput : inputSample);
-    }
+        if (notchEnabled) {
+            AFC_PROFILE_SCOPE(ProfileStage::Notch);
+            for (std::size_t channel = 0; channel < CHANNELS; ++channel) {
+                notchBank[channel].processBlock(in[channel], notchBuffer[channel], count);
+            }
+        } else {
+            for (T* buffer : notchBuffer) {
+                std::fill(buffer, buffer + count, T{});
+            }
+        }
+        if (adaptiveNotchEnabled) {
+            AFC_PROFILE_SCOPE(ProfileStage::FrequencyEstimation);
+            for (std::size_t channel = 0; channel < CHANNELS; ++channel) {
+                real_t* spectral = spectralBuffer[channel] + spectralBufferIndex;
+                for (std::size_t i = 0; i < count; ++i) {
+                    spectral[i] = Traits::toReal(in[channel][i]);
+                }
+                estimator[channel]->process(spectral, count);
+            }
+        }
+        spectralBufferIndex = (spectralBufferIndex + count) % SPECTRAL_BUFFER_SIZE;
 
-    spectralBuffer[spectralBufferIndex] = inputSample;
-    spectralBufferIndex = (spectralBufferIndex + 1) % SPECTRAL_BUFFER_SIZE;
+        if (lmsEnabled) {
+            AFC_PROFILE_SCOPE(ProfileStage::Adaptive);
+            const T* adaptiveInput[CHANNELS];
+            for (std::size_t channel = 0; channel < CHANNELS; ++channel) {
+                adaptiveInput[channel] = notchEnabled ? notchBuffer[channel] : in[channel];
+            }
+            lmsFilter.processBlock(adaptiveInput, out, count);
+        } else {
+            for (std::size_t channel = 0; channel < CHANNELS; ++channel) {
+                if (out[channel] != in[channel]) std::copy(in[channel], in[channel] + count, out[channel]);
+            }
+        }
 
-    if (adaptiveNotchEnabled && notchEnabled && lmsEnabled && spectralBufferIndex == 0) {
-        updateNotchFrequency(notchOutput - lmsOutput, lmsOutput);
-    }
+        if (adaptiveNotchEnabled && notchEnabled && lmsEnabled && spectralBufferIndex == 0) {
+            for (std::size_t channel = 0; channel < CHANNELS; ++channel) {
+                const real_t lastOutput = Traits::toReal(out[channel][count - 1]);
+                updateNotchFrequency(channel, Traits::toReal(notchBuffer[channel][count - 1]) - lastOutput, lastOutput);
+            }
+        }
 
-    return lmsOutput;
+        offset += count;
+    }
+    howlElapsed += n;
 }
 
 /**
- * @brief Sets the center frequency of the notch filter.
+ * @brief Sets the center frequency of notch 0 of every channel, allocating it if it was released.
  *
  * @param frequency The new center frequency.
  */
-void NotchLMSFilter::setNotchFrequency(double frequency) {
+template<typename T, typename Adaptive>
+void NotchLMSFilter<T, Adaptive>::setNotchFrequency(real_t frequency) {
     frequency = std::max(minFrequency, std::min(maxFrequency, frequency));
-    notchFilter.setFrequency(frequency);
+    for (NotchBank<T>& bank : notchBank) {
+        bank.setNotch(0, frequency, bank.getBandwidth(0));
+    }
 }
 
 /**
- * @brief Sets the bandwidth of the notch filter.
+ * @brief Sets the bandwidth of notch 0 of every channel, allocating it if it was released.
  *
  * @param bandwidth The new bandwidth.
  */
-void NotchLMSFilter::setNotchBandwidth(const double bandwidth) {
-    notchFilter.setBandwidth(bandwidth);
+template<typename T, typename Adaptive>
+void NotchLMSFilter<T, Adaptive>::setNotchBandwidth(const real_t bandwidth) {
+    for (NotchBank<T>& bank : notchBank) {
+        bank.setNotch(0, bank.getFrequency(0), bandwidth);
+    }
 }
 
 /**
- * @brief Updates the notch filter frequency based on the error and output.
+ * @brief Enables or disables the adaptive notch filter.
  *
- * @param error The error signal.
- * @param output The output signal.
+ * @param enable True to enable, false to disable.
  */
-void NotchLMSFilter::updateNotchFrequency(const double error, const double output) {
-    if (std::abs(error) > 0.05 || std::abs(output) > 0.7) {
-        if (const double dominantFreq = estimateDominantFrequency(); dominantFreq > 0) {
-            const double currentFreq = notchFilter.getCenterFrequency();
-            double newFreq = currentFreq * (1.0 - freqUpdateRate) + dominantFreq * freqUpdateRate;
-
-            newFreq = std::max(minFrequency, std::min(maxFrequency, newFreq));
-
-            notchFilter.setFrequency(newFreq);
-
-            const double bandwidth = std::max(50.0, newFreq * 0.1);
-            notchFilter.setBandwidth(bandwidth);
+template<typename T, typename Adaptive>
+void NotchLMSFilter<T, Adaptive>::enableAdaptiveNotch(const bool enable) {
+    if (enable && !adaptiveNotchEnabled) {
+        for (FrequencyEstimator<real_t>* channelEstimator : estimator) {
+            channelEstimator->reset();
         }
     }
+    if (!enable && adaptiveNotchEnabled) howlElapsed = 0;
+    adaptiveNotchEnabled = enable;
 }
 
 /**
- * @brief Estimates the dominant frequency in the spectral buffer.
+ * @brief Tracks howl frequencies found outside the filter, such as by a HowlDetector.
+ *
+ * The frequencies outside the frequency limits are ignored. The notches age by the samples
+ * processed since the previous call.
  *
- * @return The estimated dominant frequency.
+ * @param frequencies The howl frequencies in Hz, loudest first.
+ * @param count The number of frequencies.
  */
-double NotchLMSFilter::estimateDominantFrequency() const {
-    constexpr size_t MAX_LAG = SPECTRAL_BUFFER_SIZE / 2;
-    double autocorr[MAX_LAG];
-
-    for (size_t lag = 0; lag < MAX_LAG; ++lag) {
-        autocorr[lag] = 0;
-        for (size_t i = 0; i < SPECTRAL_BUFFER_SIZE - lag; ++i) {
-            autocorr[lag] += spectralBuffer[i] * spectralBuffer[i + lag];
-        }
+template<typename T, typename Adaptive>
+void NotchLMSFilter<T, Adaptive>::trackHowls(const real_t* frequencies, const std::size_t count) {
+    real_t candidates[NotchBank<T>::MAX_NOTCHES];
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < count && kept < NotchBank<T>::MAX_NOTCHES; ++i) {
+        if (frequencies[i] >= minFrequency && frequencies[i] <= maxFrequency) candidates[kept++] = frequencies[i];
     }
+    for (NotchBank<T>& bank : notchBank) {
+        bank.track(candidates, std::min(kept, bank.getStageCount()), real_t{1}, howlElapsed);
+    }
+    howlElapsed = 0;
+}
 
-    size_t peakLag = 0;
-    double peakValue = 0;
+/**
+ * @brief Sets the sample rate of the notch banks and of the frequency estimators of every channel.
+ *
+ * The estimators set with setFrequencyEstimator() are given the new rate too.
+ *
+ * @param sampleRate The new sample rate, in Hz.
+ */
+template<typename T, typename Adaptive>
+void NotchLMSFilter<T, Adaptive>::setSampleRate(const real_t sampleRate) {
+    for (std::size_t channel = 0; channel < CHANNELS; ++channel) {
+        notchBank[channel].setSampleRate(sampleRate);
+        defaultEstimator[channel].setSampleRate(sampleRate);
+        if (estimator[channel] != &defaultEstimator[channel]) estimator[channel]->setSampleRate(sampleRate);
+    }
+}
 
-    for (size_t lag = MAX_LAG / 5; lag < MAX_LAG - 1; ++lag) {
-        if (autocorr[lag] > autocorr[lag-1] && autocorr[lag] > autocorr[lag+1] && autocorr[lag] > peakValue) {
-            peakLag = lag;
-            peakValue = autocorr[lag];
-        }
+/**
+ * @brief Sets the estimator that steers the adaptive notch filter of a channel.
+ *
+ * @param newEstimator The new estimator, or nullptr to restore the default SpectralPeakEstimator.
+ * @param channel The channel.
+ */
+template<typename T, typename Adaptive>
+void NotchLMSFilter<T, Adaptive>::setFrequencyEstimator(FrequencyEstimator<real_t>* newEstimator, const std::size_t channel) {
+    estimator[channel] = newEstimator ? newEstimator : &defaultEstimator[channel];
+    estimator[channel]->reset();
+}
+
+/**
+ * @brief Updates the notch frequencies of a channel based on its error and output.
+ *
+ * The strongest peaks of the input are handed to the notch bank on every call, so that the
+ * allocated notches follow their howl and age when it is gone. New notches are only allocated
+ * while the error or the output suggests howling.
+ *
+ * @param channel The channel.
+ * @param error The error signal.
+ * @param output The output signal.
+ */
+template<typename T, typename Adaptive>
+void NotchLMSFilter<T, Adaptive>::updateNotchFrequency(const std::size_t channel, const real_t error, const real_t output) {
+    AFC_PROFILE_SCOPE(ProfileStage::FrequencyEstimation);
+    constexpr real_t errorThreshold{0.05}, outputThreshold{0.7};
+    const bool howling = std::abs(error) > errorThreshold || std::abs(output) > outputThreshold;
+
+    real_t candidates[NotchBank<T>::MAX_NOTCHES];
+    NotchBank<T>& bank = notchBank[channel];
+    const std::size_t count = estimator[channel]->estimatePeaks(minFrequency, maxFrequency, candidates, bank.getStageCount());
+    bank.track(candidates, count, freqUpdateRate, SPECTRAL_BUFFER_SIZE, howling);
+}
+
+/**
+ * @brief Writes the notches of every channel, then the state of the adaptive filter.
+ *
+ * @param writer The writer of the state image.
+ */
+template<typename T, typename Adaptive>
+void NotchLMSFilter<T, Adaptive>::saveState(StateWriter& writer) const {
+    for (const NotchBank<T>& bank : notchBank) {
+        bank.saveState(writer);
     }
+    lmsFilter.saveState(writer);
+}
 
-    if (peakLag > 0) {
-        constexpr double SAMPLE_RATE = AUDIO_SAMPLE_RATE_EXACT;
-        return SAMPLE_RATE / peakLag;
+/**
+ * @brief Reads back the state written by saveState().
+ *
+ * @param reader The reader of the state image.
+ * @return True if the state was read, false otherwise.
+ */
+template<typename T, typename Adaptive>
+bool NotchLMSFilter<T, Adaptive>::loadState(StateReader& reader) {
+    for (NotchBank<T>& bank : notchBank) {
+        if (!bank.loadState(reader)) return false;
     }
+    return lmsFilter.loadState(reader);
+}
 
-    return 0.0;
-}
\ No newline at end of file
+template class NotchLMSFilter<double>;
+template class NotchLMSFilter<float>;
+template class NotchLMSFilter<q15_t>;
+template class NotchLMSFilter<q31_t>;
+template class NotchLMSFilter<double, LMSFilter<double, 2>>;
+template class NotchLMSFilter<float, LMSFilter<float, 2>>;
+template class NotchLMSFilter<q15_t, LMSFilter<q15_t, 2>>;
+template class NotchLMSFilter<q31_t, LMSFilter<q31_t, 2>>;
+template class NotchLMSFilter<double, LMSFilter<double, 4>>;
+template class NotchLMSFilter<float, LMSFilter<float, 4>>;
+template class NotchLMSFilter<q15_t, LMSFilter<q15_t, 4>>;
+template class NotchLMSFilter<q31_t, LMSFilter<q31_t, 4>>;
+template class NotchLMSFilter<double, SelectableLMSFilter<double>>;
+template class NotchLMSFilter<float, SelectableLMSFilter<float>>;
+template class NotchLMSFilter<q15_t, SelectableLMSFilter<q15_t>>;
+template class NotchLMSFilter<q31_t, SelectableLMSFilter<q31_t>>;
+template class NotchLMSFilter<double, SelectableLMSFilter<double, 2>>;
+template class NotchLMSFilter<float, SelectableLMSFilter<float, 2>>;
+template class NotchLMSFilter<q15_t, SelectableLMSFilter<q15_t, 2>>;
+template class NotchLMSFilter<q31_t, SelectableLMSFilter<q31_t, 2>>;
+template class NotchLMSFilter<double, SelectableLMSFilter<double, 4>>;
+template class NotchLMSFilter<float, SelectableLMSFilter<float, 4>>;
+template class NotchLMSFilter<q15_t, SelectableLMSFilter<q15_t, 4>>;
+template class NotchLMSFilter<q31_t, SelectableLMSFilter<q31_t, 4>>;
+template class NotchLMSFilter<double, PartitionedFDAFFilter<double>>;
+template class NotchLMSFilter<float, PartitionedFDAFFilter<float>>;
+template class NotchLMSFilter<double, SubbandCanceller<double>>;
+template class NotchLMSFilter<float, SubbandCanceller<float>>;
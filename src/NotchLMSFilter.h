@@ -1,27 +1,56 @@
 #ifndef NOTCH_LMS_FILTER_H
 #define NOTCH_LMS_FILTER_H
 
-#include "NotchFilter.h"
+#include "NotchBank.h"
 #include "LMSFilter.h"
+#include "PartitionedFDAFFilter.h"
+#include "SelectableLMSFilter.h"
+#include "SpectralPeakEstimator.h"
+#include "SubbandCanceller.h"
 #include <cstddef>
+#include <type_traits>
 
 /**
- * @brief The NotchLMSFilter class combines a notch filter and an LMS filter.
+ * @brief The NotchLMSFilter class combines a bank of notch filters and an LMS filter.
  *
- * This class provides functionality to apply a notch filter and an LMS filter
+ * This class provides functionality to apply notch filters and an LMS filter
  * to an input signal. It allows for adaptive filtering and provides methods
  * to configure the filters.
+ *
+ * The adaptive filter is LMSFilter by default, or SelectableLMSFilter to switch its adaptation
+ * algorithm at runtime. PartitionedFDAFFilter or SubbandCanceller can be used instead for long
+ * feedback paths. The notches live in a NotchBank; notch 0 starts at the initial
+ * center frequency and, with the adaptive notch enabled, the bank allocates and releases up
+ * to getNotchCount() notches on the howl frequencies reported by a FrequencyEstimator, a
+ * SpectralPeakEstimator by default.
+ *
+ * With a multichannel LMSFilter as the adaptive filter, each channel has its own notch bank,
+ * estimator and adaptive filter state, and the channels are processed together, block by block.
+ *
+ * Blocks of any length are processed; the frequencies are estimated every SPECTRAL_BUFFER_SIZE
+ * samples whatever the block length, and in Hz at the sample rate given to the constructor or to
+ * setSampleRate().
+ *
+ * @tparam T The sample and coefficient type (double, float, q15_t or q31_t).
+ * @tparam Adaptive The adaptive filter type (LMSFilter<T, Channels>, SelectableLMSFilter<T, Channels>, PartitionedFDAFFilter<T> or SubbandCanceller<T>).
  */
+template<typename T, typename Adaptive = LMSFilter<T>>
 class NotchLMSFilter final {
 public:
+    using Traits = SampleTraits<T>; ///< Arithmetic of the sample type.
+    using real_t = typename Traits::real_t; ///< Type used for frequencies and adaptation control.
+
+    static constexpr std::size_t CHANNELS = Adaptive::CHANNELS; ///< Number of channels.
+
     /**
      * @brief Constructs a NotchLMSFilter object.
      *
      * @param order The order of the filter.
      * @param initialCenterFreq The initial center frequency of the notch filter.
      * @param initialBandwidth The initial bandwidth of the notch filter.
+     * @param sampleRate The sample rate, in Hz (default is AUDIO_SAMPLE_RATE_EXACT).
      */
-    NotchLMSFilter(std::size_t order, double initialCenterFreq, double initialBandwidth);
+    NotchLMSFilter(std::size_t order, real_t initialCenterFreq, real_t initialBandwidth, real_t sampleRate = AUDIO_SAMPLE_RATE_EXACT);
 
     /**
      * @brief Destroys the NotchLMSFilter object.
@@ -29,70 +58,118 @@ public:
     ~NotchLMSFilter();
     
     /**
-     * @brief Processes an input sample and returns the filtered output.
+     * @brief Processes an input sample of a single-channel filter and returns the filtered output.
      *
      * @param inputSample The input sample to be filtered.
      * @return The filtered output sample.
      */
-    double tick(double inputSample);
+    template<std::size_t C = CHANNELS, std::enable_if_t<C == 1, int> = 0>
+    T tick(const T inputSample) {
+        T outputSample;
+        processBlock(&inputSample, &outputSample, 1);
+        return outputSample;
+    }
 
     /**
-     * @brief Sets the adaptation rate (mu) for the LMS filter.
+     * @brief Processes a block of input samples of a single-channel filter and writes the filtered output.
      *
-     * @param newMu The new adaptation rate.
+     * The input and output buffers may alias.
+     *
+     * @param input The input samples to be filtered.
+     * @param output The filtered output samples.
+     * @param n The number of samples in the block.
      */
-    void setMu(const double newMu) { lmsFilter.setMu(newMu); }
+    template<std::size_t C = CHANNELS, std::enable_if_t<C == 1, int> = 0>
+    void processBlock(const T* input, T* output, const std::size_t n) { processBlock(&input, &output, n); }
 
     /**
-     * @brief Gets the current adaptation rate (mu) of the LMS filter.
+     * @brief Processes a block of input samples of every channel and writes the filtered output.
      *
-     * @return The current adaptation rate.
+     * The input and output buffers of a channel may alias.
+     *
+     * @param input The input samples to be filtered, one buffer per channel.
+     * @param output The filtered output samples, one buffer per channel.
+     * @param n The number of samples in the block.
      */
-    [[nodiscard]] double getMu() const { return lmsFilter.getMu(); }
+    void processBlock(const T* const* input, T* const* output, std::size_t n);
 
-#ifdef LEAKAGE
     /**
-     * @brief Sets the leakage factor for the LMS filter.
+     * @brief Sets the adaptation rate (mu) of the LMS filter of every channel.
      *
-     * @param newLeakage The new leakage factor.
+     * @param newMu The new adaptation rate.
      */
-    void setLeakage(double newLeakage) { lmsFilter.setLeakage(newLeakage); }
+    void setMu(const real_t newMu) { lmsFilter.setMu(newMu); }
 
     /**
-     * @brief Gets the current leakage factor of the LMS filter.
+     * @brief Gets the current adaptation rate (mu) of the LMS filter of a channel.
      *
-     * @return The current leakage factor.
+     * @param channel The channel (default is 0).
+     * @return The current adaptation rate.
      */
-    [[nodiscard]] double getLeakage() const { return lmsFilter.getLeakage(); }
-#endif
+    [[nodiscard]] real_t getMu(const std::size_t channel = 0) const { return lmsFilter.getMu(channel); }
+
+    /**
+     * @brief Gets the adaptation rate (mu) requested for the LMS filter.
+     *
+     * @return The requested adaptation rate.
+     */
+    [[nodiscard]] real_t getRequestedMu() const { return lmsFilter.getRequestedMu(); }
 
     /**
-     * @brief Sets the center frequency of the notch filter.
+     * @brief Sets the center frequency of notch 0 of every channel, allocating it if it was released.
      *
      * @param frequency The new center frequency.
      */
-    void setNotchFrequency(double frequency);
+    void setNotchFrequency(real_t frequency);
 
     /**
-     * @brief Gets the current center frequency of the notch filter.
+     * @brief Gets the current center frequency of notch 0 of a channel.
      *
+     * @param channel The channel (default is 0).
      * @return The current center frequency.
      */
-    [[nodiscard]] double getNotchFrequency() const { return notchFilter.getCenterFrequency(); }
+    [[nodiscard]] real_t getNotchFrequency(const std::size_t channel = 0) const { return notchBank[channel].getFrequency(0); }
 
     /**
-     * @brief Sets the bandwidth of the notch filter.
+     * @brief Sets the bandwidth of notch 0 of every channel, allocating it if it was released.
      *
      * @param bandwidth The new bandwidth.
      */
-    void setNotchBandwidth(double bandwidth);
+    void setNotchBandwidth(real_t bandwidth);
 
     /**
-     * @brief Gets the current bandwidth of the notch filter.
+     * @brief Gets the current bandwidth of notch 0 of a channel.
      *
+     * @param channel The channel (default is 0).
      * @return The current bandwidth.
      */
-    [[nodiscard]] double getNotchBandwidth() const { return notchFilter.getBandwidth(); }
+    [[nodiscard]] real_t getNotchBandwidth(const std::size_t channel = 0) const { return notchBank[channel].getBandwidth(0); }
+
+    /**
+     * @brief Sets the maximum number of notches the adaptive notch can allocate on every channel.
+     *
+     * @param count The new number of notches, between 1 and NotchBank<T>::MAX_NOTCHES.
+     */
+    void setNotchCount(const std::size_t count) {
+        for (NotchBank<T>& bank : notchBank) {
+            bank.setStageCount(count);
+        }
+    }
+
+    /**
+     * @brief Gets the maximum number of notches the adaptive notch can allocate on each channel.
+     *
+     * @return The number of notches.
+     */
+    [[nodiscard]] std::size_t getNotchCount() const { return notchBank[0].getStageCount(); }
+
+    /**
+     * @brief Gets the notch bank of a channel, to read the state of each notch.
+     *
+     * @param channel The channel (default is 0).
+     * @return The notch bank.
+     */
+    [[nodiscard]] const NotchBank<T>& getNotchBank(const std::size_t channel = 0) const { return notchBank[channel]; }
 
     /**
      * @brief Enables or disables the notch filter.
@@ -125,9 +202,12 @@ public:
     /**
      * @brief Enables or disables the adaptive notch filter.
      *
+     * While it is disabled, the frequency estimators are neither fed nor run, and the notches only
+     * move when trackHowls() is called. They are reset when it is enabled again.
+     *
      * @param enable True to enable, false to disable.
      */
-    void enableAdaptiveNotch(const bool enable) { adaptiveNotchEnabled = enable; }
+    void enableAdaptiveNotch(bool enable);
 
     /**
      * @brief Checks if the adaptive notch filter is enabled.
@@ -142,47 +222,133 @@ public:
      * @param minFreq The minimum frequency limit.
      * @param maxFreq The maximum frequency limit.
      */
-    void setFrequencyLimits(const double minFreq, const double maxFreq) {
+    void setFrequencyLimits(const real_t minFreq, const real_t maxFreq) {
         minFrequency = minFreq;
         maxFrequency = maxFreq;
     }
 
+    /**
+     * @brief Sets the rate at which the adaptive notches move toward the estimated howl frequencies.
+     *
+     * @param rate The fraction of the distance to the estimate a notch moves by at each estimate.
+     */
+    void setFrequencyUpdateRate(const real_t rate) { freqUpdateRate = rate; }
+
+    /**
+     * @brief Gets the rate at which the adaptive notches move toward the estimated howl frequencies.
+     *
+     * @return The fraction of the distance to the estimate a notch moves by at each estimate.
+     */
+    [[nodiscard]] real_t getFrequencyUpdateRate() const { return freqUpdateRate; }
+
+    /**
+     * @brief Tracks howl frequencies found outside the filter, such as by a HowlDetector.
+     *
+     * The notch bank of every channel allocates, moves and releases its notches from the
+     * frequencies as it does from an estimate, except that the notches jump to their frequency
+     * instead of moving toward it, and the notches age by the samples processed since the previous
+     * call, whatever the rate of the calls. Meant to be used with the adaptive notch disabled, so that the
+     * frequency estimators do not steer the same notches.
+     *
+     * @param frequencies The howl frequencies in Hz, loudest first.
+     * @param count The number of frequencies.
+     */
+    void trackHowls(const real_t* frequencies, std::size_t count);
+
+    /**
+     * @brief Sets the sample rate of the notch banks and of the frequency estimators of every channel.
+     *
+     * The notches keep their frequencies and bandwidths in Hz, and the estimators are reset.
+     *
+     * @param sampleRate The new sample rate, in Hz.
+     */
+    void setSampleRate(real_t sampleRate);
+
+    /**
+     * @brief Gets the sample rate.
+     *
+     * @return The sample rate, in Hz.
+     */
+    [[nodiscard]] real_t getSampleRate() const { return notchBank[0].getSampleRate(); }
+
+    /**
+     * @brief Sets the estimator that steers the adaptive notch filter of a channel.
+     *
+     * The estimator is not owned and must outlive the filter. It is reset before use.
+     *
+     * @param newEstimator The new estimator, or nullptr to restore the default SpectralPeakEstimator.
+     * @param channel The channel (default is 0).
+     */
+    void setFrequencyEstimator(FrequencyEstimator<real_t>* newEstimator, std::size_t channel = 0);
+
+    /**
+     * @brief Gets the estimator that steers the adaptive notch filter of a channel.
+     *
+     * @param channel The channel (default is 0).
+     * @return The current estimator.
+     */
+    [[nodiscard]] FrequencyEstimator<real_t>& getFrequencyEstimator(const std::size_t channel = 0) { return *estimator[channel]; }
+
     /**
      * @brief Resets the LMS filter.
      */
     void LMSReset() { lmsFilter.reset(); }
 
+    /**
+     * @brief Gets the adaptive filter, to configure the settings that are specific to its type.
+     *
+     * @return The adaptive filter.
+     */
+    [[nodiscard]] Adaptive& getAdaptiveFilter() { return lmsFilter; }
+
+    /**
+     * @brief Writes the notches of every channel, then the state of the adaptive filter.
+     *
+     * @param writer The writer of the state image.
+     */
+    void saveState(StateWriter& writer) const;
+
+    /**
+     * @brief Reads back the state written by saveState().
+     *
+     * The enable flags, the frequency limits and the estimators are settings and are kept.
+     *
+     * @param reader The reader of the state image.
+     * @return True if the state was read, false otherwise.
+     */
+    bool loadState(StateReader& reader);
+
 private:
-    NotchFilter notchFilter; ///< The notch filter instance.
-    LMSFilter lmsFilter; ///< The LMS filter instance.
+    NotchBank<T> notchBank[CHANNELS]; ///< The notch filter bank of each channel.
+    Adaptive lmsFilter; ///< The adaptive filter instance.
 
     bool notchEnabled{true}; ///< Flag indicating if the notch filter is enabled.
     bool lmsEnabled{true}; ///< Flag indicating if the LMS filter is enabled.
     bool adaptiveNotchEnabled{true}; ///< Flag indicating if the adaptive notch filter is enabled.
 
-    double minFrequency{100.0}; ///< Minimum frequency limit for the adaptive notch filter.
-    double maxFrequency{8000.0}; ///< Maximum frequency limit for the adaptive notch filter.
+    real_t minFrequency{100.0}; ///< Minimum frequency limit for the adaptive notch filter.
+    real_t maxFrequency{8000.0}; ///< Maximum frequency limit for the adaptive notch filter.
+
+    real_t freqUpdateRate{0.01}; ///< Frequency update rate for the adaptive notch filter.
 
-    double freqUpdateRate{0.01}; ///< Frequency update rate for the adaptive notch filter.
+    static constexpr size_t SPECTRAL_BUFFER_SIZE = 128; ///< Number of samples between two frequency estimates.
+    real_t spectralBuffer[CHANNELS][SPECTRAL_BUFFER_SIZE]{}; ///< Input samples of each channel fed to its frequency estimator.
+    size_t spectralBufferIndex{0}; ///< Current index in the spectral buffers, shared by the channels.
+    size_t howlElapsed{0}; ///< Number of samples processed since the last call to trackHowls().
 
-    static constexpr size_t SPECTRAL_BUFFER_SIZE = 128; ///< Size of the spectral buffer.
-    double spectralBuffer[SPECTRAL_BUFFER_SIZE]{}; ///< Buffer for storing spectral data.
-    size_t spectralBufferIndex{0}; ///< Current index in the spectral buffer.
+    SpectralPeakEstimator<real_t> defaultEstimator[CHANNELS]; ///< The estimator of each channel used when none is set.
+    FrequencyEstimator<real_t>* estimator[CHANNELS]; ///< The estimator steering the adaptive notch of each channel.
+
+    T notchBuffer[CHANNELS][SPECTRAL_BUFFER_SIZE]{}; ///< Notch filter output of each channel for the block being processed.
 
     /**
-     * @brief Updates the notch filter frequency based on the error and output.
+     * @brief Updates the notch frequencies of a channel based on its error and output.
      *
+     * @param channel The channel.
      * @param error The error signal.
      * @param output The output signal.
      */
-    void updateNotchFrequency(double error, double output);
-
-    /**
-     * @brief Estimates the dominant frequency in the spectral buffer.
-     *
-     * @return The estimated dominant frequency.
-     */
-    [[nodiscard]] double estimateDominantFrequency() const;
+    void updateNotchFrequency(std::size_t channel, real_t error, real_t output);
 };
 
 #endif
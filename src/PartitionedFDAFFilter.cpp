@@ -0,0 +1,273 @@
+#include "PartitionedFDAFFilter.h"
+#include <algorithm>
+
+/**
+ * @brief Constructs a PartitionedFDAFFilter object.
+ *
+ * @param order The minimum number of taps of the filter, rounded up to a multiple of blockSize.
+ * @param mu The normalized adaptation rate, between 0 and 1.
+ * @param blockSize The number of taps of a partition, a power of two.
+ */
+template<typename T>
+PartitionedFDAFFilter<T>::PartitionedFDAFFilter(const std::size_t order, const real_t mu, const std::size_t blockSize)
+    : blockSize(blockSize),
+      partitionCount((order + blockSize - 1) / blockSize),
+      binCount(blockSize + 1),
+      mu(mu),
+      regularization(static_cast<real_t>(1e-6) * static_cast<real_t>(blockSize)),
+      fft(2 * blockSize) {
+    timeBuffer = new T[2 * blockSize];
+    scratch = new T[2 * blockSize];
+    spectra = new complex_t[partitionCount * binCount];
+    weights = new complex_t[partitionCount * binCount];
+    workSpectrum = new complex_t[binCount];
+    binPower = new real_t[binCount];
+    fifoReference = new T[blockSize];
+    fifoDesired = new T[blockSize];
+    fifoError = new T[blockSize];
+
+    reset();
+}
+
+/**
+ * @brief Destroys the PartitionedFDAFFilter object and releases allocated resources.
+ */
+template<typename T>
+PartitionedFDAFFilter<T>::~PartitionedFDAFFilter() {
+    delete[] timeBuffer;
+    delete[] scratch;
+    delete[] spectra;
+    delete[] weights;
+    delete[] workSpectrum;
+    delete[] binPower;
+    delete[] fifoReference;
+    delete[] fifoDesired;
+    delete[] fifoError;
+}
+
+/**
+ * @brief Resets the filter weights and history.
+ */
+template<typename T>
+void PartitionedFDAFFilter<T>::reset() {
+    std::fill(timeBuffer, timeBuffer + 2 * blockSize, T{});
+    std::fill(spectra, spectra + partitionCount * binCount, complex_t{});
+    std::fill(weights, weights + partitionCount * binCount, complex_t{});
+    std::fill(binPower, binPower + binCount, real_t{});
+    std::fill(fifoError, fifoError + blockSize, T{});
+    powerInitialized = false;
+    newest = 0;
+    constrainedPartition = 0;
+    fifoFill = 0;
+}
+
+/**
+ * @brief Processes one block of blockSize samples.
+ *
+ * @param reference The reference samples.
+ * @param desired The desired samples.
+ * @param error The error samples.
+ */
+template<typename T>
+void PartitionedFDAFFilter<T>::processPartitionBlock(const T* reference, const T* desired, T* error) {
+    std::copy(timeBuffer + blockSize, timeBuffer + 2 * blockSize, timeBuffer);
+    std::copy(reference, reference + blockSize, timeBuffer + blockSize);
+
+    newest = (newest == 0 ? partitionCount : newest) - 1;
+    complex_t* newestSpectrum = spectra + newest * binCount;
+    fft.forward(timeBuffer, newestSpectrum);
+
+    std::fill(workSpectrum, workSpectrum + binCount, complex_t{});
+    for (std::size_t p = 0; p < partitionCount; ++p) {
+        const complex_t* x = spectra + ((newest + p) % partitionCount) * binCount;
+        const complex_t* w = weights + p * binCount;
+        for (std::size_t k = 0; k < binCount; ++k) {
+            workSpectrum[k] += w[k] * x[k];
+        }
+    }
+    fft.inverse(workSpectrum, scratch);
+
+    for (std::size_t i = 0; i < blockSize; ++i) {
+        error[i] = desired[i] - scratch[blockSize + i];
+    }
+
+    std::fill(scratch, scratch + blockSize, T{});
+    std::copy(error, error + blockSize, scratch + blockSize);
+    fft.forward(scratch, workSpectrum);
+
+    // The weights of all partitions see the same input power, so the step is normalized by their total.
+    const real_t smoothing = powerInitialized ? powerSmoothing : real_t{0};
+    const auto partitions = static_cast<real_t>(partitionCount);
+    for (std::size_t k = 0; k < binCount; ++k) {
+        binPower[k] = smoothing * binPower[k] + (real_t{1} - smoothing) * std::norm(newestSpectrum[k]);
+        workSpectrum[k] *= mu / (partitions * binPower[k] + regularization);
+    }
+    powerInitialized = true;
+
+    for (std::size_t p = 0; p < partitionCount; ++p) {
+        const complex_t* x = spectra + ((newest + p) % partitionCount) * binCount;
+        complex_t* w = weights + p * binCount;
+        for (std::size_t k = 0; k < binCount; ++k) {
+            w[k] += std::conj(x[k]) * workSpectrum[k];
+        }
+    }
+
+    // Keep the partition causal: its impulse response must fit in the first blockSize taps.
+    complex_t* constrained = weights + constrainedPartition * binCount;
+    fft.inverse(constrained, scratch);
+    std::fill(scratch + blockSize, scratch + 2 * blockSize, T{});
+    fft.forward(scratch, constrained);
+    constrainedPartition = (constrainedPartition + 1) % partitionCount;
+}
+
+/**
+ * @brief Processes a block of reference samples against separate desired samples.
+ *
+ * @param reference The reference samples.
+ * @param desired The desired samples.
+ * @param error The error samples.
+ * @param n The number of samples in the block.
+ */
+template<typename T>
+void PartitionedFDAFFilter<T>::processBlock(const T* reference, const T* desired, T* error, const std::size_t n) {
+    std::size_t i = 0;
+    while (i < n) {
+        if (fifoFill == 0 && n - i >= blockSize) {
+            processPartitionBlock(reference + i, desired + i, error + i);
+            i += blockSize;
+            continue;
+        }
+
+        fifoReference[fifoFill] = reference[i];
+        fifoDesired[fifoFill] = desired[i];
+        const T delayedError = fifoError[fifoFill];
+        if (++fifoFill == blockSize) {
+            processPartitionBlock(fifoReference, fifoDesired, fifoError);
+            fifoFill = 0;
+        }
+        error[i] = delayedError;
+        ++i;
+    }
+}
+
+/**
+ * @brief Processes a block of input samples and writes the filtered output.
+ *
+ * @param in The input samples to be filtered.
+ * @param out The filtered output samples.
+ * @param n The number of samples in the block.
+ */
+template<typename T>
+void PartitionedFDAFFilter<T>::processBlock(const T* in, T* out, const std::size_t n) {
+    processBlock(in, in, out, n);
+}
+
+/**
+ * @brief Processes a reference sample against a separate desired sample and returns the error.
+ *
+ * @param reference The reference sample.
+ * @param desired The desired sample.
+ * @return The error sample, delayed by blockSize samples.
+ */
+template<typename T>
+T PartitionedFDAFFilter<T>::tick(const T reference, const T desired) {
+    T error{};
+    processBlock(&reference, &desired, &error, 1);
+    return error;
+}
+
+/**
+ * @brief Processes an input sample and returns the filtered output.
+ *
+ * @param micSample The input sample to be filtered.
+ * @return The filtered output sample, delayed by blockSize samples.
+ */
+template<typename T>
+T PartitionedFDAFFilter<T>::tick(const T micSample) {
+    return tick(micSample, micSample);
+}
+
+/**
+ * @brief Gets the impulse response of the filter.
+ *
+ * @param impulseResponse The getOrder() output taps.
+ */
+template<typename T>
+void PartitionedFDAFFilter<T>::getImpulseResponse(T* impulseResponse) {
+    getImpulseResponse(impulseResponse, getOrder());
+}
+
+/**
+ * @brief Gets the first taps of the impulse response of the filter.
+ *
+ * @param impulseResponse The output taps.
+ * @param count The number of taps to read, at most getOrder().
+ * @param channel The channel, always 0.
+ */
+template<typename T>
+void PartitionedFDAFFilter<T>::getImpulseResponse(T* impulseResponse, const std::size_t count, std::size_t) {
+    for (std::size_t p = 0; p * blockSize < count; ++p) {
+        fft.inverse(weights + p * binCount, scratch);
+        std::copy(scratch, scratch + std::min(blockSize, count - p * blockSize), impulseResponse + p * blockSize);
+    }
+}
+
+/**
+ * @brief Writes the weights, the reference spectra, the bin power estimates and the buffered samples.
+ *
+ * @param writer The writer of the state image.
+ */
+template<typename T>
+void PartitionedFDAFFilter<T>::saveState(StateWriter& writer) const {
+    writer.writeSize(blockSize);
+    writer.writeSize(partitionCount);
+    writer.write(weights, partitionCount * binCount);
+    writer.write(spectra, partitionCount * binCount);
+    writer.writeSize(newest);
+    writer.writeSize(constrainedPartition);
+    writer.write(binPower, binCount);
+    writer.write(static_cast<std::uint8_t>(powerInitialized));
+    writer.write(timeBuffer, 2 * blockSize);
+    writer.write(fifoReference, blockSize);
+    writer.write(fifoDesired, blockSize);
+    writer.write(fifoError, blockSize);
+    writer.writeSize(fifoFill);
+}
+
+/**
+ * @brief Reads back the state written by saveState() from a filter of the same block size and number of partitions.
+ *
+ * @param reader The reader of the state image.
+ * @return True if the state was read, false otherwise.
+ */
+template<typename T>
+bool PartitionedFDAFFilter<T>::loadState(StateReader& reader) {
+    std::size_t savedBlockSize{0}, savedPartitions{0};
+    reader.readSize(savedBlockSize);
+    reader.readSize(savedPartitions);
+    if (!reader.ok() || savedBlockSize != blockSize || savedPartitions != partitionCount) return false;
+
+    std::size_t savedNewest{0}, savedConstrained{0}, savedFill{0};
+    std::uint8_t savedInitialized{0};
+    reader.read(weights, partitionCount * binCount);
+    reader.read(spectra, partitionCount * binCount);
+    reader.readSize(savedNewest);
+    reader.readSize(savedConstrained);
+    reader.read(binPower, binCount);
+    reader.read(savedInitialized);
+    reader.read(timeBuffer, 2 * blockSize);
+    reader.read(fifoReference, blockSize);
+    reader.read(fifoDesired, blockSize);
+    reader.read(fifoError, blockSize);
+    reader.readSize(savedFill);
+    if (!reader.ok() || savedNewest >= partitionCount || savedConstrained >= partitionCount || savedFill >= blockSize) return false;
+
+    newest = savedNewest;
+    constrainedPartition = savedConstrained;
+    powerInitialized = savedInitialized != 0;
+    fifoFill = savedFill;
+    return true;
+}
+
+template class PartitionedFDAFFilter<double>;
+template class PartitionedFDAFFilter<float>;
@@ -0,0 +1,222 @@
+#ifndef PARTITIONED_FDAF_FILTER_H
+#define PARTITIONED_FDAF_FILTER_H
+
+#include <Audio.h>
+#include "FFT.h"
+#include "StateImage.h"
+#include <complex>
+#include <cstddef>
+
+/**
+ * @brief The PartitionedFDAFFilter class implements a partitioned-block frequency-domain adaptive filter.
+ *
+ * The filter is split into partitions of blockSize taps. Each block of input is transformed once
+ * with an overlap-save FFT of size 2 * blockSize, the output is the sum of the partition weights
+ * times the spectra of the most recent input blocks, and the weights are updated in the frequency
+ * domain with a step size normalized per bin by a running estimate of the input power of all
+ * partitions, which keeps it stable for 0 < mu < 1 whatever the number of partitions. The gradient
+ * constraint is applied to one partition per block, in turn.
+ *
+ * The cost per sample is O(log(blockSize) + order / blockSize) instead of the O(order) of LMSFilter,
+ * which makes filters of several thousand taps affordable. It offers the same interface as LMSFilter
+ * so it can be used as the adaptive filter of NotchLMSFilter.
+ *
+ * Blocks whose length is a multiple of blockSize are processed without added latency. Other block
+ * lengths, including tick(), go through an internal buffer that delays the output by blockSize samples.
+ *
+ * @tparam T The sample type (float or double).
+ */
+template<typename T>
+class PartitionedFDAFFilter final {
+public:
+    using real_t = T; ///< Type used for the adaptation control logic.
+    using complex_t = std::complex<T>; ///< Complex type of the spectra.
+
+    static constexpr std::size_t CHANNELS = 1; ///< Number of channels filtered.
+
+    /**
+     * @brief Constructs a PartitionedFDAFFilter object.
+     *
+     * @param order The minimum number of taps of the filter, rounded up to a multiple of blockSize.
+     * @param mu The normalized adaptation rate, between 0 and 1 (default is 0.5).
+     * @param blockSize The number of taps of a partition, a power of two (default is AUDIO_BLOCK_SAMPLES, so audio blocks add no latency).
+     */
+    explicit PartitionedFDAFFilter(std::size_t order, real_t mu = 0.5, std::size_t blockSize = AUDIO_BLOCK_SAMPLES);
+
+    /**
+     * @brief Destroys the PartitionedFDAFFilter object.
+     */
+    ~PartitionedFDAFFilter();
+
+    PartitionedFDAFFilter(const PartitionedFDAFFilter&) = delete;
+    PartitionedFDAFFilter& operator=(const PartitionedFDAFFilter&) = delete;
+
+    /**
+     * @brief Processes an input sample and returns the filtered output.
+     *
+     * @param micSample The input sample to be filtered.
+     * @return The filtered output sample, delayed by blockSize samples.
+     */
+    T tick(T micSample);
+
+    /**
+     * @brief Processes a reference sample against a separate desired sample and returns the error.
+     *
+     * @param reference The reference sample.
+     * @param desired The desired sample.
+     * @return The error sample, delayed by blockSize samples.
+     */
+    T tick(T reference, T desired);
+
+    /**
+     * @brief Processes a block of input samples and writes the filtered output.
+     *
+     * The input and output buffers may alias.
+     *
+     * @param in The input samples to be filtered.
+     * @param out The filtered output samples.
+     * @param n The number of samples in the block.
+     */
+    void processBlock(const T* in, T* out, std::size_t n);
+
+    /**
+     * @brief Processes a block of reference samples against separate desired samples.
+     *
+     * The buffers may alias.
+     *
+     * @param reference The reference samples.
+     * @param desired The desired samples.
+     * @param error The error samples.
+     * @param n The number of samples in the block.
+     */
+    void processBlock(const T* reference, const T* desired, T* error, std::size_t n);
+
+    /**
+     * @brief Processes a block of input samples given as one buffer per channel.
+     *
+     * This is the interface of the multichannel LMSFilter, with a single channel.
+     *
+     * @param in The input samples to be filtered, one buffer.
+     * @param out The filtered output samples, one buffer.
+     * @param n The number of samples in the block.
+     */
+    void processBlock(const T* const* in, T* const* out, const std::size_t n) { processBlock(in[0], out[0], n); }
+
+    /**
+     * @brief Resets the filter weights and history.
+     */
+    void reset();
+
+    /**
+     * @brief Sets the normalized adaptation rate (mu).
+     *
+     * @param newMu The new adaptation rate.
+     */
+    void setMu(const real_t newMu) { mu = newMu; }
+
+    /**
+     * @brief Gets the normalized adaptation rate (mu).
+     *
+     * @return The current adaptation rate.
+     */
+    [[nodiscard]] real_t getMu(std::size_t = 0) const { return mu; }
+
+    /**
+     * @brief Gets the normalized adaptation rate (mu) set by setMu().
+     *
+     * @return The normalized adaptation rate.
+     */
+    [[nodiscard]] real_t getRequestedMu() const { return mu; }
+
+    /**
+     * @brief Gets the leakage factor (gamma) applied to the weights, always 1 as the weights do not leak.
+     *
+     * @return 1.
+     */
+    [[nodiscard]] static real_t getGamma(std::size_t = 0) { return real_t{1}; }
+
+    /**
+     * @brief Gets the number of taps of the filter.
+     *
+     * @return The number of taps.
+     */
+    [[nodiscard]] std::size_t getOrder() const { return blockSize * partitionCount; }
+
+    /**
+     * @brief Gets the number of taps of a partition.
+     *
+     * @return The partition size.
+     */
+    [[nodiscard]] std::size_t getBlockSize() const { return blockSize; }
+
+    /**
+     * @brief Gets the impulse response of the filter.
+     *
+     * @param impulseResponse The getOrder() output taps.
+     */
+    void getImpulseResponse(T* impulseResponse);
+
+    /**
+     * @brief Gets the first taps of the impulse response of the filter.
+     *
+     * Only the partitions holding these taps are transformed back to the time domain.
+     *
+     * @param impulseResponse The output taps.
+     * @param count The number of taps to read, at most getOrder().
+     * @param channel The channel, always 0.
+     */
+    void getImpulseResponse(T* impulseResponse, std::size_t count, std::size_t channel = 0);
+
+    /**
+     * @brief Writes the weights, the reference spectra, the bin power estimates and the buffered samples.
+     *
+     * @param writer The writer of the state image.
+     */
+    void saveState(StateWriter& writer) const;
+
+    /**
+     * @brief Reads back the state written by saveState() from a filter of the same block size and number of partitions.
+     *
+     * The adaptation rate is a setting and is kept.
+     *
+     * @param reader The reader of the state image.
+     * @return True if the state was read, false otherwise.
+     */
+    bool loadState(StateReader& reader);
+
+private:
+    std::size_t blockSize; ///< The number of taps of a partition.
+    std::size_t partitionCount; ///< The number of partitions.
+    std::size_t binCount; ///< The number of bins of a spectrum.
+    real_t mu; ///< The normalized adaptation rate.
+    real_t powerSmoothing{0.9}; ///< Forgetting factor of the per-bin power estimate.
+    real_t regularization; ///< Regularization added to the per-bin power estimate.
+
+    FFT<T> fft; ///< Transform of size 2 * blockSize.
+
+    T* timeBuffer; ///< The previous and the current reference block.
+    T* scratch; ///< Working buffer of 2 * blockSize samples.
+    complex_t* spectra; ///< Ring of the partitionCount most recent reference spectra.
+    complex_t* weights; ///< Frequency-domain weights, one spectrum per partition.
+    complex_t* workSpectrum; ///< Working spectrum.
+    real_t* binPower; ///< Running power estimate of each bin of the reference.
+    bool powerInitialized{false}; ///< Flag indicating if binPower holds an estimate.
+    std::size_t newest{0}; ///< Index of the most recent spectrum in the ring.
+    std::size_t constrainedPartition{0}; ///< Partition whose gradient constraint is applied next.
+
+    T* fifoReference; ///< Buffered reference samples of an incomplete block.
+    T* fifoDesired; ///< Buffered desired samples of an incomplete block.
+    T* fifoError; ///< Error samples of the last buffered block.
+    std::size_t fifoFill{0}; ///< Number of buffered samples.
+
+    /**
+     * @brief Processes one block of blockSize samples.
+     *
+     * @param reference The reference samples.
+     * @param desired The desired samples.
+     * @param error The error samples.
+     */
+    void processPartitionBlock(const T* reference, const T* desired, T* error);
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "Profiler.h"
+#include <algorithm>
+
+std::uint32_t Profiler::blockCycles[STAGES]{};
+bool Profiler::ran[STAGES]{};
+ProfileStats Profiler::stats[STAGES]{};
+
+/**
+ * @brief Enables the cycle counter, which the Teensy startup code already does.
+ */
+void Profiler::begin() {
+#if defined(__ARM_ARCH_7EM__)
+    *reinterpret_cast<volatile std::uint32_t*>(0xE000EDFC) |= 1u << 24; // DEMCR.TRCENA
+    *reinterpret_cast<volatile std::uint32_t*>(0xE0001000) |= 1u; // DWT_CTRL.CYCCNTENA
+#endif
+    reset();
+}
+
+/**
+ * @brief Adds cycles to a stage, for the current block.
+ *
+ * @param stage The stage.
+ * @param cycles The cycles spent.
+ */
+void Profiler::add(const ProfileStage stage, const std::uint32_t cycles) {
+    const auto i = static_cast<std::size_t>(stage);
+    blockCycles[i] += cycles;
+    ran[i] = true;
+}
+
+/**
+ * @brief Folds the cycles of the current block into the statistics of the stages that ran.
+ */
+void Profiler::endBlock() {
+    for (std::size_t i = 0; i < STAGES; ++i) {
+        if (!ran[i]) continue;
+
+        const std::uint32_t cycles = blockCycles[i];
+        ProfileStats& stage = stats[i];
+        stage.min = stage.blocks == 0 ? cycles : std::min(stage.min, cycles);
+        stage.max = std::max(stage.max, cycles);
+        stage.total += cycles;
+        stage.blocks++;
+
+        std::size_t bucket = 0;
+        for (std::uint32_t c = cycles; c > 1; c >>= 1) bucket++;
+        stage.histogram[bucket]++;
+
+        blockCycles[i] = 0;
+        ran[i] = false;
+    }
+}
+
+/**
+ * @brief Copies the statistics of a stage.
+ *
+ * @param stage The stage.
+ * @param stats The statistics.
+ */
+void Profiler::snapshot(const ProfileStage stage, ProfileStats& stats) {
+    stats = Profiler::stats[static_cast<std::size_t>(stage)];
+}
+
+/**
+ * @brief Clears the statistics of all the stages.
+ */
+void Profiler::reset() {
+    std::fill(stats, stats + STAGES, ProfileStats{});
+}
+
+/**
+ * @brief Gets the name of a stage.
+ *
+ * @param stage The stage.
+ * @return The name, in upper case.
+ */
+const char* Profiler::name(const ProfileStage stage) {
+    switch (stage) {
+        case ProfileStage::Update: return "UPDATE";
+        case ProfileStage::Notch: return "NOTCH";
+        case ProfileStage::Adaptive: return "ADAPTIVE";
+        case ProfileStage::NoiseParameters: return "NOISE";
+        case ProfileStage::FrequencyEstimation: return "FREQUENCY";
+        case ProfileStage::Count: break;
+    }
+    return "UNKNOWN";
+}
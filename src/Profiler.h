@@ -0,0 +1,180 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(__ARM_ARCH_7EM__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#elif !defined(__ARM_ARCH_7EM__)
+#include <chrono>
+#endif
+
+/**
+ * @file Profiler.h
+ * @brief Cycle-accurate profiling of the stages of the audio processing.
+ *
+ * Define AFC_PROFILE when building to enable it. The stages are timed with the DWT cycle
+ * counter of the Cortex-M7, the time-stamp counter on x86 hosts, or the steady clock in
+ * nanoseconds elsewhere. The time a stage takes within one audio block is summed, and at the
+ * end of the block the sum is folded into the statistics of the stage: minimum, mean, maximum
+ * and a log2 histogram of the cycles per block. Without AFC_PROFILE the macros expand to
+ * nothing, so the instrumentation costs nothing.
+ */
+
+/**
+ * @brief A profiled stage of the audio processing.
+ */
+enum class ProfileStage : std::uint8_t {
+    Update, ///< The whole of AdaptiveFeedbackCanceller::update().
+    Notch, ///< The notch bank.
+    Adaptive, ///< The adaptive filter, noise estimation included.
+    NoiseParameters, ///< The noise estimation of the LMS filter.
+    FrequencyEstimation, ///< The dominant-frequency estimator and the notch tracking.
+    Count, ///< Number of stages.
+};
+
+/**
+ * @brief Statistics of the cycles a stage takes per audio block.
+ */
+struct ProfileStats {
+    static constexpr std::size_t BUCKETS = 32; ///< Number of histogram buckets.
+
+    std::uint32_t blocks; ///< Number of blocks in which the stage ran.
+    std::uint32_t min; ///< Fewest cycles in a block.
+    std::uint32_t max; ///< Most cycles in a block.
+    std::uint64_t total; ///< Cycles over all the blocks.
+    std::uint32_t histogram[BUCKETS]; ///< Bucket i counts the blocks that took [2^i, 2^(i+1)) cycles, bucket 0 also counts 0.
+};
+
+/**
+ * @brief The Profiler class collects the cycles spent in each stage.
+ *
+ * The statistics are written from the audio interrupt; a reader in loop() must call snapshot()
+ * and reset() with the audio interrupts disabled.
+ */
+class Profiler {
+public:
+    /**
+     * @brief Reads the cycle counter.
+     *
+     * @return The counter, wrapping at 2^32.
+     */
+    static std::uint32_t cycles() {
+#if defined(__ARM_ARCH_7EM__)
+        return *reinterpret_cast<volatile std::uint32_t*>(0xE0001004); // DWT_CYCCNT
+#elif defined(__x86_64__) || defined(__i386__)
+        return static_cast<std::uint32_t>(__rdtsc());
+#else
+        return static_cast<std::uint32_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    /**
+     * @brief Enables the cycle counter, which the Teensy startup code already does.
+     */
+    static void begin();
+
+    /**
+     * @brief Adds cycles to a stage, for the current block.
+     *
+     * @param stage The stage.
+     * @param cycles The cycles spent.
+     */
+    static void add(ProfileStage stage, std::uint32_t cycles);
+
+    /**
+     * @brief Folds the cycles of the current block into the statistics of the stages that ran.
+     */
+    static void endBlock();
+
+    /**
+     * @brief Copies the statistics of a stage.
+     *
+     * @param stage The stage.
+     * @param stats The statistics.
+     */
+    static void snapshot(ProfileStage stage, ProfileStats& stats);
+
+    /**
+     * @brief Clears the statistics of all the stages.
+     */
+    static void reset();
+
+    /**
+     * @brief Gets the name of a stage.
+     *
+     * @param stage The stage.
+     * @return The name, in upper case.
+     */
+    static const char* name(ProfileStage stage);
+
+private:
+    static constexpr std::size_t STAGES = static_cast<std::size_t>(ProfileStage::Count); ///< Number of stages.
+
+    static std::uint32_t blockCycles[STAGES]; ///< Cycles of each stage in the current block.
+    static bool ran[STAGES]; ///< True for the stages that ran in the current block.
+    static ProfileStats stats[STAGES]; ///< Statistics of each stage.
+};
+
+/**
+ * @brief The ProfileScope class adds the cycles of its lifetime to a stage.
+ */
+class ProfileScope {
+public:
+    /**
+     * @brief Starts timing a stage.
+     *
+     * @param stage The stage.
+     */
+    explicit ProfileScope(const ProfileStage stage) : stage(stage), start(Profiler::cycles()) {}
+
+    /**
+     * @brief Adds the cycles elapsed since construction to the stage.
+     */
+    ~ProfileScope() { Profiler::add(stage, Profiler::cycles() - start); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    ProfileStage stage; ///< The stage timed.
+    std::uint32_t start; ///< Counter at construction.
+};
+
+/**
+ * @brief The ProfileBlock class times a whole audio block and ends it.
+ */
+class ProfileBlock {
+public:
+    ProfileBlock() : start(Profiler::cycles()) {}
+
+    /**
+     * @brief Adds the cycles of the block to ProfileStage::Update and folds the block.
+     */
+    ~ProfileBlock() {
+        Profiler::add(ProfileStage::Update, Profiler::cycles() - start);
+        Profiler::endBlock();
+    }
+
+    ProfileBlock(const ProfileBlock&) = delete;
+    ProfileBlock& operator=(const ProfileBlock&) = delete;
+
+private:
+    std::uint32_t start; ///< Counter at construction.
+};
+
+#define AFC_PROFILE_CONCAT_(a, b) a##b
+#define AFC_PROFILE_CONCAT(a, b) AFC_PROFILE_CONCAT_(a, b)
+
+#ifdef AFC_PROFILE
+/// Times the rest of the enclosing scope as a stage.
+#define AFC_PROFILE_SCOPE(stage) const ProfileScope AFC_PROFILE_CONCAT(profileScope, __LINE__){stage}
+/// Times the rest of the enclosing scope as a whole audio block.
+#define AFC_PROFILE_BLOCK() const ProfileBlock AFC_PROFILE_CONCAT(profileBlock, __LINE__){}
+#else
+#define AFC_PROFILE_SCOPE(stage) static_cast<void>(0)
+#define AFC_PROFILE_BLOCK() static_cast<void>(0)
+#endif
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief The RingBuffer class is a fixed-size single-producer single-consumer queue.
+ *
+ * One context writes and another reads, with no lock: the write index is only stored by the
+ * producer and the read index only by the consumer, so the audio interrupt can fill a buffer
+ * that loop() drains. Neither side ever waits; a write that does not fit is refused whole.
+ *
+ * @tparam T The element type.
+ * @tparam Capacity The number of elements, a power of two.
+ */
+template<typename T, std::size_t Capacity>
+class RingBuffer {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    /**
+     * @brief Appends one element.
+     *
+     * @param value The element.
+     * @return True if the element was queued, false if the buffer is full.
+     */
+    bool push(const T& value) { return write(&value, 1); }
+
+    /**
+     * @brief Removes the oldest element.
+     *
+     * @param value The element removed.
+     * @return True if an element was removed, false if the buffer is empty.
+     */
+    bool pop(T& value) {
+        const std::size_t tail = readIndex.load(std::memory_order_relaxed);
+        if (tail == writeIndex.load(std::memory_order_acquire)) return false;
+        value = items[tail & MASK];
+        readIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Appends a run of elements, all of them or none.
+     *
+     * @param values The elements.
+     * @param count The number of elements.
+     * @return True if the elements were queued, false if they do not fit.
+     */
+    bool write(const T* values, const std::size_t count) {
+        const std::size_t head = writeIndex.load(std::memory_order_relaxed);
+        if (Capacity - (head - readIndex.load(std::memory_order_acquire)) < count) return false;
+        for (std::size_t i = 0; i < count; ++i) {
+            items[(head + i) & MASK] = values[i];
+        }
+        writeIndex.store(head + count, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Gives the oldest queued elements that are contiguous in memory, without removing them.
+     *
+     * @param values Set to the first element.
+     * @return The number of contiguous elements, zero if the buffer is empty.
+     */
+    std::size_t peek(const T*& values) const {
+        const std::size_t tail = readIndex.load(std::memory_order_relaxed);
+        const std::size_t available = writeIndex.load(std::memory_order_acquire) - tail;
+        values = &items[tail & MASK];
+        return std::min(available, Capacity - (tail & MASK));
+    }
+
+    /**
+     * @brief Removes the oldest elements, after they have been read through peek().
+     *
+     * @param count The number of elements to remove, at most the count returned by peek().
+     */
+    void consume(const std::size_t count) {
+        readIndex.store(readIndex.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    /**
+     * @brief Gets the number of queued elements.
+     *
+     * @return The number of queued elements.
+     */
+    [[nodiscard]] std::size_t size() const {
+        return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr std::size_t MASK = Capacity - 1; ///< Mask wrapping an index into the buffer.
+
+    T items[Capacity]{}; ///< The elements.
+    std::atomic<std::size_t> writeIndex{0}; ///< Number of elements ever written, stored by the producer.
+    std::atomic<std::size_t> readIndex{0}; ///< Number of elements ever read, stored by the consumer.
+};
+
+#endif
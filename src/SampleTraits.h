@@ -0,0 +1,202 @@
+#ifndef SAMPLE_TRAITS_H
+#define SAMPLE_TRAITS_H
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+using q15_t = std::int16_t; ///< CMSIS-style Q1.15 fixed-point sample.
+using q31_t = std::int32_t; ///< CMSIS-style Q1.31 fixed-point sample.
+
+/**
+ * @brief The SampleTraits class describes the arithmetic of a sample type.
+ *
+ * The DSP classes are templated on their sample type and only touch samples through
+ * these traits, so the same code builds as double, float, Q15 or Q31. Multiply-accumulate
+ * loops run in acc_t, while the per-sample control logic (step sizes, variance estimates,
+ * frequencies) runs in real_t.
+ *
+ * @tparam T The sample type.
+ */
+template<typename T>
+struct SampleTraits;
+
+/**
+ * @brief Sample traits shared by the floating-point sample types.
+ *
+ * @tparam T The floating-point sample type.
+ */
+template<typename T>
+struct FloatingSampleTraits {
+    using real_t = T; ///< Type used for control logic.
+    using acc_t = T; ///< Accumulator type of multiply-accumulate loops.
+    using gain_t = T; ///< Type of a gain applied to samples.
+
+    static constexpr int coefShift{0}; ///< Number of bits filter coefficients are scaled down by.
+
+    /**
+     * @brief Converts a real value to a sample.
+     */
+    static constexpr T fromReal(const real_t x) { return x; }
+
+    /**
+     * @brief Converts a sample to a real value.
+     */
+    static constexpr real_t toReal(const T x) { return x; }
+
+    /**
+     * @brief Converts a filter coefficient to its stored representation.
+     */
+    static constexpr T fromCoefficient(const real_t c) { return c; }
+
+    /**
+     * @brief Converts a 16-bit audio sample to a sample.
+     */
+    static constexpr T fromInt16(const std::int16_t x) { return static_cast<T>(x) / static_cast<T>(32767); }
+
+    /**
+     * @brief Converts a sample to a 16-bit audio sample, clipping to [-1, 1].
+     */
+    static std::int16_t toInt16(const T x) {
+        const T clipped = x > T{1} ? T{1} : (x < T{-1} ? T{-1} : x);
+        return static_cast<std::int16_t>(clipped * static_cast<T>(32767));
+    }
+
+    /**
+     * @brief Converts a real gain to its stored representation.
+     */
+    static constexpr gain_t toGain(const real_t gain) { return gain; }
+
+    /**
+     * @brief Applies a gain to a sample.
+     */
+    static constexpr T applyGain(const T x, const gain_t gain) { return x * gain; }
+
+    /**
+     * @brief Returns acc + a * b.
+     */
+    static constexpr acc_t mac(const acc_t acc, const T a, const T b) { return acc + a * b; }
+
+    /**
+     * @brief Returns acc - a * b.
+     */
+    static constexpr acc_t msub(const acc_t acc, const T a, const T b) { return acc - a * b; }
+
+    /**
+     * @brief Converts an accumulator to a sample.
+     *
+     * @param acc The accumulator.
+     * @param shift The coefficient scaling to undo.
+     */
+    static constexpr T fromAcc(const acc_t acc, [[maybe_unused]] const int shift = 0) { return acc; }
+
+    /**
+     * @brief Returns a - b.
+     */
+    static constexpr T sub(const T a, const T b) { return a - b; }
+};
+
+template<>
+struct SampleTraits<double> : FloatingSampleTraits<double> {};
+
+template<>
+struct SampleTraits<float> : FloatingSampleTraits<float> {};
+
+/**
+ * @brief Sample traits shared by the fixed-point sample types.
+ *
+ * Products are accumulated in 64 bits and rounded back with saturation, as the CMSIS-DSP
+ * fixed-point kernels do. Filter coefficients are stored at half scale so that biquad
+ * coefficients in [-2, 2) are representable.
+ *
+ * @tparam T The fixed-point sample type.
+ * @tparam FracBits The number of fractional bits of T.
+ * @tparam ProductShift The number of bits each product is shifted down by before accumulation.
+ */
+template<typename T, int FracBits, int ProductShift>
+struct FixedSampleTraits {
+    using real_t = float; ///< Type used for control logic.
+    using acc_t = std::int64_t; ///< Accumulator type of multiply-accumulate loops.
+    using gain_t = std::int32_t; ///< Gain in Q16.16.
+
+    static constexpr int coefShift{1}; ///< Number of bits filter coefficients are scaled down by.
+
+    /**
+     * @brief Saturates a wide value to the range of T.
+     */
+    static constexpr T saturate(const acc_t x) {
+        return x > std::numeric_limits<T>::max() ? std::numeric_limits<T>::max()
+             : (x < std::numeric_limits<T>::min() ? std::numeric_limits<T>::min() : static_cast<T>(x));
+    }
+
+    /**
+     * @brief Converts a real value to a sample.
+     */
+    static T fromReal(const real_t x) {
+        return saturate(std::llround(static_cast<double>(x) * static_cast<double>(acc_t{1} << FracBits)));
+    }
+
+    /**
+     * @brief Converts a sample to a real value.
+     */
+    static constexpr real_t toReal(const T x) { return static_cast<real_t>(x) / static_cast<real_t>(acc_t{1} << FracBits); }
+
+    /**
+     * @brief Converts a filter coefficient to its stored representation.
+     */
+    static T fromCoefficient(const real_t c) { return fromReal(c * 0.5f); }
+
+    /**
+     * @brief Converts a 16-bit audio sample to a sample.
+     */
+    static constexpr T fromInt16(const std::int16_t x) { return static_cast<T>(static_cast<acc_t>(x) * (acc_t{1} << (FracBits - 15))); }
+
+    /**
+     * @brief Converts a sample to a 16-bit audio sample.
+     */
+    static constexpr std::int16_t toInt16(const T x) { return static_cast<std::int16_t>(x >> (FracBits - 15)); }
+
+    /**
+     * @brief Converts a real gain to its stored representation.
+     */
+    static gain_t toGain(const real_t gain) { return static_cast<gain_t>(std::lround(gain * 65536.0f)); }
+
+    /**
+     * @brief Applies a gain to a sample.
+     */
+    static constexpr T applyGain(const T x, const gain_t gain) { return saturate((static_cast<acc_t>(x) * gain) >> 16); }
+
+    /**
+     * @brief Returns acc + a * b.
+     */
+    static constexpr acc_t mac(const acc_t acc, const T a, const T b) { return acc + ((static_cast<acc_t>(a) * b) >> ProductShift); }
+
+    /**
+     * @brief Returns acc - a * b.
+     */
+    static constexpr acc_t msub(const acc_t acc, const T a, const T b) { return acc - ((static_cast<acc_t>(a) * b) >> ProductShift); }
+
+    /**
+     * @brief Converts an accumulator to a sample, rounding to nearest.
+     *
+     * @param acc The accumulator.
+     * @param shift The coefficient scaling to undo.
+     */
+    static constexpr T fromAcc(const acc_t acc, const int shift = 0) {
+        const int bits = FracBits - ProductShift - shift;
+        return saturate((acc + (acc_t{1} << (bits - 1))) >> bits);
+    }
+
+    /**
+     * @brief Returns a - b with saturation.
+     */
+    static constexpr T sub(const T a, const T b) { return saturate(static_cast<acc_t>(a) - b); }
+};
+
+template<>
+struct SampleTraits<q15_t> : FixedSampleTraits<q15_t, 15, 0> {};
+
+template<>
+struct SampleTraits<q31_t> : FixedSampleTraits<q31_t, 31, 14> {};
+
+#endif
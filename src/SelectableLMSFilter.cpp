@@ -0,0 +1,234 @@
+#include "SelectableLMSFilter.h"
+#include <cstring>
+
+/**
+ * @brief Names of the adaptation algorithms, in the order of LMSAlgorithm.
+ */
+static constexpr const char* ALGORITHM_NAMES[LMS_ALGORITHM_COUNT] = {"LMS", "NLMS", "VSS", "KALMAN", "DYNAMIC", "APA", "RLS", "IPNLMS"};
+
+/**
+ * @brief Gets the name of an adaptation algorithm, as used by the serial commands.
+ *
+ * @param algorithm The algorithm.
+ * @return The upper-case name of the algorithm.
+ */
+const char* lmsAlgorithmName(const LMSAlgorithm algorithm) {
+    const auto index = static_cast<std::size_t>(algorithm);
+    return index < LMS_ALGORITHM_COUNT ? ALGORITHM_NAMES[index] : "?";
+}
+
+/**
+ * @brief Finds an adaptation algorithm from its name.
+ *
+ * @param name The upper-case name of the algorithm.
+ * @param algorithm The algorithm, set if the name is known.
+ * @return True if the name is known.
+ */
+bool parseLMSAlgorithm(const char* name, LMSAlgorithm& algorithm) {
+    for (std::size_t i = 0; i < LMS_ALGORITHM_COUNT; ++i) {
+        if (std::strcmp(name, ALGORITHM_NAMES[i]) == 0) {
+            algorithm = static_cast<LMSAlgorithm>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Constructs a SelectableLMSFilter object running the DynamicNoise algorithm.
+ *
+ * @param order The order of the filters.
+ * @param mu The adaptation rate of every channel.
+ */
+template<typename T, std::size_t Channels>
+SelectableLMSFilter<T, Channels>::SelectableLMSFilter(const std::size_t order, const real_t mu)
+    : lms(order, mu), nlms(order, mu), vss(order, mu), kalman(order, mu), dynamicNoise(order, mu), apa(order, mu), rls(order, mu),
+      ipnlms(order, mu) {}
+
+/**
+ * @brief Calls a visitor with the filter of an algorithm.
+ *
+ * @param self The SelectableLMSFilter, const or not.
+ * @param which The algorithm.
+ * @param visitor The generic callable called with the filter.
+ * @return The result of the visitor.
+ */
+template<typename T, std::size_t Channels>
+template<typename Self, typename Visitor>
+decltype(auto) SelectableLMSFilter<T, Channels>::visit(Self& self, const LMSAlgorithm which, Visitor&& visitor) {
+    switch (which) {
+        case LMSAlgorithm::LMS:
+            return visitor(self.lms);
+        case LMSAlgorithm::NLMS:
+            return visitor(self.nlms);
+        case LMSAlgorithm::VSS:
+            return visitor(self.vss);
+        case LMSAlgorithm::Kalman:
+            return visitor(self.kalman);
+        case LMSAlgorithm::APA:
+            return visitor(self.apa);
+        case LMSAlgorithm::RLS:
+            return visitor(self.rls);
+        case LMSAlgorithm::IPNLMS:
+            return visitor(self.ipnlms);
+        case LMSAlgorithm::DynamicNoise:
+        default:
+            return visitor(self.dynamicNoise);
+    }
+}
+
+/**
+ * @brief Processes a block of reference samples of every channel against separate desired samples.
+ *
+ * @param reference The reference samples fed into the delay lines, one buffer per channel.
+ * @param desired The desired samples the filter outputs are subtracted from, one buffer per channel.
+ * @param error The error samples, one buffer per channel.
+ * @param n The number of samples in the block.
+ */
+template<typename T, std::size_t Channels>
+void SelectableLMSFilter<T, Channels>::processBlock(const T* const* reference, const T* const* desired, T* const* error, const std::size_t n) {
+    visit(*this, algorithm, [=](auto& filter) { filter.processBlock(reference, desired, error, n); });
+}
+
+/**
+ * @brief Selects the adaptation algorithm, which takes over the weights and the delay line.
+ *
+ * @param next The algorithm to run from the next block.
+ */
+template<typename T, std::size_t Channels>
+void SelectableLMSFilter<T, Channels>::select(const LMSAlgorithm next) {
+    if (next == algorithm || static_cast<std::size_t>(next) >= LMS_ALGORITHM_COUNT) return;
+
+    visit(*this, next, [this](auto& target) {
+        visit(*this, algorithm, [&target](const auto& source) { target.takeOver(source); });
+    });
+    algorithm = next;
+}
+
+/**
+ * @brief Resets the filter of the selected algorithm.
+ *
+ * The other filters are rebuilt from it when they are selected.
+ */
+template<typename T, std::size_t Channels>
+void SelectableLMSFilter<T, Channels>::reset() {
+    visit(*this, algorithm, [](auto& filter) { filter.reset(); });
+}
+
+/**
+ * @brief Sets the adaptation rate (mu) of every channel of every algorithm.
+ *
+ * @param newMu The new adaptation rate.
+ */
+template<typename T, std::size_t Channels>
+void SelectableLMSFilter<T, Channels>::setMu(const real_t newMu) {
+    for (std::size_t i = 0; i < LMS_ALGORITHM_COUNT; ++i) {
+        visit(*this, static_cast<LMSAlgorithm>(i), [newMu](auto& filter) { filter.setMu(newMu); });
+    }
+}
+
+/**
+ * @brief Gets the current adaptation rate (mu) of a channel of the selected algorithm.
+ *
+ * @param channel The channel.
+ * @return The current adaptation rate.
+ */
+template<typename T, std::size_t Channels>
+typename SelectableLMSFilter<T, Channels>::real_t SelectableLMSFilter<T, Channels>::getMu(const std::size_t channel) const {
+    return visit(*this, algorithm, [channel](const auto& filter) { return filter.getMu(channel); });
+}
+
+/**
+ * @brief Gets the adaptation rate (mu) requested for the selected algorithm.
+ *
+ * @return The requested adaptation rate.
+ */
+template<typename T, std::size_t Channels>
+typename SelectableLMSFilter<T, Channels>::real_t SelectableLMSFilter<T, Channels>::getRequestedMu() const {
+    return visit(*this, algorithm, [](const auto& filter) { return filter.getRequestedMu(); });
+}
+
+/**
+ * @brief Gets the leakage factor (gamma) applied to the weights of a channel at the last update.
+ *
+ * @param channel The channel.
+ * @return The last gamma value.
+ */
+template<typename T, std::size_t Channels>
+typename SelectableLMSFilter<T, Channels>::real_t SelectableLMSFilter<T, Channels>::getGamma(const std::size_t channel) const {
+    return visit(*this, algorithm, [channel](const auto& filter) { return filter.getGamma(channel); });
+}
+
+/**
+ * @brief Gets the first taps of the impulse response of a channel, which are its weights.
+ *
+ * @param impulseResponse The output taps.
+ * @param count The number of taps to read, at most getOrder().
+ * @param channel The channel.
+ */
+template<typename T, std::size_t Channels>
+void SelectableLMSFilter<T, Channels>::getImpulseResponse(real_t* impulseResponse, const std::size_t count, const std::size_t channel) const {
+    visit(*this, algorithm, [=](const auto& filter) { filter.getImpulseResponse(impulseResponse, count, channel); });
+}
+
+/**
+ * @brief Sets the leakage factor of the algorithms with a fixed adaptation rate.
+ *
+ * @param newLeakage The new leakage factor, 1 for none.
+ */
+template<typename T, std::size_t Channels>
+void SelectableLMSFilter<T, Channels>::setLeakage(const real_t newLeakage) {
+    for (std::size_t i = 0; i < LMS_ALGORITHM_COUNT; ++i) {
+        visit(*this, static_cast<LMSAlgorithm>(i), [newLeakage](auto& filter) { filter.setLeakage(newLeakage); });
+    }
+}
+
+/**
+ * @brief Writes the selected algorithm and the state of the filter of every algorithm.
+ *
+ * @param writer The writer of the state image.
+ */
+template<typename T, std::size_t Channels>
+void SelectableLMSFilter<T, Channels>::saveState(StateWriter& writer) const {
+    writer.write(static_cast<std::uint8_t>(algorithm));
+    for (std::size_t i = 0; i < LMS_ALGORITHM_COUNT; ++i) {
+        visit(*this, static_cast<LMSAlgorithm>(i), [&writer](const auto& filter) { filter.saveState(writer); });
+    }
+}
+
+/**
+ * @brief Reads back the state written by saveState().
+ *
+ * @param reader The reader of the state image.
+ * @return True if the state was read, false otherwise.
+ */
+template<typename T, std::size_t Channels>
+bool SelectableLMSFilter<T, Channels>::loadState(StateReader& reader) {
+    std::uint8_t saved{0};
+    if (!reader.read(saved) || saved >= LMS_ALGORITHM_COUNT) return false;
+
+    for (std::size_t i = 0; i < LMS_ALGORITHM_COUNT; ++i) {
+        if (!visit(*this, static_cast<LMSAlgorithm>(i), [&reader](auto& filter) { return filter.loadState(reader); })) return false;
+    }
+
+    const auto savedAlgorithm = static_cast<LMSAlgorithm>(saved);
+    if (savedAlgorithm != algorithm) {
+        visit(*this, algorithm, [this, savedAlgorithm](auto& target) {
+            visit(*this, savedAlgorithm, [&target](const auto& source) { target.takeOver(source); });
+        });
+    }
+    return true;
+}
+
+template class SelectableLMSFilter<double>;
+template class SelectableLMSFilter<float>;
+template class SelectableLMSFilter<q15_t>;
+template class SelectableLMSFilter<q31_t>;
+template class SelectableLMSFilter<double, 2>;
+template class SelectableLMSFilter<float, 2>;
+template class SelectableLMSFilter<q15_t, 2>;
+template class SelectableLMSFilter<q31_t, 2>;
+template class SelectableLMSFilter<double, 4>;
+template class SelectableLMSFilter<float, 4>;
+template class SelectableLMSFilter<q15_t, 4>;
+template class SelectableLMSFilter<q31_t, 4>;
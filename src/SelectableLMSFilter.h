@@ -0,0 +1,265 @@
+#ifndef SELECTABLE_LMS_FILTER_H
+#define SELECTABLE_LMS_FILTER_H
+
+#include "LMSFilter.h"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * @brief Adaptation algorithms of SelectableLMSFilter.
+ */
+enum class LMSAlgorithm : std::uint8_t {
+    LMS, ///< LMS with a fixed adaptation rate.
+    NLMS, ///< NLMS with a fixed adaptation rate.
+    VSS, ///< NLMS with the adaptation rate set by exponentially smoothed variances.
+    Kalman, ///< NLMS with the adaptation rate set by Kalman-filtered variances.
+    DynamicNoise, ///< NLMS with the Kalman step control whose noise parameters are estimated over a window.
+    APA, ///< Affine projection algorithm with a fixed adaptation rate.
+    RLS, ///< Stabilized fast transversal RLS.
+    IPNLMS, ///< Improved proportionate NLMS with a fixed adaptation rate.
+};
+
+constexpr std::size_t LMS_ALGORITHM_COUNT{8}; ///< Number of adaptation algorithms.
+
+/**
+ * @brief Gets the name of an adaptation algorithm, as used by the serial commands.
+ *
+ * @param algorithm The algorithm.
+ * @return The upper-case name of the algorithm.
+ */
+const char* lmsAlgorithmName(LMSAlgorithm algorithm);
+
+/**
+ * @brief Finds an adaptation algorithm from its name.
+ *
+ * @param name The upper-case name of the algorithm.
+ * @param algorithm The algorithm, set if the name is known.
+ * @return True if the name is known.
+ */
+bool parseLMSAlgorithm(const char* name, LMSAlgorithm& algorithm);
+
+/**
+ * @brief The SelectableLMSFilter class runs one of several LMSFilter algorithms, selected at runtime.
+ *
+ * Every algorithm of LMSAlgorithm is an LMSFilter instantiation of its own, composed of its
+ * weight update and step control policies at compile time, and all of them live side by side. A
+ * switch on the selected algorithm dispatches each block to its filter, so the sample loops run
+ * the policies of one algorithm with no indirection. Selecting another algorithm hands the
+ * weights and the delay line over to its filter, so the adaptation carries on from the model
+ * identified so far.
+ *
+ * The state saved by saveState() holds the filters of every algorithm, so each one carries on
+ * from its own estimates when it is selected again after a load.
+ *
+ * It offers the interface of LMSFilter and can be used as the adaptive filter of NotchLMSFilter.
+ *
+ * @tparam T The sample and coefficient type (double, float, q15_t or q31_t).
+ * @tparam Channels The number of channels (default is 1).
+ */
+template<typename T, std::size_t Channels = 1>
+class SelectableLMSFilter final {
+public:
+    using Traits = SampleTraits<T>; ///< Arithmetic of the sample type.
+    using real_t = typename Traits::real_t; ///< Type used for the adaptation control logic.
+
+    static constexpr std::size_t CHANNELS = Channels; ///< Number of channels.
+    static constexpr std::size_t MIN_ESTIMATION_WINDOW = EstimationWindow::MIN; ///< Minimum window size for noise estimation.
+    static constexpr std::size_t MAX_ESTIMATION_WINDOW = EstimationWindow::MAX; ///< Maximum window size for noise estimation.
+
+    /**
+     * @brief Constructs a SelectableLMSFilter object running the DynamicNoise algorithm.
+     *
+     * @param order The order of the filters.
+     * @param mu The adaptation rate of every channel (default is 0.0001).
+     */
+    explicit SelectableLMSFilter(std::size_t order, real_t mu = 0.0001);
+
+    SelectableLMSFilter(const SelectableLMSFilter&) = delete;
+    SelectableLMSFilter& operator=(const SelectableLMSFilter&) = delete;
+
+    /**
+     * @brief Processes a block of input samples of a single-channel filter and writes the filtered output.
+     *
+     * The input and output buffers may alias.
+     *
+     * @param in The input samples to be filtered.
+     * @param out The filtered output samples.
+     * @param n The number of samples in the block.
+     */
+    template<std::size_t C = Channels, std::enable_if_t<C == 1, int> = 0>
+    void processBlock(const T* in, T* out, const std::size_t n) { processBlock(&in, &in, &out, n); }
+
+    /**
+     * @brief Processes a block of reference samples of a single-channel filter against separate desired samples.
+     *
+     * The buffers may alias.
+     *
+     * @param reference The reference samples fed into the delay line.
+     * @param desired The desired samples the filter output is subtracted from.
+     * @param error The error samples.
+     * @param n The number of samples in the block.
+     */
+    template<std::size_t C = Channels, std::enable_if_t<C == 1, int> = 0>
+    void processBlock(const T* reference, const T* desired, T* error, const std::size_t n) {
+        processBlock(&reference, &desired, &error, n);
+    }
+
+    /**
+     * @brief Processes a block of input samples of every channel and writes the filtered output.
+     *
+     * The input and output buffers of a channel may alias.
+     *
+     * @param in The input samples to be filtered, one buffer per channel.
+     * @param out The filtered output samples, one buffer per channel.
+     * @param n The number of samples in the block.
+     */
+    void processBlock(const T* const* in, T* const* out, const std::size_t n) { processBlock(in, in, out, n); }
+
+    /**
+     * @brief Processes a block of reference samples of every channel against separate desired samples.
+     *
+     * The buffers of a channel may alias.
+     *
+     * @param reference The reference samples fed into the delay lines, one buffer per channel.
+     * @param desired The desired samples the filter outputs are subtracted from, one buffer per channel.
+     * @param error The error samples, one buffer per channel.
+     * @param n The number of samples in the block.
+     */
+    void processBlock(const T* const* reference, const T* const* desired, T* const* error, std::size_t n);
+
+    /**
+     * @brief Selects the adaptation algorithm, which takes over the weights and the delay line.
+     *
+     * @param next The algorithm to run from the next block.
+     */
+    void select(LMSAlgorithm next);
+
+    /**
+     * @brief Gets the selected adaptation algorithm.
+     *
+     * @return The selected algorithm.
+     */
+    [[nodiscard]] LMSAlgorithm getAlgorithm() const { return algorithm; }
+
+    /**
+     * @brief Resets the filter of the selected algorithm.
+     */
+    void reset();
+
+    /**
+     * @brief Sets the adaptation rate (mu) of every channel of every algorithm.
+     *
+     * @param newMu The new adaptation rate.
+     */
+    void setMu(real_t newMu);
+
+    /**
+     * @brief Gets the current adaptation rate (mu) of a channel of the selected algorithm.
+     *
+     * @param channel The channel (default is 0).
+     * @return The current adaptation rate.
+     */
+    [[nodiscard]] real_t getMu(std::size_t channel = 0) const;
+
+    /**
+     * @brief Gets the adaptation rate (mu) requested for the selected algorithm.
+     *
+     * @return The requested adaptation rate.
+     */
+    [[nodiscard]] real_t getRequestedMu() const;
+
+    /**
+     * @brief Gets the leakage factor (gamma) applied to the weights of a channel at the last update.
+     *
+     * @param channel The channel (default is 0).
+     * @return The last gamma value.
+     */
+    [[nodiscard]] real_t getGamma(std::size_t channel = 0) const;
+
+    /**
+     * @brief Gets the number of taps of the filters.
+     *
+     * @return The number of taps.
+     */
+    [[nodiscard]] std::size_t getOrder() const { return dynamicNoise.getOrder(); }
+
+    /**
+     * @brief Gets the first taps of the impulse response of a channel, which are its weights.
+     *
+     * @param impulseResponse The output taps.
+     * @param count The number of taps to read, at most getOrder().
+     * @param channel The channel (default is 0).
+     */
+    void getImpulseResponse(real_t* impulseResponse, std::size_t count, std::size_t channel = 0) const;
+
+    /**
+     * @brief Sets the length of the window over which the DynamicNoise algorithm estimates its noise parameters.
+     *
+     * @param size The new window length, in samples.
+     */
+    void setEstimationWindow(const std::size_t size) { dynamicNoise.setEstimationWindow(size); }
+
+    /**
+     * @brief Sets the leakage factor of the algorithms with a fixed adaptation rate.
+     *
+     * @param newLeakage The new leakage factor, 1 for none.
+     */
+    void setLeakage(real_t newLeakage);
+
+    /**
+     * @brief Sets the forgetting factor of the RLS algorithm.
+     *
+     * @param factor The forgetting factor, just below 1.
+     */
+    void setForgetting(const real_t factor) { rls.getUpdate().setForgetting(factor); }
+
+    /**
+     * @brief Sets how much the IPNLMS algorithm concentrates its step on the largest taps.
+     *
+     * @param alpha The proportionality, from -1 (NLMS) to just below 1 (PNLMS).
+     */
+    void setProportionality(const real_t alpha) { ipnlms.getUpdate().setProportionality(alpha); }
+
+    /**
+     * @brief Writes the selected algorithm and the state of the filter of every algorithm.
+     *
+     * @param writer The writer of the state image.
+     */
+    void saveState(StateWriter& writer) const;
+
+    /**
+     * @brief Reads back the state written by saveState().
+     *
+     * The selected algorithm is a setting and is kept. If the state was saved with another one,
+     * the selected filter takes over the weights and the delay line of that one.
+     *
+     * @param reader The reader of the state image.
+     * @return True if the state was read, false otherwise.
+     */
+    bool loadState(StateReader& reader);
+
+private:
+    LMSFilter<T, Channels, LMSUpdate, FixedStep> lms; ///< Filter of the LMS algorithm.
+    LMSFilter<T, Channels, NLMSUpdate, FixedStep> nlms; ///< Filter of the NLMS algorithm.
+    LMSFilter<T, Channels, NLMSUpdate, SmoothedStep> vss; ///< Filter of the VSS algorithm.
+    LMSFilter<T, Channels, NLMSUpdate, KalmanStep> kalman; ///< Filter of the Kalman algorithm.
+    LMSFilter<T, Channels> dynamicNoise; ///< Filter of the DynamicNoise algorithm.
+    LMSFilter<T, Channels, AffineProjectionUpdate, FixedStep> apa; ///< Filter of the APA algorithm.
+    LMSFilter<T, Channels, FastRLSUpdate, FixedStep> rls; ///< Filter of the RLS algorithm.
+    LMSFilter<T, Channels, ProportionateUpdate, FixedStep> ipnlms; ///< Filter of the IPNLMS algorithm.
+    LMSAlgorithm algorithm{LMSAlgorithm::DynamicNoise}; ///< The selected algorithm.
+
+    /**
+     * @brief Calls a visitor with the filter of an algorithm.
+     *
+     * @param self The SelectableLMSFilter, const or not.
+     * @param which The algorithm.
+     * @param visitor The generic callable called with the filter.
+     * @return The result of the visitor.
+     */
+    template<typename Self, typename Visitor>
+    static decltype(auto) visit(Self& self, LMSAlgorithm which, Visitor&& visitor);
+};
+
+#endif
@@ -0,0 +1,206 @@
+#include "SignalRecorder.h"
+
+#include <cstdio>
+#include <cstring>
+
+/**
+ * @brief Starts a recording, from the next audio block.
+ *
+ * @return True if the recording started, false if the previous one is not written out yet.
+ */
+bool SignalRecorder::start() {
+    if (isActive()) return false;
+
+    // The audio interrupt leaves the recorder alone while it is stopped.
+    filling = 0;
+    fillBlocks = 0;
+    pendingDrops = 0;
+    reading = 0;
+    RecorderGap gap;
+    while (gaps.pop(gap)) {
+    }
+    blocks.store(0, std::memory_order_relaxed);
+    overruns.store(0, std::memory_order_relaxed);
+    state.store(Running, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Stops the recording at the end of the current audio block.
+ */
+void SignalRecorder::stop() {
+    std::uint8_t running = Running;
+    state.compare_exchange_strong(running, Stopping, std::memory_order_acq_rel);
+}
+
+/**
+ * @brief Checks if a recording is running or still has chunks to write out.
+ *
+ * @return True from start() until the last chunk after stop() is released, false otherwise.
+ */
+bool SignalRecorder::isActive() const {
+    return state.load(std::memory_order_acquire) != Stopped || full[0].load(std::memory_order_acquire) ||
+           full[1].load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Takes the oldest chunk handed over by the audio interrupt.
+ *
+ * @param blocks The number of blocks in the chunk, CHUNK_BLOCKS but for the last one.
+ * @return The interleaved samples of the chunk, or nullptr if no chunk is ready.
+ */
+const std::int16_t* SignalRecorder::acquireChunk(std::size_t& blocks) {
+    if (!full[reading].load(std::memory_order_acquire)) return nullptr;
+    blocks = chunkBlocks[reading];
+    return chunks[reading];
+}
+
+/**
+ * @brief Gives the chunk taken by acquireChunk() back to the audio interrupt.
+ */
+void SignalRecorder::releaseChunk() {
+    full[reading].store(false, std::memory_order_release);
+    reading ^= 1;
+}
+
+/**
+ * @brief Gets the frame of the current audio block to fill, called by the audio interrupt.
+ *
+ * A stop request is served here: the partly filled chunk is handed over and nothing is recorded.
+ *
+ * @return The BLOCK_VALUES interleaved samples of the block, or nullptr if the block is not recorded.
+ */
+std::int16_t* SignalRecorder::beginBlock() {
+    const std::uint8_t current = state.load(std::memory_order_acquire);
+    if (current == Stopped) return nullptr;
+    if (current == Stopping) {
+        if (fillBlocks > 0) handOver();
+        closeGap();
+        state.store(Stopped, std::memory_order_release);
+        return nullptr;
+    }
+
+    if (fillBlocks == 0 && full[filling].load(std::memory_order_acquire)) {
+        ++pendingDrops;
+        overruns.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    closeGap();
+    return chunks[filling] + fillBlocks * BLOCK_VALUES;
+}
+
+/**
+ * @brief Commits the block filled since beginBlock(), called by the audio interrupt.
+ */
+void SignalRecorder::endBlock() {
+    blocks.fetch_add(1, std::memory_order_relaxed);
+    if (++fillBlocks == CHUNK_BLOCKS) handOver();
+}
+
+/**
+ * @brief Hands the chunk being filled over to loop() and moves to the other one.
+ */
+void SignalRecorder::handOver() {
+    chunkBlocks[filling] = fillBlocks;
+    full[filling].store(true, std::memory_order_release);
+    filling ^= 1;
+    fillBlocks = 0;
+}
+
+/**
+ * @brief Queues the gap of the blocks dropped since the last block recorded.
+ *
+ * A gap that does not fit in the queue is only counted in the overruns.
+ */
+void SignalRecorder::closeGap() {
+    if (pendingDrops == 0) return;
+    gaps.push(RecorderGap{blocks.load(std::memory_order_relaxed), pendingDrops});
+    pendingDrops = 0;
+}
+
+/**
+ * @brief Writes a value in little-endian order.
+ *
+ * @param out The bytes.
+ * @param value The value.
+ * @param bytes The number of bytes.
+ */
+static void putLittleEndian(std::uint8_t* out, std::uint32_t value, const std::size_t bytes) {
+    for (std::size_t i = 0; i < bytes; ++i, value >>= 8) {
+        out[i] = static_cast<std::uint8_t>(value);
+    }
+}
+
+/**
+ * @brief Writes the WAV header of a recording.
+ *
+ * @param header The RECORDING_HEADER_SIZE bytes of the header.
+ * @param sampleRate The sample rate, in Hz.
+ * @param frames The number of frames of the recording.
+ */
+void writeRecordingHeader(std::uint8_t* header, const std::uint32_t sampleRate, const std::uint32_t frames) {
+    constexpr std::uint32_t frameBytes = SignalRecorder::CHANNELS * sizeof(std::int16_t);
+    constexpr std::uint32_t junkBytes = RECORDING_HEADER_SIZE - 52;
+    const std::uint32_t dataBytes = frames * frameBytes;
+
+    std::memset(header, 0, RECORDING_HEADER_SIZE);
+    std::memcpy(header, "RIFF", 4);
+    putLittleEndian(header + 4, RECORDING_HEADER_SIZE - 8 + dataBytes, 4);
+    std::memcpy(header + 8, "WAVE", 4);
+
+    std::memcpy(header + 12, "fmt ", 4);
+    putLittleEndian(header + 16, 16, 4);
+    putLittleEndian(header + 20, 1, 2);
+    putLittleEndian(header + 22, SignalRecorder::CHANNELS, 2);
+    putLittleEndian(header + 24, sampleRate, 4);
+    putLittleEndian(header + 28, sampleRate * frameBytes, 4);
+    putLittleEndian(header + 32, frameBytes, 2);
+    putLittleEndian(header + 34, 16, 2);
+
+    std::memcpy(header + 36, "JUNK", 4);
+    putLittleEndian(header + 40, junkBytes, 4);
+
+    std::memcpy(header + RECORDING_HEADER_SIZE - 8, "data", 4);
+    putLittleEndian(header + RECORDING_HEADER_SIZE - 4, dataBytes, 4);
+}
+
+/**
+ * @brief Writes the JSON sidecar describing a recording.
+ *
+ * The sidecar gives the sample rate, the block size, the names of the channels, the number of
+ * blocks and of dropped blocks, and the gaps as [blocks before the gap, blocks dropped] pairs.
+ * Gaps that did not fit in the queue of the recorder are counted in the overruns but not listed.
+ *
+ * @param text The text.
+ * @param capacity The size of the text buffer.
+ * @param sampleRate The sample rate, in Hz.
+ * @param blocks The number of blocks recorded.
+ * @param overruns The number of blocks dropped.
+ * @param gaps The gaps read from the recorder.
+ * @param gapCount The number of gaps.
+ * @return The length of the text, or 0 if it does not fit.
+ */
+std::size_t writeRecordingSidecar(char* text, const std::size_t capacity, const double sampleRate, const std::uint32_t blocks,
+                                  const std::uint32_t overruns, const RecorderGap* gaps, const std::size_t gapCount) {
+    std::size_t length = 0;
+    auto append = [&](const int written) {
+        if (written < 0 || length + static_cast<std::size_t>(written) >= capacity) {
+            length = capacity;
+            return;
+        }
+        length += static_cast<std::size_t>(written);
+    };
+
+    append(std::snprintf(text, capacity,
+                         "{\n  \"format\": \"afc-recording\",\n  \"version\": 1,\n  \"sample_rate\": %.3f,\n  \"block_samples\": %u,\n"
+                         "  \"channels\": [\"input\", \"output\", \"error\", \"notch_hz\"],\n  \"blocks\": %lu,\n"
+                         "  \"overruns\": %lu,\n  \"gaps\": [",
+                         sampleRate, static_cast<unsigned>(AUDIO_BLOCK_SAMPLES), static_cast<unsigned long>(blocks),
+                         static_cast<unsigned long>(overruns)));
+    for (std::size_t i = 0; i < gapCount && length < capacity; ++i) {
+        append(std::snprintf(text + length, capacity - length, "%s[%lu, %lu]", i > 0 ? ", " : "",
+                             static_cast<unsigned long>(gaps[i].block), static_cast<unsigned long>(gaps[i].dropped)));
+    }
+    if (length < capacity) append(std::snprintf(text + length, capacity - length, "]\n}\n"));
+    return length < capacity ? length : 0;
+}
@@ -0,0 +1,178 @@
+#ifndef SIGNAL_RECORDER_H
+#define SIGNAL_RECORDER_H
+
+#include <Audio.h>
+#include "RingBuffer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Channels of a recording, in their order in each frame.
+ */
+enum class RecordChannel : std::uint8_t {
+    Input, ///< The input of the canceller.
+    Output, ///< The output of the canceller, after the gain.
+    Error, ///< The output of the filters before the gain, the error signal of the adaptive filter.
+    NotchFrequency, ///< The frequency of the first notch during the block, in Hz, 0 if no notch is active.
+};
+
+/**
+ * @brief A run of blocks the recorder dropped because loop() still held the chunk to fill.
+ */
+struct RecorderGap {
+    std::uint32_t block; ///< Number of blocks recorded before the gap.
+    std::uint32_t dropped; ///< Number of blocks dropped.
+};
+
+/**
+ * @brief The SignalRecorder class streams the signals of the audio interrupt to loop() in large chunks.
+ *
+ * At each audio block the interrupt writes CHANNELS interleaved channels of AUDIO_BLOCK_SAMPLES
+ * 16-bit samples into one of two preallocated chunks. A full chunk is handed to loop(), which
+ * writes it in one piece and gives it back while the interrupt fills the other one. If loop()
+ * still holds the chunk the interrupt is about to fill, the block is dropped and counted as an
+ * overrun, and the gap is queued so that the recording can be realigned. Neither side waits or
+ * allocates, and the chunks are 32-byte aligned and a multiple of 512 bytes, so they can be
+ * handed to a DMA or written to an SD card sector by sector.
+ */
+class SignalRecorder final {
+public:
+    static constexpr std::size_t CHANNELS = 4; ///< Number of channels recorded, see RecordChannel.
+    static constexpr std::size_t CHUNK_BLOCKS = 4096 / AUDIO_BLOCK_SAMPLES; ///< Number of audio blocks per chunk, 32 KB whatever the block size.
+    static constexpr std::size_t BLOCK_VALUES = CHANNELS * AUDIO_BLOCK_SAMPLES; ///< Number of samples of a block, all channels.
+    static constexpr std::size_t CHUNK_VALUES = CHUNK_BLOCKS * BLOCK_VALUES; ///< Number of samples of a chunk.
+    static constexpr std::size_t MAX_GAPS = 16; ///< Number of gaps queued until loop() reads them.
+
+    static_assert(CHUNK_VALUES * sizeof(std::int16_t) % 512 == 0, "a chunk must be a whole number of sectors");
+
+    /**
+     * @brief Starts a recording, from the next audio block.
+     *
+     * @return True if the recording started, false if the previous one is not written out yet.
+     */
+    bool start();
+
+    /**
+     * @brief Stops the recording at the end of the current audio block.
+     *
+     * The audio interrupt then hands the partly filled chunk over, and isActive() turns false once
+     * loop() has released it.
+     */
+    void stop();
+
+    /**
+     * @brief Checks if a recording is running or still has chunks to write out.
+     *
+     * @return True from start() until the last chunk after stop() is released, false otherwise.
+     */
+    [[nodiscard]] bool isActive() const;
+
+    /**
+     * @brief Takes the oldest chunk handed over by the audio interrupt.
+     *
+     * The chunk stays valid until releaseChunk() is called.
+     *
+     * @param blocks The number of blocks in the chunk, CHUNK_BLOCKS but for the last one.
+     * @return The interleaved samples of the chunk, or nullptr if no chunk is ready.
+     */
+    const std::int16_t* acquireChunk(std::size_t& blocks);
+
+    /**
+     * @brief Gives the chunk taken by acquireChunk() back to the audio interrupt.
+     */
+    void releaseChunk();
+
+    /**
+     * @brief Takes the oldest gap of the recording.
+     *
+     * @param gap The gap.
+     * @return True if a gap was taken, false if none is queued.
+     */
+    bool readGap(RecorderGap& gap) { return gaps.pop(gap); }
+
+    /**
+     * @brief Gets the number of blocks recorded since start().
+     *
+     * @return The number of blocks.
+     */
+    [[nodiscard]] std::uint32_t getBlocks() const { return blocks.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Gets the number of blocks dropped since start().
+     *
+     * @return The number of blocks.
+     */
+    [[nodiscard]] std::uint32_t getOverruns() const { return overruns.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Gets the frame of the current audio block to fill, called by the audio interrupt.
+     *
+     * @return The BLOCK_VALUES interleaved samples of the block, or nullptr if the block is not recorded.
+     */
+    std::int16_t* beginBlock();
+
+    /**
+     * @brief Commits the block filled since beginBlock(), called by the audio interrupt.
+     */
+    void endBlock();
+
+private:
+    enum State : std::uint8_t { Stopped, Running, Stopping };
+
+    alignas(32) std::int16_t chunks[2][CHUNK_VALUES]{}; ///< The two chunks.
+    std::size_t chunkBlocks[2]{}; ///< Number of blocks of each chunk handed over.
+    std::atomic<bool> full[2]{}; ///< True from the hand-over of each chunk until loop() releases it.
+    std::atomic<std::uint8_t> state{Stopped}; ///< State of the recording.
+    std::atomic<std::uint32_t> blocks{0}; ///< Number of blocks recorded.
+    std::atomic<std::uint32_t> overruns{0}; ///< Number of blocks dropped.
+    RingBuffer<RecorderGap, MAX_GAPS> gaps; ///< Gaps not read by loop() yet.
+
+    std::size_t filling{0}; ///< Chunk filled by the audio interrupt.
+    std::size_t fillBlocks{0}; ///< Number of blocks in the chunk being filled.
+    std::uint32_t pendingDrops{0}; ///< Number of blocks dropped since the last block recorded.
+    std::size_t reading{0}; ///< Next chunk loop() takes.
+
+    /**
+     * @brief Hands the chunk being filled over to loop() and moves to the other one.
+     */
+    void handOver();
+
+    /**
+     * @brief Queues the gap of the blocks dropped since the last block recorded.
+     */
+    void closeGap();
+};
+
+constexpr std::size_t RECORDING_HEADER_SIZE{512}; ///< Size of the WAV header of a recording, one SD sector.
+
+/**
+ * @brief Writes the WAV header of a recording.
+ *
+ * The header is a RIFF header, a PCM fmt chunk of SignalRecorder::CHANNELS 16-bit channels and a
+ * JUNK chunk padding it to RECORDING_HEADER_SIZE bytes, the last 8 of which start the data chunk,
+ * so that the samples that follow are sector-aligned.
+ *
+ * @param header The RECORDING_HEADER_SIZE bytes of the header.
+ * @param sampleRate The sample rate, in Hz.
+ * @param frames The number of frames of the recording.
+ */
+void writeRecordingHeader(std::uint8_t* header, std::uint32_t sampleRate, std::uint32_t frames);
+
+/**
+ * @brief Writes the JSON sidecar describing a recording.
+ *
+ * @param text The text.
+ * @param capacity The size of the text buffer.
+ * @param sampleRate The sample rate, in Hz.
+ * @param blocks The number of blocks recorded.
+ * @param overruns The number of blocks dropped.
+ * @param gaps The gaps read from the recorder.
+ * @param gapCount The number of gaps.
+ * @return The length of the text, or 0 if it does not fit.
+ */
+std::size_t writeRecordingSidecar(char* text, std::size_t capacity, double sampleRate, std::uint32_t blocks, std::uint32_t overruns,
+                                  const RecorderGap* gaps, std::size_t gapCount);
+
+#endif
@@ -0,0 +1,121 @@
+#include "SlidingDFTEstimator.h"
+#include <algorithm>
+
+/**
+ * @brief Constructs a SlidingDFTEstimator object.
+ *
+ * @param size The number of samples in the analysis window.
+ * @param sampleRate The sample rate of the input, in Hz.
+ */
+template<typename R>
+SlidingDFTEstimator<R>::SlidingDFTEstimator(const std::size_t size, const R sampleRate)
+    : size(size), binCount(size / 2 + 1), binWidth(sampleRate / static_cast<R>(size)),
+      dampingN(static_cast<R>(std::pow(static_cast<double>(DAMPING), static_cast<double>(size)))) {
+    history = new R[size];
+    rotations = new complex_t[binCount];
+    bins = new complex_t[binCount];
+    power = new R[binCount];
+
+    const double pi = M_PI;
+    for (std::size_t k = 0; k < binCount; ++k) {
+        const double angle = 2.0 * pi * static_cast<double>(k) / static_cast<double>(size);
+        rotations[k] = complex_t(static_cast<R>(DAMPING * std::cos(angle)), static_cast<R>(DAMPING * std::sin(angle)));
+    }
+
+    reset();
+}
+
+/**
+ * @brief Destroys the SlidingDFTEstimator object and releases allocated resources.
+ */
+template<typename R>
+SlidingDFTEstimator<R>::~SlidingDFTEstimator() {
+    delete[] history;
+    delete[] rotations;
+    delete[] bins;
+    delete[] power;
+}
+
+/**
+ * @brief Feeds samples to the estimator and updates the bins.
+ *
+ * Each bin follows X[k] = r e^(j2πk/N) (X[k] + x[n] - r^N x[n-N]).
+ *
+ * @param samples The input samples.
+ * @param n The number of samples.
+ */
+template<typename R>
+void SlidingDFTEstimator<R>::process(const R* samples, const std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        const R delta = samples[i] - dampingN * history[historyIndex];
+        history[historyIndex] = samples[i];
+        historyIndex = (historyIndex + 1) % size;
+
+        for (std::size_t k = 0; k < binCount; ++k) {
+            bins[k] = (bins[k] + delta) * rotations[k];
+        }
+    }
+}
+
+/**
+ * @brief Estimates the dominant frequency of the most recent samples.
+ *
+ * @param minFrequency The lowest frequency to consider, in Hz.
+ * @param maxFrequency The highest frequency to consider, in Hz.
+ * @return The estimated frequency in Hz, or 0 if no component was found.
+ */
+template<typename R>
+R SlidingDFTEstimator<R>::estimate(const R minFrequency, const R maxFrequency) {
+    R frequency{0};
+    estimatePeaks(minFrequency, maxFrequency, &frequency, 1);
+    return frequency;
+}
+
+/**
+ * @brief Estimates the frequencies of the strongest components of the most recent samples.
+ *
+ * The Hann window is applied in the frequency domain as a three-tap convolution of the bins.
+ *
+ * @param minFrequency The lowest frequency to consider, in Hz.
+ * @param maxFrequency The highest frequency to consider, in Hz.
+ * @param frequencies The estimated frequencies in Hz, strongest first.
+ * @param maxPeaks The maximum number of frequencies to report.
+ * @return The number of frequencies reported.
+ */
+template<typename R>
+std::size_t SlidingDFTEstimator<R>::estimatePeaks(const R minFrequency, const R maxFrequency, R* frequencies, const std::size_t maxPeaks) {
+    const auto firstBin = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(minFrequency / binWidth)));
+    const auto lastBin = std::min<std::size_t>(binCount - 2, static_cast<std::size_t>(maxFrequency / binWidth));
+
+    for (std::size_t k = firstBin - 1; k <= lastBin + 1; ++k) {
+        const complex_t below = k > 0 ? bins[k - 1] : std::conj(bins[1]);
+        const complex_t above = k + 1 < binCount ? bins[k + 1] : std::conj(bins[k - 1]);
+        power[k] = std::norm(R{0.5} * bins[k] - R{0.25} * (below + above));
+    }
+
+    return FrequencyEstimator<R>::findPeaks(power, firstBin, lastBin, binWidth, frequencies, maxPeaks);
+}
+
+/**
+ * @brief Clears the history and the bins of the estimator.
+ */
+template<typename R>
+void SlidingDFTEstimator<R>::reset() {
+    std::fill(history, history + size, R{0});
+    std::fill(bins, bins + binCount, complex_t{});
+    historyIndex = 0;
+}
+
+/**
+ * @brief Sets the sample rate of the input and clears the history and the bins of the estimator.
+ *
+ * @param sampleRate The sample rate of the input, in Hz.
+ */
+template<typename R>
+void SlidingDFTEstimator<R>::setSampleRate(const R sampleRate) {
+    binWidth = sampleRate / static_cast<R>(size);
+    reset();
+}
+
+template class SlidingDFTEstimator<double>;
+template class SlidingDFTEstimator<float>;
@@ -0,0 +1,94 @@
+#ifndef SLIDING_DFT_ESTIMATOR_H
+#define SLIDING_DFT_ESTIMATOR_H
+
+#include "FrequencyEstimator.h"
+#include <Audio.h>
+#include <complex>
+
+/**
+ * @brief The SlidingDFTEstimator class estimates the dominant frequency with a sliding DFT.
+ *
+ * The DFT bins of the most recent samples are updated recursively on every sample, at a cost of
+ * O(N) per sample, so an estimate only has to apply a Hann window in the frequency domain and
+ * interpolate the strongest bin. The resonators are damped slightly to keep rounding errors from
+ * accumulating.
+ *
+ * @tparam R The real type (float or double).
+ */
+template<typename R>
+class SlidingDFTEstimator final : public FrequencyEstimator<R> {
+public:
+    using complex_t = std::complex<R>; ///< Complex type of the spectrum.
+
+    /**
+     * @brief Constructs a SlidingDFTEstimator object.
+     *
+     * @param size The number of samples in the analysis window (default is 256).
+     * @param sampleRate The sample rate of the input, in Hz.
+     */
+    explicit SlidingDFTEstimator(std::size_t size = 256, R sampleRate = AUDIO_SAMPLE_RATE_EXACT);
+
+    /**
+     * @brief Destroys the SlidingDFTEstimator object.
+     */
+    ~SlidingDFTEstimator() override;
+
+    SlidingDFTEstimator(const SlidingDFTEstimator&) = delete;
+    SlidingDFTEstimator& operator=(const SlidingDFTEstimator&) = delete;
+
+    /**
+     * @brief Feeds samples to the estimator and updates the bins.
+     *
+     * @param samples The input samples.
+     * @param n The number of samples.
+     */
+    void process(const R* samples, std::size_t n) override;
+
+    /**
+     * @brief Estimates the dominant frequency of the most recent samples.
+     *
+     * @param minFrequency The lowest frequency to consider, in Hz.
+     * @param maxFrequency The highest frequency to consider, in Hz.
+     * @return The estimated frequency in Hz, or 0 if no component was found.
+     */
+    R estimate(R minFrequency, R maxFrequency) override;
+
+    /**
+     * @brief Estimates the frequencies of the strongest components of the most recent samples.
+     *
+     * @param minFrequency The lowest frequency to consider, in Hz.
+     * @param maxFrequency The highest frequency to consider, in Hz.
+     * @param frequencies The estimated frequencies in Hz, strongest first.
+     * @param maxPeaks The maximum number of frequencies to report.
+     * @return The number of frequencies reported.
+     */
+    std::size_t estimatePeaks(R minFrequency, R maxFrequency, R* frequencies, std::size_t maxPeaks) override;
+
+    /**
+     * @brief Clears the history and the bins of the estimator.
+     */
+    void reset() override;
+
+    /**
+     * @brief Sets the sample rate of the input and clears the history and the bins of the estimator.
+     *
+     * @param sampleRate The sample rate of the input, in Hz.
+     */
+    void setSampleRate(R sampleRate) override;
+
+private:
+    static constexpr R DAMPING{0.9999}; ///< Pole radius of the resonators.
+
+    std::size_t size; ///< The number of samples in the analysis window.
+    std::size_t binCount; ///< The number of bins updated, size / 2 + 1.
+    R binWidth; ///< The frequency spacing of the bins, in Hz.
+    R dampingN; ///< DAMPING to the power size, applied to the sample leaving the window.
+
+    R* history; ///< Ring buffer of the most recent samples.
+    std::size_t historyIndex{0}; ///< Position of the oldest sample in the ring buffer.
+    complex_t* rotations; ///< Damped rotation of each bin per sample.
+    complex_t* bins; ///< Current DFT bins of the window.
+    R* power; ///< Power of each Hann-windowed bin of the current estimate.
+};
+
+#endif
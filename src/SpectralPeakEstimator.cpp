@@ -0,0 +1,118 @@
+#include "SpectralPeakEstimator.h"
+#include <algorithm>
+
+/**
+ * @brief Constructs a SpectralPeakEstimator object.
+ *
+ * @param size The number of samples in the analysis window, a power of two.
+ * @param sampleRate The sample rate of the input, in Hz.
+ */
+template<typename R>
+SpectralPeakEstimator<R>::SpectralPeakEstimator(const std::size_t size, const R sampleRate)
+    : size(size), binWidth(sampleRate / static_cast<R>(size)), fft(size) {
+    history = new R[size];
+    window = new R[size];
+    frame = new R[size];
+    spectrum = new complex_t[size / 2 + 1];
+    power = new R[size / 2 + 1];
+
+    const double pi = M_PI;
+    for (std::size_t i = 0; i < size; ++i) {
+        window[i] = static_cast<R>(0.5 - 0.5 * std::cos(2.0 * pi * static_cast<double>(i) / static_cast<double>(size)));
+    }
+
+    reset();
+}
+
+/**
+ * @brief Destroys the SpectralPeakEstimator object and releases allocated resources.
+ */
+template<typename R>
+SpectralPeakEstimator<R>::~SpectralPeakEstimator() {
+    delete[] history;
+    delete[] window;
+    delete[] frame;
+    delete[] spectrum;
+    delete[] power;
+}
+
+/**
+ * @brief Feeds samples to the estimator.
+ *
+ * @param samples The input samples.
+ * @param n The number of samples.
+ */
+template<typename R>
+void SpectralPeakEstimator<R>::process(const R* samples, const std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        history[historyIndex] = samples[i];
+        historyIndex = (historyIndex + 1) % size;
+    }
+}
+
+/**
+ * @brief Estimates the dominant frequency of the most recent samples.
+ *
+ * @param minFrequency The lowest frequency to consider, in Hz.
+ * @param maxFrequency The highest frequency to consider, in Hz.
+ * @return The estimated frequency in Hz, or 0 if no component was found.
+ */
+template<typename R>
+R SpectralPeakEstimator<R>::estimate(const R minFrequency, const R maxFrequency) {
+    R frequency{0};
+    estimatePeaks(minFrequency, maxFrequency, &frequency, 1);
+    return frequency;
+}
+
+/**
+ * @brief Estimates the frequencies of the strongest components of the most recent samples.
+ *
+ * @param minFrequency The lowest frequency to consider, in Hz.
+ * @param maxFrequency The highest frequency to consider, in Hz.
+ * @param frequencies The estimated frequencies in Hz, strongest first.
+ * @param maxPeaks The maximum number of frequencies to report.
+ * @return The number of frequencies reported.
+ */
+template<typename R>
+std::size_t SpectralPeakEstimator<R>::estimatePeaks(const R minFrequency, const R maxFrequency, R* frequencies, const std::size_t maxPeaks) {
+    const std::size_t tail = size - historyIndex;
+    for (std::size_t i = 0; i < tail; ++i) {
+        frame[i] = history[historyIndex + i] * window[i];
+    }
+    for (std::size_t i = tail; i < size; ++i) {
+        frame[i] = history[i - tail] * window[i];
+    }
+    fft.forward(frame, spectrum);
+
+    const auto firstBin = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(minFrequency / binWidth)));
+    const auto lastBin = std::min<std::size_t>(size / 2 - 1, static_cast<std::size_t>(maxFrequency / binWidth));
+
+    for (std::size_t k = firstBin - 1; k <= lastBin + 1; ++k) {
+        power[k] = std::norm(spectrum[k]);
+    }
+
+    return FrequencyEstimator<R>::findPeaks(power, firstBin, lastBin, binWidth, frequencies, maxPeaks);
+}
+
+/**
+ * @brief Clears the history of the estimator.
+ */
+template<typename R>
+void SpectralPeakEstimator<R>::reset() {
+    std::fill(history, history + size, R{0});
+    historyIndex = 0;
+}
+
+/**
+ * @brief Sets the sample rate of the input and clears the history of the estimator.
+ *
+ * @param sampleRate The sample rate of the input, in Hz.
+ */
+template<typename R>
+void SpectralPeakEstimator<R>::setSampleRate(const R sampleRate) {
+    binWidth = sampleRate / static_cast<R>(size);
+    reset();
+}
+
+template class SpectralPeakEstimator<double>;
+template class SpectralPeakEstimator<float>;
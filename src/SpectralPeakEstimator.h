@@ -0,0 +1,92 @@
+#ifndef SPECTRAL_PEAK_ESTIMATOR_H
+#define SPECTRAL_PEAK_ESTIMATOR_H
+
+#include "FrequencyEstimator.h"
+#include "FFT.h"
+#include <Audio.h>
+
+/**
+ * @brief The SpectralPeakEstimator class estimates the dominant frequency from the peak of an FFT.
+ *
+ * Each estimate applies a Hann window to the most recent samples, computes their spectrum with
+ * an FFT and locates the strongest bin within the requested band to a fraction of a bin by a
+ * parabolic fit on the log power. The cost is O(N log N) per estimate and the error a few
+ * hundredths of a bin, independent of the frequency.
+ *
+ * @tparam R The real type (float or double).
+ */
+template<typename R>
+class SpectralPeakEstimator final : public FrequencyEstimator<R> {
+public:
+    using complex_t = std::complex<R>; ///< Complex type of the spectrum.
+
+    /**
+     * @brief Constructs a SpectralPeakEstimator object.
+     *
+     * @param size The number of samples in the analysis window, a power of two (default is 256).
+     * @param sampleRate The sample rate of the input, in Hz.
+     */
+    explicit SpectralPeakEstimator(std::size_t size = 256, R sampleRate = AUDIO_SAMPLE_RATE_EXACT);
+
+    /**
+     * @brief Destroys the SpectralPeakEstimator object.
+     */
+    ~SpectralPeakEstimator() override;
+
+    SpectralPeakEstimator(const SpectralPeakEstimator&) = delete;
+    SpectralPeakEstimator& operator=(const SpectralPeakEstimator&) = delete;
+
+    /**
+     * @brief Feeds samples to the estimator.
+     *
+     * @param samples The input samples.
+     * @param n The number of samples.
+     */
+    void process(const R* samples, std::size_t n) override;
+
+    /**
+     * @brief Estimates the dominant frequency of the most recent samples.
+     *
+     * @param minFrequency The lowest frequency to consider, in Hz.
+     * @param maxFrequency The highest frequency to consider, in Hz.
+     * @return The estimated frequency in Hz, or 0 if no component was found.
+     */
+    R estimate(R minFrequency, R maxFrequency) override;
+
+    /**
+     * @brief Estimates the frequencies of the strongest components of the most recent samples.
+     *
+     * @param minFrequency The lowest frequency to consider, in Hz.
+     * @param maxFrequency The highest frequency to consider, in Hz.
+     * @param frequencies The estimated frequencies in Hz, strongest first.
+     * @param maxPeaks The maximum number of frequencies to report.
+     * @return The number of frequencies reported.
+     */
+    std::size_t estimatePeaks(R minFrequency, R maxFrequency, R* frequencies, std::size_t maxPeaks) override;
+
+    /**
+     * @brief Clears the history of the estimator.
+     */
+    void reset() override;
+
+    /**
+     * @brief Sets the sample rate of the input and clears the history of the estimator.
+     *
+     * @param sampleRate The sample rate of the input, in Hz.
+     */
+    void setSampleRate(R sampleRate) override;
+
+private:
+    std::size_t size; ///< The number of samples in the analysis window.
+    R binWidth; ///< The frequency spacing of the bins, in Hz.
+    FFT<R> fft; ///< Transform of the analysis window.
+
+    R* history; ///< Ring buffer of the most recent samples.
+    std::size_t historyIndex{0}; ///< Position of the oldest sample in the ring buffer.
+    R* window; ///< Hann window.
+    R* frame; ///< Windowed samples of the current estimate.
+    complex_t* spectrum; ///< Spectrum of the current estimate.
+    R* power; ///< Power of each bin of the current estimate.
+};
+
+#endif
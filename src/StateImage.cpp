@@ -0,0 +1,129 @@
+#include "StateImage.h"
+
+static constexpr std::uint8_t MAGIC[4] = {'A', 'F', 'C', 'S'}; ///< First bytes of an image.
+
+/**
+ * @brief Writes a 16-bit value in little-endian order.
+ */
+static void put16(std::uint8_t* out, const std::uint16_t value) {
+    out[0] = static_cast<std::uint8_t>(value);
+    out[1] = static_cast<std::uint8_t>(value >> 8);
+}
+
+/**
+ * @brief Writes a 32-bit value in little-endian order.
+ */
+static void put32(std::uint8_t* out, const std::uint32_t value) {
+    put16(out, static_cast<std::uint16_t>(value));
+    put16(out + 2, static_cast<std::uint16_t>(value >> 16));
+}
+
+/**
+ * @brief Reads a 16-bit value in little-endian order.
+ */
+static std::uint16_t get16(const std::uint8_t* in) {
+    return static_cast<std::uint16_t>(in[0] | in[1] << 8);
+}
+
+/**
+ * @brief Reads a 32-bit value in little-endian order.
+ */
+static std::uint32_t get32(const std::uint8_t* in) {
+    return get16(in) | static_cast<std::uint32_t>(get16(in + 2)) << 16;
+}
+
+/**
+ * @brief Gets the name of a reason an image is rejected, as used by the serial replies.
+ *
+ * @param error The reason.
+ * @return The upper-case name of the reason.
+ */
+const char* stateImageErrorName(const StateImageError error) {
+    switch (error) {
+        case StateImageError::None:
+            return "OK";
+        case StateImageError::Truncated:
+            return "TRUNCATED";
+        case StateImageError::Magic:
+            return "MAGIC";
+        case StateImageError::Version:
+            return "VERSION";
+        case StateImageError::Build:
+            return "BUILD";
+        case StateImageError::Checksum:
+            return "CHECKSUM";
+    }
+    return "?";
+}
+
+/**
+ * @brief Computes the CRC-32 (IEEE 802.3) of a run of bytes.
+ *
+ * The CRC is computed bit by bit, as telemetryCrc() is: it only runs when an image is saved or
+ * loaded, outside the audio interrupt, and a table would cost 1 KB of RAM.
+ *
+ * @param data The bytes.
+ * @param length The number of bytes.
+ * @return The CRC.
+ */
+std::uint32_t stateImageCrc(const std::uint8_t* data, const std::size_t length) {
+    std::uint32_t crc{0xFFFFFFFF};
+    for (std::size_t i = 0; i < length; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = crc & 1 ? crc >> 1 ^ 0xEDB88320 : crc >> 1;
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Writes the header of an image whose payload has been written after it.
+ *
+ * @param image The image, whose payload starts STATE_HEADER_SIZE bytes in.
+ * @param info The build configuration the payload was saved from.
+ * @param payloadSize The size of the payload.
+ * @return The size of the image.
+ */
+std::size_t sealStateImage(std::uint8_t* image, const StateImageInfo& info, const std::size_t payloadSize) {
+    std::memcpy(image, MAGIC, sizeof(MAGIC));
+    put16(image + 4, STATE_IMAGE_VERSION);
+    image[6] = static_cast<std::uint8_t>(info.sample);
+    image[7] = static_cast<std::uint8_t>(info.filter);
+    put16(image + 8, info.channels);
+    put16(image + 10, 0);
+    put32(image + 12, info.order);
+    put32(image + 16, static_cast<std::uint32_t>(payloadSize));
+    put32(image + 20, stateImageCrc(image + STATE_HEADER_SIZE, payloadSize));
+    return STATE_HEADER_SIZE + payloadSize;
+}
+
+/**
+ * @brief Checks the header and the CRC of an image before its payload is loaded.
+ *
+ * The checks run from the cheapest to the costliest, so a file that is not an image, or an image
+ * of another build, is rejected before its payload is read.
+ *
+ * @param image The image.
+ * @param size The number of bytes available.
+ * @param expected The build configuration loading the image.
+ * @param payloadSize The size of the payload, which starts STATE_HEADER_SIZE bytes in, set if the image is valid.
+ * @return StateImageError::None if the image is valid, the reason it is rejected otherwise.
+ */
+StateImageError openStateImage(const std::uint8_t* image, const std::size_t size, const StateImageInfo& expected,
+                               std::size_t& payloadSize) {
+    if (size < STATE_HEADER_SIZE) return StateImageError::Truncated;
+    if (std::memcmp(image, MAGIC, sizeof(MAGIC)) != 0) return StateImageError::Magic;
+    if (get16(image + 4) != STATE_IMAGE_VERSION) return StateImageError::Version;
+    if (image[6] != static_cast<std::uint8_t>(expected.sample) || image[7] != static_cast<std::uint8_t>(expected.filter) ||
+        get16(image + 8) != expected.channels || get32(image + 12) != expected.order) {
+        return StateImageError::Build;
+    }
+
+    const std::uint32_t payload = get32(image + 16);
+    if (payload > size - STATE_HEADER_SIZE) return StateImageError::Truncated;
+    if (stateImageCrc(image + STATE_HEADER_SIZE, payload) != get32(image + 20)) return StateImageError::Checksum;
+
+    payloadSize = payload;
+    return StateImageError::None;
+}
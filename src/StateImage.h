@@ -0,0 +1,358 @@
+#ifndef STATE_IMAGE_H
+#define STATE_IMAGE_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * State images hold the adaptive state of the feedback canceller, so that it can be saved in a
+ * venue and restored at the next power-up instead of converging from scratch.
+ *
+ * An image is a STATE_HEADER_SIZE byte header followed by the payload written by the saveState()
+ * methods of the filters. The header is laid out as
+ *
+ *   "AFCS" | version (2) | sample type (1) | adaptive filter (1) | channels (2) | reserved (2) |
+ *   order (4) | payload size (4) | CRC (4)
+ *
+ * where the CRC is the CRC-32 (IEEE 802.3) of the payload. Every multi-byte value of the header
+ * and of the payload is written in little-endian order and floating-point values as their IEEE 754
+ * bits, so an image saved by the firmware loads in a host build of the same configuration.
+ */
+
+constexpr std::uint16_t STATE_IMAGE_VERSION{2}; ///< Version of the layout of the payload, raised when it changes.
+constexpr std::size_t STATE_HEADER_SIZE{24}; ///< Size of the header of an image.
+
+/**
+ * @brief Sample types of the filters an image was saved from.
+ */
+enum class StateSample : std::uint8_t {
+    Float, ///< float.
+    Double, ///< double.
+    Q15, ///< q15_t.
+    Q31, ///< q31_t.
+};
+
+/**
+ * @brief Adaptive filters an image was saved from.
+ */
+enum class StateFilter : std::uint8_t {
+    Selectable, ///< SelectableLMSFilter.
+    FDAF, ///< PartitionedFDAFFilter.
+    Subband, ///< SubbandCanceller.
+};
+
+/**
+ * @brief Build configuration an image was saved from, which must match the one loading it.
+ */
+struct StateImageInfo {
+    StateSample sample; ///< Sample type of the filters.
+    StateFilter filter; ///< Adaptive filter.
+    std::uint16_t channels; ///< Number of channels.
+    std::uint32_t order; ///< Number of taps of the adaptive filter.
+};
+
+/**
+ * @brief Reasons an image is rejected.
+ */
+enum class StateImageError : std::uint8_t {
+    None, ///< The image is valid.
+    Truncated, ///< The image is shorter than its header says.
+    Magic, ///< The image does not start with "AFCS".
+    Version, ///< The payload has another layout version.
+    Build, ///< The image was saved by another build configuration.
+    Checksum, ///< The CRC of the payload does not match.
+};
+
+/**
+ * @brief Gets the name of a reason an image is rejected, as used by the serial replies.
+ *
+ * @param error The reason.
+ * @return The upper-case name of the reason.
+ */
+const char* stateImageErrorName(StateImageError error);
+
+/**
+ * @brief Computes the CRC-32 (IEEE 802.3) of a run of bytes.
+ *
+ * @param data The bytes.
+ * @param length The number of bytes.
+ * @return The CRC.
+ */
+std::uint32_t stateImageCrc(const std::uint8_t* data, std::size_t length);
+
+/**
+ * @brief Writes the header of an image whose payload has been written after it.
+ *
+ * @param image The image, whose payload starts STATE_HEADER_SIZE bytes in.
+ * @param info The build configuration the payload was saved from.
+ * @param payloadSize The size of the payload.
+ * @return The size of the image.
+ */
+std::size_t sealStateImage(std::uint8_t* image, const StateImageInfo& info, std::size_t payloadSize);
+
+/**
+ * @brief Checks the header and the CRC of an image before its payload is loaded.
+ *
+ * @param image The image.
+ * @param size The number of bytes available.
+ * @param expected The build configuration loading the image.
+ * @param payloadSize The size of the payload, which starts STATE_HEADER_SIZE bytes in, set if the image is valid.
+ * @return StateImageError::None if the image is valid, the reason it is rejected otherwise.
+ */
+StateImageError openStateImage(const std::uint8_t* image, std::size_t size, const StateImageInfo& expected, std::size_t& payloadSize);
+
+/**
+ * @brief The StateWriter class writes the values of a state image payload in little-endian order.
+ *
+ * Constructed without a buffer, it only counts the bytes, so the size of a payload can be found
+ * by running the same saveState() that writes it. Writing past the end of the buffer sets a flag
+ * instead, and the payload is then unusable.
+ */
+class StateWriter final {
+public:
+    /**
+     * @brief Constructs a StateWriter object that only counts the bytes.
+     */
+    StateWriter() = default;
+
+    /**
+     * @brief Constructs a StateWriter object filling a buffer.
+     *
+     * @param buffer The buffer.
+     * @param capacity The size of the buffer.
+     */
+    StateWriter(std::uint8_t* buffer, const std::size_t capacity) : buffer(buffer), capacity(capacity) {}
+
+    void write(const std::uint8_t value) { put(value, 1); } ///< Writes an 8-bit value.
+    void write(const std::uint16_t value) { put(value, 2); } ///< Writes a 16-bit value.
+    void write(const std::uint32_t value) { put(value, 4); } ///< Writes a 32-bit value.
+    void write(const std::int16_t value) { put(static_cast<std::uint16_t>(value), 2); } ///< Writes a q15_t sample.
+    void write(const std::int32_t value) { put(static_cast<std::uint32_t>(value), 4); } ///< Writes a q31_t sample.
+
+    /**
+     * @brief Writes a float as its IEEE 754 bits.
+     */
+    void write(const float value) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        put(bits, 4);
+    }
+
+    /**
+     * @brief Writes a double as its IEEE 754 bits.
+     */
+    void write(const double value) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        put(bits, 8);
+    }
+
+    /**
+     * @brief Writes a complex value, real part first.
+     */
+    template<typename V>
+    void write(const std::complex<V>& value) {
+        write(value.real());
+        write(value.imag());
+    }
+
+    /**
+     * @brief Writes a count or an index as a 32-bit value.
+     */
+    void writeSize(const std::size_t value) { put(value, 4); }
+
+    /**
+     * @brief Writes an array of values.
+     *
+     * @param values The values.
+     * @param count The number of values.
+     */
+    template<typename V>
+    void write(const V* values, const std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            write(values[i]);
+        }
+    }
+
+    /**
+     * @brief Gets the number of bytes written, or counted.
+     *
+     * @return The number of bytes.
+     */
+    [[nodiscard]] std::size_t size() const { return position; }
+
+    /**
+     * @brief Checks if the payload did not fit in the buffer.
+     *
+     * @return True if bytes were dropped, false otherwise.
+     */
+    [[nodiscard]] bool overflowed() const { return overflow; }
+
+private:
+    std::uint8_t* buffer{nullptr}; ///< The buffer, nullptr to only count the bytes.
+    std::size_t capacity{0}; ///< The size of the buffer.
+    std::size_t position{0}; ///< The number of bytes written.
+    bool overflow{false}; ///< True if bytes did not fit in the buffer.
+
+    /**
+     * @brief Writes the low bytes of a value, least significant first.
+     *
+     * @param value The value.
+     * @param bytes The number of bytes.
+     */
+    void put(std::uint64_t value, const std::size_t bytes) {
+        if (buffer) {
+            if (position + bytes > capacity) {
+                overflow = true;
+                return;
+            }
+            for (std::size_t i = 0; i < bytes; ++i, value >>= 8) {
+                buffer[position + i] = static_cast<std::uint8_t>(value);
+            }
+        }
+        position += bytes;
+    }
+};
+
+/**
+ * @brief The StateReader class reads back the values written by StateWriter.
+ *
+ * Reading past the end of the payload leaves the values unchanged and makes ok() false for good,
+ * so a loadState() can read everything and check once.
+ */
+class StateReader final {
+public:
+    /**
+     * @brief Constructs a StateReader object over a payload.
+     *
+     * @param data The payload.
+     * @param size The size of the payload.
+     */
+    StateReader(const std::uint8_t* data, const std::size_t size) : data(data), size(size) {}
+
+    bool read(std::uint8_t& value) { return get(value, 1); } ///< Reads an 8-bit value.
+    bool read(std::uint16_t& value) { return get(value, 2); } ///< Reads a 16-bit value.
+    bool read(std::uint32_t& value) { return get(value, 4); } ///< Reads a 32-bit value.
+
+    /**
+     * @brief Reads a q15_t sample.
+     */
+    bool read(std::int16_t& value) {
+        std::uint16_t bits;
+        if (!get(bits, 2)) return false;
+        value = static_cast<std::int16_t>(bits);
+        return true;
+    }
+
+    /**
+     * @brief Reads a q31_t sample.
+     */
+    bool read(std::int32_t& value) {
+        std::uint32_t bits;
+        if (!get(bits, 4)) return false;
+        value = static_cast<std::int32_t>(bits);
+        return true;
+    }
+
+    /**
+     * @brief Reads a float from its IEEE 754 bits.
+     */
+    bool read(float& value) {
+        std::uint32_t bits;
+        if (!get(bits, 4)) return false;
+        std::memcpy(&value, &bits, sizeof(value));
+        return true;
+    }
+
+    /**
+     * @brief Reads a double from its IEEE 754 bits.
+     */
+    bool read(double& value) {
+        std::uint64_t bits;
+        if (!get(bits, 8)) return false;
+        std::memcpy(&value, &bits, sizeof(value));
+        return true;
+    }
+
+    /**
+     * @brief Reads a complex value, real part first.
+     */
+    template<typename V>
+    bool read(std::complex<V>& value) {
+        V real{}, imag{};
+        if (!read(real) || !read(imag)) return false;
+        value = {real, imag};
+        return true;
+    }
+
+    /**
+     * @brief Reads a count or an index written by StateWriter::writeSize().
+     */
+    bool readSize(std::size_t& value) {
+        std::uint32_t bits;
+        if (!get(bits, 4)) return false;
+        value = bits;
+        return true;
+    }
+
+    /**
+     * @brief Reads an array of values.
+     *
+     * @param values The values.
+     * @param count The number of values.
+     * @return True if every value was read, false otherwise.
+     */
+    template<typename V>
+    bool read(V* values, const std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            if (!read(values[i])) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Checks if every read so far was within the payload.
+     *
+     * @return True if no read ran past the end, false otherwise.
+     */
+    [[nodiscard]] bool ok() const { return !failed; }
+
+    /**
+     * @brief Gets the number of bytes not read yet.
+     *
+     * @return The number of bytes.
+     */
+    [[nodiscard]] std::size_t remaining() const { return size - position; }
+
+private:
+    const std::uint8_t* data; ///< The payload.
+    std::size_t size; ///< The size of the payload.
+    std::size_t position{0}; ///< The number of bytes read.
+    bool failed{false}; ///< True once a read ran past the end.
+
+    /**
+     * @brief Reads a value of some bytes, least significant first.
+     *
+     * @param value The value.
+     * @param bytes The number of bytes.
+     * @return True if the bytes were available, false otherwise.
+     */
+    template<typename U>
+    bool get(U& value, const std::size_t bytes) {
+        if (failed || bytes > size - position) {
+            failed = true;
+            return false;
+        }
+        std::uint64_t bits{0};
+        for (std::size_t i = bytes; i-- > 0;) {
+            bits = bits << 8 | data[position + i];
+        }
+        value = static_cast<U>(bits);
+        position += bytes;
+        return true;
+    }
+};
+
+#endif
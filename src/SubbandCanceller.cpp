@@ -0,0 +1,266 @@
+#include "SubbandCanceller.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Constructs a SubbandCanceller object.
+ *
+ * The analysis prototype is a Hann-windowed sinc cutoff at fs / (8 * Bands), the half-width of a
+ * complex subband, normalized for unit DC gain. The synthesis prototype is cutoff at twice that
+ * frequency, and scaled so that a signal going through both banks keeps its level.
+ *
+ * @param order The number of taps of the fullband filter modelled.
+ * @param mu The adaptation rate of every subband.
+ */
+template<typename T, std::size_t Bands>
+SubbandCanceller<T, Bands>::SubbandCanceller(const std::size_t order, const real_t mu)
+    : lms((order + DECIMATION - 1) / DECIMATION + SPREAD_TAPS, mu) {
+    const double pi = std::acos(-1.0);
+    const auto prototype = [pi](const std::size_t i, const double cutoff) {
+        const double t = static_cast<double>(i) - static_cast<double>(PROTOTYPE_LENGTH / 2);
+        const double window = 0.5 - 0.5 * std::cos(2.0 * pi * static_cast<double>(i) / static_cast<double>(PROTOTYPE_LENGTH));
+        return window * (t == 0.0 ? 2.0 * cutoff : std::sin(2.0 * pi * cutoff * t) / (pi * t));
+    };
+
+    double analysis[PROTOTYPE_LENGTH], synthesis[PROTOTYPE_LENGTH];
+    double analysisSum{0.0}, synthesisSum{0.0};
+    for (std::size_t i = 0; i < PROTOTYPE_LENGTH; ++i) {
+        analysis[i] = prototype(i, 1.0 / static_cast<double>(FFT_SIZE));
+        synthesis[i] = prototype(i, 2.0 / static_cast<double>(FFT_SIZE));
+        analysisSum += analysis[i];
+        synthesisSum += synthesis[i];
+    }
+
+    // Each sample is rebuilt from the FFT_SIZE / 2 complex subbands, of which only the odd bins of
+    // positive frequency are computed, at 1 / DECIMATION of the rate, and scaled by 1 / FFT_SIZE by
+    // the inverse transform.
+    double overlap{0.0};
+    for (std::size_t i = 0; i < PROTOTYPE_LENGTH; ++i) {
+        analysis[i] /= analysisSum;
+        synthesis[i] /= synthesisSum;
+        overlap += analysis[i] * synthesis[i];
+    }
+    const double synthesisGain = 4.0 * static_cast<double>(DECIMATION) / overlap;
+    for (std::size_t i = 0; i < PROTOTYPE_LENGTH; ++i) {
+        analysisWindow[i] = static_cast<T>(analysis[i]);
+        synthesisWindow[i] = static_cast<T>(synthesis[i] * synthesisGain);
+    }
+
+    for (std::size_t p = 0; p < ROTATIONS; ++p) {
+        rotation[p] = std::polar(T{1}, static_cast<T>(-pi * static_cast<double>(p) / 4.0));
+    }
+
+    reset();
+}
+
+/**
+ * @brief Resets the subband filters and the filterbank history.
+ */
+template<typename T, std::size_t Bands>
+void SubbandCanceller<T, Bands>::reset() {
+    lms.reset();
+    std::fill(std::begin(referenceLine), std::end(referenceLine), T{});
+    std::fill(std::begin(desiredLine), std::end(desiredLine), T{});
+    std::fill(std::begin(outputLine), std::end(outputLine), T{});
+    lineIndex = 0;
+    outputIndex = 0;
+    phase = 0;
+    frame = 0;
+}
+
+/**
+ * @brief Splits the newest frame of a history into the real subband samples.
+ *
+ * The history weighted by the analysis prototype is folded with a period of FFT_SIZE, so that bin
+ * 2k + 1 of its transform is the conjugate of complex subband k, up to a rotation. The rotation
+ * also shifts the subband up by a quarter of the subband rate, which moves its negative frequencies
+ * above zero, so that its real part keeps all of it.
+ *
+ * @param line The mirrored history.
+ * @param subbands The Bands subband samples.
+ */
+template<typename T, std::size_t Bands>
+void SubbandCanceller<T, Bands>::analyze(const T* line, T* subbands) {
+    const T* newest = line + lineIndex;
+    for (std::size_t n = 0; n < FFT_SIZE; ++n) {
+        T sum{0};
+        for (std::size_t i = n; i < PROTOTYPE_LENGTH; i += FFT_SIZE) {
+            sum += analysisWindow[i] * newest[i];
+        }
+        folded[n] = sum;
+    }
+    fft.forward(folded, bins);
+
+    for (std::size_t k = 0; k < Bands; ++k) {
+        const complex_t& q = rotation[((2 * k + ROTATIONS - 1) * frame) % ROTATIONS];
+        const complex_t& bin = bins[2 * k + 1];
+        subbands[k] = bin.real() * q.real() + bin.imag() * q.imag();
+    }
+}
+
+/**
+ * @brief Filters one frame of subband samples and overlap-adds the synthesized error.
+ *
+ * The subband errors are rotated back into the odd bins, which rebuilds the complex subbands along
+ * with an image at half the subband rate that the synthesis prototype removes.
+ *
+ * @param shared True if the desired signal is the reference signal.
+ */
+template<typename T, std::size_t Bands>
+void SubbandCanceller<T, Bands>::processFrame(const bool shared) {
+    analyze(referenceLine, subbandReference);
+    if (shared) {
+        std::copy(std::begin(subbandReference), std::end(subbandReference), subbandDesired);
+    } else {
+        analyze(desiredLine, subbandDesired);
+    }
+
+    lms.tickFrame(subbandReference, subbandDesired, subbandError);
+
+    std::fill(std::begin(bins), std::end(bins), complex_t{});
+    for (std::size_t k = 0; k < Bands; ++k) {
+        bins[2 * k + 1] = subbandError[k] * std::conj(rotation[((2 * k + ROTATIONS - 1) * frame) % ROTATIONS]);
+    }
+    fft.inverse(bins, folded);
+
+    const std::size_t wrap = PROTOTYPE_LENGTH - outputIndex;
+    for (std::size_t i = 0; i < wrap; ++i) {
+        outputLine[outputIndex + i] += synthesisWindow[i] * folded[i % FFT_SIZE];
+    }
+    for (std::size_t i = wrap; i < PROTOTYPE_LENGTH; ++i) {
+        outputLine[i - wrap] += synthesisWindow[i] * folded[i % FFT_SIZE];
+    }
+
+    frame = (frame + 1) % ROTATIONS;
+}
+
+/**
+ * @brief Processes a block of reference samples against separate desired samples.
+ *
+ * @param reference The reference samples.
+ * @param desired The desired samples.
+ * @param error The error samples, delayed by LATENCY samples.
+ * @param n The number of samples in the block.
+ */
+template<typename T, std::size_t Bands>
+void SubbandCanceller<T, Bands>::processBlock(const T* reference, const T* desired, T* error, const std::size_t n) {
+    const bool shared = reference == desired;
+    for (std::size_t i = 0; i < n; ++i) {
+        lineIndex = (lineIndex == 0 ? PROTOTYPE_LENGTH : lineIndex) - 1;
+        referenceLine[lineIndex] = referenceLine[lineIndex + PROTOTYPE_LENGTH] = reference[i];
+        desiredLine[lineIndex] = desiredLine[lineIndex + PROTOTYPE_LENGTH] = desired[i];
+
+        if (++phase == DECIMATION) {
+            phase = 0;
+            processFrame(shared);
+        }
+
+        error[i] = outputLine[outputIndex];
+        outputLine[outputIndex] = T{};
+        outputIndex = (outputIndex + 1) % PROTOTYPE_LENGTH;
+    }
+}
+
+/**
+ * @brief Processes a block of input samples and writes the filtered output.
+ *
+ * @param in The input samples to be filtered.
+ * @param out The filtered output samples, delayed by LATENCY samples.
+ * @param n The number of samples in the block.
+ */
+template<typename T, std::size_t Bands>
+void SubbandCanceller<T, Bands>::processBlock(const T* in, T* out, const std::size_t n) {
+    processBlock(in, in, out, n);
+}
+
+/**
+ * @brief Processes a reference sample against a separate desired sample and returns the error.
+ *
+ * @param reference The reference sample.
+ * @param desired The desired sample.
+ * @return The error sample, delayed by LATENCY samples.
+ */
+template<typename T, std::size_t Bands>
+T SubbandCanceller<T, Bands>::tick(const T reference, const T desired) {
+    T error{};
+    processBlock(&reference, &desired, &error, 1);
+    return error;
+}
+
+/**
+ * @brief Processes an input sample and returns the filtered output.
+ *
+ * @param micSample The input sample to be filtered.
+ * @return The filtered output sample, delayed by LATENCY samples.
+ */
+template<typename T, std::size_t Bands>
+T SubbandCanceller<T, Bands>::tick(const T micSample) {
+    return tick(micSample, micSample);
+}
+
+/**
+ * @brief Gets the first weights of the subband filters, laid out one subband after the other.
+ *
+ * @param impulseResponse The output weights.
+ * @param count The number of weights to read, at most getOrder().
+ * @param channel The channel, always 0.
+ */
+template<typename T, std::size_t Bands>
+void SubbandCanceller<T, Bands>::getImpulseResponse(T* impulseResponse, const std::size_t count, std::size_t) const {
+    const std::size_t taps = lms.getOrder();
+    for (std::size_t k = 0; k * taps < count; ++k) {
+        lms.getImpulseResponse(impulseResponse + k * taps, std::min(taps, count - k * taps), k);
+    }
+}
+
+/**
+ * @brief Writes the state of the subband filters and the histories of the filterbank.
+ *
+ * @param writer The writer of the state image.
+ */
+template<typename T, std::size_t Bands>
+void SubbandCanceller<T, Bands>::saveState(StateWriter& writer) const {
+    lms.saveState(writer);
+    writer.write(referenceLine, 2 * PROTOTYPE_LENGTH);
+    writer.write(desiredLine, 2 * PROTOTYPE_LENGTH);
+    writer.writeSize(lineIndex);
+    writer.write(outputLine, PROTOTYPE_LENGTH);
+    writer.writeSize(outputIndex);
+    writer.writeSize(phase);
+    writer.writeSize(frame);
+}
+
+/**
+ * @brief Reads back the state written by saveState() from a canceller of the same order.
+ *
+ * @param reader The reader of the state image.
+ * @return True if the state was read, false otherwise.
+ */
+template<typename T, std::size_t Bands>
+bool SubbandCanceller<T, Bands>::loadState(StateReader& reader) {
+    if (!lms.loadState(reader)) return false;
+
+    std::size_t savedLineIndex{0}, savedOutputIndex{0}, savedPhase{0}, savedFrame{0};
+    reader.read(referenceLine, 2 * PROTOTYPE_LENGTH);
+    reader.read(desiredLine, 2 * PROTOTYPE_LENGTH);
+    reader.readSize(savedLineIndex);
+    reader.read(outputLine, PROTOTYPE_LENGTH);
+    reader.readSize(savedOutputIndex);
+    reader.readSize(savedPhase);
+    reader.readSize(savedFrame);
+    if (!reader.ok() || savedLineIndex >= PROTOTYPE_LENGTH || savedOutputIndex >= PROTOTYPE_LENGTH || savedPhase >= DECIMATION ||
+        savedFrame >= ROTATIONS) {
+        return false;
+    }
+
+    lineIndex = savedLineIndex;
+    outputIndex = savedOutputIndex;
+    phase = savedPhase;
+    frame = savedFrame;
+    return true;
+}
+
+template class SubbandCanceller<double>;
+template class SubbandCanceller<float>;
+template class SubbandCanceller<double, 8>;
+template class SubbandCanceller<float, 8>;
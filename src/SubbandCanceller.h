@@ -0,0 +1,240 @@
+#ifndef SUBBAND_CANCELLER_H
+#define SUBBAND_CANCELLER_H
+
+#include "FFT.h"
+#include "LMSFilter.h"
+#include <complex>
+#include <cstddef>
+
+/**
+ * @brief The SubbandCanceller class implements an adaptive filter running in decimated subbands.
+ *
+ * An oversampled polyphase filterbank splits the reference and desired signals into 2 * Bands complex
+ * subbands centred on (k + 1/2) * fs / (2 * Bands), decimated by DECIMATION = Bands / 2. Each frame of
+ * DECIMATION samples, the analysis folds the history weighted by the prototype filter into 4 * Bands
+ * samples and transforms them with one real FFT, whose odd bins are the Bands subbands of positive
+ * frequency. Each of them is shifted by a quarter of the subband rate and its real part is kept, so the
+ * Bands subbands are real signals that run through one multichannel LMSFilter<T, Bands>, one channel per
+ * subband, with order / DECIMATION taps plus a few to model the spreading of the feedback path by the
+ * filterbank. The synthesis bank puts the subband errors back in the odd bins, transforms them back
+ * and overlap-adds them weighted by a second prototype filter.
+ *
+ * The analysis prototype is a Hann-windowed sinc cutoff at the half-width of a subband, so the subbands
+ * add up to the input. The synthesis prototype is twice as wide, flat over the analysis band and stopping
+ * before the image left by the real subbands, so the reconstruction only depends on the analysis bank.
+ * Both are 8 * 2 * Bands taps long, which delays the error by LATENCY samples.
+ *
+ * The adaptive filter sees each subband at 1 / DECIMATION of the sample rate with a spectrum much
+ * flatter than the fullband signal, which speeds up convergence on coloured input such as music. The
+ * LMS cost per sample falls by about Bands / 4 against a fullband LMSFilter of the same length, the
+ * filterbank adding two FFTs of 4 * Bands samples per frame, so it pays off for long filters. It offers
+ * the same interface as LMSFilter with a single channel, so it can be used as the adaptive filter of
+ * NotchLMSFilter.
+ *
+ * @tparam T The sample type (float or double).
+ * @tparam Bands The number of real subbands, a power of two of at least 4 (default is 16).
+ */
+template<typename T, std::size_t Bands = 16>
+class SubbandCanceller final {
+public:
+    using real_t = T; ///< Type used for the adaptation control logic.
+    using complex_t = std::complex<T>; ///< Complex type of the spectra.
+
+    static constexpr std::size_t CHANNELS = 1; ///< Number of channels filtered.
+    static constexpr std::size_t BANDS = Bands; ///< Number of real subbands.
+    static constexpr std::size_t DECIMATION = Bands / 2; ///< Number of samples per subband sample.
+    static constexpr std::size_t PROTOTYPE_LENGTH = 16 * Bands; ///< Number of taps of the prototype filters.
+    static constexpr std::size_t LATENCY = PROTOTYPE_LENGTH; ///< Delay of the error, in samples.
+    static constexpr std::size_t SPREAD_TAPS = 8; ///< Subband taps added to model the spreading by the filterbank.
+
+    static_assert(Bands >= 4 && (Bands & (Bands - 1)) == 0, "the number of subbands must be a power of two of at least 4");
+
+    /**
+     * @brief Constructs a SubbandCanceller object.
+     *
+     * @param order The number of taps of the fullband filter modelled.
+     * @param mu The adaptation rate of every subband (default is 0.0001).
+     */
+    explicit SubbandCanceller(std::size_t order, real_t mu = 0.0001);
+
+    SubbandCanceller(const SubbandCanceller&) = delete;
+    SubbandCanceller& operator=(const SubbandCanceller&) = delete;
+
+    /**
+     * @brief Processes an input sample and returns the filtered output.
+     *
+     * @param micSample The input sample to be filtered.
+     * @return The filtered output sample, delayed by LATENCY samples.
+     */
+    T tick(T micSample);
+
+    /**
+     * @brief Processes a reference sample against a separate desired sample and returns the error.
+     *
+     * @param reference The reference sample.
+     * @param desired The desired sample.
+     * @return The error sample, delayed by LATENCY samples.
+     */
+    T tick(T reference, T desired);
+
+    /**
+     * @brief Processes a block of input samples and writes the filtered output.
+     *
+     * The input and output buffers may alias.
+     *
+     * @param in The input samples to be filtered.
+     * @param out The filtered output samples, delayed by LATENCY samples.
+     * @param n The number of samples in the block.
+     */
+    void processBlock(const T* in, T* out, std::size_t n);
+
+    /**
+     * @brief Processes a block of reference samples against separate desired samples.
+     *
+     * The buffers may alias. When the reference and desired buffers are the same, the signal is
+     * analysed once.
+     *
+     * @param reference The reference samples.
+     * @param desired The desired samples.
+     * @param error The error samples, delayed by LATENCY samples.
+     * @param n The number of samples in the block.
+     */
+    void processBlock(const T* reference, const T* desired, T* error, std::size_t n);
+
+    /**
+     * @brief Processes a block of input samples given as one buffer per channel.
+     *
+     * This is the interface of the multichannel LMSFilter, with a single channel.
+     *
+     * @param in The input samples to be filtered, one buffer.
+     * @param out The filtered output samples, one buffer.
+     * @param n The number of samples in the block.
+     */
+    void processBlock(const T* const* in, T* const* out, const std::size_t n) { processBlock(in[0], out[0], n); }
+
+    /**
+     * @brief Resets the subband filters and the filterbank history.
+     */
+    void reset();
+
+    /**
+     * @brief Sets the adaptation rate (mu) of every subband.
+     *
+     * @param newMu The new adaptation rate.
+     */
+    void setMu(const real_t newMu) { lms.setMu(newMu); }
+
+    /**
+     * @brief Gets the adaptation rate (mu) of the first subband.
+     *
+     * @return The current adaptation rate.
+     */
+    [[nodiscard]] real_t getMu(std::size_t = 0) const { return lms.getMu(0); }
+
+    /**
+     * @brief Gets the adaptation rate (mu) requested for the subbands.
+     *
+     * @return The requested adaptation rate.
+     */
+    [[nodiscard]] real_t getRequestedMu() const { return lms.getRequestedMu(); }
+
+    /**
+     * @brief Gets the leakage factor (gamma) applied to the weights of the first subband at the last update.
+     *
+     * @return The last gamma value.
+     */
+    [[nodiscard]] real_t getGamma(std::size_t = 0) const { return lms.getGamma(0); }
+
+    /**
+     * @brief Gets the number of weights of all the subband filters.
+     *
+     * @return The number of weights.
+     */
+    [[nodiscard]] std::size_t getOrder() const { return Bands * lms.getOrder(); }
+
+    /**
+     * @brief Gets the number of taps of each subband filter.
+     *
+     * @return The number of taps.
+     */
+    [[nodiscard]] std::size_t getSubbandOrder() const { return lms.getOrder(); }
+
+    /**
+     * @brief Gets the first weights of the subband filters, laid out one subband after the other.
+     *
+     * @param impulseResponse The output weights.
+     * @param count The number of weights to read, at most getOrder().
+     * @param channel The channel, always 0.
+     */
+    void getImpulseResponse(T* impulseResponse, std::size_t count, std::size_t channel = 0) const;
+
+    /**
+     * @brief Writes the state of the subband filters and the histories of the filterbank.
+     *
+     * @param writer The writer of the state image.
+     */
+    void saveState(StateWriter& writer) const;
+
+    /**
+     * @brief Reads back the state written by saveState() from a canceller of the same order.
+     *
+     * @param reader The reader of the state image.
+     * @return True if the state was read, false otherwise.
+     */
+    bool loadState(StateReader& reader);
+
+    /**
+     * @brief Sets the length of the window over which the subband filters estimate their noise parameters.
+     *
+     * @param size The new window length, in subband samples.
+     */
+    void setEstimationWindow(const std::size_t size) { lms.setEstimationWindow(size); }
+
+    static constexpr std::size_t MIN_ESTIMATION_WINDOW = LMSFilter<T, Bands>::MIN_ESTIMATION_WINDOW; ///< Minimum window size for noise estimation.
+    static constexpr std::size_t MAX_ESTIMATION_WINDOW = LMSFilter<T, Bands>::MAX_ESTIMATION_WINDOW; ///< Maximum window size for noise estimation.
+
+private:
+    static constexpr std::size_t FFT_SIZE = 4 * Bands; ///< Size of the filterbank transform, twice the number of complex subbands.
+    static constexpr std::size_t BIN_COUNT = FFT_SIZE / 2 + 1; ///< Number of bins of the filterbank transform.
+    static constexpr std::size_t ROTATIONS = 8; ///< Period of the subband rotations, in frames.
+
+    LMSFilter<T, Bands> lms; ///< The subband filters, one channel per subband.
+    FFT<T> fft{FFT_SIZE}; ///< The filterbank transform.
+
+    T analysisWindow[PROTOTYPE_LENGTH]; ///< Analysis prototype filter.
+    T synthesisWindow[PROTOTYPE_LENGTH]; ///< Synthesis prototype filter, scaled for unit gain.
+    complex_t rotation[ROTATIONS]; ///< exp(-j * pi * p / 4), the rotations of the subbands.
+
+    T referenceLine[2 * PROTOTYPE_LENGTH]; ///< Mirrored reference history, newest sample first.
+    T desiredLine[2 * PROTOTYPE_LENGTH]; ///< Mirrored desired history, newest sample first.
+    std::size_t lineIndex{0}; ///< Position of the newest sample in the histories.
+
+    T outputLine[PROTOTYPE_LENGTH]; ///< Overlap-add ring of the synthesized error.
+    std::size_t outputIndex{0}; ///< Position of the next error sample in the ring.
+
+    T folded[FFT_SIZE]; ///< Folded history, then synthesized frame.
+    complex_t bins[BIN_COUNT]; ///< Spectrum of the folded history, then of the subband errors.
+    T subbandReference[Bands]; ///< Reference sample of each subband.
+    T subbandDesired[Bands]; ///< Desired sample of each subband.
+    T subbandError[Bands]; ///< Error sample of each subband.
+
+    std::size_t phase{0}; ///< Number of samples in the current frame.
+    std::size_t frame{0}; ///< Index of the current frame modulo ROTATIONS.
+
+    /**
+     * @brief Splits the newest frame of a history into the real subband samples.
+     *
+     * @param line The mirrored history.
+     * @param subbands The Bands subband samples.
+     */
+    void analyze(const T* line, T* subbands);
+
+    /**
+     * @brief Filters one frame of subband samples and overlap-adds the synthesized error.
+     *
+     * @param shared True if the desired signal is the reference signal.
+     */
+    void processFrame(bool shared);
+};
+
+#endif
@@ -0,0 +1,35 @@
+#include "TaskScheduler.h"
+
+/**
+ * @brief Adds a task, first run at the next call to run().
+ *
+ * @param task The task.
+ * @param periodMicros The period of the task, in microseconds, zero to run it on every call.
+ * @return True if the task was added, false if MAX_TASKS tasks are already registered.
+ */
+bool TaskScheduler::add(const Task task, const std::uint32_t periodMicros) {
+    if (taskCount == MAX_TASKS) return false;
+    tasks[taskCount++] = Entry{task, periodMicros, 0, false};
+    return true;
+}
+
+/**
+ * @brief Runs the tasks that are due.
+ *
+ * Times are compared through their difference, so the 71-minute wrap of micros() is harmless.
+ *
+ * @param nowMicros The current time, in microseconds, as returned by micros().
+ */
+void TaskScheduler::run(const std::uint32_t nowMicros) {
+    for (std::size_t i = 0; i < taskCount; ++i) {
+        Entry& entry = tasks[i];
+        if (entry.started && static_cast<std::int32_t>(nowMicros - entry.next) < 0) continue;
+
+        entry.next = entry.started ? entry.next + entry.period : nowMicros + entry.period;
+        if (static_cast<std::int32_t>(nowMicros - entry.next) >= 0) {
+            entry.next = nowMicros + entry.period;
+        }
+        entry.started = true;
+        entry.task();
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The TaskScheduler class runs periodic tasks cooperatively from loop().
+ *
+ * Each task is a function with its own period. run() calls the tasks that are due and returns
+ * at once, so loop() never sleeps: a task with a zero period runs on every call. A task that
+ * falls behind by more than one period skips the missed runs instead of running in a burst.
+ */
+class TaskScheduler {
+public:
+    using Task = void (*)(); ///< A task.
+
+    static constexpr std::size_t MAX_TASKS = 12; ///< Maximum number of tasks.
+
+    /**
+     * @brief Adds a task, first run at the next call to run().
+     *
+     * @param task The task.
+     * @param periodMicros The period of the task, in microseconds, zero to run it on every call.
+     * @return True if the task was added, false if MAX_TASKS tasks are already registered.
+     */
+    bool add(Task task, std::uint32_t periodMicros);
+
+    /**
+     * @brief Runs the tasks that are due.
+     *
+     * @param nowMicros The current time, in microseconds, as returned by micros().
+     */
+    void run(std::uint32_t nowMicros);
+
+private:
+    /**
+     * @brief A registered task.
+     */
+    struct Entry {
+        Task task; ///< The task.
+        std::uint32_t period; ///< Period, in microseconds.
+        std::uint32_t next; ///< Time of the next run, in microseconds.
+        bool started; ///< True once the task has run.
+    };
+
+    Entry tasks[MAX_TASKS]{}; ///< The registered tasks.
+    std::size_t taskCount{0}; ///< Number of registered tasks.
+};
+
+#endif
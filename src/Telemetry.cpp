@@ -0,0 +1,311 @@
+#include "Telemetry.h"
+#include <cstring>
+
+/**
+ * @brief Writes a 16-bit value in little-endian order.
+ */
+static void put16(std::uint8_t* out, const std::uint16_t value) {
+    out[0] = static_cast<std::uint8_t>(value);
+    out[1] = static_cast<std::uint8_t>(value >> 8);
+}
+
+/**
+ * @brief Writes a 32-bit value in little-endian order.
+ */
+static void put32(std::uint8_t* out, const std::uint32_t value) {
+    put16(out, static_cast<std::uint16_t>(value));
+    put16(out + 2, static_cast<std::uint16_t>(value >> 16));
+}
+
+/**
+ * @brief Writes a float as its IEEE 754 bits in little-endian order.
+ */
+static void putFloat(std::uint8_t* out, const float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put32(out, bits);
+}
+
+/**
+ * @brief Reads a 16-bit value in little-endian order.
+ */
+static std::uint16_t get16(const std::uint8_t* in) {
+    return static_cast<std::uint16_t>(in[0] | in[1] << 8);
+}
+
+/**
+ * @brief Reads a 32-bit value in little-endian order.
+ */
+static std::uint32_t get32(const std::uint8_t* in) {
+    return get16(in) | static_cast<std::uint32_t>(get16(in + 2)) << 16;
+}
+
+/**
+ * @brief Reads a float from its IEEE 754 bits in little-endian order.
+ */
+static float getFloat(const std::uint8_t* in) {
+    const std::uint32_t bits = get32(in);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Encodes a frequency payload.
+ *
+ * @param value The payload.
+ * @param payload The TelemetryFrequency::SIZE bytes to fill.
+ */
+void encodePayload(const TelemetryFrequency& value, std::uint8_t* payload) {
+    putFloat(payload, value.frequency);
+    putFloat(payload + 4, value.magnitude);
+}
+
+/**
+ * @brief Encodes a block payload.
+ *
+ * @param value The payload.
+ * @param payload The TelemetryBlock::SIZE bytes to fill.
+ */
+void encodePayload(const TelemetryBlock& value, std::uint8_t* payload) {
+    put32(payload, value.block);
+    put16(payload + 4, value.inputPeak);
+    put16(payload + 6, value.outputPeak);
+    putFloat(payload + 8, value.notchFrequency);
+    payload[12] = value.activeNotches;
+}
+
+/**
+ * @brief Encodes an acknowledgement payload.
+ *
+ * @param value The payload.
+ * @param payload The TelemetryAck::SIZE bytes to fill.
+ */
+void encodePayload(const TelemetryAck& value, std::uint8_t* payload) {
+    put32(payload, value.id);
+    put32(payload + 4, value.block);
+}
+
+/**
+ * @brief Encodes a snapshot payload.
+ *
+ * @param value The payload.
+ * @param payload The TelemetrySnapshot::SIZE bytes to fill.
+ */
+void encodePayload(const TelemetrySnapshot& value, std::uint8_t* payload) {
+    put32(payload, value.block);
+    putFloat(payload + 4, value.mu);
+    putFloat(payload + 8, value.gamma);
+    putFloat(payload + 12, value.notchFrequency);
+    putFloat(payload + 16, value.notchBandwidth);
+    payload[20] = value.activeNotches;
+    put16(payload + 21, value.tapCount);
+    payload[23] = value.channel;
+}
+
+/**
+ * @brief Encodes a weights payload.
+ *
+ * @param value The payload.
+ * @param payload The TelemetryWeights::SIZE bytes to fill.
+ */
+void encodePayload(const TelemetryWeights& value, std::uint8_t* payload) {
+    put32(payload, value.block);
+    put16(payload + 4, value.offset);
+    payload[6] = value.count;
+    for (std::size_t i = 0; i < TelemetryWeights::MAX_TAPS; ++i) {
+        putFloat(payload + 7 + 4 * i, value.taps[i]);
+    }
+}
+
+/**
+ * @brief Decodes a frequency payload.
+ *
+ * @param payload The payload bytes.
+ * @param length The number of payload bytes.
+ * @param value The decoded payload.
+ * @return True if the payload has the expected size, false otherwise.
+ */
+bool decodePayload(const std::uint8_t* payload, const std::size_t length, TelemetryFrequency& value) {
+    if (length != TelemetryFrequency::SIZE) return false;
+    value.frequency = getFloat(payload);
+    value.magnitude = getFloat(payload + 4);
+    return true;
+}
+
+/**
+ * @brief Decodes a block payload.
+ *
+ * @param payload The payload bytes.
+ * @param length The number of payload bytes.
+ * @param value The decoded payload.
+ * @return True if the payload has the expected size, false otherwise.
+ */
+bool decodePayload(const std::uint8_t* payload, const std::size_t length, TelemetryBlock& value) {
+    if (length != TelemetryBlock::SIZE) return false;
+    value.block = get32(payload);
+    value.inputPeak = get16(payload + 4);
+    value.outputPeak = get16(payload + 6);
+    value.notchFrequency = getFloat(payload + 8);
+    value.activeNotches = payload[12];
+    return true;
+}
+
+/**
+ * @brief Decodes an acknowledgement payload.
+ *
+ * @param payload The payload bytes.
+ * @param length The number of payload bytes.
+ * @param value The decoded payload.
+ * @return True if the payload has the expected size, false otherwise.
+ */
+bool decodePayload(const std::uint8_t* payload, const std::size_t length, TelemetryAck& value) {
+    if (length != TelemetryAck::SIZE) return false;
+    value.id = get32(payload);
+    value.block = get32(payload + 4);
+    return true;
+}
+
+/**
+ * @brief Decodes a snapshot payload.
+ *
+ * @param payload The payload bytes.
+ * @param length The number of payload bytes.
+ * @param value The decoded payload.
+ * @return True if the payload has the expected size, false otherwise.
+ */
+bool decodePayload(const std::uint8_t* payload, const std::size_t length, TelemetrySnapshot& value) {
+    if (length != TelemetrySnapshot::SIZE) return false;
+    value.block = get32(payload);
+    value.mu = getFloat(payload + 4);
+    value.gamma = getFloat(payload + 8);
+    value.notchFrequency = getFloat(payload + 12);
+    value.notchBandwidth = getFloat(payload + 16);
+    value.activeNotches = payload[20];
+    value.tapCount = get16(payload + 21);
+    value.channel = payload[23];
+    return true;
+}
+
+/**
+ * @brief Decodes a weights payload.
+ *
+ * @param payload The payload bytes.
+ * @param length The number of payload bytes.
+ * @param value The decoded payload.
+ * @return True if the payload has the expected size and tap count, false otherwise.
+ */
+bool decodePayload(const std::uint8_t* payload, const std::size_t length, TelemetryWeights& value) {
+    if (length != TelemetryWeights::SIZE || payload[6] > TelemetryWeights::MAX_TAPS) return false;
+    value.block = get32(payload);
+    value.offset = get16(payload + 4);
+    value.count = payload[6];
+    for (std::size_t i = 0; i < TelemetryWeights::MAX_TAPS; ++i) {
+        value.taps[i] = getFloat(payload + 7 + 4 * i);
+    }
+    return true;
+}
+
+/**
+ * @brief Computes the CRC-16/CCITT-FALSE of a run of bytes.
+ *
+ * The CRC is computed bit by bit: frames are short, and a table would cost 512 bytes of RAM.
+ *
+ * @param data The bytes.
+ * @param length The number of bytes.
+ * @param crc The CRC of the preceding bytes, to chain calls.
+ * @return The CRC.
+ */
+std::uint16_t telemetryCrc(const std::uint8_t* data, const std::size_t length, std::uint16_t crc) {
+    for (std::size_t i = 0; i < length; ++i) {
+        crc ^= static_cast<std::uint16_t>(data[i] << 8);
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = static_cast<std::uint16_t>(crc & 0x8000 ? crc << 1 ^ 0x1021 : crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Builds a frame around a raw payload.
+ *
+ * @param type The frame type.
+ * @param payload The payload bytes.
+ * @param length The number of payload bytes, at most MAX_PAYLOAD.
+ * @param frame The buffer receiving the frame, at least HEADER_SIZE + length + CRC_SIZE bytes.
+ * @return The size of the frame, zero if the payload is too long.
+ */
+std::size_t TelemetryEncoder::encode(const TelemetryType type, const std::uint8_t* payload, const std::size_t length,
+                                     std::uint8_t* frame) {
+    if (length > MAX_PAYLOAD) return 0;
+
+    frame[0] = SYNC0;
+    frame[1] = SYNC1;
+    frame[2] = static_cast<std::uint8_t>(type);
+    frame[3] = static_cast<std::uint8_t>(length);
+    put16(frame + 4, sequence++);
+    std::memcpy(frame + HEADER_SIZE, payload, length);
+    put16(frame + HEADER_SIZE + length, telemetryCrc(frame + 2, HEADER_SIZE - 2 + length));
+    return HEADER_SIZE + length + CRC_SIZE;
+}
+
+/**
+ * @brief Pushes the next byte of the stream.
+ *
+ * @param byte The byte.
+ * @return Whether the byte completed a frame, is part of one, or is text.
+ */
+TelemetryDecoder::Result TelemetryDecoder::push(const std::uint8_t byte) {
+    switch (state) {
+        case State::Sync0:
+            if (byte != TelemetryEncoder::SYNC0) return Result::Text;
+            state = State::Sync1;
+            return Result::Pending;
+
+        case State::Sync1:
+            if (byte == TelemetryEncoder::SYNC1) {
+                state = State::Header;
+                position = 0;
+                return Result::Pending;
+            }
+            if (byte == TelemetryEncoder::SYNC0) return Result::Pending;
+            state = State::Sync0;
+            return Result::Text;
+
+        case State::Header:
+            header[position++] = byte;
+            if (position < sizeof(header)) return Result::Pending;
+            if (getLength() > TelemetryEncoder::MAX_PAYLOAD) {
+                ++corruptFrames;
+                state = State::Sync0;
+                return Result::Pending;
+            }
+            position = 0;
+            state = getLength() > 0 ? State::Payload : State::Crc;
+            return Result::Pending;
+
+        case State::Payload:
+            payload[position++] = byte;
+            if (position == getLength()) {
+                position = 0;
+                state = State::Crc;
+            }
+            return Result::Pending;
+
+        case State::Crc:
+            crc[position++] = byte;
+            if (position < TelemetryEncoder::CRC_SIZE) return Result::Pending;
+            state = State::Sync0;
+            if (get16(crc) != telemetryCrc(payload, getLength(), telemetryCrc(header, sizeof(header)))) {
+                ++corruptFrames;
+                return Result::Pending;
+            }
+            if (synchronized) {
+                lostFrames += static_cast<std::uint16_t>(getSequence() - nextSequence);
+            }
+            synchronized = true;
+            nextSequence = static_cast<std::uint16_t>(getSequence() + 1);
+            return Result::Frame;
+    }
+    return Result::Pending;
+}
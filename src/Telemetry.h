@@ -0,0 +1,317 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file Telemetry.h
+ * @brief Binary telemetry frames shared by the firmware and the host tools.
+ *
+ * A frame is laid out as
+ *
+ *   0xA5 0x5A | type | length | sequence (2) | payload (length) | CRC (2)
+ *
+ * with multi-byte fields in little-endian order. The CRC is the CRC-16/CCITT-FALSE of the
+ * type, length, sequence and payload bytes. The sync bytes are not ASCII, so frames can share
+ * the serial link with the text replies to the commands: a decoder hands every byte outside a
+ * frame back as text.
+ */
+
+/**
+ * @brief Type of the payload of a telemetry frame.
+ */
+enum class TelemetryType : std::uint8_t {
+    Frequency = 1, ///< TelemetryFrequency payload.
+    Block = 2, ///< TelemetryBlock payload.
+    Ack = 3, ///< TelemetryAck payload.
+    Snapshot = 4, ///< TelemetrySnapshot payload.
+    Weights = 5, ///< TelemetryWeights payload.
+};
+
+/**
+ * @brief Dominant frequency of the output, from the firmware FFT.
+ */
+struct TelemetryFrequency {
+    static constexpr TelemetryType TYPE{TelemetryType::Frequency}; ///< Frame type of the payload.
+    static constexpr std::size_t SIZE{8}; ///< Encoded size, in bytes.
+
+    float frequency; ///< Dominant frequency, in Hz.
+    float magnitude; ///< Magnitude of the FFT bin.
+};
+
+/**
+ * @brief Metrics of one audio block processed by the canceller.
+ */
+struct TelemetryBlock {
+    static constexpr TelemetryType TYPE{TelemetryType::Block}; ///< Frame type of the payload.
+    static constexpr std::size_t SIZE{13}; ///< Encoded size, in bytes.
+
+    std::uint32_t block; ///< Index of the block since the canceller started.
+    std::uint16_t inputPeak; ///< Peak absolute input sample.
+    std::uint16_t outputPeak; ///< Peak absolute output sample.
+    float notchFrequency; ///< Frequency of the first notch, in Hz.
+    std::uint8_t activeNotches; ///< Number of active notches.
+};
+
+/**
+ * @brief Acknowledgement of a group of parameter changes applied by the canceller.
+ */
+struct TelemetryAck {
+    static constexpr TelemetryType TYPE{TelemetryType::Ack}; ///< Frame type of the payload.
+    static constexpr std::size_t SIZE{8}; ///< Encoded size, in bytes.
+
+    std::uint32_t id; ///< Identifier of the group.
+    std::uint32_t block; ///< Index of the first audio block processed with the changes.
+};
+
+/**
+ * @brief State of the adaptive filter and of the first notch of a channel, taken at the end of an audio block.
+ *
+ * The taps of the filter follow in TelemetryWeights frames with the same block index.
+ */
+struct TelemetrySnapshot {
+    static constexpr TelemetryType TYPE{TelemetryType::Snapshot}; ///< Frame type of the payload.
+    static constexpr std::size_t SIZE{24}; ///< Encoded size, in bytes.
+
+    std::uint32_t block; ///< Index of the block the snapshot was taken at.
+    float mu; ///< Adaptation rate of the adaptive filter.
+    float gamma; ///< Leakage factor of the adaptive filter.
+    float notchFrequency; ///< Frequency of the first notch, in Hz.
+    float notchBandwidth; ///< Bandwidth of the first notch, in Hz.
+    std::uint8_t activeNotches; ///< Number of active notches.
+    std::uint16_t tapCount; ///< Number of taps sent in the TelemetryWeights frames.
+    std::uint8_t channel; ///< Channel the snapshot was taken on.
+};
+
+/**
+ * @brief A run of taps of the impulse response of the adaptive filter.
+ */
+struct TelemetryWeights {
+    static constexpr TelemetryType TYPE{TelemetryType::Weights}; ///< Frame type of the payload.
+    static constexpr std::size_t MAX_TAPS{12}; ///< Number of taps a frame holds.
+    static constexpr std::size_t SIZE{7 + 4 * MAX_TAPS}; ///< Encoded size, in bytes.
+
+    std::uint32_t block; ///< Index of the block of the snapshot the taps belong to.
+    std::uint16_t offset; ///< Index of the first tap.
+    std::uint8_t count; ///< Number of valid taps, at most MAX_TAPS.
+    float taps[MAX_TAPS]; ///< The taps; those beyond count are zero.
+};
+
+/**
+ * @brief Encodes a frequency payload.
+ *
+ * @param value The payload.
+ * @param payload The TelemetryFrequency::SIZE bytes to fill.
+ */
+void encodePayload(const TelemetryFrequency& value, std::uint8_t* payload);
+
+/**
+ * @brief Encodes a block payload.
+ *
+ * @param value The payload.
+ * @param payload The TelemetryBlock::SIZE bytes to fill.
+ */
+void encodePayload(const TelemetryBlock& value, std::uint8_t* payload);
+
+/**
+ * @brief Encodes an acknowledgement payload.
+ *
+ * @param value The payload.
+ * @param payload The TelemetryAck::SIZE bytes to fill.
+ */
+void encodePayload(const TelemetryAck& value, std::uint8_t* payload);
+
+/**
+ * @brief Encodes a snapshot payload.
+ *
+ * @param value The payload.
+ * @param payload The TelemetrySnapshot::SIZE bytes to fill.
+ */
+void encodePayload(const TelemetrySnapshot& value, std::uint8_t* payload);
+
+/**
+ * @brief Encodes a weights payload.
+ *
+ * @param value The payload.
+ * @param payload The TelemetryWeights::SIZE bytes to fill.
+ */
+void encodePayload(const TelemetryWeights& value, std::uint8_t* payload);
+
+/**
+ * @brief Decodes a frequency payload.
+ *
+ * @param payload The payload bytes.
+ * @param length The number of payload bytes.
+ * @param value The decoded payload.
+ * @return True if the payload has the expected size, false otherwise.
+ */
+bool decodePayload(const std::uint8_t* payload, std::size_t length, TelemetryFrequency& value);
+
+/**
+ * @brief Decodes a block payload.
+ *
+ * @param payload The payload bytes.
+ * @param length The number of payload bytes.
+ * @param value The decoded payload.
+ * @return True if the payload has the expected size, false otherwise.
+ */
+bool decodePayload(const std::uint8_t* payload, std::size_t length, TelemetryBlock& value);
+
+/**
+ * @brief Decodes an acknowledgement payload.
+ *
+ * @param payload The payload bytes.
+ * @param length The number of payload bytes.
+ * @param value The decoded payload.
+ * @return True if the payload has the expected size, false otherwise.
+ */
+bool decodePayload(const std::uint8_t* payload, std::size_t length, TelemetryAck& value);
+
+/**
+ * @brief Decodes a snapshot payload.
+ *
+ * @param payload The payload bytes.
+ * @param length The number of payload bytes.
+ * @param value The decoded payload.
+ * @return True if the payload has the expected size, false otherwise.
+ */
+bool decodePayload(const std::uint8_t* payload, std::size_t length, TelemetrySnapshot& value);
+
+/**
+ * @brief Decodes a weights payload.
+ *
+ * @param payload The payload bytes.
+ * @param length The number of payload bytes.
+ * @param value The decoded payload.
+ * @return True if the payload has the expected size and tap count, false otherwise.
+ */
+bool decodePayload(const std::uint8_t* payload, std::size_t length, TelemetryWeights& value);
+
+/**
+ * @brief Computes the CRC-16/CCITT-FALSE of a run of bytes.
+ *
+ * @param data The bytes.
+ * @param length The number of bytes.
+ * @param crc The CRC of the preceding bytes, to chain calls.
+ * @return The CRC.
+ */
+std::uint16_t telemetryCrc(const std::uint8_t* data, std::size_t length, std::uint16_t crc = 0xFFFF);
+
+/**
+ * @brief The TelemetryEncoder class builds numbered telemetry frames.
+ */
+class TelemetryEncoder {
+public:
+    static constexpr std::uint8_t SYNC0{0xA5}; ///< First sync byte of a frame.
+    static constexpr std::uint8_t SYNC1{0x5A}; ///< Second sync byte of a frame.
+    static constexpr std::size_t HEADER_SIZE{6}; ///< Sync bytes, type, length and sequence.
+    static constexpr std::size_t CRC_SIZE{2}; ///< Size of the trailing CRC.
+    static constexpr std::size_t MAX_PAYLOAD{64}; ///< Largest payload of a frame.
+    static constexpr std::size_t MAX_FRAME{HEADER_SIZE + MAX_PAYLOAD + CRC_SIZE}; ///< Largest frame.
+
+    /**
+     * @brief Builds a frame around a raw payload.
+     *
+     * @param type The frame type.
+     * @param payload The payload bytes.
+     * @param length The number of payload bytes, at most MAX_PAYLOAD.
+     * @param frame The buffer receiving the frame, at least HEADER_SIZE + length + CRC_SIZE bytes.
+     * @return The size of the frame, zero if the payload is too long.
+     */
+    std::size_t encode(TelemetryType type, const std::uint8_t* payload, std::size_t length, std::uint8_t* frame);
+
+    /**
+     * @brief Builds a frame around a typed payload.
+     *
+     * @tparam Payload A payload structure, such as TelemetryBlock.
+     * @param value The payload.
+     * @param frame The buffer receiving the frame, at least MAX_FRAME bytes.
+     * @return The size of the frame.
+     */
+    template<typename Payload>
+    std::size_t encode(const Payload& value, std::uint8_t* frame) {
+        std::uint8_t payload[Payload::SIZE];
+        encodePayload(value, payload);
+        return encode(Payload::TYPE, payload, Payload::SIZE, frame);
+    }
+
+private:
+    std::uint16_t sequence{0}; ///< Sequence number of the next frame.
+};
+
+/**
+ * @brief The TelemetryDecoder class extracts frames from a byte stream.
+ *
+ * Bytes are pushed one at a time. A byte that cannot start a frame is returned as text, and a
+ * frame with a bad CRC or an oversized length is dropped and counted, after which the decoder
+ * looks for the next sync bytes.
+ */
+class TelemetryDecoder {
+public:
+    /**
+     * @brief Outcome of pushing one byte.
+     */
+    enum class Result {
+        Pending, ///< The byte belongs to a frame not complete yet.
+        Frame, ///< The byte completes a valid frame.
+        Text, ///< The byte is outside any frame.
+    };
+
+    /**
+     * @brief Pushes the next byte of the stream.
+     *
+     * @param byte The byte.
+     * @return Whether the byte completed a frame, is part of one, or is text.
+     */
+    Result push(std::uint8_t byte);
+
+    /**
+     * @brief Gets the type of the last complete frame.
+     */
+    [[nodiscard]] TelemetryType getType() const { return static_cast<TelemetryType>(header[0]); }
+
+    /**
+     * @brief Gets the sequence number of the last complete frame.
+     */
+    [[nodiscard]] std::uint16_t getSequence() const { return static_cast<std::uint16_t>(header[2] | header[3] << 8); }
+
+    /**
+     * @brief Gets the payload of the last complete frame.
+     */
+    [[nodiscard]] const std::uint8_t* getPayload() const { return payload; }
+
+    /**
+     * @brief Gets the payload length of the last complete frame.
+     */
+    [[nodiscard]] std::size_t getLength() const { return header[1]; }
+
+    /**
+     * @brief Gets the number of frames dropped for a bad CRC or length.
+     */
+    [[nodiscard]] std::uint32_t getCorruptFrames() const { return corruptFrames; }
+
+    /**
+     * @brief Gets the number of frames missing from the sequence numbers received.
+     */
+    [[nodiscard]] std::uint32_t getLostFrames() const { return lostFrames; }
+
+private:
+    /**
+     * @brief Position of the decoder in a frame.
+     */
+    enum class State { Sync0, Sync1, Header, Payload, Crc };
+
+    State state{State::Sync0}; ///< Position in the current frame.
+    std::uint8_t header[4]{}; ///< Type, length and sequence of the current frame.
+    std::uint8_t payload[TelemetryEncoder::MAX_PAYLOAD]{}; ///< Payload of the current frame.
+    std::uint8_t crc[TelemetryEncoder::CRC_SIZE]{}; ///< CRC of the current frame.
+    std::size_t position{0}; ///< Number of bytes read in the current field.
+
+    bool synchronized{false}; ///< True once a valid frame has been received.
+    std::uint16_t nextSequence{0}; ///< Expected sequence number of the next frame.
+    std::uint32_t corruptFrames{0}; ///< Number of frames dropped.
+    std::uint32_t lostFrames{0}; ///< Number of frames missing from the sequence.
+};
+
+#endif
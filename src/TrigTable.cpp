@@ -0,0 +1,51 @@
+#include "TrigTable.h"
+#include <cmath>
+
+/**
+ * @brief Constructs a TrigTable object and fills the table.
+ */
+template<typename R>
+TrigTable<R>::TrigTable() {
+    for (std::size_t k = 0; k <= SIZE; ++k) {
+        const double angle = M_PI * static_cast<double>(k) / static_cast<double>(SIZE);
+        cosines[k] = static_cast<R>(std::cos(angle));
+        sines[k] = static_cast<R>(std::sin(angle));
+    }
+}
+
+/**
+ * @brief Gets the table, filled on first use.
+ *
+ * @return The table.
+ */
+template<typename R>
+const TrigTable<R>& TrigTable<R>::instance() {
+    static const TrigTable table;
+    return table;
+}
+
+/**
+ * @brief Computes the cosine of an angle.
+ *
+ * @param w The angle in radians, clamped to [0, π].
+ * @return The cosine of the angle.
+ */
+template<typename R>
+R TrigTable<R>::cosine(const R w) {
+    const TrigTable& table = instance();
+    constexpr R step = static_cast<R>(M_PI / static_cast<double>(SIZE));
+
+    const R position = w / step;
+    if (!(position > R{0})) return table.cosines[0];
+    if (position >= static_cast<R>(SIZE)) return table.cosines[SIZE];
+
+    const auto k = static_cast<std::size_t>(position + R{0.5});
+    const R delta = w - static_cast<R>(k) * step;
+    const R delta2 = delta * delta;
+    const R cosDelta = R{1} - delta2 * R{0.5};
+    const R sinDelta = delta * (R{1} - delta2 / R{6});
+    return table.cosines[k] * cosDelta - table.sines[k] * sinDelta;
+}
+
+template class TrigTable<double>;
+template class TrigTable<float>;
@@ -0,0 +1,46 @@
+#ifndef TRIG_TABLE_H
+#define TRIG_TABLE_H
+
+#include <cstddef>
+
+/**
+ * @brief The TrigTable class evaluates the cosine of filter design angles without calling libm.
+ *
+ * Cosines and sines of SIZE + 1 angles evenly spaced over [0, π] are computed once. An angle is
+ * split into its nearest table angle and a remainder of at most π / (2 * SIZE), and the cosine is
+ * rebuilt with the angle addition formula and third-order expansions of the remainder, which is
+ * accurate to about 1e-11.
+ *
+ * @tparam R The real type (float or double).
+ */
+template<typename R>
+class TrigTable final {
+public:
+    static constexpr std::size_t SIZE = 512; ///< Number of intervals of the table over [0, π].
+
+    /**
+     * @brief Computes the cosine of an angle.
+     *
+     * @param w The angle in radians, clamped to [0, π].
+     * @return The cosine of the angle.
+     */
+    static R cosine(R w);
+
+private:
+    R cosines[SIZE + 1]; ///< Cosine of each table angle.
+    R sines[SIZE + 1]; ///< Sine of each table angle.
+
+    /**
+     * @brief Constructs a TrigTable object and fills the table.
+     */
+    TrigTable();
+
+    /**
+     * @brief Gets the table, filled on first use.
+     *
+     * @return The table.
+     */
+    static const TrigTable& instance();
+};
+
+#endif
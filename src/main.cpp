@@ -1,18 +1,236 @@
 #include <Arduino.h>
 #include <Audio.h>
+#include <SD.h>
 #include "AdaptiveFeedbackCanceller.h"
+#include "CommandReader.h"
+#include "HowlDetector.h"
+#include "LatencyProbe.h"
+#include "Profiler.h"
+#include "RingBuffer.h"
+#include "SignalRecorder.h"
+#include "TaskScheduler.h"
+#include "Telemetry.h"
+#include <algorithm>
+#include <cctype>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
-AdaptiveFeedbackCanceller adaptiveFeedbackCanceller;
+#ifndef AFC_CHANNELS
+#define AFC_CHANNELS 1 ///< Number of channels of the canceller: 1 (mono input to both outputs), 2 or 4.
+#endif
+
+// AudioAnalyzeFFT1024 only runs on blocks of 128 samples, so a build with smaller blocks
+// (-DAUDIO_BLOCK_SAMPLES=16 or 32 for a lower latency) has no howl detector and leaves the notches
+// to the in-filter estimators.
+#if AUDIO_BLOCK_SAMPLES == 128
+#define AFC_HOWL_DETECTOR 1
+#else
+#define AFC_HOWL_DETECTOR 0
+#endif
+
+// The audio library updates its objects in the order they are constructed, so the input comes
+// before the canceller and the canceller before the output: each block goes through within the
+// update() it is captured in, without waiting a block in a queue.
+#if AFC_CHANNELS == 4
+AudioInputI2SQuad in;
+#else
 AudioInputI2S in;
+#endif
+AdaptiveFeedbackCanceller<AFC_CHANNELS> adaptiveFeedbackCanceller;
+LatencyProbe latencyProbe; ///< Sends the click of GET:ROUNDTRIP on the first output and watches for it on the first channel.
+#if AFC_CHANNELS == 4
+AudioOutputI2SQuad out;
+#else
 AudioOutputI2S out;
+#endif
 AudioControlSGTL5000 audioShield;
+#if AFC_HOWL_DETECTOR
 AudioAnalyzeFFT1024 fft1024;
+#endif
 
+#if AFC_CHANNELS == 1
+AudioConnection patchCord0(in,0,adaptiveFeedbackCanceller,0);
+AudioConnection patchCord1(adaptiveFeedbackCanceller,0,latencyProbe,0);
+AudioConnection patchCord2(latencyProbe,0,out,0);
+AudioConnection patchCord3(latencyProbe,0,out,1);
+#elif AFC_CHANNELS == 2
+AudioConnection patchCord0(in,0,adaptiveFeedbackCanceller,0);
+AudioConnection patchCord1(in,1,adaptiveFeedbackCanceller,1);
+AudioConnection patchCord2(adaptiveFeedbackCanceller,0,latencyProbe,0);
+AudioConnection patchCord3(latencyProbe,0,out,0);
+AudioConnection patchCord4(adaptiveFeedbackCanceller,1,out,1);
+#elif AFC_CHANNELS == 4
 AudioConnection patchCord0(in,0,adaptiveFeedbackCanceller,0);
-AudioConnection patchCord1(adaptiveFeedbackCanceller,0,out,0);
-AudioConnection patchCord2(adaptiveFeedbackCanceller,0,out,1);
-AudioConnection patchCord3(adaptiveFeedbackCanceller,0,fft1024,0);
+AudioConnection patchCord1(in,1,adaptiveFeedbackCanceller,1);
+AudioConnection patchCord2(in,2,adaptiveFeedbackCanceller,2);
+AudioConnection patchCord3(in,3,adaptiveFeedbackCanceller,3);
+AudioConnection patchCord4(adaptiveFeedbackCanceller,0,latencyProbe,0);
+AudioConnection patchCord5(latencyProbe,0,out,0);
+AudioConnection patchCord6(adaptiveFeedbackCanceller,1,out,1);
+AudioConnection patchCord7(adaptiveFeedbackCanceller,2,out,2);
+AudioConnection patchCord8(adaptiveFeedbackCanceller,3,out,3);
+#else
+#error "AFC_CHANNELS must be 1, 2 or 4"
+#endif
+#if AFC_HOWL_DETECTOR
+AudioConnection patchCordFft(adaptiveFeedbackCanceller,0,fft1024,0);
+#endif
+
+/**
+ * @brief Print sink queuing everything sent to the host, so that loop() never waits for the USB link.
+ *
+ * Text replies and telemetry frames share one queue, which keeps frames and lines whole on the
+ * link. Printed text is gathered into a line and queued at its newline, so that a line built
+ * from several prints is queued whole or dropped whole. A frame or a line that does not fit is
+ * dropped, and so is a line longer than MAX_LINE.
+ */
+class SerialQueue final : public Print {
+public:
+    static constexpr std::size_t MAX_LINE{1024}; ///< Longest text line, newline included.
+
+    size_t write(const uint8_t byte) override { return write(&byte, 1); }
+
+    size_t write(const uint8_t* data, const size_t size) override {
+        for (std::size_t i = 0; i < size; ++i) {
+            if (length < MAX_LINE) line[length] = data[i];
+            ++length;
+            if (data[i] != '\n') continue;
+            if (length <= MAX_LINE) writeFrame(line, length);
+            length = 0;
+        }
+        return size;
+    }
+
+    /**
+     * @brief Queues a binary frame whole, or drops it if the queue is full.
+     *
+     * @param frame The bytes of the frame.
+     * @param size The number of bytes.
+     */
+    void writeFrame(const uint8_t* frame, const std::size_t size) {
+        if (!buffer.write(frame, size)) return;
+        queued += size;
+    }
+
+    /**
+     * @brief Sends as much of the queue as the serial port accepts without blocking.
+     */
+    void drain() {
+        const uint8_t* data;
+        while (std::size_t count = buffer.peek(data)) {
+            const int room = Serial.availableForWrite();
+            if (room <= 0) return;
+            count = std::min(count, static_cast<std::size_t>(room));
+            Serial.write(data, count);
+            buffer.consume(count);
+            sent += count;
+        }
+    }
+
+    /**
+     * @brief Gets the number of bytes queued so far, to mark a position in the stream.
+     */
+    [[nodiscard]] uint32_t getQueued() const { return queued; }
+
+    /**
+     * @brief Checks if the bytes up to a position in the stream have been handed to the serial port.
+     *
+     * @param mark The position, as returned by getQueued().
+     */
+    [[nodiscard]] bool hasSent(const uint32_t mark) const { return static_cast<int32_t>(sent - mark) >= 0; }
+
+private:
+    RingBuffer<uint8_t, 4096> buffer; ///< Bytes waiting for the serial port.
+    uint8_t line[MAX_LINE]; ///< Text line being printed.
+    std::size_t length{0}; ///< Number of bytes printed since the last newline, counting those beyond MAX_LINE.
+    uint32_t queued{0}; ///< Number of bytes queued so far.
+    uint32_t sent{0}; ///< Number of bytes handed to the serial port so far.
+};
+
+SerialQueue serialQueue;
+TelemetryEncoder telemetryEncoder;
+bool binaryTelemetry{false}; ///< True to stream binary frames instead of the DATA:FREQ text lines.
+
+/**
+ * @brief Queues a telemetry frame, or drops it if the queue is full.
+ *
+ * @param value The payload of the frame.
+ */
+template<typename Payload>
+void publish(const Payload& value) {
+    uint8_t frame[TelemetryEncoder::MAX_FRAME];
+    serialQueue.writeFrame(frame, telemetryEncoder.encode(value, frame));
+}
+
+TaskScheduler scheduler;
+CommandReader commandReader;
+
+constexpr uint32_t frequencyPeriod{5000}; ///< Period of the FFT spectrum polling, in microseconds.
+constexpr uint32_t frequencyTextPeriod{100000}; ///< Minimum interval between two DATA:FREQ lines, in microseconds.
+constexpr uint32_t buttonPeriod{5000}; ///< Period of the button polling, in microseconds.
+constexpr uint32_t potentiometerPeriod{50000}; ///< Period of the potentiometer polling, in microseconds.
+constexpr uint32_t snapshotPollPeriod{10000}; ///< Period of the filter snapshot polling, in microseconds.
+constexpr uint32_t probePollPeriod{10000}; ///< Period of the latency probe polling, in microseconds.
+
+uint32_t lastFrequencyText{0}; ///< micros() of the last DATA:FREQ line.
+uint32_t commandStart{0}; ///< micros() when the first byte of the last command arrived.
+uint32_t ackMark{0}; ///< Position of the end of the last reply in the serial queue.
+bool ackPending{false}; ///< True until the reply to the last command is handed to the serial port.
+uint32_t lastLatency{0}; ///< Command-to-reply time of the last command, in microseconds.
+uint32_t maxLatency{0}; ///< Longest command-to-reply time, in microseconds.
+uint32_t snapshotInterval{0}; ///< Interval between two filter snapshots, in milliseconds, 0 for none.
+uint32_t lastSnapshotRequest{0}; ///< millis() when the last filter snapshot was requested.
+uint8_t snapshotChannel{0}; ///< Channel of the canceller the filter snapshots are taken on.
+uint32_t parameterUpdateId{0}; ///< Identifier of the last group of parameter changes queued from a command.
+
+constexpr uint32_t venuePollPeriod{1000}; ///< Period of the venue image transfers, in microseconds.
+constexpr std::size_t venueChunk{512}; ///< Bytes of a venue image read or written per transfer, one SD sector.
+constexpr std::size_t venueNameLength{16}; ///< Longest name of a venue.
+constexpr const char* venueDirectory{"/venues"}; ///< Directory of the venue images, one <name>.afc file per venue.
+constexpr const char* venueDefaultPath{"/venues/default.txt"}; ///< File holding the name of the venue loaded at power-up.
+
+/**
+ * @brief Steps of the transfer of a venue image between the canceller and the SD card.
+ */
+enum class VenueStep : uint8_t {
+    Idle, ///< No transfer.
+    Saving, ///< Waiting for the audio interrupt to write the state image.
+    Writing, ///< Writing the image to its file.
+    Reading, ///< Reading the image from its file.
+    Applying, ///< Waiting for the canceller to load the image.
+};
+
+bool sdReady{false}; ///< True if the SD card was found at power-up.
+uint8_t* venueImage{nullptr}; ///< Buffer of the venue image being transferred, getStateImageSize() bytes.
+std::size_t venueSize{0}; ///< Size of the venue image being transferred.
+std::size_t venueOffset{0}; ///< Bytes of the venue image transferred so far.
+File venueFile; ///< File of the venue image being transferred.
+VenueStep venueStep{VenueStep::Idle}; ///< Step of the venue image transfer.
+char venueName[venueNameLength + 1]{}; ///< Name of the venue being transferred.
+uint32_t venueUpdateId{0}; ///< Identifier of the group of parameter changes loading the venue image.
+
+constexpr uint32_t recordPollPeriod{5000}; ///< Period of the recorder polling, in microseconds.
+constexpr uint32_t overrunReportPeriod{1000}; ///< Minimum interval between two DATA:RECORD:OVERRUN lines, in milliseconds.
+constexpr std::size_t maxRecordGaps{64}; ///< Gaps listed in the sidecar of a recording; later ones are only counted.
+constexpr const char* recordDirectory{"/rec"}; ///< Directory of the recordings, RECnnnnn.wav with a RECnnnnn.json sidecar.
+
+SignalRecorder signalRecorder; ///< Chunks of the recorded signals, filled by the audio interrupt.
+File recordFile; ///< WAV file of the recording.
+char recordPath[32]{}; ///< Path of the recording, without its extension.
+RecorderGap recordGaps[maxRecordGaps]; ///< Gaps of the recording listed in its sidecar.
+std::size_t recordGapCount{0}; ///< Number of gaps in recordGaps.
+bool recordFailed{false}; ///< True if a chunk of the recording could not be written.
+uint32_t reportedOverruns{0}; ///< Overruns of the recording last reported.
+uint32_t lastOverrunReport{0}; ///< millis() of the last DATA:RECORD:OVERRUN line.
+
+#if AFC_HOWL_DETECTOR
+constexpr std::size_t spectrumBins{512}; ///< Number of bins of the fft1024 spectra.
+float spectrum[spectrumBins]; ///< Magnitude of each bin of the last fft1024 spectrum.
+HowlDetector<float> howlDetector{spectrumBins, AUDIO_SAMPLE_RATE_EXACT / 1024.0f}; ///< Finds the howls in the fft1024 spectra.
+#endif
+bool howlSeeding{AFC_HOWL_DETECTOR != 0}; ///< True to steer the notches from howlDetector instead of the in-filter estimators.
 
 #ifdef BUTTON
 constexpr uint8_t buttonPin{0};
@@ -23,91 +241,889 @@ constexpr unsigned long debounceDelay = 50;
 bool changedState = false;
 #endif
 
+/**
+ * @brief Checks if a command starts with a prefix.
+ *
+ * @param command The command.
+ * @param prefix The prefix.
+ * @return True if the command starts with the prefix, false otherwise.
+ */
+static bool startsWith(const char* command, const char* prefix) {
+    return std::strncmp(command, prefix, std::strlen(prefix)) == 0;
+}
+
+/**
+ * @brief Reports the profile of the audio processing.
+ *
+ * Replies DATA:PERF:CLOCK:<cycles per second>, then for each stage that ran
+ * DATA:PERF:<stage>:<blocks>,<min>,<mean>,<max>,<histogram...>, the cycles per audio block and
+ * the 32 buckets of their log2 histogram. Replies DATA:PERF:DISABLED in a build without
+ * AFC_PROFILE.
+ */
+void reportProfile() {
+#ifdef AFC_PROFILE
+    serialQueue.print("DATA:PERF:CLOCK:");
+    serialQueue.println(static_cast<unsigned long>(F_CPU));
+
+    for (std::size_t i = 0; i < static_cast<std::size_t>(ProfileStage::Count); ++i) {
+        const auto stage = static_cast<ProfileStage>(i);
+        ProfileStats stats;
+        AudioNoInterrupts();
+        Profiler::snapshot(stage, stats);
+        AudioInterrupts();
+        if (stats.blocks == 0) continue;
+
+        serialQueue.print("DATA:PERF:");
+        serialQueue.print(Profiler::name(stage));
+        serialQueue.print(":");
+        serialQueue.print(static_cast<unsigned long>(stats.blocks));
+        serialQueue.print(",");
+        serialQueue.print(static_cast<unsigned long>(stats.min));
+        serialQueue.print(",");
+        serialQueue.print(static_cast<unsigned long>(stats.total / stats.blocks));
+        serialQueue.print(",");
+        serialQueue.print(static_cast<unsigned long>(stats.max));
+        for (const std::uint32_t count : stats.histogram) {
+            serialQueue.print(",");
+            serialQueue.print(static_cast<unsigned long>(count));
+        }
+        serialQueue.println();
+    }
+#else
+    serialQueue.println("DATA:PERF:DISABLED");
+#endif
+}
+
+/**
+ * @brief Queues a group of parameter changes for the canceller, numbered for its acknowledgement.
+ *
+ * Replies DATA:BUSY if the canceller queue is full.
+ *
+ * @param update The changes.
+ * @return True if the changes were queued, false otherwise.
+ */
+bool queueParameters(ParameterUpdate update) {
+    update.id = ++parameterUpdateId;
+    if (adaptiveFeedbackCanceller.apply(update)) return true;
+    serialQueue.println("DATA:BUSY");
+    return false;
+}
+
+/**
+ * @brief Checks if the adaptation algorithm as last requested ignores the adaptation rate.
+ *
+ * The RLS algorithm has no adaptation rate: its memory is set by its forgetting factor.
+ *
+ * @return True if a requested adaptation rate would have no effect, false otherwise.
+ */
+static bool isMuUnused() {
+#if !defined(AFC_FDAF) && !defined(AFC_SUBBAND)
+    return adaptiveFeedbackCanceller.getAlgorithm() == LMSAlgorithm::RLS;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Parses the parameters of a SET:PARAMS command.
+ *
+ * The parameters are a comma-separated list of KEY=VALUE pairs, with the keys GAIN, MU (numbers),
+ * LMS, NOTCH and MUTE (ON or OFF), for example GAIN=1.5,MUTE=OFF.
+ *
+ * @param parameters The list of parameters.
+ * @param update The changes parsed.
+ * @return True if every pair is valid, false otherwise.
+ */
+bool parseParameters(const char* parameters, ParameterUpdate& update) {
+    while (*parameters) {
+        const char* end = std::strchr(parameters, ',');
+        if (!end) end = parameters + std::strlen(parameters);
+        const char* value = std::strchr(parameters, '=');
+        if (!value || value > end) return false;
+        ++value;
+
+        const auto length = static_cast<std::size_t>(end - value);
+        const bool on = length == 2 && std::strncmp(value, "ON", length) == 0;
+        const bool off = length == 3 && std::strncmp(value, "OFF", length) == 0;
+        if (startsWith(parameters, "GAIN=")) update.setGain(std::strtod(value, nullptr));
+        else if (startsWith(parameters, "MU=")) update.setMu(std::strtod(value, nullptr));
+        else if (startsWith(parameters, "LMS=") && (on || off)) update.setLMS(on);
+        else if (startsWith(parameters, "NOTCH=") && (on || off)) update.setNotch(on);
+        else if (startsWith(parameters, "MUTE=") && (on || off)) update.setMute(on);
+        else return false;
+
+        parameters = *end ? end + 1 : end;
+    }
+    return update.fields != 0;
+}
+
+/**
+ * @brief Checks a venue name and copies it in upper case.
+ *
+ * A name is 1 to venueNameLength letters, digits, '_' or '-', and not NONE.
+ *
+ * @param name The name.
+ * @param parsed The name in upper case, venueNameLength + 1 characters.
+ * @return True if the name is valid, false otherwise.
+ */
+static bool parseVenueName(const char* name, char* parsed) {
+    std::size_t length = 0;
+    for (; name[length]; ++length) {
+        const auto c = static_cast<unsigned char>(name[length]);
+        if (length == venueNameLength || !(std::isalnum(c) || c == '_' || c == '-')) return false;
+        parsed[length] = static_cast<char>(std::toupper(c));
+    }
+    parsed[length] = '\0';
+    return length > 0 && std::strcmp(parsed, "NONE") != 0;
+}
+
+/**
+ * @brief Gets the path of the image of a venue.
+ *
+ * @param name The name of the venue.
+ * @param path The path, at least 32 characters.
+ */
+static void venuePath(const char* name, char* path) {
+    std::snprintf(path, 32, "%s/%s.afc", venueDirectory, name);
+}
+
+/**
+ * @brief Reads the name of the venue loaded at power-up.
+ *
+ * @param name The name, venueNameLength + 1 characters.
+ * @return True if a valid name is set, false otherwise.
+ */
+static bool readDefaultVenue(char* name) {
+    File file = SD.open(venueDefaultPath, FILE_READ);
+    if (!file) return false;
+
+    char text[venueNameLength + 2]{};
+    file.read(text, venueNameLength + 1);
+    file.close();
+    text[std::strcspn(text, "\r\n ")] = '\0';
+    return parseVenueName(text, name);
+}
+
+/**
+ * @brief Sets the venue loaded at power-up.
+ *
+ * @param name The name of the venue, empty for none.
+ * @return True if the setting was written, false otherwise.
+ */
+static bool writeDefaultVenue(const char* name) {
+    SD.mkdir(venueDirectory);
+    SD.remove(venueDefaultPath);
+    if (!*name) return true;
+
+    File file = SD.open(venueDefaultPath, FILE_WRITE);
+    if (!file) return false;
+    const std::size_t length = std::strlen(name);
+    const bool written = file.write(reinterpret_cast<const uint8_t*>(name), length) == length;
+    file.close();
+    return written;
+}
+
+/**
+ * @brief Ends the venue image transfer on an error.
+ *
+ * Replies DATA:VENUE:ERROR:<reason>.
+ *
+ * @param reason The reason of the error.
+ */
+static void failVenue(const char* reason) {
+    if (venueFile) venueFile.close();
+    venueStep = VenueStep::Idle;
+    serialQueue.print("DATA:VENUE:ERROR:");
+    serialQueue.println(reason);
+}
+
+/**
+ * @brief Starts saving the adaptive state of the canceller as a venue.
+ *
+ * The audio interrupt writes the state image at the end of the next block, and pollVenue()
+ * then writes it to the SD card.
+ *
+ * @param name The name of the venue, as returned by parseVenueName().
+ */
+static void beginSaveVenue(const char* name) {
+    std::strcpy(venueName, name);
+    adaptiveFeedbackCanceller.requestState(venueImage, adaptiveFeedbackCanceller.getStateImageSize());
+    venueStep = VenueStep::Saving;
+}
+
+/**
+ * @brief Starts loading the image of a venue, which pollVenue() reads from the SD card.
+ *
+ * @param name The name of the venue, as returned by parseVenueName().
+ */
+static void beginLoadVenue(const char* name) {
+    char path[32];
+    venuePath(name, path);
+    venueFile = SD.open(path, FILE_READ);
+    if (!venueFile) {
+        failVenue("FILE");
+        return;
+    }
+
+    const auto size = venueFile.size();
+    if (size > adaptiveFeedbackCanceller.getStateImageSize()) {
+        failVenue("SIZE");
+        return;
+    }
+    std::strcpy(venueName, name);
+    venueSize = static_cast<std::size_t>(size);
+    venueOffset = 0;
+    venueStep = VenueStep::Reading;
+}
+
+/**
+ * @brief Moves the venue image transfer on by one step.
+ *
+ * The file is read or written venueChunk bytes at a time, so loop() never waits for a whole
+ * image. A saved venue is reported as DATA:VENUE:SAVED:<name>,<bytes>. A read image is checked
+ * by openStateImage() and handed to the canceller with a ParameterUpdate::setState() group,
+ * reported as DATA:VENUE:LOADED:<name>; the buffer stays in use until the group is
+ * acknowledged. A rejected image is reported as DATA:VENUE:ERROR:<reason>.
+ */
+void pollVenue() {
+    switch (venueStep) {
+        case VenueStep::Idle:
+        case VenueStep::Applying:
+            return;
+
+        case VenueStep::Saving: {
+            std::size_t size;
+            if (!adaptiveFeedbackCanceller.takeState(size)) return;
+            if (size == 0) {
+                failVenue("SIZE");
+                return;
+            }
+
+            char path[32];
+            venuePath(venueName, path);
+            SD.mkdir(venueDirectory);
+            SD.remove(path);
+            venueFile = SD.open(path, FILE_WRITE);
+            if (!venueFile) {
+                failVenue("FILE");
+                return;
+            }
+            venueSize = size;
+            venueOffset = 0;
+            venueStep = VenueStep::Writing;
+            return;
+        }
+
+        case VenueStep::Writing: {
+            const std::size_t count = std::min(venueChunk, venueSize - venueOffset);
+            if (venueFile.write(venueImage + venueOffset, count) != count) {
+                failVenue("FILE");
+                return;
+            }
+            venueOffset += count;
+            if (venueOffset < venueSize) return;
+
+            venueFile.close();
+            venueStep = VenueStep::Idle;
+            serialQueue.print("DATA:VENUE:SAVED:");
+            serialQueue.print(venueName);
+            serialQueue.print(",");
+            serialQueue.println(static_cast<unsigned long>(venueSize));
+            return;
+        }
+
+        case VenueStep::Reading: {
+            const std::size_t count = std::min(venueChunk, venueSize - venueOffset);
+            if (venueFile.read(venueImage + venueOffset, count) != static_cast<int>(count)) {
+                failVenue("FILE");
+                return;
+            }
+            venueOffset += count;
+            if (venueOffset < venueSize) return;
+
+            venueFile.close();
+            std::size_t payloadSize;
+            const StateImageError error = openStateImage(venueImage, venueSize, AdaptiveFeedbackCanceller<AFC_CHANNELS>::getStateInfo(),
+                                                         payloadSize);
+            if (error != StateImageError::None) {
+                failVenue(stateImageErrorName(error));
+                return;
+            }
+            if (!queueParameters(ParameterUpdate{}.setState(venueImage + STATE_HEADER_SIZE, payloadSize))) {
+                venueStep = VenueStep::Idle;
+                return;
+            }
+            venueUpdateId = parameterUpdateId;
+            venueStep = VenueStep::Applying;
+            serialQueue.print("DATA:VENUE:LOADED:");
+            serialQueue.println(venueName);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Reports the saved venues and the one loaded at power-up.
+ *
+ * Replies DATA:VENUES:<name>,<name>,... and DATA:VENUE:DEFAULT:<name>, or NONE.
+ */
+void reportVenues() {
+    serialQueue.print("DATA:VENUES:");
+    File directory = SD.open(venueDirectory);
+    if (directory) {
+        bool first = true;
+        while (File entry = directory.openNextFile()) {
+            const char* name = entry.name();
+            const char* extension = std::strrchr(name, '.');
+            if (!entry.isDirectory() && extension && std::strcmp(extension, ".afc") == 0) {
+                if (!first) serialQueue.print(",");
+                serialQueue.write(reinterpret_cast<const uint8_t*>(name), static_cast<std::size_t>(extension - name));
+                first = false;
+            }
+            entry.close();
+        }
+        directory.close();
+    }
+    serialQueue.println();
+
+    char name[venueNameLength + 1];
+    serialQueue.print("DATA:VENUE:DEFAULT:");
+    serialQueue.println(readDefaultVenue(name) ? name : "NONE");
+}
+
+/**
+ * @brief Starts recording the signals of channel 0 to a new RECnnnnn.wav file.
+ *
+ * Replies DATA:RECORD:ON:<file>, or DATA:RECORD:ERROR:<reason>.
+ */
+void startRecording() {
+    if (!sdReady) {
+        serialQueue.println("DATA:RECORD:ERROR:NOSD");
+        return;
+    }
+    if (recordFile || signalRecorder.isActive()) {
+        serialQueue.println("DATA:RECORD:ERROR:BUSY");
+        return;
+    }
+
+    SD.mkdir(recordDirectory);
+    char path[40];
+    unsigned int number = 1;
+    for (; number <= 99999; ++number) {
+        std::snprintf(recordPath, sizeof(recordPath), "%s/REC%05u", recordDirectory, number);
+        std::snprintf(path, sizeof(path), "%s.wav", recordPath);
+        if (!SD.exists(path)) break;
+    }
+
+    const uint8_t header[RECORDING_HEADER_SIZE]{};
+    if (number > 99999 || !(recordFile = SD.open(path, FILE_WRITE)) || recordFile.write(header, sizeof(header)) != sizeof(header)) {
+        if (recordFile) recordFile.close();
+        serialQueue.println("DATA:RECORD:ERROR:FILE");
+        return;
+    }
+    recordGapCount = 0;
+    recordFailed = false;
+    reportedOverruns = 0;
+    signalRecorder.start();
+    serialQueue.print("DATA:RECORD:ON:");
+    serialQueue.println(path);
+}
+
+/**
+ * @brief Completes the WAV header of the recording and writes its sidecar.
+ *
+ * Replies DATA:RECORD:OFF:<file>,<blocks>,<overruns>, or DATA:RECORD:ERROR:FILE.
+ */
+void finishRecording() {
+    const uint32_t blocks = signalRecorder.getBlocks();
+    const uint32_t overruns = signalRecorder.getOverruns();
+    uint8_t header[RECORDING_HEADER_SIZE];
+    writeRecordingHeader(header, static_cast<uint32_t>(std::lround(AUDIO_SAMPLE_RATE_EXACT)), blocks * AUDIO_BLOCK_SAMPLES);
+    const bool written = !recordFailed && recordFile.seek(0) && recordFile.write(header, sizeof(header)) == sizeof(header);
+    recordFile.close();
+
+    char text[256 + 24 * maxRecordGaps];
+    const std::size_t length = writeRecordingSidecar(text, sizeof(text), AUDIO_SAMPLE_RATE_EXACT, blocks, overruns, recordGaps, recordGapCount);
+    char path[40];
+    std::snprintf(path, sizeof(path), "%s.json", recordPath);
+    SD.remove(path);
+    File sidecar = SD.open(path, FILE_WRITE);
+    const bool described = sidecar && sidecar.write(reinterpret_cast<const uint8_t*>(text), length) == length;
+    if (sidecar) sidecar.close();
+
+    if (!written || !described) {
+        serialQueue.println("DATA:RECORD:ERROR:FILE");
+        return;
+    }
+    serialQueue.print("DATA:RECORD:OFF:");
+    serialQueue.print(recordPath);
+    serialQueue.print(".wav,");
+    serialQueue.print(static_cast<unsigned long>(blocks));
+    serialQueue.print(",");
+    serialQueue.println(static_cast<unsigned long>(overruns));
+}
+
+/**
+ * @brief Writes the chunks of the recording handed over by the audio interrupt to the SD card.
+ *
+ * A chunk is written in one piece, 32 KB starting on a sector boundary, and given back to the
+ * interrupt. New overruns are reported as DATA:RECORD:OVERRUN:<blocks dropped>, at most once per
+ * overrunReportPeriod, and the recording is completed once the last chunk after SET:RECORD:OFF
+ * is written.
+ */
+void pollRecorder() {
+    if (!recordFile) return;
+
+    std::size_t blocks;
+    if (const int16_t* chunk = signalRecorder.acquireChunk(blocks)) {
+        const std::size_t bytes = blocks * SignalRecorder::BLOCK_VALUES * sizeof(int16_t);
+        if (recordFile.write(reinterpret_cast<const uint8_t*>(chunk), bytes) != bytes) recordFailed = true;
+        signalRecorder.releaseChunk();
+    }
+
+    RecorderGap gap;
+    while (signalRecorder.readGap(gap)) {
+        if (recordGapCount < maxRecordGaps) recordGaps[recordGapCount++] = gap;
+    }
+    const uint32_t overruns = signalRecorder.getOverruns();
+    if (overruns != reportedOverruns && millis() - lastOverrunReport >= overrunReportPeriod) {
+        lastOverrunReport = millis();
+        reportedOverruns = overruns;
+        serialQueue.print("DATA:RECORD:OVERRUN:");
+        serialQueue.println(static_cast<unsigned long>(overruns));
+    }
+
+    if (!signalRecorder.isActive()) finishRecording();
+}
+
+/**
+ * @brief Reports the sample rate and the block size the firmware was built for.
+ *
+ * Replies DATA:AUDIO:<sample rate in Hz>,<samples per block>.
+ */
+void reportAudioFormat() {
+    serialQueue.print("DATA:AUDIO:");
+    serialQueue.print(AUDIO_SAMPLE_RATE_EXACT, 3);
+    serialQueue.print(",");
+    serialQueue.println(static_cast<unsigned int>(AUDIO_BLOCK_SAMPLES));
+}
+
+/**
+ * @brief Sends the result of the round-trip latency measurement started by GET:ROUNDTRIP, once it is over.
+ *
+ * Replies DATA:ROUNDTRIP:<samples>,<us by the audio clock>,<us by the cycle counter>,<sample rate>,<block size>,
+ * the latency from the output of the first channel back to its input, through whatever loops it
+ * back, or DATA:ROUNDTRIP:TIMEOUT if the click did not come back. The cycle counter time scales
+ * the samples by the cycles the audio blocks of the measurement actually took.
+ */
+void pollLatencyProbe() {
+    LatencyResult result;
+    if (!latencyProbe.takeResult(result)) return;
+    if (!result.detected) {
+        serialQueue.println("DATA:ROUNDTRIP:TIMEOUT");
+        return;
+    }
+
+    const float audioMicros = 1e6f * static_cast<float>(result.samples) / AUDIO_SAMPLE_RATE_EXACT;
+    const float cyclesPerSample = static_cast<float>(result.cycles) / static_cast<float>(result.blocks * AUDIO_BLOCK_SAMPLES);
+    const float cycleMicros = 1e6f * static_cast<float>(result.samples) * cyclesPerSample / static_cast<float>(F_CPU);
+    serialQueue.print("DATA:ROUNDTRIP:");
+    serialQueue.print(static_cast<unsigned long>(result.samples));
+    serialQueue.print(",");
+    serialQueue.print(audioMicros, 1);
+    serialQueue.print(",");
+    serialQueue.print(cycleMicros, 1);
+    serialQueue.print(",");
+    serialQueue.print(AUDIO_SAMPLE_RATE_EXACT, 3);
+    serialQueue.print(",");
+    serialQueue.println(static_cast<unsigned int>(AUDIO_BLOCK_SAMPLES));
+}
+
+/**
+ * @brief Checks that a venue command can start a transfer.
+ *
+ * Replies DATA:VENUE:ERROR:NOSD without an SD card, DATA:VENUE:BUSY while another transfer runs
+ * and DATA:VENUE:ERROR:NAME for an invalid name.
+ *
+ * @param name The name given to the command.
+ * @param parsed The name in upper case, venueNameLength + 1 characters.
+ * @return True if the transfer can start, false otherwise.
+ */
+static bool acceptVenue(const char* name, char* parsed) {
+    if (!sdReady) {
+        serialQueue.println("DATA:VENUE:ERROR:NOSD");
+    } else if (venueStep != VenueStep::Idle) {
+        serialQueue.println("DATA:VENUE:BUSY");
+    } else if (!parseVenueName(name, parsed)) {
+        serialQueue.println("DATA:VENUE:ERROR:NAME");
+    } else {
+        return true;
+    }
+    return false;
+}
+
 /**
  * @brief Processes a serial command and performs the corresponding action.
  *
  * @param command The serial command to process.
  */
-void processSerialCommand(const String &command) {
-    if (command.startsWith("SET:GAIN:")) {
-        const double gain = command.substring(9).toFloat();
-        adaptiveFeedbackCanceller.setGain(gain);
-        Serial.print("DATA:GAIN:");
-        Serial.println(gain);
+void processSerialCommand(const char* command) {
+    if (startsWith(command, "SET:GAIN:")) {
+        const double gain = std::strtod(command + 9, nullptr);
+        if (queueParameters(ParameterUpdate{}.setGain(gain))) {
+            serialQueue.print("DATA:GAIN:");
+            serialQueue.println(gain);
+        }
     }
-    else if (command == "SET:LMS:ON") {
-        adaptiveFeedbackCanceller.setLMS(true);
-        Serial.println("DATA:LMS:ON");
+    else if (startsWith(command, "SET:MU:")) {
+        const double mu = std::strtod(command + 7, nullptr);
+        if (isMuUnused()) {
+            serialQueue.println("DATA:MU:UNSUPPORTED");
+        } else if (queueParameters(ParameterUpdate{}.setMu(mu))) {
+            serialQueue.print("DATA:MU:");
+            serialQueue.println(mu, 6);
+        }
     }
-    else if (command == "SET:LMS:OFF") {
-        adaptiveFeedbackCanceller.setLMS(false);
-        Serial.println("DATA:LMS:OFF");
+    else if (startsWith(command, "SET:PARAMS:")) {
+        ParameterUpdate update;
+        if (!parseParameters(command + 11, update)) {
+            serialQueue.println("DATA:PARAMS:ERROR");
+        } else if ((update.fields & ParameterUpdate::Mu) && isMuUnused()) {
+            serialQueue.println("DATA:PARAMS:UNSUPPORTED");
+        } else if (queueParameters(update)) {
+            serialQueue.println("DATA:PARAMS:OK");
+        }
     }
-    else if (command == "SET:NOTCH:ON") {
-        adaptiveFeedbackCanceller.setNotch(true);
-        Serial.println("DATA:NOTCH:ON");
+    else if (std::strcmp(command, "SET:LMS:ON") == 0) {
+        if (queueParameters(ParameterUpdate{}.setLMS(true))) {
+            serialQueue.println("DATA:LMS:ON");
+        }
     }
-    else if (command == "SET:NOTCH:OFF") {
-        adaptiveFeedbackCanceller.setNotch(false);
-        Serial.println("DATA:NOTCH:OFF");
+    else if (std::strcmp(command, "SET:LMS:OFF") == 0) {
+        if (queueParameters(ParameterUpdate{}.setLMS(false))) {
+            serialQueue.println("DATA:LMS:OFF");
+        }
     }
-    else if (command == "SET:MUTE:ON") {
-        adaptiveFeedbackCanceller.setMute(true);
-        Serial.println("DATA:MUTE:ON");
+    else if (std::strcmp(command, "SET:NOTCH:ON") == 0) {
+        if (queueParameters(ParameterUpdate{}.setNotch(true))) {
+            serialQueue.println("DATA:NOTCH:ON");
+        }
     }
-    else if (command == "SET:MUTE:OFF") {
-        adaptiveFeedbackCanceller.setMute(false);
-        Serial.println("DATA:MUTE:OFF");
+    else if (std::strcmp(command, "SET:NOTCH:OFF") == 0) {
+        if (queueParameters(ParameterUpdate{}.setNotch(false))) {
+            serialQueue.println("DATA:NOTCH:OFF");
+        }
     }
-    else if (command == "RESET:LMS") {
-        adaptiveFeedbackCanceller.resetLMS();
-        Serial.println("DATA:LMS:RESET");
+    else if (std::strcmp(command, "SET:MUTE:ON") == 0) {
+        if (queueParameters(ParameterUpdate{}.setMute(true))) {
+            serialQueue.println("DATA:MUTE:ON");
+        }
+    }
+    else if (std::strcmp(command, "SET:MUTE:OFF") == 0) {
+        if (queueParameters(ParameterUpdate{}.setMute(false))) {
+            serialQueue.println("DATA:MUTE:OFF");
+        }
+    }
+#ifndef AFC_FDAF
+    else if (startsWith(command, "SET:NOISEWIN:")) {
+        const long size = std::strtol(command + 13, nullptr, 10);
+        const std::size_t window = AdaptiveFeedbackCanceller<AFC_CHANNELS>::clampNoiseWindow(size > 0 ? static_cast<std::size_t>(size) : 0);
+        if (queueParameters(ParameterUpdate{}.setNoiseWindow(window))) {
+            serialQueue.print("DATA:NOISEWIN:");
+            serialQueue.println(window);
+        }
+    }
+#endif
+#if !defined(AFC_FDAF) && !defined(AFC_SUBBAND)
+    else if (startsWith(command, "SET:ALGO:")) {
+        LMSAlgorithm algorithm;
+        if (!parseLMSAlgorithm(command + 9, algorithm)) {
+            serialQueue.println("DATA:ALGO:ERROR");
+        } else if (queueParameters(ParameterUpdate{}.setAlgorithm(algorithm))) {
+            serialQueue.print("DATA:ALGO:");
+            serialQueue.println(lmsAlgorithmName(algorithm));
+        }
+    }
+#endif
+    else if (std::strcmp(command, "SET:HOWL:ON") == 0) {
+#if AFC_HOWL_DETECTOR
+        if (queueParameters(ParameterUpdate{}.setAdaptiveNotch(false))) {
+            howlSeeding = true;
+            howlDetector.reset();
+            serialQueue.println("DATA:HOWL:ON");
+        }
+#else
+        serialQueue.println("DATA:HOWL:UNSUPPORTED");
+#endif
+    }
+    else if (std::strcmp(command, "SET:HOWL:OFF") == 0) {
+        if (queueParameters(ParameterUpdate{}.setAdaptiveNotch(true))) {
+            howlSeeding = false;
+            serialQueue.println("DATA:HOWL:OFF");
+        }
+    }
+    else if (std::strcmp(command, "SET:TELEMETRY:BINARY") == 0) {
+        binaryTelemetry = true;
+        adaptiveFeedbackCanceller.setMetricsEnabled(true);
+        serialQueue.println("DATA:TELEMETRY:BINARY");
+    }
+    else if (std::strcmp(command, "SET:TELEMETRY:TEXT") == 0) {
+        binaryTelemetry = false;
+        adaptiveFeedbackCanceller.setMetricsEnabled(false);
+        serialQueue.println("DATA:TELEMETRY:TEXT");
+    }
+    else if (startsWith(command, "SET:SNAPSHOT:")) {
+        char* end;
+        snapshotInterval = static_cast<uint32_t>(std::strtoul(command + 13, &end, 10));
+        const unsigned long channel = *end == ',' ? std::strtoul(end + 1, nullptr, 10) : 0;
+        snapshotChannel = static_cast<uint8_t>(std::min<unsigned long>(channel, AFC_CHANNELS - 1));
+        serialQueue.print("DATA:SNAPSHOT:");
+        serialQueue.print(static_cast<unsigned long>(snapshotInterval));
+        serialQueue.print(",");
+        serialQueue.println(static_cast<unsigned int>(snapshotChannel));
+    }
+    else if (std::strcmp(command, "RESET:LMS") == 0) {
+        if (queueParameters(ParameterUpdate{}.resetLMS())) {
+            serialQueue.println("DATA:LMS:RESET");
+        }
+    }
+    else if (std::strcmp(command, "GET:STATUS") == 0) {
+        serialQueue.print("DATA:STATUS:");
+        serialQueue.print(adaptiveFeedbackCanceller.isLMSEnabled() ? "LMS:ON," : "LMS:OFF,");
+        serialQueue.print(adaptiveFeedbackCanceller.isNotchEnabled() ? "NOTCH:ON," : "NOTCH:OFF,");
+        serialQueue.print(adaptiveFeedbackCanceller.isMuted() ? "MUTE:ON" : "MUTE:OFF");
+#if !defined(AFC_FDAF) && !defined(AFC_SUBBAND)
+        serialQueue.print(",ALGO:");
+        serialQueue.print(lmsAlgorithmName(adaptiveFeedbackCanceller.getAlgorithm()));
+#endif
+        serialQueue.println();
+        reportAudioFormat();
     }
-    else if (command == "GET:STATUS") {
-        Serial.print("DATA:STATUS:");
-        Serial.print(adaptiveFeedbackCanceller.isLMSEnabled() ? "LMS:ON," : "LMS:OFF,");
-        Serial.print(adaptiveFeedbackCanceller.isNotchEnabled() ? "NOTCH:ON," : "NOTCH:OFF,");
-        Serial.print(adaptiveFeedbackCanceller.isMuted() ? "MUTE:ON" : "MUTE:OFF");
-        Serial.println();
+    else if (std::strcmp(command, "GET:PERF") == 0) {
+        reportProfile();
+    }
+    else if (std::strcmp(command, "RESET:PERF") == 0) {
+#ifdef AFC_PROFILE
+        AudioNoInterrupts();
+        Profiler::reset();
+        AudioInterrupts();
+#endif
+        serialQueue.println("DATA:PERF:RESET");
+    }
+    else if (startsWith(command, "SAVE:VENUE:")) {
+        char name[venueNameLength + 1];
+        if (acceptVenue(command + 11, name)) beginSaveVenue(name);
+    }
+    else if (startsWith(command, "LOAD:VENUE:")) {
+        char name[venueNameLength + 1];
+        if (acceptVenue(command + 11, name)) beginLoadVenue(name);
+    }
+    else if (startsWith(command, "SET:VENUE:")) {
+        char name[venueNameLength + 1]{};
+        const bool none = std::strcmp(command + 10, "NONE") == 0;
+        if (!sdReady) {
+            serialQueue.println("DATA:VENUE:ERROR:NOSD");
+        } else if (!none && !parseVenueName(command + 10, name)) {
+            serialQueue.println("DATA:VENUE:ERROR:NAME");
+        } else if (!writeDefaultVenue(name)) {
+            serialQueue.println("DATA:VENUE:ERROR:FILE");
+        } else {
+            serialQueue.print("DATA:VENUE:DEFAULT:");
+            serialQueue.println(none ? "NONE" : name);
+        }
+    }
+    else if (std::strcmp(command, "GET:VENUES") == 0) {
+        if (sdReady) {
+            reportVenues();
+        } else {
+            serialQueue.println("DATA:VENUE:ERROR:NOSD");
+        }
+    }
+    else if (std::strcmp(command, "SET:RECORD:ON") == 0) {
+        startRecording();
+    }
+    else if (std::strcmp(command, "SET:RECORD:OFF") == 0) {
+        signalRecorder.stop();
+        serialQueue.println(recordFile ? "DATA:RECORD:STOPPING" : "DATA:RECORD:OFF");
+    }
+    else if (std::strcmp(command, "GET:RECORD") == 0) {
+        serialQueue.print(recordFile ? "DATA:RECORD:STATUS:ON," : "DATA:RECORD:STATUS:OFF,");
+        serialQueue.print(static_cast<unsigned long>(signalRecorder.getBlocks()));
+        serialQueue.print(",");
+        serialQueue.println(static_cast<unsigned long>(signalRecorder.getOverruns()));
+    }
+    else if (std::strcmp(command, "GET:LATENCY") == 0) {
+        serialQueue.print("DATA:LATENCY:");
+        serialQueue.print(lastLatency);
+        serialQueue.print(",");
+        serialQueue.println(maxLatency);
+    }
+    else if (std::strcmp(command, "GET:ROUNDTRIP") == 0) {
+        serialQueue.println(latencyProbe.start() ? "DATA:ROUNDTRIP:START" : "DATA:ROUNDTRIP:BUSY");
     }
 }
 
 /**
- * @brief Initializes the audio system and serial communication.
+ * @brief Reads the bytes received and runs each complete command.
+ *
+ * The time from the first byte of a command to its reply being handed to the serial port is
+ * measured by sendSerialData().
  */
-void setup() {
-    Serial.begin(115200);
-#ifdef BUTTON
-    pinMode(buttonPin, INPUT);
-#endif
-    AudioMemory(20);
-    audioShield.enable();
-    audioShield.inputSelect(AUDIO_INPUT_MIC);
-    audioShield.micGain(10);
-    audioShield.volume(0.8);
+void readSerialCommands() {
+    while (Serial.available() > 0) {
+        const int c = Serial.read();
+        if (commandReader.isEmpty()) commandStart = micros();
+        if (commandReader.push(static_cast<char>(c))) {
+            processSerialCommand(commandReader.line());
+            ackMark = serialQueue.getQueued();
+            ackPending = true;
+        }
+    }
+}
 
-    Serial.println("DATA:INIT:Système initialisé");
-    Serial.print("DATA:STATUS:");
-    Serial.print(adaptiveFeedbackCanceller.isLMSEnabled() ? "LMS:ON," : "LMS:OFF,");
-    Serial.print(adaptiveFeedbackCanceller.isNotchEnabled() ? "NOTCH:ON," : "NOTCH:OFF,");
-    Serial.print(adaptiveFeedbackCanceller.isMuted() ? "MUTE:ON" : "MUTE:OFF");
-    Serial.println();
+/**
+ * @brief Queues the recorded block metrics and the parameter acknowledgements, and sends what
+ * the serial port accepts.
+ *
+ * An acknowledgement is sent as DATA:APPLIED:<id>,<block>, or as a frame in binary telemetry,
+ * once the canceller has applied the changes of a command, from audio block <block> on.
+ */
+void sendSerialData() {
+    ParameterAck ack;
+    while (adaptiveFeedbackCanceller.readAck(ack)) {
+        if (venueStep == VenueStep::Applying && ack.id == venueUpdateId) venueStep = VenueStep::Idle;
+        if (binaryTelemetry) {
+            publish(TelemetryAck{ack.id, ack.block});
+        } else {
+            serialQueue.print("DATA:APPLIED:");
+            serialQueue.print(static_cast<unsigned long>(ack.id));
+            serialQueue.print(",");
+            serialQueue.println(static_cast<unsigned long>(ack.block));
+        }
+    }
 
-    Serial.print("DATA:MODE:");
-    Serial.println("INACTIF");
+    if (binaryTelemetry) {
+        TelemetryBlock block;
+        while (adaptiveFeedbackCanceller.readMetrics(block)) {
+            publish(block);
+        }
+    }
+
+    serialQueue.drain();
+
+    if (ackPending && serialQueue.hasSent(ackMark)) {
+        ackPending = false;
+        lastLatency = micros() - commandStart;
+        maxLatency = std::max(maxLatency, lastLatency);
+    }
 }
 
 /**
- * @brief Main loop that processes serial commands and updates the audio system.
+ * @brief Requests a snapshot of the filters every snapshotInterval and sends the published ones.
+ *
+ * In binary telemetry a snapshot is sent as a snapshot frame followed by the weights frames of
+ * its taps; in text as DATA:FILTER:<block>,<mu>,<gamma>,<notch frequency>,<notch bandwidth>,<active notches>,<channel>
+ * and DATA:WEIGHTS:<tap 0>,<tap 1>,...
  */
-void loop() {
-    if (Serial.available() > 0) {
-        String command = Serial.readStringUntil('\n');
-        command.trim();
-        processSerialCommand(command);
+void streamSnapshot() {
+    if (snapshotInterval > 0 && millis() - lastSnapshotRequest >= snapshotInterval) {
+        lastSnapshotRequest = millis();
+        adaptiveFeedbackCanceller.requestSnapshot(snapshotChannel);
+    }
+
+    const FilterSnapshot* snapshot = adaptiveFeedbackCanceller.acquireSnapshot();
+    if (!snapshot) return;
+
+    if (binaryTelemetry) {
+        publish(TelemetrySnapshot{snapshot->block, snapshot->mu, snapshot->gamma, snapshot->notchFrequency,
+                                  snapshot->notchBandwidth, snapshot->activeNotches, static_cast<uint16_t>(afcSnapshotTaps),
+                                  snapshot->channel});
+        for (std::size_t offset = 0; offset < afcSnapshotTaps; offset += TelemetryWeights::MAX_TAPS) {
+            TelemetryWeights weights{};
+            weights.block = snapshot->block;
+            weights.offset = static_cast<uint16_t>(offset);
+            weights.count = static_cast<uint8_t>(std::min(TelemetryWeights::MAX_TAPS, afcSnapshotTaps - offset));
+            for (std::size_t i = 0; i < weights.count; ++i) {
+                weights.taps[i] = static_cast<float>(snapshot->taps[offset + i]);
+            }
+            publish(weights);
+        }
+    } else {
+        serialQueue.print("DATA:FILTER:");
+        serialQueue.print(static_cast<unsigned long>(snapshot->block));
+        serialQueue.print(",");
+        serialQueue.print(snapshot->mu, 8);
+        serialQueue.print(",");
+        serialQueue.print(snapshot->gamma, 6);
+        serialQueue.print(",");
+        serialQueue.print(snapshot->notchFrequency);
+        serialQueue.print(",");
+        serialQueue.print(snapshot->notchBandwidth);
+        serialQueue.print(",");
+        serialQueue.print(static_cast<unsigned int>(snapshot->activeNotches));
+        serialQueue.print(",");
+        serialQueue.println(static_cast<unsigned int>(snapshot->channel));
+
+        serialQueue.print("DATA:WEIGHTS:");
+        for (std::size_t i = 0; i < afcSnapshotTaps; i++) {
+            if (i > 0) serialQueue.print(",");
+            serialQueue.print(static_cast<float>(snapshot->taps[i]), 8);
+        }
+        serialQueue.println();
     }
 
+    adaptiveFeedbackCanceller.releaseSnapshot();
+}
+
+#if AFC_HOWL_DETECTOR
+/**
+ * @brief Analyzes each new spectrum of the FFT for howls and reports the dominant frequency of the output.
+ *
+ * With howlSeeding, the howls found steer the notches of the canceller. Binary telemetry reports
+ * every spectrum; the DATA:FREQ text lines, each followed by a DATA:HOWLS line while howls are
+ * found, are limited to one per frequencyTextPeriod.
+ */
+void reportFrequency() {
+    if (!fft1024.available()) return;
+
+    for (std::size_t i = 0; i < spectrumBins; i++) {
+        spectrum[i] = fft1024.read(static_cast<unsigned int>(i));
+    }
+    howlDetector.analyze(spectrum);
+
+    float howls[ParameterUpdate::MAX_HOWLS];
+    const std::size_t howlCount = howlDetector.getHowls(howls, ParameterUpdate::MAX_HOWLS);
+    if (howlSeeding) adaptiveFeedbackCanceller.trackHowls(howls, howlCount);
+
+    const float dominantFreq = howlDetector.getPeakFrequency();
+    const float maxVal = howlDetector.getPeakMagnitude();
+
+    if (binaryTelemetry) {
+        publish(TelemetryFrequency{dominantFreq, maxVal});
+    } else if (micros() - lastFrequencyText >= frequencyTextPeriod) {
+        lastFrequencyText = micros();
+        serialQueue.print("DATA:FREQ:");
+        serialQueue.print(dominantFreq);
+        serialQueue.print(",");
+        serialQueue.println(maxVal);
+
+        if (howlCount > 0) {
+            serialQueue.print("DATA:HOWLS:");
+            for (std::size_t i = 0; i < howlCount; i++) {
+                if (i > 0) serialQueue.print(",");
+                serialQueue.print(howls[i]);
+            }
+            serialQueue.println();
+        }
+    }
+}
+#endif
+
 #ifdef BUTTON
+/**
+ * @brief Debounces the button and toggles the mode on a press.
+ */
+void pollButton() {
     const auto reading = digitalRead(buttonPin);
 
     if (reading != lastButtonState) {
@@ -121,36 +1137,105 @@ void loop() {
         if (!changedState) {
             changedState = true;
             adaptiveFeedbackCanceller.changeMode();
-            Serial.print("DATA:MODE:");
-            Serial.println(reading == LOW ? "ACTIF" : "INACTIF");
+            serialQueue.print("DATA:MODE:");
+            serialQueue.println(reading == LOW ? "ACTIF" : "INACTIF");
         }
     }
 
     lastButtonState = reading;
+}
 #endif
 
 #ifdef POTENTIOMETER
+/**
+ * @brief Sets the gain from the potentiometer.
+ */
+void readPotentiometer() {
     const auto potentiometerValue{analogRead(0) / 256};
     adaptiveFeedbackCanceller.setGain(potentiometerValue);
+}
 #endif
 
-    if (fft1024.available()) {
-        float maxVal = 0.0f;
-        int maxBin = 0;
-        for (int i = 0; i < 512; i++) {
-            if (const float binValue = fft1024.read(i); binValue > maxVal) {
-                maxVal = binValue;
-                maxBin = i;
-            }
+/**
+ * @brief Adds a task to the scheduler, or halts if it is full.
+ *
+ * A task left out would silently stop a part of the firmware, the transmission of the serial
+ * queue for instance, so a full scheduler is reported straight on the serial port and the
+ * firmware stops there.
+ *
+ * @param task The task.
+ * @param periodMicros The period of the task, in microseconds, zero to run it on every call.
+ */
+static void addTask(const TaskScheduler::Task task, const std::uint32_t periodMicros) {
+    if (scheduler.add(task, periodMicros)) return;
+    Serial.println("DATA:ERROR:TASKS");
+    while (true) {
+    }
+}
+
+/**
+ * @brief Initializes the audio system and serial communication.
+ */
+void setup() {
+    Serial.begin(115200);
+#ifdef BUTTON
+    pinMode(buttonPin, INPUT);
+#endif
+    // The default venue is loaded before the audio blocks flow, so the first block already runs
+    // with its state: the update() calls without blocks apply the queued image.
+    venueImage = new uint8_t[adaptiveFeedbackCanceller.getStateImageSize()];
+    adaptiveFeedbackCanceller.setRecorder(&signalRecorder);
+    sdReady = SD.begin(BUILTIN_SDCARD);
+    char venue[venueNameLength + 1];
+    if (sdReady && readDefaultVenue(venue)) {
+        beginLoadVenue(venue);
+        while (venueStep == VenueStep::Reading) {
+            pollVenue();
         }
+    }
+    AudioMemory(12 + 8 * AFC_CHANNELS);
+    // The cycle counter also times the latency probe, so it runs whether the build profiles or not.
+    Profiler::begin();
+    audioShield.enable();
+    audioShield.inputSelect(AUDIO_INPUT_MIC);
+    audioShield.micGain(10);
+    audioShield.volume(0.8);
+    adaptiveFeedbackCanceller.setAdaptiveNotch(!howlSeeding);
 
-        const auto dominantFreq = static_cast<float>(maxBin) * AUDIO_SAMPLE_RATE_EXACT / 1024.0f;
+    serialQueue.println("DATA:INIT:Système initialisé");
+    serialQueue.print("DATA:STATUS:");
+    serialQueue.print(adaptiveFeedbackCanceller.isLMSEnabled() ? "LMS:ON," : "LMS:OFF,");
+    serialQueue.print(adaptiveFeedbackCanceller.isNotchEnabled() ? "NOTCH:ON," : "NOTCH:OFF,");
+    serialQueue.print(adaptiveFeedbackCanceller.isMuted() ? "MUTE:ON" : "MUTE:OFF");
+    serialQueue.println();
+    reportAudioFormat();
 
-        Serial.print("DATA:FREQ:");
-        Serial.print(dominantFreq);
-        Serial.print(",");
-        Serial.println(maxVal);
-    }
+    serialQueue.print("DATA:MODE:");
+    serialQueue.println("INACTIF");
 
-    delay(100);
-}
\ No newline at end of file
+    addTask(readSerialCommands, 0);
+#if AFC_HOWL_DETECTOR
+    addTask(reportFrequency, frequencyPeriod);
+#endif
+    addTask(streamSnapshot, snapshotPollPeriod);
+#ifdef BUTTON
+    addTask(pollButton, buttonPeriod);
+#endif
+#ifdef POTENTIOMETER
+    addTask(readPotentiometer, potentiometerPeriod);
+#endif
+    addTask(pollVenue, venuePollPeriod);
+    addTask(pollRecorder, recordPollPeriod);
+    addTask(pollLatencyProbe, probePollPeriod);
+    addTask(sendSerialData, 0);
+}
+
+/**
+ * @brief Main loop that processes serial commands and updates the audio system.
+ *
+ * loop() never blocks: commands are read as their bytes arrive, everything sent to the host
+ * goes through serialQueue, and the periodic work is run by the scheduler when it is due.
+ */
+void loop() {
+    scheduler.run(micros());
+}